@@ -25,6 +25,8 @@
 
 namespace aco {
 
+thread_local monotonic_arena *instr_arena = NULL;
+
 bool can_use_SDWA(chip_class chip, const aco_ptr<Instruction>& instr)
 {
    if (!instr->isVALU())
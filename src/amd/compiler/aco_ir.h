@@ -1219,9 +1219,20 @@ struct Pseudo_reduction_instruction : public Instruction {
 };
 static_assert(sizeof(Pseudo_reduction_instruction) == sizeof(Instruction) + 4, "Unexpected padding");
 
+/* Instructions are allocated from the arena of the Program being compiled on
+ * this thread and are released together with it. */
+extern thread_local monotonic_arena *instr_arena;
+
 struct instr_deleter_functor {
-   void operator()(void* p) {
-      free(p);
+   void operator()(Instruction* instr) {
+      /* The Program is being destroyed, which releases the memory. */
+      if (!instr_arena)
+         return;
+
+      /* The definitions are the last part of the allocation. If they were
+       * shrunk, this is smaller than the allocation, which is fine. */
+      std::size_t size = (char*)instr->definitions.end() - (char*)instr;
+      instr_arena->deallocate(instr, size);
    }
 };
 
@@ -1232,7 +1243,8 @@ template<typename T>
 T* create_instruction(aco_opcode opcode, Format format, uint32_t num_operands, uint32_t num_definitions)
 {
    std::size_t size = sizeof(T) + num_operands * sizeof(Operand) + num_definitions * sizeof(Definition);
-   char *data = (char*) calloc(1, size);
+   assert(instr_arena);
+   char *data = (char*) instr_arena->allocate(size);
    T* inst = (T*) data;
 
    inst->opcode = opcode;
@@ -1461,6 +1473,24 @@ enum statistic {
 };
 
 class Program final {
+public:
+   Program() {
+      assert(!instr_arena);
+      instr_arena = &arena;
+   }
+
+   ~Program() {
+      /* Skip recycling the instructions, the arena is about to be released. */
+      instr_arena = NULL;
+   }
+
+   Program(const Program&) = delete;
+   Program& operator=(const Program&) = delete;
+
+private:
+   /* Must be declared before everything which can own instructions. */
+   monotonic_arena arena;
+
 public:
    float_mode next_fp_mode;
    std::vector<Block> blocks;
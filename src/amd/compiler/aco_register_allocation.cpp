@@ -30,6 +30,7 @@
 #include <array>
 #include <map>
 #include <unordered_map>
+#include <vector>
 
 #include "aco_ir.h"
 #include "sid.h"
@@ -43,12 +44,23 @@ void add_subdword_operand(chip_class chip, aco_ptr<Instruction>& instr, unsigned
 std::pair<unsigned, unsigned> get_subdword_definition_info(Program *program, const aco_ptr<Instruction>& instr, RegClass rc);
 void add_subdword_definition(Program *program, aco_ptr<Instruction>& instr, unsigned idx, PhysReg reg, bool is_partial);
 
+/* Everything the register allocator knows about a temporary, indexed by its id. */
 struct assignment {
    PhysReg reg;
    RegClass rc;
    uint8_t assigned = 0;
+   uint32_t affinity = 0; /* id of the temporary whose register is preferred */
+   uint32_t phi_idx = 0; /* 1 + index into ra_ctx::phis if it's defined by a phi created by RA */
+   uint32_t renames = 0; /* first entry of this temporary's list in ra_ctx::renames */
+   Temp orig_name; /* the original temporary if this one is a rename */
    assignment() = default;
    assignment(PhysReg reg, RegClass rc) : reg(reg), rc(rc), assigned(-1) {}
+
+   void set(const Definition& def) {
+      reg = def.physReg();
+      rc = def.regClass();
+      assigned = -1;
+   }
 };
 
 struct phi_info {
@@ -57,19 +69,24 @@ struct phi_info {
    std::set<Instruction*> uses;
 };
 
+/* The name of a temporary at the end of a block. */
+struct rename_entry {
+   unsigned block_idx;
+   Temp temp;
+   uint32_t next; /* next entry for the same temporary, 0 terminates the list */
+};
+
 struct ra_ctx {
    std::bitset<512> war_hint;
    Program* program;
    std::vector<assignment> assignments;
-   std::vector<std::unordered_map<unsigned, Temp>> renames;
+   std::vector<rename_entry> renames; /* the first entry is unused */
    std::vector<std::vector<Instruction*>> incomplete_phis;
    std::vector<bool> filled;
    std::vector<bool> sealed;
-   std::unordered_map<unsigned, Temp> orig_names;
-   std::unordered_map<unsigned, phi_info> phi_map;
-   std::unordered_map<unsigned, unsigned> affinities;
-   std::unordered_map<unsigned, Instruction*> vectors;
-   std::unordered_map<unsigned, Instruction*> split_vectors;
+   std::vector<phi_info> phis;
+   std::vector<Instruction*> vectors; /* indexed by temp id, might be smaller than assignments */
+   std::vector<Instruction*> split_vectors; /* same as vectors */
    aco_ptr<Instruction> pseudo_dummy;
    unsigned max_used_sgpr = 0;
    unsigned max_used_vgpr = 0;
@@ -77,10 +94,12 @@ struct ra_ctx {
 
    ra_ctx(Program* program) : program(program),
                               assignments(program->peekAllocationId()),
-                              renames(program->blocks.size()),
+                              renames(1),
                               incomplete_phis(program->blocks.size()),
                               filled(program->blocks.size()),
-                              sealed(program->blocks.size())
+                              sealed(program->blocks.size()),
+                              vectors(program->peekAllocationId()),
+                              split_vectors(program->peekAllocationId())
    {
       pseudo_dummy.reset(create_instruction<Instruction>(aco_opcode::p_parallelcopy, Format::PSEUDO, 0, 0));
    }
@@ -132,26 +151,37 @@ struct DefInfo {
 
 class RegisterFile {
 public:
-   RegisterFile() {regs.fill(0);}
+   RegisterFile() {regs.fill(0); used.fill(0);}
 
-   std::array<uint32_t, 512> regs;
    std::map<uint32_t, std::array<uint32_t, 4>> subdword_regs;
 
    const uint32_t& operator [] (unsigned index) const {
       return regs[index];
    }
 
-   uint32_t& operator [] (unsigned index) {
-      return regs[index];
-   }
-
    unsigned count_zero(PhysReg start, unsigned size) {
       unsigned res = 0;
-      for (unsigned i = 0; i < size; i++)
-         res += !regs[start + i];
+      for (unsigned i = start; i < start + size;) {
+         unsigned count = std::min(64 - i % 64, start + size - i);
+         uint64_t mask = count == 64 ? UINT64_MAX : ((1ull << count) - 1) << (i % 64);
+         res += count - util_bitcount64(used[i / 64] & mask);
+         i += count;
+      }
       return res;
    }
 
+   /* returns whether all registers in the range are zero */
+   bool is_free(PhysReg start, unsigned size) {
+      for (unsigned i = start; i < start + size;) {
+         unsigned count = std::min(64 - i % 64, start + size - i);
+         uint64_t mask = count == 64 ? UINT64_MAX : ((1ull << count) - 1) << (i % 64);
+         if (used[i / 64] & mask)
+            return false;
+         i += count;
+      }
+      return true;
+   }
+
    bool test(PhysReg start, unsigned num_bytes) {
       for (PhysReg i = start; i.reg_b < start.reg_b + num_bytes; i = PhysReg(i + 1)) {
          if (regs[i] & 0x0FFFFFFF)
@@ -226,9 +256,23 @@ public:
    }
 
 private:
+   /* only written through fill(), which keeps used in sync */
+   std::array<uint32_t, 512> regs;
+   /* one bit per register which is set if it's not zero, to scan for free registers quickly */
+   std::array<uint64_t, 8> used;
+
+   void set_used(unsigned reg, bool value) {
+      if (value)
+         used[reg / 64] |= 1ull << (reg % 64);
+      else
+         used[reg / 64] &= ~(1ull << (reg % 64));
+   }
+
    void fill(PhysReg start, unsigned size, uint32_t val) {
-      for (unsigned i = 0; i < size; i++)
+      for (unsigned i = 0; i < size; i++) {
          regs[start + i] = val;
+         set_used(start + i, val);
+      }
    }
 
    void fill_subdword(PhysReg start, unsigned num_bytes, uint32_t val) {
@@ -242,6 +286,7 @@ private:
          if (sub == std::array<uint32_t, 4>{0, 0, 0, 0}) {
             subdword_regs.erase(i);
             regs[i] = 0;
+            set_used(i, false);
          }
       }
    }
@@ -298,8 +343,9 @@ void print_regs(ra_ctx& ctx, bool vgprs, RegisterFile& reg_file)
             printf("]\n");
          prev = reg_file[i];
          if (prev && prev != 0xFFFF) {
-            if (ctx.orig_names.count(reg_file[i]) && ctx.orig_names[reg_file[i]].id() != reg_file[i])
-               printf("%%%u (was %%%d) = %c[%d", reg_file[i], ctx.orig_names[reg_file[i]].id(), reg_char, i - lb);
+            Temp orig = ctx.assignments[reg_file[i]].orig_name;
+            if (orig.id() && orig.id() != reg_file[i])
+               printf("%%%u (was %%%d) = %c[%d", reg_file[i], orig.id(), reg_char, i - lb);
             else
                printf("%%%u = %c[%d", reg_file[i], reg_char, i - lb);
          }
@@ -658,26 +704,17 @@ std::pair<PhysReg, bool> get_reg_simple(ra_ctx& ctx,
       return {PhysReg{best_pos}, true};
    }
 
-   bool found = false;
-   unsigned reg_lo = lb;
-   unsigned reg_hi = lb + size - 1;
-   while (!found && reg_lo + size <= ub) {
-      if (reg_file[reg_lo] != 0) {
-         reg_lo += stride;
+   for (unsigned reg_lo = lb; reg_lo + size <= ub; reg_lo += stride) {
+      if (!reg_file.is_free(PhysReg{reg_lo}, size))
          continue;
-      }
-      reg_hi = reg_lo + size - 1;
-      found = true;
-      for (unsigned reg = reg_lo + 1; found && reg <= reg_hi; reg++) {
-         if (reg_file[reg] != 0 || ctx.war_hint[reg])
-            found = false;
-      }
+
+      bool found = true;
+      for (unsigned reg = reg_lo + 1; found && reg < reg_lo + size; reg++)
+         found = !ctx.war_hint[reg];
       if (found) {
          adjust_max_used_regs(ctx, rc, reg_lo);
          return {PhysReg{reg_lo}, true};
       }
-
-      reg_lo += stride;
    }
 
    /* do this late because using the upper bytes of a register can require
@@ -1168,13 +1205,13 @@ PhysReg get_reg(ra_ctx& ctx,
                 aco_ptr<Instruction>& instr,
                 int operand_index=-1)
 {
-   auto split_vec = ctx.split_vectors.find(temp.id());
-   if (split_vec != ctx.split_vectors.end()) {
+   Instruction* split_vec = temp.id() < ctx.split_vectors.size() ? ctx.split_vectors[temp.id()] : NULL;
+   if (split_vec) {
       unsigned offset = 0;
-      for (Definition def : split_vec->second->definitions) {
-         auto affinity_it = ctx.affinities.find(def.tempId());
-         if (affinity_it != ctx.affinities.end() && ctx.assignments[affinity_it->second].assigned) {
-            PhysReg reg = ctx.assignments[affinity_it->second].reg;
+      for (Definition def : split_vec->definitions) {
+         unsigned affinity = ctx.assignments[def.tempId()].affinity;
+         if (affinity && ctx.assignments[affinity].assigned) {
+            PhysReg reg = ctx.assignments[affinity].reg;
             reg.reg_b -= offset;
             if (get_reg_specified(ctx, reg_file, temp.regClass(), parallelcopies, instr, reg))
                return reg;
@@ -1183,15 +1220,15 @@ PhysReg get_reg(ra_ctx& ctx,
       }
    }
 
-   if (ctx.affinities.find(temp.id()) != ctx.affinities.end() &&
-       ctx.assignments[ctx.affinities[temp.id()]].assigned) {
-      PhysReg reg = ctx.assignments[ctx.affinities[temp.id()]].reg;
+   unsigned affinity = ctx.assignments[temp.id()].affinity;
+   if (affinity && ctx.assignments[affinity].assigned) {
+      PhysReg reg = ctx.assignments[affinity].reg;
       if (get_reg_specified(ctx, reg_file, temp.regClass(), parallelcopies, instr, reg))
          return reg;
    }
 
-   if (ctx.vectors.find(temp.id()) != ctx.vectors.end()) {
-      Instruction* vec = ctx.vectors[temp.id()];
+   Instruction* vec = temp.id() < ctx.vectors.size() ? ctx.vectors[temp.id()] : NULL;
+   if (vec) {
       unsigned byte_offset = 0;
       for (const Operand& op : vec->operands) {
          if (op.isTemp() && op.tempId() == temp.id())
@@ -1539,11 +1576,47 @@ void get_reg_for_operand(ra_ctx& ctx, RegisterFile& register_file,
 
 Temp read_variable(ra_ctx& ctx, Temp val, unsigned block_idx)
 {
-   std::unordered_map<unsigned, Temp>::iterator it = ctx.renames[block_idx].find(val.id());
-   if (it == ctx.renames[block_idx].end())
-      return val;
-   else
-      return it->second;
+   for (uint32_t i = ctx.assignments[val.id()].renames; i; i = ctx.renames[i].next) {
+      if (ctx.renames[i].block_idx == block_idx)
+         return ctx.renames[i].temp;
+   }
+   return val;
+}
+
+void write_variable(ra_ctx& ctx, Temp orig, Temp val, unsigned block_idx)
+{
+   uint32_t& first = ctx.assignments[orig.id()].renames;
+   for (uint32_t i = first; i; i = ctx.renames[i].next) {
+      if (ctx.renames[i].block_idx == block_idx) {
+         ctx.renames[i].temp = val;
+         return;
+      }
+   }
+   ctx.renames.push_back(rename_entry{block_idx, val, first});
+   first = ctx.renames.size() - 1;
+}
+
+phi_info* get_phi_info(ra_ctx& ctx, Temp temp)
+{
+   unsigned idx = ctx.assignments[temp.id()].phi_idx;
+   return idx ? &ctx.phis[idx - 1] : NULL;
+}
+
+void add_phi_info(ra_ctx& ctx, Instruction* phi, unsigned block_idx)
+{
+   ctx.phis.emplace_back(phi_info{phi, block_idx});
+   ctx.assignments[phi->definitions[0].tempId()].phi_idx = ctx.phis.size();
+}
+
+void remove_phi_info(ra_ctx& ctx, Temp temp)
+{
+   unsigned idx = ctx.assignments[temp.id()].phi_idx - 1;
+   ctx.assignments[temp.id()].phi_idx = 0;
+   if (idx != ctx.phis.size() - 1) {
+      ctx.phis[idx] = std::move(ctx.phis.back());
+      ctx.assignments[ctx.phis[idx].phi->definitions[0].tempId()].phi_idx = idx + 1;
+   }
+   ctx.phis.pop_back();
 }
 
 Temp handle_live_in(ra_ctx& ctx, Temp val, Block* block)
@@ -1568,9 +1641,9 @@ Temp handle_live_in(ra_ctx& ctx, Temp val, Block* block)
       for (unsigned i = 0; i < preds.size(); i++)
          phi->operands[i] = Operand(val);
       if (tmp.regClass() == new_val.regClass())
-         ctx.affinities[new_val.id()] = tmp.id();
+         ctx.assignments[new_val.id()].affinity = tmp.id();
 
-      ctx.phi_map.emplace(new_val.id(), phi_info{phi.get(), block->index});
+      add_phi_info(ctx, phi.get(), block->index);
       ctx.incomplete_phis[block->index].emplace_back(phi.get());
       block->instructions.insert(block->instructions.begin(), std::move(phi));
 
@@ -1596,36 +1669,36 @@ Temp handle_live_in(ra_ctx& ctx, Temp val, Block* block)
          aco_opcode opcode = val.is_linear() ? aco_opcode::p_linear_phi : aco_opcode::p_phi;
          aco_ptr<Instruction> phi{create_instruction<Pseudo_instruction>(opcode, Format::PSEUDO, preds.size(), 1)};
          new_val = Temp{ctx.program->allocateId(), val.regClass()};
+         ctx.assignments.emplace_back();
+         assert(ctx.assignments.size() == ctx.program->peekAllocationId());
          phi->definitions[0] = Definition(new_val);
          for (unsigned i = 0; i < preds.size(); i++) {
             phi->operands[i] = Operand(ops[i]);
             phi->operands[i].setFixed(ctx.assignments[ops[i].id()].reg);
             if (ops[i].regClass() == new_val.regClass())
-               ctx.affinities[new_val.id()] = ops[i].id();
+               ctx.assignments[new_val.id()].affinity = ops[i].id();
          }
-         ctx.assignments.emplace_back();
-         assert(ctx.assignments.size() == ctx.program->peekAllocationId());
-         ctx.phi_map.emplace(new_val.id(), phi_info{phi.get(), block->index});
+         add_phi_info(ctx, phi.get(), block->index);
          block->instructions.insert(block->instructions.begin(), std::move(phi));
       }
    }
 
    if (new_val != val) {
-      ctx.renames[block->index][val.id()] = new_val;
-      ctx.orig_names[new_val.id()] = val;
+      write_variable(ctx, val, new_val, block->index);
+      ctx.assignments[new_val.id()].orig_name = val;
    }
    return new_val;
 }
 
 void try_remove_trivial_phi(ra_ctx& ctx, Temp temp)
 {
-   std::unordered_map<unsigned, phi_info>::iterator info = ctx.phi_map.find(temp.id());
+   phi_info* info = get_phi_info(ctx, temp);
 
-   if (info == ctx.phi_map.end() || !ctx.sealed[info->second.block_idx])
+   if (!info || !ctx.sealed[info->block_idx])
       return;
 
-   assert(info->second.block_idx != 0);
-   Instruction* phi = info->second.phi;
+   assert(info->block_idx != 0);
+   Instruction* phi = info->phi;
    Temp same = Temp();
    Definition def = phi->definitions[0];
 
@@ -1645,8 +1718,8 @@ void try_remove_trivial_phi(ra_ctx& ctx, Temp temp)
 
    /* reroute all uses to same and remove phi */
    std::vector<Temp> phi_users;
-   std::unordered_map<unsigned, phi_info>::iterator same_phi_info = ctx.phi_map.find(same.id());
-   for (Instruction* instr : info->second.uses) {
+   phi_info* same_phi_info = get_phi_info(ctx, same);
+   for (Instruction* instr : info->uses) {
       assert(phi != instr);
       /* recursively try to remove trivial phis */
       if (is_phi(instr)) {
@@ -1660,22 +1733,22 @@ void try_remove_trivial_phi(ra_ctx& ctx, Temp temp)
       for (Operand& op : instr->operands) {
          if (op.isTemp() && op.tempId() == def.tempId()) {
             op.setTemp(same);
-            if (same_phi_info != ctx.phi_map.end())
-               same_phi_info->second.uses.emplace(instr);
+            if (same_phi_info)
+               same_phi_info->uses.emplace(instr);
          }
       }
    }
 
-   auto it = ctx.orig_names.find(same.id());
-   unsigned orig_var = it != ctx.orig_names.end() ? it->second.id() : same.id();
-   for (unsigned i = 0; i < ctx.program->blocks.size(); i++) {
-      auto it = ctx.renames[i].find(orig_var);
-      if (it != ctx.renames[i].end() && it->second == def.getTemp())
-         ctx.renames[i][orig_var] = same;
+   Temp orig_var = ctx.assignments[same.id()].orig_name;
+   if (!orig_var.id())
+      orig_var = same;
+   for (uint32_t i = ctx.assignments[orig_var.id()].renames; i; i = ctx.renames[i].next) {
+      if (ctx.renames[i].temp == def.getTemp())
+         ctx.renames[i].temp = same;
    }
 
    phi->definitions.clear(); /* this indicates that the phi can be removed */
-   ctx.phi_map.erase(info);
+   remove_phi_info(ctx, temp);
    for (Temp t : phi_users)
       try_remove_trivial_phi(ctx, t);
 
@@ -1770,7 +1843,7 @@ void register_allocation(Program *program, std::vector<TempSet>& live_out_per_bl
       assert(vec.size() > 1);
       for (unsigned i = 1; i < vec.size(); i++)
          if (vec[i].id() != vec[0].id())
-            ctx.affinities[vec[i].id()] = vec[0].id();
+            ctx.assignments[vec[i].id()].affinity = vec[0].id();
    }
 
    /* state of register file after phis */
@@ -1824,7 +1897,7 @@ void register_allocation(Program *program, std::vector<TempSet>& live_out_per_bl
          assert(definition.physReg() == exec);
          assert(!register_file.test(definition.physReg(), definition.bytes()));
          register_file.fill(definition);
-         ctx.assignments[definition.tempId()] = {definition.physReg(), definition.regClass()};
+         ctx.assignments[definition.tempId()].set(definition);
       }
 
       /* look up the affinities */
@@ -1836,10 +1909,10 @@ void register_allocation(Program *program, std::vector<TempSet>& live_out_per_bl
          if (definition.isKill() || definition.isFixed())
              continue;
 
-         if (ctx.affinities.find(definition.tempId()) != ctx.affinities.end() &&
-             ctx.assignments[ctx.affinities[definition.tempId()]].assigned) {
-            assert(ctx.assignments[ctx.affinities[definition.tempId()]].rc == definition.regClass());
-            PhysReg reg = ctx.assignments[ctx.affinities[definition.tempId()]].reg;
+         unsigned affinity = ctx.assignments[definition.tempId()].affinity;
+         if (affinity && ctx.assignments[affinity].assigned) {
+            assert(ctx.assignments[affinity].rc == definition.regClass());
+            PhysReg reg = ctx.assignments[affinity].reg;
             bool try_use_special_reg = reg == scc || reg == exec;
             if (try_use_special_reg) {
                for (const Operand& op : phi->operands) {
@@ -1856,7 +1929,7 @@ void register_allocation(Program *program, std::vector<TempSet>& live_out_per_bl
             if (!register_file.test(reg, definition.bytes())) {
                definition.setFixed(reg);
                register_file.fill(definition);
-               ctx.assignments[definition.tempId()] = {definition.physReg(), definition.regClass()};
+               ctx.assignments[definition.tempId()].set(definition);
             }
          }
       }
@@ -1909,19 +1982,18 @@ void register_allocation(Program *program, std::vector<TempSet>& live_out_per_bl
                   /* if so, just update that phi's register */
                   register_file.clear(prev_phi->definitions[0]);
                   prev_phi->definitions[0].setFixed(pc.second.physReg());
-                  ctx.assignments[prev_phi->definitions[0].tempId()] = {pc.second.physReg(), pc.second.regClass()};
+                  ctx.assignments[prev_phi->definitions[0].tempId()].set(pc.second);
                   register_file.fill(prev_phi->definitions[0]);
                   continue;
                }
 
                /* rename */
-               std::unordered_map<unsigned, Temp>::iterator orig_it = ctx.orig_names.find(pc.first.tempId());
-               Temp orig = pc.first.getTemp();
-               if (orig_it != ctx.orig_names.end())
-                  orig = orig_it->second;
-               else
-                  ctx.orig_names[pc.second.tempId()] = orig;
-               ctx.renames[block.index][orig.id()] = pc.second.getTemp();
+               Temp orig = ctx.assignments[pc.first.tempId()].orig_name;
+               if (!orig.id()) {
+                  orig = pc.first.getTemp();
+                  ctx.assignments[pc.second.tempId()].orig_name = orig;
+               }
+               write_variable(ctx, orig, pc.second.getTemp(), block.index);
 
                /* otherwise, this is a live-in and we need to create a new phi
                 * to move it in this block's predecessors */
@@ -1935,14 +2007,14 @@ void register_allocation(Program *program, std::vector<TempSet>& live_out_per_bl
             }
 
             register_file.fill(definition);
-            ctx.assignments[definition.tempId()] = {definition.physReg(), definition.regClass()};
+            ctx.assignments[definition.tempId()].set(definition);
          }
          live.emplace(definition.getTemp());
 
          /* update phi affinities */
          for (const Operand& op : phi->operands) {
             if (op.isTemp() && op.regClass() == phi->definitions[0].regClass())
-               ctx.affinities[op.tempId()] = definition.tempId();
+               ctx.assignments[op.tempId()].affinity = definition.tempId();
          }
 
          instructions.emplace_back(std::move(*it));
@@ -1980,7 +2052,7 @@ void register_allocation(Program *program, std::vector<TempSet>& live_out_per_bl
                      Temp phi_op = read_variable(ctx, phi->operands[idx].getTemp(), block.index);
                      PhysReg reg = ctx.assignments[phi_op.id()].reg;
                      assert(register_file[reg] == phi_op.id());
-                     register_file[reg] = 0;
+                     register_file.clear(reg, s1);
                   }
                } else if (phi->opcode != aco_opcode::p_linear_phi) {
                   break;
@@ -2017,9 +2089,9 @@ void register_allocation(Program *program, std::vector<TempSet>& live_out_per_bl
                   ctx.war_hint.set(operand.physReg().reg() + j);
             }
 
-            std::unordered_map<unsigned, phi_info>::iterator phi = ctx.phi_map.find(operand.getTemp().id());
-            if (phi != ctx.phi_map.end())
-               phi->second.uses.emplace(instr.get());
+            phi_info* phi = get_phi_info(ctx, operand.getTemp());
+            if (phi)
+               phi->uses.emplace(instr.get());
          }
 
          /* remove dead vars from register file */
@@ -2044,10 +2116,10 @@ void register_allocation(Program *program, std::vector<TempSet>& live_out_per_bl
              instr->operands[1].physReg().byte() == 0 &&
              instr->operands[2].physReg().byte() == 0) {
             unsigned def_id = instr->definitions[0].tempId();
-            auto it = ctx.affinities.find(def_id);
-            if (it == ctx.affinities.end() || !ctx.assignments[it->second].assigned ||
-                instr->operands[2].physReg() == ctx.assignments[it->second].reg ||
-                register_file.test(ctx.assignments[it->second].reg, instr->operands[2].bytes())) {
+            unsigned affinity = ctx.assignments[def_id].affinity;
+            if (!affinity || !ctx.assignments[affinity].assigned ||
+                instr->operands[2].physReg() == ctx.assignments[affinity].reg ||
+                register_file.test(ctx.assignments[affinity].reg, instr->operands[2].bytes())) {
                instr->format = Format::VOP2;
                switch (instr->opcode) {
                case aco_opcode::v_mad_f32:
@@ -2140,7 +2212,7 @@ void register_allocation(Program *program, std::vector<TempSet>& live_out_per_bl
             if (!definition.isKill())
                live.emplace(definition.getTemp());
 
-            ctx.assignments[definition.tempId()] = {definition.physReg(), definition.regClass()};
+            ctx.assignments[definition.tempId()].set(definition);
             register_file.fill(definition);
          }
 
@@ -2201,7 +2273,7 @@ void register_allocation(Program *program, std::vector<TempSet>& live_out_per_bl
             if (!definition->isKill())
                live.emplace(definition->getTemp());
 
-            ctx.assignments[definition->tempId()] = {definition->physReg(), definition->regClass()};
+            ctx.assignments[definition->tempId()].set(*definition);
             register_file.fill(*definition);
          }
 
@@ -2246,14 +2318,15 @@ void register_allocation(Program *program, std::vector<TempSet>& live_out_per_bl
                assert(pc->operands[i].size() == pc->definitions[i].size());
 
                /* it might happen that the operand is already renamed. we have to restore the original name. */
-               std::unordered_map<unsigned, Temp>::iterator it = ctx.orig_names.find(pc->operands[i].tempId());
-               Temp orig = it != ctx.orig_names.end() ? it->second : pc->operands[i].getTemp();
-               ctx.orig_names[pc->definitions[i].tempId()] = orig;
-               ctx.renames[block.index][orig.id()] = pc->definitions[i].getTemp();
-
-               std::unordered_map<unsigned, phi_info>::iterator phi = ctx.phi_map.find(pc->operands[i].tempId());
-               if (phi != ctx.phi_map.end())
-                  phi->second.uses.emplace(pc.get());
+               Temp orig = ctx.assignments[pc->operands[i].tempId()].orig_name;
+               if (!orig.id())
+                  orig = pc->operands[i].getTemp();
+               ctx.assignments[pc->definitions[i].tempId()].orig_name = orig;
+               write_variable(ctx, orig, pc->definitions[i].getTemp(), block.index);
+
+               phi_info* phi = get_phi_info(ctx, pc->operands[i].getTemp());
+               if (phi)
+                  phi->uses.emplace(pc.get());
             }
 
             if (temp_in_scc && sgpr_operands_alias_defs) {
@@ -2353,12 +2426,12 @@ void register_allocation(Program *program, std::vector<TempSet>& live_out_per_bl
             for (unsigned i = 0; i < instr->operands.size(); i++) {
                Operand& operand = tmp->operands[i];
                instr->operands[i] = operand;
-               /* keep phi_map up to date */
+               /* keep the phi uses up to date */
                if (operand.isTemp()) {
-                  std::unordered_map<unsigned, phi_info>::iterator phi = ctx.phi_map.find(operand.tempId());
-                  if (phi != ctx.phi_map.end()) {
-                     phi->second.uses.erase(tmp.get());
-                     phi->second.uses.emplace(instr.get());
+                  phi_info* phi = get_phi_info(ctx, operand.getTemp());
+                  if (phi) {
+                     phi->uses.erase(tmp.get());
+                     phi->uses.emplace(instr.get());
                   }
                }
             }
@@ -2406,9 +2479,9 @@ void register_allocation(Program *program, std::vector<TempSet>& live_out_per_bl
                      continue;
                   operand.setTemp(read_variable(ctx, operand.getTemp(), preds[i]));
                   operand.setFixed(ctx.assignments[operand.tempId()].reg);
-                  std::unordered_map<unsigned, phi_info>::iterator phi = ctx.phi_map.find(operand.getTemp().id());
-                  if (phi != ctx.phi_map.end())
-                     phi->second.uses.emplace(instr.get());
+                  phi_info* phi = get_phi_info(ctx, operand.getTemp());
+                  if (phi)
+                     phi->uses.emplace(instr.get());
                }
             }
          }
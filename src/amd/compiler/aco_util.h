@@ -26,6 +26,9 @@
 #define ACO_UTIL_H
 
 #include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <iterator>
 
 namespace aco {
@@ -228,6 +231,102 @@ private:
    size_type length{ 0 };     //!> Size of the span
 };
 
+/*! \brief      Definition of a monotonic arena
+*
+*   \details    Allocations are carved out of large blocks which are only
+*               released when the arena is destroyed. Deallocated memory is
+*               kept in one free list per size class and handed out again by
+*               allocations of the same size class, so objects which are
+*               replaced many times don't make the arena grow.
+*/
+class monotonic_arena {
+public:
+   static constexpr std::size_t alignment = 16;
+   static constexpr std::size_t block_size = 64 * 1024;
+   static constexpr unsigned num_size_classes = 32;
+
+   monotonic_arena() = default;
+   monotonic_arena(const monotonic_arena&) = delete;
+   monotonic_arena& operator=(const monotonic_arena&) = delete;
+
+   ~monotonic_arena() {
+      while (blocks) {
+         block_header *next = blocks->next;
+         free(blocks);
+         blocks = next;
+      }
+   }
+
+   /*! \brief                 Returns zeroed memory aligned to the alignment
+   *   \param[in]   size      Size of the allocation in bytes
+   */
+   void* allocate(std::size_t size) {
+      size = align_size(size);
+
+      unsigned size_class = size / alignment - 1;
+      if (size_class < num_size_classes && free_lists[size_class]) {
+         free_entry *entry = free_lists[size_class];
+         free_lists[size_class] = entry->next;
+         memset(entry, 0, size);
+         return entry;
+      }
+
+      /* Big allocations get their own block, so that the current one isn't wasted. */
+      if (size > block_size / 4)
+         return add_block(size);
+
+      if (size > std::size_t(end - current)) {
+         current = (char*)add_block(block_size - sizeof(block_header));
+         end = current + block_size - sizeof(block_header);
+      }
+
+      void *ptr = current;
+      current += size;
+      return ptr;
+   }
+
+   /*! \brief                 Allows the memory to be returned by a later allocation
+   *   \param[in]   ptr       Memory returned by allocate()
+   *   \param[in]   size      Size passed to allocate() or less
+   */
+   void deallocate(void* ptr, std::size_t size) {
+      unsigned size_class = align_size(size) / alignment - 1;
+      if (size_class >= num_size_classes)
+         return;
+
+      free_entry *entry = (free_entry*)ptr;
+      entry->next = free_lists[size_class];
+      free_lists[size_class] = entry;
+   }
+
+private:
+   struct alignas(alignment) block_header {
+      block_header *next;
+   };
+
+   struct free_entry {
+      free_entry *next;
+   };
+
+   static constexpr std::size_t align_size(std::size_t size) {
+      return (size + alignment - 1) & ~(alignment - 1);
+   }
+
+   void* add_block(std::size_t size) {
+      block_header *block = (block_header*)calloc(1, sizeof(block_header) + size);
+      if (!block)
+         abort();
+      block->next = blocks;
+      blocks = block;
+      return block + 1;
+   }
+
+   block_header *blocks{ nullptr };   //!> All blocks, most recent first
+   char *current{ nullptr };          //!> Free space of the most recent regular block
+   char *end{ nullptr };
+   free_entry *free_lists[num_size_classes]{};
+};
+
 } // namespace aco
 
 #endif // ACO_UTIL_H
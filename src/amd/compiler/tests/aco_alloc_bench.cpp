@@ -0,0 +1,169 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file aco_alloc_bench.cpp
+ *
+ * Times the instruction allocation pattern of a compile: fill a Program's
+ * blocks with instructions, replace a third of them the way the optimizer
+ * does, then destroy the Program.  "arena" uses create_instruction() and
+ * the Program's arena, "calloc" the one calloc() and free() per
+ * instruction that create_instruction() used before.  Run each mode in its
+ * own process to compare the peak RSS as well.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include "aco_ir.h"
+#include "util/os_time.h"
+
+using namespace aco;
+
+namespace {
+
+constexpr unsigned num_blocks = 2000;
+constexpr unsigned instrs_per_block = 500;
+
+struct free_deleter {
+   void operator()(Instruction *instr) { free(instr); }
+};
+
+template<typename T>
+T *create_instruction_calloc(aco_opcode opcode, Format format,
+                             uint32_t num_operands, uint32_t num_definitions)
+{
+   std::size_t size = sizeof(T) + num_operands * sizeof(Operand) + num_definitions * sizeof(Definition);
+   char *data = (char*) calloc(1, size);
+   T* inst = (T*) data;
+
+   inst->opcode = opcode;
+   inst->format = format;
+
+   uint16_t operands_offset = data + sizeof(T) - (char*)&inst->operands;
+   inst->operands = aco::span<Operand>(operands_offset, num_operands);
+   uint16_t definitions_offset = (char*)inst->operands.end() - (char*)&inst->definitions;
+   inst->definitions = aco::span<Definition>(definitions_offset, num_definitions);
+
+   return inst;
+}
+
+/* A mix of the instruction kinds and sizes that make up most shaders. */
+template<template<typename> class Create>
+Instruction *create_mixed(unsigned i)
+{
+   switch (i % 4) {
+   case 0:
+      return Create<VOP2_instruction>::get(aco_opcode::v_add_f32, Format::VOP2, 2, 1);
+   case 1:
+      return Create<VOP3A_instruction>::get(aco_opcode::v_mad_f32, Format::VOP3A, 3, 1);
+   case 2:
+      return Create<SOP2_instruction>::get(aco_opcode::s_add_u32, Format::SOP2, 2, 2);
+   default:
+      return Create<Pseudo_instruction>::get(aco_opcode::p_create_vector, Format::PSEUDO, 1 + i % 8, 1);
+   }
+}
+
+template<typename T>
+struct create_arena {
+   static T *get(aco_opcode op, Format format, uint32_t ops, uint32_t defs)
+   {
+      return create_instruction<T>(op, format, ops, defs);
+   }
+};
+
+template<typename T>
+struct create_calloc {
+   static T *get(aco_opcode op, Format format, uint32_t ops, uint32_t defs)
+   {
+      return create_instruction_calloc<T>(op, format, ops, defs);
+   }
+};
+
+void
+run_arena()
+{
+   Program program;
+
+   for (unsigned b = 0; b < num_blocks; b++) {
+      Block *block = program.create_and_insert_block();
+      for (unsigned i = 0; i < instrs_per_block; i++)
+         block->instructions.emplace_back(create_mixed<create_arena>(i));
+   }
+
+   for (Block& block : program.blocks) {
+      for (unsigned i = 0; i < block.instructions.size(); i += 3)
+         block.instructions[i].reset(create_mixed<create_arena>(i + 1));
+   }
+}
+
+void
+run_calloc()
+{
+   std::vector<std::vector<std::unique_ptr<Instruction, free_deleter>>> blocks(num_blocks);
+
+   for (auto& block : blocks) {
+      for (unsigned i = 0; i < instrs_per_block; i++)
+         block.emplace_back(create_mixed<create_calloc>(i));
+   }
+
+   for (auto& block : blocks) {
+      for (unsigned i = 0; i < block.size(); i += 3)
+         block[i].reset(create_mixed<create_calloc>(i + 1));
+   }
+}
+
+} /* end namespace */
+
+int
+main(int argc, char **argv)
+{
+   if (argc != 3 || (strcmp(argv[1], "arena") && strcmp(argv[1], "calloc"))) {
+      fprintf(stderr, "usage: %s arena|calloc <iterations>\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   const bool arena = !strcmp(argv[1], "arena");
+   const unsigned iterations = atoi(argv[2]);
+
+   int64_t start = os_time_get_nano();
+   for (unsigned i = 0; i < iterations; i++) {
+      if (arena)
+         run_arena();
+      else
+         run_calloc();
+   }
+   int64_t total_ns = os_time_get_nano() - start;
+
+   struct rusage usage;
+   getrusage(RUSAGE_SELF, &usage);
+
+   printf("%s: %u programs of %u instructions: %.3f ms per program, "
+          "peak RSS %ld KiB\n", argv[1], iterations,
+          num_blocks * instrs_per_block,
+          iterations ? total_ns / 1e6 / iterations : 0.0, usage.ru_maxrss);
+
+   return EXIT_SUCCESS;
+}
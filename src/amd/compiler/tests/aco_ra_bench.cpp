@@ -0,0 +1,208 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file aco_ra_bench.cpp
+ *
+ * Times register allocation of a large generated compute shader: a chain of
+ * blocks of VALU and SALU arithmetic whose operands are picked from the
+ * recently defined temporaries, so that many values stay live across
+ * blocks, with vectors built and split now and then.  Only
+ * register_allocation() is timed; building the program and liveness
+ * analysis are not.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "aco_ir.h"
+#include "util/os_time.h"
+
+using namespace aco;
+
+namespace {
+
+constexpr unsigned num_blocks = 200;
+constexpr unsigned instrs_per_block = 400;
+constexpr unsigned num_live_vgprs = 48;
+constexpr unsigned num_live_sgprs = 16;
+
+struct generator {
+   Program *program;
+   uint32_t seed = 1;
+   std::vector<Temp> vgprs;
+   std::vector<Temp> sgprs;
+   unsigned next_vgpr = 0;
+   unsigned next_sgpr = 0;
+
+   unsigned random(unsigned n)
+   {
+      seed = seed * 1103515245 + 12345;
+      return (seed >> 16) % n;
+   }
+
+   Temp def(std::vector<Temp>& temps, unsigned& next, RegClass rc)
+   {
+      Temp tmp(program->allocateId(), rc);
+      temps[next] = tmp;
+      next = (next + 1) % temps.size();
+      return tmp;
+   }
+
+   void emit(Block *block, unsigned i)
+   {
+      Instruction *instr;
+
+      if (i % 32 == 31) {
+         instr = create_instruction<Pseudo_instruction>(aco_opcode::p_create_vector, Format::PSEUDO, 2, 1);
+         instr->operands[0] = Operand(vgprs[random(vgprs.size())]);
+         instr->operands[1] = Operand(vgprs[random(vgprs.size())]);
+         Temp vec(program->allocateId(), v2);
+         instr->definitions[0] = Definition(vec);
+         block->instructions.emplace_back(instr);
+
+         instr = create_instruction<Pseudo_instruction>(aco_opcode::p_split_vector, Format::PSEUDO, 1, 2);
+         instr->operands[0] = Operand(vec);
+         instr->definitions[0] = Definition(def(vgprs, next_vgpr, v1));
+         instr->definitions[1] = Definition(def(vgprs, next_vgpr, v1));
+      } else if (i % 8 == 7) {
+         instr = create_instruction<SOP2_instruction>(aco_opcode::s_add_u32, Format::SOP2, 2, 2);
+         instr->operands[0] = Operand(sgprs[random(sgprs.size())]);
+         instr->operands[1] = Operand(sgprs[random(sgprs.size())]);
+         instr->definitions[0] = Definition(def(sgprs, next_sgpr, s1));
+         instr->definitions[1] = Definition(program->allocateId(), scc, s1);
+      } else if (i % 4 == 3) {
+         instr = create_instruction<VOP3A_instruction>(aco_opcode::v_mad_f32, Format::VOP3A, 3, 1);
+         instr->operands[0] = Operand(vgprs[random(vgprs.size())]);
+         instr->operands[1] = Operand(sgprs[random(sgprs.size())]);
+         instr->operands[2] = Operand(vgprs[random(vgprs.size())]);
+         instr->definitions[0] = Definition(def(vgprs, next_vgpr, v1));
+      } else {
+         instr = create_instruction<VOP2_instruction>(aco_opcode::v_add_f32, Format::VOP2, 2, 1);
+         instr->operands[0] = Operand(vgprs[random(vgprs.size())]);
+         instr->operands[1] = Operand(vgprs[random(vgprs.size())]);
+         instr->definitions[0] = Definition(def(vgprs, next_vgpr, v1));
+      }
+      block->instructions.emplace_back(instr);
+   }
+
+   void emit_initial_values(Block *block)
+   {
+      for (unsigned i = 0; i < sgprs.size(); i++) {
+         Instruction *instr = create_instruction<SOP1_instruction>(aco_opcode::s_mov_b32, Format::SOP1, 1, 1);
+         instr->operands[0] = Operand(i);
+         instr->definitions[0] = Definition(def(sgprs, next_sgpr, s1));
+         block->instructions.emplace_back(instr);
+      }
+      for (unsigned i = 0; i < vgprs.size(); i++) {
+         Instruction *instr = create_instruction<VOP1_instruction>(aco_opcode::v_mov_b32, Format::VOP1, 1, 1);
+         instr->operands[0] = Operand(i);
+         instr->definitions[0] = Definition(def(vgprs, next_vgpr, v1));
+         block->instructions.emplace_back(instr);
+      }
+   }
+
+   void emit_end(Block *block)
+   {
+      Instruction *instr = create_instruction<SOPP_instruction>(aco_opcode::s_endpgm, Format::SOPP, 0, 0);
+      block->instructions.emplace_back(instr);
+   }
+
+   generator(Program *program) : program(program),
+                                 vgprs(num_live_vgprs),
+                                 sgprs(num_live_sgprs) {}
+};
+
+void
+init_program(Program *program, ac_shader_config *config)
+{
+   program->config = config;
+   program->chip_class = GFX9;
+   program->family = CHIP_VEGA10;
+   program->wave_size = 64;
+   program->lane_mask = s2;
+   program->stage = compute_cs;
+   program->workgroup_size = 64;
+   program->lds_alloc_granule = 512;
+   program->lds_limit = 65536;
+   program->has_16bank_lds = false;
+   program->vgpr_limit = 256;
+   program->vgpr_alloc_granule = 3;
+   program->physical_sgprs = 800;
+   program->sgpr_alloc_granule = 15;
+   program->sgpr_limit = 102;
+
+   calc_min_waves(program);
+   program->vgpr_limit = get_addr_vgpr_from_waves(program, program->min_waves);
+   program->sgpr_limit = get_addr_sgpr_from_waves(program, program->min_waves);
+
+   generator gen(program);
+   for (unsigned b = 0; b < num_blocks; b++) {
+      Block *block = program->create_and_insert_block();
+      block->kind = block_kind_top_level | block_kind_uniform;
+      if (b) {
+         block->logical_preds.push_back(b - 1);
+         block->linear_preds.push_back(b - 1);
+         program->blocks[b - 1].logical_succs.push_back(b);
+         program->blocks[b - 1].linear_succs.push_back(b);
+      } else {
+         gen.emit_initial_values(block);
+      }
+
+      for (unsigned i = 0; i < instrs_per_block; i++)
+         gen.emit(block, i);
+   }
+   gen.emit_end(&program->blocks.back());
+}
+
+} /* end namespace */
+
+int
+main(int argc, char **argv)
+{
+   if (argc != 2) {
+      fprintf(stderr, "usage: %s <iterations>\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   const unsigned iterations = atoi(argv[1]);
+   int64_t total_ns = 0;
+
+   for (unsigned i = 0; i < iterations; i++) {
+      ac_shader_config config = {};
+      Program program;
+      init_program(&program, &config);
+
+      live live_vars = live_var_analysis(&program, NULL);
+
+      int64_t start = os_time_get_nano();
+      register_allocation(&program, live_vars.live_out);
+      total_ns += os_time_get_nano() - start;
+   }
+
+   printf("register allocation of %u instructions: %.3f ms per program\n",
+          num_blocks * instrs_per_block,
+          iterations ? total_ns / 1e6 / iterations : 0.0);
+
+   return EXIT_SUCCESS;
+}
@@ -833,11 +833,9 @@ no_matching_function_error(const char *name,
                            exec_list *actual_parameters,
                            _mesa_glsl_parse_state *state)
 {
-   gl_shader *sh = _mesa_glsl_get_builtin_function_shader();
-
    if (!function_exists(state, state->symbols, name)
        && (!state->uses_builtin_functions
-           || !function_exists(state, sh->symbols, name))) {
+           || !_mesa_glsl_has_builtin_function(state, name))) {
       _mesa_glsl_error(loc, state, "no function with name '%s'", name);
    } else {
       char *str = prototype_string(NULL, name, actual_parameters);
@@ -852,7 +850,7 @@ no_matching_function_error(const char *name,
 
       if (state->uses_builtin_functions) {
          print_function_prototypes(state, loc,
-                                   sh->symbols->get_function(name));
+                                   _mesa_glsl_get_builtin_function(name));
       }
    }
 }
@@ -878,6 +878,7 @@ public:
    void release();
    ir_function_signature *find(_mesa_glsl_parse_state *state,
                                const char *name, exec_list *actual_parameters);
+   ir_function *get_function(const char *name);
 
    /**
     * A shader to hold all the built-in signatures; created by this module.
@@ -895,6 +896,27 @@ private:
    void create_intrinsics();
    void create_builtins();
 
+   /**
+    * Built-in functions are only built the first time a shader looks them
+    * up.  Until then, only their names are known: initialize() runs
+    * create_builtins() to collect them, and build_function() runs it again
+    * to build a single function.
+    */
+   enum {
+      BUILD_ALL,
+      REGISTER_NAMES,
+      BUILD_ONE,
+   } build_mode;
+
+   /** The function build_function() is building */
+   const char *function_to_build;
+
+   /** Names of the functions which weren't built yet */
+   struct hash_table *pending_functions;
+
+   bool should_build(const char *name);
+   void build_function(const char *name);
+
    /**
     * IR builder helpers:
     *
@@ -1266,6 +1288,9 @@ builtin_builder::builtin_builder()
    : shader(NULL)
 {
    mem_ctx = NULL;
+   build_mode = BUILD_ALL;
+   function_to_build = NULL;
+   pending_functions = NULL;
 }
 
 builtin_builder::~builtin_builder()
@@ -1286,7 +1311,7 @@ builtin_builder::find(_mesa_glsl_parse_state *state,
     */
    state->uses_builtin_functions = true;
 
-   ir_function *f = shader->symbols->get_function(name);
+   ir_function *f = get_function(name);
    if (f == NULL)
       return NULL;
 
@@ -1308,9 +1333,57 @@ builtin_builder::initialize()
    glsl_type_singleton_init_or_ref();
 
    mem_ctx = ralloc_context(NULL);
+   pending_functions = _mesa_hash_table_create(mem_ctx, _mesa_hash_string,
+                                               _mesa_key_string_equal);
    create_shader();
    create_intrinsics();
+
+   build_mode = REGISTER_NAMES;
+   create_builtins();
+   build_mode = BUILD_ALL;
+}
+
+/**
+ * Returns the built-in function named \p name, building its signatures if
+ * that wasn't done yet.
+ */
+ir_function *
+builtin_builder::get_function(const char *name)
+{
+   struct hash_entry *entry =
+      _mesa_hash_table_search(pending_functions, name);
+
+   if (entry) {
+      _mesa_hash_table_remove(pending_functions, entry);
+      build_function(name);
+   }
+
+   return shader->symbols->get_function(name);
+}
+
+bool
+builtin_builder::should_build(const char *name)
+{
+   switch (build_mode) {
+   case REGISTER_NAMES:
+      if (!_mesa_hash_table_search(pending_functions, name))
+         _mesa_hash_table_insert(pending_functions, name, NULL);
+      return false;
+   case BUILD_ONE:
+      return strcmp(name, function_to_build) == 0;
+   default:
+      return true;
+   }
+}
+
+void
+builtin_builder::build_function(const char *name)
+{
+   build_mode = BUILD_ONE;
+   function_to_build = name;
    create_builtins();
+   function_to_build = NULL;
+   build_mode = BUILD_ALL;
 }
 
 void
@@ -1318,6 +1391,7 @@ builtin_builder::release()
 {
    ralloc_free(mem_ctx);
    mem_ctx = NULL;
+   pending_functions = NULL;
 
    ralloc_free(shader);
    shader = NULL;
@@ -1554,6 +1628,13 @@ builtin_builder::create_intrinsics()
 void
 builtin_builder::create_builtins()
 {
+   /* Only build what should_build() asks for.  The macro doesn't expand
+    * again inside of its own expansion, which calls the actual method.
+    */
+#define add_function(NAME, ...)                 \
+   if (should_build(NAME))                      \
+      add_function(NAME, __VA_ARGS__)
+
 #define F(NAME)                                 \
    add_function(#NAME,                          \
                 _##NAME(glsl_type::float_type), \
@@ -4557,6 +4638,7 @@ builtin_builder::create_builtins()
 #undef FIUD_VEC
 #undef FIUBD_VEC
 #undef FIU2_MIXED
+#undef add_function
 }
 
 void
@@ -4629,6 +4711,9 @@ builtin_builder::add_image_function(const char *name,
       glsl_type::uimage2DMSArray_type
    };
 
+   if (!should_build(name))
+      return;
+
    ir_function *f = new(mem_ctx) ir_function(name);
 
    for (unsigned i = 0; i < ARRAY_SIZE(types); ++i) {
@@ -7681,7 +7766,7 @@ _mesa_glsl_has_builtin_function(_mesa_glsl_parse_state *state, const char *name)
    ir_function *f;
    bool ret = false;
    mtx_lock(&builtins_lock);
-   f = builtins.shader->symbols->get_function(name);
+   f = builtins.get_function(name);
    if (f != NULL) {
       foreach_in_list(ir_function_signature, sig, &f->signatures) {
          if (sig->is_builtin_available(state)) {
@@ -7695,10 +7780,20 @@ _mesa_glsl_has_builtin_function(_mesa_glsl_parse_state *state, const char *name)
    return ret;
 }
 
-gl_shader *
-_mesa_glsl_get_builtin_function_shader()
+/**
+ * Returns the built-in function called \p name, or NULL.  Its signatures
+ * are built under the lock if they haven't been yet.  They don't change
+ * afterwards, so the caller can walk them without the lock.
+ */
+ir_function *
+_mesa_glsl_get_builtin_function(const char *name)
 {
-   return builtins.shader;
+   ir_function *f;
+   mtx_lock(&builtins_lock);
+   f = builtins.get_function(name);
+   mtx_unlock(&builtins_lock);
+
+   return f;
 }
 
 
@@ -104,6 +104,7 @@ init_fake_gl_context (struct gl_context *gl_ctx)
 {
 	gl_ctx->API = API_OPENGL_COMPAT;
 	gl_ctx->Const.DisableGLSLLineContinuations = false;
+	gl_ctx->Const.DisableGLSLPreprocessorFastPath = false;
 }
 
 static void
@@ -115,16 +116,20 @@ usage (void)
 		 "Pre-process the given filename (stdin if no filename given).\n"
 		 "The following options are supported:\n"
 		 "    --disable-line-continuations      Do not interpret lines ending with a\n"
-		 "                                      backslash ('\\') as a line continuation.\n");
+		 "                                      backslash ('\\') as a line continuation.\n"
+		 "    --disable-fast-path               Always run the full preprocessor, even\n"
+		 "                                      for shaders without macros or conditionals.\n");
 }
 
 enum {
-	DISABLE_LINE_CONTINUATIONS_OPT = CHAR_MAX + 1
+	DISABLE_LINE_CONTINUATIONS_OPT = CHAR_MAX + 1,
+	DISABLE_FAST_PATH_OPT
 };
 
 static const struct option
 long_options[] = {
 	{"disable-line-continuations", no_argument, 0, DISABLE_LINE_CONTINUATIONS_OPT },
+	{"disable-fast-path",          no_argument, 0, DISABLE_FAST_PATH_OPT },
         {"debug",                      no_argument, 0, 'd'},
 	{0,                            0,           0, 0 }
 };
@@ -147,6 +152,9 @@ main (int argc, char *argv[])
 		case DISABLE_LINE_CONTINUATIONS_OPT:
 			gl_ctx.Const.DisableGLSLLineContinuations = true;
 			break;
+		case DISABLE_FAST_PATH_OPT:
+			gl_ctx.Const.DisableGLSLPreprocessorFastPath = true;
+			break;
                 case 'd':
 			glcpp_parser_debug = 1;
 			break;
@@ -221,14 +221,271 @@ remove_line_continuations(glcpp_parser_t *ctx, const char *shader)
 	return sb->buf;
 }
 
+/* Most shaders use no macros or conditionals at all, so all the
+ * preprocessor has to do for them is to print the #version line, pass the
+ * #extension and #pragma directives through, and normalize the whitespace
+ * of everything else the same way as it prints tokens.  The fast path below
+ * does exactly that for such shaders with a single scan of the source,
+ * without creating a parser.  It bails out to the full preprocessor as soon
+ * as it sees anything else: another directive, a comment, a line
+ * continuation, or an identifier that might be a predefined macro, (those
+ * contain "__" or start with "GL_").
+ *
+ * The output is built lazily: until the first place where it differs from
+ * the source, it is the source itself, so a shader that is already in the
+ * form glcpp would print is not copied at all.
+ */
+struct fast_path_output {
+	void *mem_ctx;
+	/* The source up to here is in sb, (or sb is NULL). */
+	const char *flushed;
+	struct _mesa_string_buffer *sb;
+};
+
+static bool
+is_hspace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\v' || c == '\f';
+}
+
+static bool
+is_line_end(char c)
+{
+	return c == '\0' || c == '\r' || c == '\n';
+}
+
+static const char *
+skip_hspace(const char *str)
+{
+	while (is_hspace(*str))
+		str++;
+
+	return str;
+}
+
+/* Output str in place of the source between start and end. */
+static void
+fast_path_replace(struct fast_path_output *out, const char *start,
+		  const char *end, const char *str)
+{
+	size_t len = strlen(str);
+
+	if ((size_t) (end - start) == len && memcmp(start, str, len) == 0)
+		return;
+
+	if (out->sb == NULL) {
+		out->sb = _mesa_string_buffer_create(out->mem_ctx,
+						     INITIAL_PP_OUTPUT_BUF_SIZE);
+	}
+
+	_mesa_string_buffer_append_len(out->sb, out->flushed,
+				       start - out->flushed);
+	_mesa_string_buffer_append_len(out->sb, str, len);
+	out->flushed = end;
+}
+
+/* Handle a line with no directive: leading whitespace and any run of
+ * whitespace become a single space and trailing whitespace is dropped,
+ * (unless the line is nothing but whitespace).
+ *
+ * Returns the end of the line, or NULL if the line needs the full
+ * preprocessor.
+ */
+static const char *
+fast_path_text_line(struct fast_path_output *out, const char *line)
+{
+	const char *str = line;
+
+	while (!is_line_end(*str)) {
+		if (is_hspace(*str)) {
+			const char *space = str;
+
+			str = skip_hspace(str);
+			if (space != line && is_line_end(*str))
+				fast_path_replace(out, space, str, "");
+			else
+				fast_path_replace(out, space, str, " ");
+			continue;
+		}
+
+		switch (*str) {
+		case '#':
+		case '"':
+		case '\\':
+			return NULL;
+		case '/':
+			if (str[1] == '/' || str[1] == '*')
+				return NULL;
+			break;
+		case '_':
+			if (str[1] == '_')
+				return NULL;
+			break;
+		case 'G':
+			if (str[1] == 'L' && str[2] == '_')
+				return NULL;
+			break;
+		}
+
+		str++;
+	}
+
+	return str;
+}
+
+/* Handle a "#version" line at the very start of the shader, which is
+ * printed as "#version <number>[ <identifier>]".
+ */
+static const char *
+fast_path_version_line(struct fast_path_output *out, const char *line)
+{
+	const char *directive = skip_hspace(line + 1);
+	const char *number, *number_end;
+	const char *identifier = NULL, *identifier_end = NULL;
+	const char *str;
+
+	str = directive + strlen("version");
+	if (!is_hspace(*str))
+		return NULL;
+
+	/* Only plain decimal numbers print the same as they are written. */
+	number = skip_hspace(str);
+	if (*number < '1' || *number > '9')
+		return NULL;
+
+	for (number_end = number; isdigit(*number_end); number_end++);
+	if (number_end - number > 9)
+		return NULL;
+
+	str = skip_hspace(number_end);
+	if (str != number_end && (*str == '_' || isalpha(*str))) {
+		identifier = str;
+		for (identifier_end = identifier;
+		     *identifier_end == '_' || isalnum(*identifier_end);
+		     identifier_end++);
+
+		/* "defined" is a token of its own. */
+		if ((size_t) (identifier_end - identifier) == strlen("defined") &&
+		    strncmp(identifier, "defined", strlen("defined")) == 0)
+			return NULL;
+
+		str = skip_hspace(identifier_end);
+	}
+
+	if (!is_line_end(*str))
+		return NULL;
+
+	fast_path_replace(out, line, number, "#version ");
+	if (identifier) {
+		fast_path_replace(out, number_end, identifier, " ");
+		fast_path_replace(out, identifier_end, str, "");
+	} else {
+		fast_path_replace(out, number_end, str, "");
+	}
+
+	return str;
+}
+
+/* Handle the directives the preprocessor leaves alone: #extension and
+ * #pragma lines are printed as they are, (without any whitespace before
+ * or after the '#'), and an empty #pragma or a null directive becomes an
+ * empty line.
+ */
+static const char *
+fast_path_directive_line(struct fast_path_output *out, const char *line,
+			 const char *hash)
+{
+	const char *directive = skip_hspace(hash + 1);
+	const char *end = directive + strcspn(directive, "\r\n\\");
+
+	if (*end == '\\')
+		return NULL;
+
+	fast_path_replace(out, line, hash, "");
+
+	if (directive == end) {
+		fast_path_replace(out, hash, end, "");
+	} else if (strncmp(directive, "pragma", strlen("pragma")) == 0 &&
+		   skip_hspace(directive + strlen("pragma")) == end &&
+		   *end != '\0') {
+		fast_path_replace(out, hash, end, "");
+	} else if (strncmp(directive, "pragma", strlen("pragma")) == 0 ||
+		   strncmp(directive, "extension", strlen("extension")) == 0) {
+		fast_path_replace(out, hash + 1, directive, "");
+	} else {
+		return NULL;
+	}
+
+	return end;
+}
+
+/* Preprocess the shader with the fast path, if it can. */
+static bool
+fast_path_preprocess(void *ralloc_ctx, const char **shader)
+{
+	struct fast_path_output out;
+	const char *source = *shader;
+	const char *line = source, *end;
+
+	out.mem_ctx = ralloc_ctx;
+	out.flushed = source;
+	out.sb = NULL;
+
+	while (true) {
+		const char *str = skip_hspace(line);
+
+		if (*str != '#') {
+			end = fast_path_text_line(&out, line);
+		} else if (str == source &&
+			   strncmp(skip_hspace(str + 1), "version",
+				   strlen("version")) == 0) {
+			end = fast_path_version_line(&out, str);
+		} else {
+			end = fast_path_directive_line(&out, line, str);
+		}
+
+		if (end == NULL) {
+			if (out.sb)
+				_mesa_string_buffer_destroy(out.sb);
+			return false;
+		}
+
+		if (*end == '\0')
+			break;
+
+		line = skip_newline(end);
+		fast_path_replace(&out, end, line, "\n");
+	}
+
+	/* The output always ends with a newline. */
+	if (end != line || end == source)
+		fast_path_replace(&out, end, end, "\n");
+
+	if (out.sb) {
+		_mesa_string_buffer_append(out.sb, out.flushed);
+		_mesa_string_buffer_crimp_to_fit(out.sb);
+
+		ralloc_steal(ralloc_ctx, out.sb->buf);
+		*shader = out.sb->buf;
+		_mesa_string_buffer_destroy(out.sb);
+	}
+
+	return true;
+}
+
 int
 glcpp_preprocess(void *ralloc_ctx, const char **shader, char **info_log,
                  glcpp_extension_iterator extensions, void *state,
                  struct gl_context *gl_ctx)
 {
 	int errors;
-	glcpp_parser_t *parser =
-		glcpp_parser_create(gl_ctx, extensions, state);
+	glcpp_parser_t *parser;
+
+	if (!gl_ctx->Const.DisableGLSLPreprocessorFastPath &&
+	    fast_path_preprocess(ralloc_ctx, shader))
+		return 0;
+
+	parser = glcpp_parser_create(gl_ctx, extensions, state);
 
 	if (! gl_ctx->Const.DisableGLSLLineContinuations)
 		*shader = remove_line_continuations(parser, *shader);
@@ -0,0 +1,11 @@
+#version 130
+#extension GL_ARB_foo : enable
+  #  extension   GL_ARB_bar:require
+#pragma optimize(off)
+#pragma
+#
+void   main()
+{
+	gl_FragColor = vec4(1.0,  0.5e-2, 2u, 0x1F) ;	
+  
+}
@@ -48,6 +48,7 @@ def arg_parser():
     parser.add_argument('--oldmac', action='store_true', help='Run tests for Old Mac (pre-OSX) style newlines')
     parser.add_argument('--bizarro', action='store_true', help='Run tests for Bizarro world style newlines')
     parser.add_argument('--valgrind', action='store_true', help='Run with valgrind for errors')
+    parser.add_argument('--fast-path', action='store_true', help='Compare the fast path with the full preprocessor')
     return parser.parse_args()
 
 
@@ -221,6 +222,68 @@ def test_valgrind(args):
     return total == passed
 
 
+def _run(glcpp, filename, extra_args):
+    with open(filename, 'rb') as f:
+        proc = subprocess.Popen(
+            glcpp + extra_args,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.STDOUT,
+            stdin=subprocess.PIPE)
+        output, _ = proc.communicate(f.read())
+    return proc.returncode, output.decode('utf-8')
+
+
+def test_fast_path(args):
+    """Test that the fast path gives the same results as the full preprocessor,
+    with all styles of new lines."""
+    total = 0
+    passed = 0
+
+    print('============= Testing Fast Path against Full Preprocessor =============')
+    for filename in os.listdir(args.testdir):
+        if not filename.endswith('.c'):
+            continue
+
+        print(   '{}:'.format(os.path.splitext(filename)[0]), end=' ')
+        total += 1
+        testfile = os.path.join(args.testdir, filename)
+        with io.open(testfile, 'rt') as f:
+            contents = f.read()
+
+        diff = []
+        for nl_format in ['\n', '\r\n', '\r', '\n\r']:
+            try:
+                fd, tmpfile = tempfile.mkstemp()
+                os.close(fd)
+                with io.open(tmpfile, 'wt', newline='') as f:
+                    f.write(contents.replace('\n', nl_format))
+                extra_args = parse_test_file(tmpfile, nl_format)
+                fast = _run(args.glcpp, tmpfile, extra_args)
+                full = _run(args.glcpp, tmpfile,
+                            extra_args + ['--disable-fast-path'])
+            finally:
+                os.unlink(tmpfile)
+
+            if fast != full:
+                diff = difflib.unified_diff(fast[1].splitlines(),
+                                            full[1].splitlines())
+                break
+
+        if not diff:
+            passed += 1
+            print('PASS')
+        else:
+            print('FAIL')
+            for l in diff:
+                print(l, file=sys.stderr)
+
+    if not total:
+        raise Exception('Could not find any tests.')
+
+    print('{}/{}'.format(passed, total), 'tests returned correct results')
+    return total == passed
+
+
 def main():
     args = arg_parser()
 
@@ -242,6 +305,8 @@ def main():
             success = success and test_bizarro(args)
         if args.valgrind:
             success = success and test_valgrind(args)
+        if args.fast_path:
+            success = success and test_fast_path(args)
     except OSError as e:
         if e.errno == errno.ENOEXEC:
             print('Skipping due to inability to run host binaries.',
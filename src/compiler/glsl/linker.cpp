@@ -4550,6 +4550,32 @@ linker_optimisation_loop(struct gl_context *ctx, exec_list *ir,
       }
 }
 
+struct link_optimize_state {
+   struct gl_context *ctx;
+   struct gl_linked_shader *shaders[MESA_SHADER_STAGES];
+   unsigned num_stages;
+};
+
+static void
+link_optimize_stage(void *data, unsigned index)
+{
+   struct link_optimize_state *state = (struct link_optimize_state *) data;
+   struct gl_context *ctx = state->ctx;
+   struct gl_linked_shader *shader = state->shaders[index];
+   const unsigned i = shader->Stage;
+
+   /* Call opts before lowering const arrays to uniforms so we can const
+    * propagate any elements accessed directly.
+    */
+   linker_optimisation_loop(ctx, shader->ir, i);
+
+   /* Call opts after lowering const arrays to copy propagate things. */
+   if (ctx->Const.GLSLLowerConstArrays &&
+       lower_const_arrays_to_uniforms(shader->ir, i,
+                                      ctx->Const.Program[i].MaxUniformComponents))
+      linker_optimisation_loop(ctx, shader->ir, i);
+}
+
 void
 link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
 {
@@ -4886,19 +4912,21 @@ link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
          }
       }
 
-      /* Call opts before lowering const arrays to uniforms so we can const
-       * propagate any elements accessed directly.
-       */
-      linker_optimisation_loop(ctx, prog->_LinkedShaders[i]->ir, i);
-
-      /* Call opts after lowering const arrays to copy propagate things. */
-      if (ctx->Const.GLSLLowerConstArrays &&
-          lower_const_arrays_to_uniforms(prog->_LinkedShaders[i]->ir, i,
-                                         ctx->Const.Program[i].MaxUniformComponents))
-         linker_optimisation_loop(ctx, prog->_LinkedShaders[i]->ir, i);
+   }
 
+   /* The stages are optimized independently, in parallel. */
+   struct link_optimize_state optimize_state;
+   optimize_state.ctx = ctx;
+   optimize_state.num_stages = 0;
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      if (prog->_LinkedShaders[i] != NULL)
+         optimize_state.shaders[optimize_state.num_stages++] =
+            prog->_LinkedShaders[i];
    }
 
+   link_util_parallel_for(optimize_state.num_stages, link_optimize_stage,
+                          &optimize_state);
+
    /* Validation for special cases where we allow sampler array indexing
     * with loop induction variable. This check emits a warning or error
     * depending if backend can handle dynamic indexing.
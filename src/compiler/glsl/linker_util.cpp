@@ -27,6 +27,10 @@
 #include "util/bitscan.h"
 #include "util/set.h"
 #include "ir_uniform.h" /* for gl_uniform_storage */
+#include "util/debug.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_queue.h"
+#include "c11/threads.h"
 
 /* Utility methods shared between the GLSL IR and the NIR */
 
@@ -374,3 +378,44 @@ link_util_mark_array_elements_referenced(const struct array_deref_range *dr,
 
    _mark_array_elements_referenced(dr, count, 1, 0, bits);
 }
+
+static struct util_queue link_queue;
+static bool link_queue_initialized;
+static once_flag link_queue_once = ONCE_FLAG_INIT;
+
+static void
+init_link_queue(void)
+{
+   util_cpu_detect();
+
+   /* The calling thread handles one stage itself. */
+   unsigned num_threads =
+      env_var_as_unsigned("MESA_GLSL_LINK_THREADS",
+                          MIN2(util_cpu_caps.nr_cpus, MESA_SHADER_STAGES) - 1);
+
+   if (num_threads > 0) {
+      link_queue_initialized =
+         util_queue_init(&link_queue, "gllink", 2 * MESA_SHADER_STAGES,
+                         num_threads, UTIL_QUEUE_INIT_RESIZE_IF_FULL);
+   }
+}
+
+/**
+ * Calls \p func for every index below \p count, and returns once all calls
+ * returned.
+ *
+ * The calls run in parallel, on a thread pool shared by all contexts, unless
+ * MESA_GLSL_LINK_THREADS is 0.  This is meant for the parts of linking which
+ * each only touch one stage: \p func must not change anything shared with
+ * other indices, and must not report errors through the gl_shader_program.
+ */
+void
+link_util_parallel_for(unsigned count,
+                       void (*func)(void *data, unsigned index), void *data)
+{
+   if (count > 1)
+      call_once(&link_queue_once, init_link_queue);
+
+   util_queue_parallel_for(link_queue_initialized ? &link_queue : NULL,
+                           count, func, data);
+}
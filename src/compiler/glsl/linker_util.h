@@ -105,6 +105,10 @@ link_util_mark_array_elements_referenced(const struct array_deref_range *dr,
                                          unsigned count, unsigned array_depth,
                                          BITSET_WORD *bits);
 
+void
+link_util_parallel_for(unsigned count,
+                       void (*func)(void *data, unsigned index), void *data);
+
 #ifdef __cplusplus
 }
 #endif
@@ -283,14 +283,35 @@ initialize_context(struct gl_context *ctx, gl_api api)
          ctx->Const.Program[MESA_SHADER_GEOMETRY].MaxOutputComponents;
       ctx->Const.Program[MESA_SHADER_FRAGMENT].MaxOutputComponents = 0; /* not used */
 
+      /* Tessellation shaders get the limits of geometry shaders. */
+      for (unsigned i = MESA_SHADER_TESS_CTRL; i <= MESA_SHADER_TESS_EVAL; i++) {
+         ctx->Const.Program[i].MaxTextureImageUnits = 16;
+         ctx->Const.Program[i].MaxUniformComponents = 1024;
+         ctx->Const.Program[i].MaxCombinedUniformComponents = 1024;
+         ctx->Const.Program[i].MaxInputComponents = 128;
+         ctx->Const.Program[i].MaxOutputComponents = 128;
+      }
+
+      for (unsigned i = 0; i < MESA_SHADER_COMPUTE; i++)
+         ctx->Const.Program[i].MaxUniformBlocks = 12;
+      ctx->Const.MaxCombinedUniformBlocks = 60;
+      ctx->Const.MaxUniformBlockSize = 16384;
+
       ctx->Const.MaxCombinedTextureImageUnits =
          ctx->Const.Program[MESA_SHADER_VERTEX].MaxTextureImageUnits
+         + ctx->Const.Program[MESA_SHADER_TESS_CTRL].MaxTextureImageUnits
+         + ctx->Const.Program[MESA_SHADER_TESS_EVAL].MaxTextureImageUnits
          + ctx->Const.Program[MESA_SHADER_GEOMETRY].MaxTextureImageUnits
          + ctx->Const.Program[MESA_SHADER_FRAGMENT].MaxTextureImageUnits;
 
       ctx->Const.MaxGeometryOutputVertices = 256;
       ctx->Const.MaxGeometryTotalOutputComponents = 1024;
 
+      ctx->Const.MaxPatchVertices = 32;
+      ctx->Const.MaxTessGenLevel = 64;
+      ctx->Const.MaxTessPatchComponents = 120;
+      ctx->Const.MaxTessControlTotalOutputComponents = 4096;
+
       ctx->Const.MaxVarying = 60 / 4;
       break;
    case 300:
@@ -610,8 +631,10 @@ extern "C" void
 standalone_compiler_cleanup(struct gl_shader_program *whole_program)
 {
    for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
-      if (whole_program->_LinkedShaders[i])
+      if (whole_program->_LinkedShaders[i]) {
          ralloc_free(whole_program->_LinkedShaders[i]->Program);
+         ralloc_free(whole_program->_LinkedShaders[i]);
+      }
    }
 
    delete whole_program->AttributeBindings;
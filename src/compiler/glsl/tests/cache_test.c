@@ -266,6 +266,11 @@ test_put_and_get(void)
    uint8_t one_KB_key[20], one_MB_key[20];
    int count;
 
+   /* Eviction from the disk is tested here, which the in-memory cache would
+    * hide.
+    */
+   setenv("MESA_GLSL_CACHE_MEMORY_SIZE", "0", 1);
+
    cache = disk_cache_create("test", "make_check", 0);
 
    disk_cache_compute_key(cache, blob, sizeof(blob), blob_key);
@@ -421,6 +426,64 @@ test_put_and_get(void)
    expect_equal(count, 1, "eviction after overflow with MAX_SIZE=1M");
 
    disk_cache_destroy(cache);
+
+   unsetenv("MESA_GLSL_CACHE_MEMORY_SIZE");
+}
+
+static void
+test_memory_cache(void)
+{
+   struct disk_cache *cache, *cache2;
+   char blob[] = "This is a blob of thirty-seven bytes";
+   uint8_t blob_key[20];
+   char blob_key_str[41];
+   char *filename = NULL;
+   char *result;
+   size_t size;
+
+   cache = disk_cache_create("test", "memory_cache", 0);
+
+   disk_cache_compute_key(cache, blob, sizeof(blob), blob_key);
+   disk_cache_put(cache, blob_key, blob, sizeof(blob), NULL);
+   disk_cache_wait_for_idle(cache);
+
+   /* Load the item into the memory of a second cache, and remove it from
+    * the disk behind the back of both caches.
+    */
+   cache2 = disk_cache_create("test", "memory_cache", 0);
+   result = disk_cache_get(cache2, blob_key, &size);
+   expect_equal_str(blob, result, "get of put item from disk");
+   free(result);
+
+   _mesa_sha1_format(blob_key_str, blob_key);
+   if (asprintf(&filename, CACHE_TEST_TMP "/mesa-glsl-cache-dir/"
+                CACHE_DIR_NAME "/%c%c/%s", blob_key_str[0], blob_key_str[1],
+                blob_key_str + 2) != -1) {
+      expect_equal(unlink(filename), 0, "memory cache item on disk");
+      free(filename);
+   }
+
+   result = disk_cache_get(cache, blob_key, &size);
+   expect_equal_str(blob, result, "get of put item from memory (pointer)");
+   expect_equal(size, sizeof(blob), "get of put item from memory (size)");
+   free(result);
+
+   /* Each get returns a copy of its own. */
+   result = disk_cache_get(cache2, blob_key, &size);
+   expect_equal_str(blob, result, "get of loaded item (pointer)");
+   expect_equal(size, sizeof(blob), "get of loaded item (size)");
+   free(result);
+
+   result = disk_cache_get(cache2, blob_key, &size);
+   expect_equal_str(blob, result, "2nd get of loaded item");
+   free(result);
+
+   disk_cache_remove(cache2, blob_key);
+   result = disk_cache_get(cache2, blob_key, &size);
+   expect_null(result, "get of removed item");
+
+   disk_cache_destroy(cache2);
+   disk_cache_destroy(cache);
 }
 
 static void
@@ -474,6 +537,96 @@ test_put_key_and_get_key(void)
 
    disk_cache_destroy(cache);
 }
+static void
+test_single_file(void)
+{
+   struct disk_cache *cache;
+   char blob[] = "This is a blob of thirty-seven bytes";
+   uint8_t blob_key[20];
+   char string[] = "While this string has thirty-four";
+   uint8_t string_key[20];
+   uint8_t *one_KB;
+   uint8_t one_KB_key[20], one_KB_key2[20];
+   char *result;
+   size_t size;
+
+   setenv("MESA_GLSL_CACHE_SINGLE_FILE", "true", 1);
+   setenv("MESA_GLSL_CACHE_MAX_SIZE", "1M", 1);
+   setenv("MESA_GLSL_CACHE_MEMORY_SIZE", "0", 1);
+
+   cache = disk_cache_create("test", "single_file", 0);
+
+   disk_cache_compute_key(cache, blob, sizeof(blob), blob_key);
+   disk_cache_compute_key(cache, string, sizeof(string), string_key);
+
+   result = disk_cache_get(cache, blob_key, &size);
+   expect_null(result, "single file get with non-existent item");
+
+   disk_cache_put(cache, blob_key, blob, sizeof(blob), NULL);
+   disk_cache_put(cache, string_key, string, sizeof(string), NULL);
+
+   /* disk_cache_put() hands things off to a thread so wait for it. */
+   disk_cache_wait_for_idle(cache);
+
+   result = disk_cache_get(cache, blob_key, &size);
+   expect_equal_str(blob, result, "single file get of existing item (pointer)");
+   expect_equal(size, sizeof(blob), "single file get of existing item (size)");
+   free(result);
+
+   /* The entries must still be there once the pack is opened again. */
+   disk_cache_destroy(cache);
+   cache = disk_cache_create("test", "single_file", 0);
+
+   result = disk_cache_get(cache, string_key, &size);
+   expect_equal_str(string, result, "single file get after re-open (pointer)");
+   expect_equal(size, sizeof(string), "single file get after re-open (size)");
+   free(result);
+
+   disk_cache_remove(cache, blob_key);
+   result = disk_cache_get(cache, blob_key, &size);
+   expect_null(result, "single file get of removed item");
+
+   /* Set the cache size to 1KB and add two 1KB items, which don't compress,
+    * to force the first one out of the pack.
+    */
+   disk_cache_destroy(cache);
+
+   setenv("MESA_GLSL_CACHE_MAX_SIZE", "1K", 1);
+   cache = disk_cache_create("test", "single_file", 0);
+
+   one_KB = malloc(1024);
+   for (unsigned i = 0; i < 1024; i++)
+      one_KB[i] = rand();
+
+   disk_cache_compute_key(cache, one_KB, 1024, one_KB_key);
+   disk_cache_put(cache, one_KB_key, one_KB, 1024, NULL);
+   disk_cache_wait_for_idle(cache);
+
+   result = disk_cache_get(cache, one_KB_key, &size);
+   expect_true(result && memcmp(result, one_KB, 1024) == 0,
+               "single file get of 1KB item");
+   free(result);
+
+   one_KB[0]++;
+   disk_cache_compute_key(cache, one_KB, 1024, one_KB_key2);
+   disk_cache_put(cache, one_KB_key2, one_KB, 1024, NULL);
+   disk_cache_wait_for_idle(cache);
+
+   free(one_KB);
+
+   result = disk_cache_get(cache, one_KB_key, &size);
+   expect_null(result, "single file eviction of the oldest item");
+
+   result = disk_cache_get(cache, one_KB_key2, &size);
+   expect_non_null(result, "single file put after eviction");
+   free(result);
+
+   disk_cache_destroy(cache);
+
+   unsetenv("MESA_GLSL_CACHE_SINGLE_FILE");
+   unsetenv("MESA_GLSL_CACHE_MAX_SIZE");
+   unsetenv("MESA_GLSL_CACHE_MEMORY_SIZE");
+}
 #endif /* ENABLE_SHADER_CACHE */
 
 int
@@ -488,6 +641,10 @@ main(void)
 
    test_put_key_and_get_key();
 
+   test_memory_cache();
+
+   test_single_file();
+
    err = rmrf_local(CACHE_TEST_TMP);
    expect_equal(err, 0, "Removing " CACHE_TEST_TMP " again");
 #endif /* ENABLE_SHADER_CACHE */
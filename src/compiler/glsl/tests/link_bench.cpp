@@ -0,0 +1,89 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file link_bench.cpp
+ *
+ * Times compiling and linking a program with all graphics stages, using the
+ * standalone compiler.  Run it with MESA_GLSL_LINK_THREADS=0 as well to
+ * compare with linking every stage on the calling thread.
+ *
+ * The first link is reported on its own, with the peak RSS, since it also
+ * pays for setting up the built-in functions.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include "main/mtypes.h"
+#include "standalone.h"
+#include "util/os_time.h"
+
+int
+main(int argc, char **argv)
+{
+   if (argc < 3) {
+      fprintf(stderr, "usage: %s <iterations> <shader files>...\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   const unsigned iterations = atoi(argv[1]);
+
+   struct standalone_options options;
+   memset(&options, 0, sizeof(options));
+   options.glsl_version = 450;
+   options.do_link = true;
+   options.just_log = true;
+
+   static struct gl_context ctx;
+   int64_t first_ns = 0, total_ns = 0;
+
+   for (unsigned i = 0; i < iterations; i++) {
+      int64_t start = os_time_get_nano();
+      struct gl_shader_program *prog =
+         standalone_compile_shader(&options, argc - 2, &argv[2], &ctx);
+      int64_t ns = os_time_get_nano() - start;
+      if (i == 0)
+         first_ns = ns;
+      total_ns += ns;
+
+      if (!prog || !prog->data->LinkStatus) {
+         fprintf(stderr, "linking failed\n");
+         return EXIT_FAILURE;
+      }
+
+      standalone_compiler_cleanup(prog);
+   }
+
+   struct rusage usage;
+   getrusage(RUSAGE_SELF, &usage);
+
+   printf("%u links of %d shaders: %.3f ms per link, first link %.3f ms, "
+          "peak RSS %ld KiB\n", iterations, argc - 2,
+          iterations ? total_ns / 1e6 / iterations : 0.0, first_ns / 1e6,
+          usage.ru_maxrss);
+
+   return EXIT_SUCCESS;
+}
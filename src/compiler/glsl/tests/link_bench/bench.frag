@@ -0,0 +1,47 @@
+#version 450
+
+in vec3 g_normal;
+in vec4 g_color;
+
+layout(location = 0) out vec4 color;
+
+struct light {
+   vec4 position;
+   vec4 color;
+   vec4 attenuation;
+};
+
+layout(std140, binding = 1) uniform Lights {
+   light lights[32];
+   vec4 eye;
+};
+
+uniform sampler2D albedo;
+uniform sampler2D shadow[4];
+
+vec3 shade(light l, vec3 n)
+{
+   vec3 dir = l.position.xyz - gl_FragCoord.xyz;
+   float dist = length(dir);
+   float att = 1.0 / (l.attenuation.x + l.attenuation.y * dist +
+                      l.attenuation.z * dist * dist);
+   vec3 h = normalize(normalize(dir) + normalize(eye.xyz));
+   float spec = pow(max(dot(n, h), 0.0), l.attenuation.w);
+   return att * (max(dot(n, normalize(dir)), 0.0) + spec) * l.color.rgb;
+}
+
+void main()
+{
+   vec3 n = normalize(g_normal);
+   vec3 lit = vec3(0.0);
+
+   for (int i = 0; i < 32; i++)
+      lit += shade(lights[i], n);
+
+   float visibility = 1.0;
+   for (int i = 0; i < 4; i++)
+      visibility *= texture(shadow[i], gl_FragCoord.xy * float(i + 1)).r;
+
+   color = g_color * texture(albedo, gl_FragCoord.xy) *
+           vec4(lit * visibility, 1.0);
+}
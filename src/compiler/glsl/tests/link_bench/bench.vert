@@ -0,0 +1,37 @@
+#version 450
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec3 normal;
+
+layout(std140, binding = 0) uniform Transforms {
+   mat4 model[16];
+   mat4 view_proj;
+   vec4 weights[16];
+};
+
+out vec3 v_normal;
+out vec4 v_color;
+
+vec4 skin(vec4 p)
+{
+   vec4 result = vec4(0.0);
+   for (int i = 0; i < 16; i++)
+      result += weights[i].x * (model[i] * p);
+   return result;
+}
+
+vec3 skin_normal(vec3 n)
+{
+   vec3 result = vec3(0.0);
+   for (int i = 0; i < 16; i++)
+      result += weights[i].y * (mat3(model[i]) * n);
+   return normalize(result);
+}
+
+void main()
+{
+   vec4 p = skin(position);
+   v_normal = skin_normal(normal);
+   v_color = vec4(abs(v_normal), 1.0);
+   gl_Position = view_proj * p;
+}
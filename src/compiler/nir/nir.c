@@ -67,6 +67,9 @@ nir_shader_create(void *mem_ctx,
    shader->num_uniforms = 0;
    shader->num_shared = 0;
 
+   if (options && options->use_ir_arena)
+      shader->arena = ralloc_arena_create(shader);
+
    return shader;
 }
 
@@ -290,6 +293,8 @@ nir_function_impl_create_bare(nir_shader *shader)
    impl->reg_alloc = 0;
    impl->ssa_alloc = 0;
    impl->valid_metadata = nir_metadata_none;
+   impl->tracked_metadata = nir_metadata_none;
+   memset(&impl->ssa_uses, 0, sizeof(impl->ssa_uses));
 
    /* create start & end blocks */
    nir_block *start_block = nir_block_create(shader);
@@ -321,7 +326,7 @@ nir_function_impl_create(nir_function *function)
 nir_block *
 nir_block_create(nir_shader *shader)
 {
-   nir_block *block = rzalloc(shader, nir_block);
+   nir_block *block = rzalloc_arena(shader->arena, shader, nir_block);
 
    cf_init(&block->cf_node, nir_cf_node_block);
 
@@ -355,7 +360,7 @@ src_init(nir_src *src)
 nir_if *
 nir_if_create(nir_shader *shader)
 {
-   nir_if *if_stmt = ralloc(shader, nir_if);
+   nir_if *if_stmt = ralloc_arena(shader->arena, shader, nir_if);
 
    if_stmt->control = nir_selection_control_none;
 
@@ -378,7 +383,7 @@ nir_if_create(nir_shader *shader)
 nir_loop *
 nir_loop_create(nir_shader *shader)
 {
-   nir_loop *loop = rzalloc(shader, nir_loop);
+   nir_loop *loop = rzalloc_arena(shader->arena, shader, nir_loop);
 
    cf_init(&loop->cf_node, nir_cf_node_loop);
 
@@ -433,8 +438,8 @@ nir_alu_instr_create(nir_shader *shader, nir_op op)
    unsigned num_srcs = nir_op_infos[op].num_inputs;
    /* TODO: don't use rzalloc */
    nir_alu_instr *instr =
-      rzalloc_size(shader,
-                   sizeof(nir_alu_instr) + num_srcs * sizeof(nir_alu_src));
+      rzalloc_arena_size(shader->arena, shader,
+                         sizeof(nir_alu_instr) + num_srcs * sizeof(nir_alu_src));
 
    instr_init(&instr->instr, nir_instr_type_alu);
    instr->op = op;
@@ -449,7 +454,7 @@ nir_deref_instr *
 nir_deref_instr_create(nir_shader *shader, nir_deref_type deref_type)
 {
    nir_deref_instr *instr =
-      rzalloc_size(shader, sizeof(nir_deref_instr));
+      rzalloc_arena(shader->arena, shader, nir_deref_instr);
 
    instr_init(&instr->instr, nir_instr_type_deref);
 
@@ -469,7 +474,7 @@ nir_deref_instr_create(nir_shader *shader, nir_deref_type deref_type)
 nir_jump_instr *
 nir_jump_instr_create(nir_shader *shader, nir_jump_type type)
 {
-   nir_jump_instr *instr = ralloc(shader, nir_jump_instr);
+   nir_jump_instr *instr = ralloc_arena(shader->arena, shader, nir_jump_instr);
    instr_init(&instr->instr, nir_instr_type_jump);
    instr->type = type;
    return instr;
@@ -480,7 +485,8 @@ nir_load_const_instr_create(nir_shader *shader, unsigned num_components,
                             unsigned bit_size)
 {
    nir_load_const_instr *instr =
-      rzalloc_size(shader, sizeof(*instr) + num_components * sizeof(*instr->value));
+      rzalloc_arena_size(shader->arena, shader,
+                         sizeof(*instr) + num_components * sizeof(*instr->value));
    instr_init(&instr->instr, nir_instr_type_load_const);
 
    nir_ssa_def_init(&instr->instr, &instr->def, num_components, bit_size, NULL);
@@ -494,8 +500,8 @@ nir_intrinsic_instr_create(nir_shader *shader, nir_intrinsic_op op)
    unsigned num_srcs = nir_intrinsic_infos[op].num_srcs;
    /* TODO: don't use rzalloc */
    nir_intrinsic_instr *instr =
-      rzalloc_size(shader,
-                  sizeof(nir_intrinsic_instr) + num_srcs * sizeof(nir_src));
+      rzalloc_arena_size(shader->arena, shader,
+                         sizeof(nir_intrinsic_instr) + num_srcs * sizeof(nir_src));
 
    instr_init(&instr->instr, nir_instr_type_intrinsic);
    instr->intrinsic = op;
@@ -514,8 +520,8 @@ nir_call_instr_create(nir_shader *shader, nir_function *callee)
 {
    const unsigned num_params = callee->num_params;
    nir_call_instr *instr =
-      rzalloc_size(shader, sizeof(*instr) +
-                   num_params * sizeof(instr->params[0]));
+      rzalloc_arena_size(shader->arena, shader, sizeof(*instr) +
+                         num_params * sizeof(instr->params[0]));
 
    instr_init(&instr->instr, nir_instr_type_call);
    instr->callee = callee;
@@ -537,13 +543,14 @@ static int8_t default_tg4_offsets[4][2] =
 nir_tex_instr *
 nir_tex_instr_create(nir_shader *shader, unsigned num_srcs)
 {
-   nir_tex_instr *instr = rzalloc(shader, nir_tex_instr);
+   nir_tex_instr *instr = rzalloc_arena(shader->arena, shader, nir_tex_instr);
    instr_init(&instr->instr, nir_instr_type_tex);
 
    dest_init(&instr->dest);
 
    instr->num_srcs = num_srcs;
-   instr->src = ralloc_array(instr, nir_tex_src, num_srcs);
+   instr->src = ralloc_arena_size(shader->arena, instr,
+                                  num_srcs * sizeof(nir_tex_src));
    for (unsigned i = 0; i < num_srcs; i++)
       src_init(&instr->src[i].src);
 
@@ -604,7 +611,7 @@ nir_tex_instr_has_explicit_tg4_offsets(nir_tex_instr *tex)
 nir_phi_instr *
 nir_phi_instr_create(nir_shader *shader)
 {
-   nir_phi_instr *instr = ralloc(shader, nir_phi_instr);
+   nir_phi_instr *instr = ralloc_arena(shader->arena, shader, nir_phi_instr);
    instr_init(&instr->instr, nir_instr_type_phi);
 
    dest_init(&instr->dest);
@@ -615,7 +622,8 @@ nir_phi_instr_create(nir_shader *shader)
 nir_parallel_copy_instr *
 nir_parallel_copy_instr_create(nir_shader *shader)
 {
-   nir_parallel_copy_instr *instr = ralloc(shader, nir_parallel_copy_instr);
+   nir_parallel_copy_instr *instr =
+      ralloc_arena(shader->arena, shader, nir_parallel_copy_instr);
    instr_init(&instr->instr, nir_instr_type_parallel_copy);
 
    exec_list_make_empty(&instr->entries);
@@ -628,7 +636,8 @@ nir_ssa_undef_instr_create(nir_shader *shader,
                            unsigned num_components,
                            unsigned bit_size)
 {
-   nir_ssa_undef_instr *instr = ralloc(shader, nir_ssa_undef_instr);
+   nir_ssa_undef_instr *instr =
+      ralloc_arena(shader->arena, shader, nir_ssa_undef_instr);
    instr_init(&instr->instr, nir_instr_type_ssa_undef);
 
    nir_ssa_def_init(&instr->instr, &instr->def, num_components, bit_size, NULL);
@@ -771,37 +780,235 @@ nir_cursors_equal(nir_cursor a, nir_cursor b)
    return a.block == b.block && a.option == b.option;
 }
 
+/* Returns the impl containing \p node, or NULL if the node isn't part of a
+ * function yet.
+ */
+static nir_function_impl *
+cf_node_get_impl(nir_cf_node *node)
+{
+   while (node && node->type != nir_cf_node_function)
+      node = node->parent;
+
+   return node ? nir_cf_node_as_function(node) : NULL;
+}
+
+static nir_function_impl *
+instr_get_impl(nir_instr *instr)
+{
+   return instr->block ? cf_node_get_impl(&instr->block->cf_node) : NULL;
+}
+
+/* Marks liveness out of date before the SSA uses in \p impl change.  Returns
+ * the use table if it is to be kept up to date along with the use lists.
+ */
+static nir_ssa_use_table *
+ssa_uses_changed(nir_function_impl *impl)
+{
+   if (!impl)
+      return NULL;
+
+   nir_metadata_dirty(impl, nir_metadata_live_ssa_defs);
+   return nir_impl_ssa_use_table(impl);
+}
+
+/* Marks liveness out of date after \p instr moved.  Its sources and defs are
+ * the same, so the use table still holds.
+ */
+static void
+instr_order_changed(nir_instr *instr)
+{
+   nir_function_impl *impl = instr_get_impl(instr);
+
+   if (impl)
+      nir_metadata_dirty(impl, nir_metadata_live_ssa_defs);
+}
+
+static nir_ssa_use_range *
+use_table_get_range(nir_ssa_use_table *table, const nir_ssa_def *def)
+{
+   /* Defs get an index, and a range, once they are in the impl. */
+   return def->index < table->num_defs ? &table->defs[def->index] : NULL;
+}
+
+/* Makes room for \p size more entries at the end of the table.  If there is
+ * none left, this compacts the table, which moves every range.
+ */
+static void
+use_table_reserve(nir_ssa_use_table *table, unsigned size)
+{
+   if (table->num_srcs + size <= table->srcs_size)
+      return;
+
+   unsigned num_srcs = 0;
+   for (unsigned i = 0; i < table->num_defs; i++)
+      num_srcs += table->defs[i].num_uses + table->defs[i].num_if_uses;
+
+   const unsigned srcs_size = MAX2(2 * (num_srcs + size), 64);
+   nir_src **srcs = ralloc_array(ralloc_parent(table->srcs), nir_src *,
+                                 srcs_size);
+
+   /* Stale ranges are copied as well: their uses are still valid pointers,
+    * nir_ssa_def_rewrite_uses() walks them while it rewrites them.
+    */
+   unsigned next = 0;
+   for (unsigned i = 0; i < table->num_defs; i++) {
+      nir_ssa_use_range *range = &table->defs[i];
+      const unsigned count = range->num_uses + range->num_if_uses;
+
+      memcpy(&srcs[next], &table->srcs[range->start], count * sizeof(*srcs));
+      range->start = next;
+      range->size = count;
+      next += count;
+   }
+
+   ralloc_free(table->srcs);
+   table->srcs = srcs;
+   table->srcs_size = srcs_size;
+   table->num_srcs = next;
+}
+
+/* Gives \p range room for \p size uses, at the end of the table unless it
+ * already is there.
+ */
+static void
+use_range_resize(nir_ssa_use_table *table, nir_ssa_use_range *range,
+                 unsigned size)
+{
+   if (range->start + range->size == table->num_srcs) {
+      use_table_reserve(table, size - range->size);
+      if (range->start + range->size == table->num_srcs) {
+         table->num_srcs += size - range->size;
+         range->size = size;
+         return;
+      }
+   }
+
+   use_table_reserve(table, size);
+   memcpy(&table->srcs[table->num_srcs], &table->srcs[range->start],
+          (range->num_uses + range->num_if_uses) * sizeof(*table->srcs));
+   range->start = table->num_srcs;
+   range->size = size;
+   table->num_srcs += size;
+}
+
+/* Adds \p src to the end of the uses or if uses of its def, like the
+ * list_addtail() on the use list.
+ */
+static void
+use_table_add(nir_ssa_use_table *table, nir_src *src, bool if_use)
+{
+   nir_ssa_use_range *range = use_table_get_range(table, src->ssa);
+   if (!range || range->stale)
+      return;
+
+   if (range->num_uses + range->num_if_uses == range->size)
+      use_range_resize(table, range, MAX2(2 * range->size, 4));
+
+   nir_src **srcs = &table->srcs[range->start];
+   if (if_use) {
+      srcs[range->num_uses + range->num_if_uses++] = src;
+   } else {
+      memmove(&srcs[range->num_uses + 1], &srcs[range->num_uses],
+              range->num_if_uses * sizeof(*srcs));
+      srcs[range->num_uses++] = src;
+   }
+}
+
+/* Finding the use in the range would take as long as filling the range in
+ * again, so removing a use only marks it stale.
+ */
+static void
+use_table_remove(nir_ssa_use_table *table, const nir_ssa_def *def)
+{
+   nir_ssa_use_range *range = use_table_get_range(table, def);
+   if (range)
+      range->stale = true;
+}
+
+/* Gives a def which just got an index a range, which is stale since the
+ * def may have uses already.
+ */
+static void
+use_table_add_def(nir_ssa_use_table *table, const nir_ssa_def *def)
+{
+   if (def->index >= table->num_defs) {
+      const unsigned num_defs = MAX2(2 * table->num_defs, def->index + 1);
+
+      table->defs = reralloc(ralloc_parent(table->srcs), table->defs,
+                             nir_ssa_use_range, num_defs);
+      memset(&table->defs[table->num_defs], 0,
+             (num_defs - table->num_defs) * sizeof(*table->defs));
+      table->num_defs = num_defs;
+   }
+
+   table->defs[def->index].stale = true;
+}
+
+/**
+ * Fills the range of \p def in again from its use lists, after uses were
+ * removed.  nir_ssa_use_table_range() calls this as needed.
+ */
+void
+nir_ssa_use_table_update(nir_ssa_use_table *table, const nir_ssa_def *def)
+{
+   nir_ssa_use_range *range = &table->defs[def->index];
+   const unsigned num_uses = list_length(&def->uses);
+   const unsigned num_if_uses = list_length(&def->if_uses);
+
+   range->num_uses = 0;
+   range->num_if_uses = 0;
+   if (num_uses + num_if_uses > range->size)
+      use_range_resize(table, range, num_uses + num_if_uses);
+
+   nir_src **srcs = &table->srcs[range->start];
+   nir_foreach_use(src, def)
+      *srcs++ = src;
+   nir_foreach_if_use(src, def)
+      *srcs++ = src;
+
+   range->num_uses = num_uses;
+   range->num_if_uses = num_if_uses;
+   range->stale = false;
+}
+
+struct add_defs_uses_state {
+   nir_instr *instr;
+   nir_function_impl *impl;
+   nir_ssa_use_table *table;
+};
+
 static bool
-add_use_cb(nir_src *src, void *state)
+add_use_cb(nir_src *src, void *void_state)
 {
-   nir_instr *instr = state;
+   struct add_defs_uses_state *state = void_state;
 
-   src->parent_instr = instr;
+   src->parent_instr = state->instr;
    list_addtail(&src->use_link,
                 src->is_ssa ? &src->ssa->uses : &src->reg.reg->uses);
+   if (src->is_ssa && state->table)
+      use_table_add(state->table, src, false);
 
    return true;
 }
 
 static bool
-add_ssa_def_cb(nir_ssa_def *def, void *state)
+add_ssa_def_cb(nir_ssa_def *def, void *void_state)
 {
-   nir_instr *instr = state;
-
-   if (instr->block && def->index == UINT_MAX) {
-      nir_function_impl *impl =
-         nir_cf_node_get_function(&instr->block->cf_node);
+   struct add_defs_uses_state *state = void_state;
 
-      def->index = impl->ssa_alloc++;
+   if (state->impl && def->index == UINT_MAX) {
+      def->index = state->impl->ssa_alloc++;
+      if (state->table)
+         use_table_add_def(state->table, def);
    }
 
    return true;
 }
 
 static bool
-add_reg_def_cb(nir_dest *dest, void *state)
+add_reg_def_cb(nir_dest *dest, void *void_state)
 {
-   nir_instr *instr = state;
+   nir_instr *instr = ((struct add_defs_uses_state *) void_state)->instr;
 
    if (!dest->is_ssa) {
       dest->reg.parent_instr = instr;
@@ -814,9 +1021,14 @@ add_reg_def_cb(nir_dest *dest, void *state)
 static void
 add_defs_uses(nir_instr *instr)
 {
-   nir_foreach_src(instr, add_use_cb, instr);
-   nir_foreach_dest(instr, add_reg_def_cb, instr);
-   nir_foreach_ssa_def(instr, add_ssa_def_cb, instr);
+   struct add_defs_uses_state state = { .instr = instr };
+
+   state.impl = instr_get_impl(instr);
+   state.table = ssa_uses_changed(state.impl);
+
+   nir_foreach_src(instr, add_use_cb, &state);
+   nir_foreach_dest(instr, add_reg_def_cb, &state);
+   nir_foreach_ssa_def(instr, add_ssa_def_cb, &state);
 }
 
 void
@@ -867,6 +1079,43 @@ nir_instr_insert(nir_cursor cursor, nir_instr *instr)
       nir_handle_add_jump(instr->block);
 }
 
+void
+nir_instr_move(nir_cursor cursor, nir_instr *instr)
+{
+   /* The sources and defs don't change, so unlike nir_instr_remove() and
+    * nir_instr_insert() this leaves the use lists and the use table alone.
+    * Live indices follow instruction order, though, so liveness goes stale
+    * in both impls.
+    */
+   assert(cursor.option == nir_cursor_before_block ||
+          cursor.option == nir_cursor_after_block ||
+          cursor.instr != instr);
+
+   instr_order_changed(instr);
+   exec_node_remove(&instr->node);
+
+   switch (cursor.option) {
+   case nir_cursor_before_block:
+      instr->block = cursor.block;
+      exec_list_push_head(&cursor.block->instr_list, &instr->node);
+      break;
+   case nir_cursor_after_block:
+      instr->block = cursor.block;
+      exec_list_push_tail(&cursor.block->instr_list, &instr->node);
+      break;
+   case nir_cursor_before_instr:
+      instr->block = cursor.instr->block;
+      exec_node_insert_node_before(&cursor.instr->node, &instr->node);
+      break;
+   case nir_cursor_after_instr:
+      instr->block = cursor.instr->block;
+      exec_node_insert_after(&cursor.instr->node, &instr->node);
+      break;
+   }
+
+   instr_order_changed(instr);
+}
+
 static bool
 src_is_valid(const nir_src *src)
 {
@@ -876,10 +1125,13 @@ src_is_valid(const nir_src *src)
 static bool
 remove_use_cb(nir_src *src, void *state)
 {
-   (void) state;
+   nir_ssa_use_table *table = state;
 
-   if (src_is_valid(src))
+   if (src_is_valid(src)) {
       list_del(&src->use_link);
+      if (src->is_ssa && table)
+         use_table_remove(table, src->ssa);
+   }
 
    return true;
 }
@@ -898,8 +1150,10 @@ remove_def_cb(nir_dest *dest, void *state)
 static void
 remove_defs_uses(nir_instr *instr)
 {
+   nir_ssa_use_table *table = ssa_uses_changed(instr_get_impl(instr));
+
    nir_foreach_dest(instr, remove_def_cb, instr);
-   nir_foreach_src(instr, remove_use_cb, instr);
+   nir_foreach_src(instr, remove_use_cb, table);
 }
 
 void nir_instr_remove_v(nir_instr *instr)
@@ -1374,18 +1628,21 @@ nir_src_is_dynamically_uniform(nir_src src)
 }
 
 static void
-src_remove_all_uses(nir_src *src)
+src_remove_all_uses(nir_src *src, nir_ssa_use_table *table)
 {
    for (; src; src = src->is_ssa ? NULL : src->reg.indirect) {
       if (!src_is_valid(src))
          continue;
 
       list_del(&src->use_link);
+      if (src->is_ssa && table)
+         use_table_remove(table, src->ssa);
    }
 }
 
 static void
-src_add_all_uses(nir_src *src, nir_instr *parent_instr, nir_if *parent_if)
+src_add_all_uses(nir_src *src, nir_instr *parent_instr, nir_if *parent_if,
+                 nir_ssa_use_table *table)
 {
    for (; src; src = src->is_ssa ? NULL : src->reg.indirect) {
       if (!src_is_valid(src))
@@ -1405,6 +1662,9 @@ src_add_all_uses(nir_src *src, nir_instr *parent_instr, nir_if *parent_if)
          else
             list_addtail(&src->use_link, &src->reg.reg->if_uses);
       }
+
+      if (src->is_ssa && table)
+         use_table_add(table, src, parent_instr == NULL);
    }
 }
 
@@ -1413,9 +1673,11 @@ nir_instr_rewrite_src(nir_instr *instr, nir_src *src, nir_src new_src)
 {
    assert(!src_is_valid(src) || src->parent_instr == instr);
 
-   src_remove_all_uses(src);
+   nir_ssa_use_table *table = ssa_uses_changed(instr_get_impl(instr));
+
+   src_remove_all_uses(src, table);
    *src = new_src;
-   src_add_all_uses(src, instr, NULL);
+   src_add_all_uses(src, instr, NULL, table);
 }
 
 void
@@ -1423,11 +1685,13 @@ nir_instr_move_src(nir_instr *dest_instr, nir_src *dest, nir_src *src)
 {
    assert(!src_is_valid(dest) || dest->parent_instr == dest_instr);
 
-   src_remove_all_uses(dest);
-   src_remove_all_uses(src);
+   nir_ssa_use_table *table = ssa_uses_changed(instr_get_impl(dest_instr));
+
+   src_remove_all_uses(dest, table);
+   src_remove_all_uses(src, table);
    *dest = *src;
    *src = NIR_SRC_INIT;
-   src_add_all_uses(dest, dest_instr, NULL);
+   src_add_all_uses(dest, dest_instr, NULL, table);
 }
 
 void
@@ -1436,21 +1700,26 @@ nir_if_rewrite_condition(nir_if *if_stmt, nir_src new_src)
    nir_src *src = &if_stmt->condition;
    assert(!src_is_valid(src) || src->parent_if == if_stmt);
 
-   src_remove_all_uses(src);
+   nir_ssa_use_table *table =
+      ssa_uses_changed(cf_node_get_impl(&if_stmt->cf_node));
+
+   src_remove_all_uses(src, table);
    *src = new_src;
-   src_add_all_uses(src, NULL, if_stmt);
+   src_add_all_uses(src, NULL, if_stmt, table);
 }
 
 void
 nir_instr_rewrite_dest(nir_instr *instr, nir_dest *dest, nir_dest new_dest)
 {
+   nir_ssa_use_table *table = ssa_uses_changed(instr_get_impl(instr));
+
    if (dest->is_ssa) {
       /* We can only overwrite an SSA destination if it has no uses. */
       assert(list_is_empty(&dest->ssa.uses) && list_is_empty(&dest->ssa.if_uses));
    } else {
       list_del(&dest->reg.def_link);
       if (dest->reg.indirect)
-         src_remove_all_uses(dest->reg.indirect);
+         src_remove_all_uses(dest->reg.indirect, table);
    }
 
    /* We can't re-write with an SSA def */
@@ -1462,7 +1731,7 @@ nir_instr_rewrite_dest(nir_instr *instr, nir_dest *dest, nir_dest new_dest)
    list_addtail(&dest->reg.def_link, &new_dest.reg.reg->defs);
 
    if (dest->reg.indirect)
-      src_add_all_uses(dest->reg.indirect, instr, NULL);
+      src_add_all_uses(dest->reg.indirect, instr, NULL, table);
 }
 
 /* note: does *not* take ownership of 'name' */
@@ -1484,6 +1753,10 @@ nir_ssa_def_init(nir_instr *instr, nir_ssa_def *def,
          nir_cf_node_get_function(&instr->block->cf_node);
 
       def->index = impl->ssa_alloc++;
+
+      nir_ssa_use_table *table = ssa_uses_changed(impl);
+      if (table)
+         use_table_add_def(table, def);
    } else {
       def->index = UINT_MAX;
    }
@@ -1499,11 +1772,43 @@ nir_ssa_dest_init(nir_instr *instr, nir_dest *dest,
    nir_ssa_def_init(instr, &dest->ssa, num_components, bit_size, name);
 }
 
+/* Returns the use table of the impl \p def is in, if it is kept. */
+static nir_ssa_use_table *
+def_use_table(nir_ssa_def *def)
+{
+   nir_function_impl *impl = instr_get_impl(def->parent_instr);
+   return impl ? nir_impl_ssa_use_table(impl) : NULL;
+}
+
 void
 nir_ssa_def_rewrite_uses(nir_ssa_def *def, nir_src new_src)
 {
    assert(!new_src.is_ssa || def != new_src.ssa);
 
+   nir_ssa_use_table *table = def_use_table(def);
+   if (table) {
+      /* Rewriting a use marks the range of def stale but leaves it as it
+       * is, so walk it in place.  It may move when the range of new_src
+       * does.
+       */
+      const nir_ssa_use_range *range = nir_ssa_use_table_range(table, def);
+      const unsigned num_uses = range->num_uses;
+      const unsigned num_srcs = num_uses + range->num_if_uses;
+
+      for (unsigned i = 0; i < num_srcs; i++) {
+         nir_src *use_src = table->srcs[range->start + i];
+         if (i < num_uses)
+            nir_instr_rewrite_src(use_src->parent_instr, use_src, new_src);
+         else
+            nir_if_rewrite_condition(use_src->parent_if, new_src);
+      }
+
+      /* Nothing uses def any more. */
+      table->defs[def->index] = (nir_ssa_use_range) { .start = range->start,
+                                                      .size = range->size };
+      return;
+   }
+
    nir_foreach_use_safe(use_src, def)
       nir_instr_rewrite_src(use_src->parent_instr, use_src, new_src);
 
@@ -1548,6 +1853,27 @@ nir_ssa_def_rewrite_uses_after(nir_ssa_def *def, nir_src new_src,
    if (new_src.is_ssa && def == new_src.ssa)
       return;
 
+   nir_ssa_use_table *table = def_use_table(def);
+   if (table) {
+      /* See nir_ssa_def_rewrite_uses().  Uses which aren't rewritten stay,
+       * so def keeps a stale range.
+       */
+      const nir_ssa_use_range *range = nir_ssa_use_table_range(table, def);
+      const unsigned num_uses = range->num_uses;
+      const unsigned num_srcs = num_uses + range->num_if_uses;
+
+      for (unsigned i = 0; i < num_srcs; i++) {
+         nir_src *use_src = table->srcs[range->start + i];
+         if (i >= num_uses) {
+            nir_if_rewrite_condition(use_src->parent_if, new_src);
+         } else if (!is_instr_between(def->parent_instr, after_me,
+                                      use_src->parent_instr)) {
+            nir_instr_rewrite_src(use_src->parent_instr, use_src, new_src);
+         }
+      }
+      return;
+   }
+
    nir_foreach_use_safe(use_src, def) {
       assert(use_src->parent_instr != def->parent_instr);
       /* Since def already dominates all of its uses, the only way a use can
@@ -1799,6 +2125,77 @@ nir_index_ssa_defs(nir_function_impl *impl)
    }
 
    impl->ssa_alloc = index;
+   nir_metadata_dirty(impl, nir_metadata_ssa_uses);
+}
+
+static bool
+count_ssa_use_cb(nir_src *src, void *state)
+{
+   nir_ssa_use_range *defs = state;
+
+   if (src->is_ssa)
+      defs[src->ssa->index].size++;
+
+   return true;
+}
+
+static bool
+add_ssa_uses_cb(nir_ssa_def *def, void *state)
+{
+   nir_ssa_use_table *table = state;
+   nir_ssa_use_range *range = &table->defs[def->index];
+   nir_src **srcs = &table->srcs[range->start];
+
+   nir_foreach_use(src, def)
+      srcs[range->num_uses++] = src;
+   nir_foreach_if_use(src, def)
+      srcs[range->num_uses + range->num_if_uses++] = src;
+
+   return true;
+}
+
+/**
+ * Builds nir_function_impl::ssa_uses.  The table is sized by
+ * nir_function_impl::ssa_alloc, so it stays compact after
+ * nir_index_ssa_defs().
+ */
+void
+nir_calc_ssa_use_table_impl(nir_function_impl *impl)
+{
+   nir_ssa_use_table *table = &impl->ssa_uses;
+
+   table->num_defs = impl->ssa_alloc;
+   table->defs = reralloc(impl, table->defs, nir_ssa_use_range,
+                          MAX2(table->num_defs, 1));
+   memset(table->defs, 0, table->num_defs * sizeof(*table->defs));
+
+   /* Count the uses of every def by walking the sources in order, which is
+    * faster than walking the use lists, and lay the ranges out by index.
+    */
+   nir_foreach_block(block, impl) {
+      nir_foreach_instr(instr, block)
+         nir_foreach_src(instr, count_ssa_use_cb, table->defs);
+
+      nir_if *following_if = nir_block_get_following_if(block);
+      if (following_if && following_if->condition.is_ssa)
+         table->defs[following_if->condition.ssa->index].size++;
+   }
+
+   unsigned num_srcs = 0;
+   for (unsigned i = 0; i < table->num_defs; i++) {
+      table->defs[i].start = num_srcs;
+      num_srcs += table->defs[i].size;
+   }
+
+   table->srcs_size = MAX2(num_srcs, 1);
+   table->num_srcs = num_srcs;
+   table->srcs = reralloc(impl, table->srcs, nir_src *, table->srcs_size);
+
+   /* Then fill them in from the use lists, in their order. */
+   nir_foreach_block(block, impl) {
+      nir_foreach_instr(instr, block)
+         nir_foreach_ssa_def(instr, add_ssa_uses_cb, table);
+   }
 }
 
 /**
@@ -1939,6 +2336,10 @@ nir_function_impl_lower_instructions(nir_function_impl *impl,
       list_replace(&old_def->if_uses, &old_if_uses);
       list_inithead(&old_def->if_uses);
 
+      nir_ssa_use_table *table = nir_impl_ssa_use_table(impl);
+      if (table)
+         use_table_remove(table, old_def);
+
       b.cursor = nir_after_instr(instr);
       nir_ssa_def *new_def = lower(&b, instr, cb_data);
       if (new_def && new_def != NIR_LOWER_INSTR_PROGRESS) {
@@ -2700,6 +2700,15 @@ typedef enum {
     */
    nir_metadata_loop_analysis = 0x10,
 
+   /** Indicates that nir_function_impl::ssa_uses is valid
+    *
+    * Unlike other metadata, this is kept up to date by the helpers which add,
+    * remove and rewrite SSA uses once it has been required, until the CFG
+    * changes or the defs are renumbered, see
+    * nir_function_impl::tracked_metadata.  Passes don't need to preserve it.
+    */
+   nir_metadata_ssa_uses = 0x20,
+
    /** All metadata
     *
     * This includes all nir_metadata flags except not_properly_reset.  Passes
@@ -2710,6 +2719,52 @@ typedef enum {
    nir_metadata_all = ~nir_metadata_not_properly_reset,
 } nir_metadata;
 
+/** Where the uses of one SSA def are in a nir_ssa_use_table */
+typedef struct {
+   /** Index of the first use in nir_ssa_use_table::srcs */
+   unsigned start;
+
+   /** Number of uses, followed by num_if_uses if uses */
+   unsigned num_uses;
+   unsigned num_if_uses;
+
+   /** Number of entries of nir_ssa_use_table::srcs reserved from start on */
+   unsigned size;
+
+   /** Uses were removed, so the range needs to be filled in again from the
+    * use lists before it is read
+    */
+   bool stale;
+} nir_ssa_use_range;
+
+/**
+ * The SSA uses of a function, in one array where the uses of every SSA def
+ * are next to each other, in the order of the nir_ssa_def::uses and if_uses
+ * lists.
+ *
+ * It is built with nir_metadata_require(impl, nir_metadata_ssa_uses), and
+ * from then on kept up to date by nir_instr_insert(), nir_instr_remove(),
+ * nir_instr_rewrite_src() and the other helpers changing SSA uses.  Adding
+ * a use appends it to the range of its def, which moves to the end of srcs
+ * when it runs out of room.  Removing one only marks the range stale, and it
+ * is filled in again from the use lists the next time it is read.  When srcs
+ * is full, it is compacted, dropping what was left behind by ranges which
+ * moved.
+ */
+typedef struct {
+   /** Number of ranges, at least nir_function_impl::ssa_alloc */
+   unsigned num_defs;
+
+   /** The range of every SSA def, by index */
+   nir_ssa_use_range *defs;
+
+   /** Number of entries of srcs allocated and in use */
+   unsigned srcs_size;
+   unsigned num_srcs;
+
+   nir_src **srcs;
+} nir_ssa_use_table;
+
 typedef struct {
    nir_cf_node cf_node;
 
@@ -2736,8 +2791,85 @@ typedef struct {
    unsigned num_blocks;
 
    nir_metadata valid_metadata;
+
+   /**
+    * Block indices, dominance, liveness and the use table which are known to
+    * be up to date, because nothing they are computed from changed since
+    * they were.
+    *
+    * Unlike valid_metadata, this doesn't depend on passes telling what they
+    * preserved: the helpers which change the CFG or SSA uses drop what they
+    * invalidate, see nir_metadata_dirty().  This lets nir_metadata_require()
+    * skip recomputing them after passes which call
+    * nir_metadata_preserve(impl, nir_metadata_none) for local edits.
+    * Block indices, dominance and liveness that did go stale are still
+    * recomputed for the whole impl; only the use table is updated in place.
+    */
+   nir_metadata tracked_metadata;
+
+   /** Only valid with nir_metadata_ssa_uses */
+   nir_ssa_use_table ssa_uses;
 } nir_function_impl;
 
+/** Returns nir_function_impl::ssa_uses if it is up to date, NULL otherwise */
+static inline nir_ssa_use_table *
+nir_impl_ssa_use_table(nir_function_impl *impl)
+{
+   return (impl->tracked_metadata & nir_metadata_ssa_uses) ?
+          &impl->ssa_uses : NULL;
+}
+
+void nir_ssa_use_table_update(nir_ssa_use_table *table, const nir_ssa_def *def);
+
+/** Returns the range of the uses of \p def, filling it in if it is stale */
+static inline const nir_ssa_use_range *
+nir_ssa_use_table_range(nir_ssa_use_table *table, const nir_ssa_def *def)
+{
+   assert(def->index < table->num_defs);
+   if (table->defs[def->index].stale)
+      nir_ssa_use_table_update(table, def);
+
+   return &table->defs[def->index];
+}
+
+static inline unsigned
+nir_ssa_use_table_num_uses(nir_ssa_use_table *table, const nir_ssa_def *def)
+{
+   return nir_ssa_use_table_range(table, def)->num_uses;
+}
+
+static inline unsigned
+nir_ssa_use_table_num_if_uses(nir_ssa_use_table *table,
+                              const nir_ssa_def *def)
+{
+   return nir_ssa_use_table_range(table, def)->num_if_uses;
+}
+
+/** Returns the uses of \p def, followed by its if uses */
+static inline nir_src **
+nir_ssa_use_table_srcs(nir_ssa_use_table *table, const nir_ssa_def *def)
+{
+   return &table->srcs[nir_ssa_use_table_range(table, def)->start];
+}
+
+#define nir_foreach_use_in_table_range(src, table, def, first, count)      \
+   for (nir_src **_src_##src = nir_ssa_use_table_srcs(table, def) + (first), \
+        **_end_##src = _src_##src + (count),                                \
+        *src;                                                               \
+        _src_##src < _end_##src && (src = *_src_##src, true);               \
+        _src_##src++)
+
+/** Like nir_foreach_use(), but with the uses of a nir_ssa_use_table */
+#define nir_foreach_use_in_table(src, table, def)                          \
+   nir_foreach_use_in_table_range(src, table, def, 0,                       \
+                                  nir_ssa_use_table_num_uses(table, def))
+
+/** Like nir_foreach_if_use(), but with the uses of a nir_ssa_use_table */
+#define nir_foreach_if_use_in_table(src, table, def)                       \
+   nir_foreach_use_in_table_range(src, table, def,                          \
+                                  nir_ssa_use_table_num_uses(table, def),   \
+                                  nir_ssa_use_table_num_if_uses(table, def))
+
 ATTRIBUTE_RETURNS_NONNULL static inline nir_block *
 nir_start_block(nir_function_impl *impl)
 {
@@ -3167,6 +3299,13 @@ typedef struct nir_shader_compiler_options {
    /** Whether 16-bit ALU is supported. */
    bool support_16bit_alu;
 
+   /**
+    * Carve instructions and control flow nodes out of a per-shader arena
+    * (see ralloc_arena_create()) instead of allocating each of them with
+    * malloc().
+    */
+   bool use_ir_arena;
+
    unsigned max_unroll_iterations;
 
    nir_lower_int64_options lower_int64_options;
@@ -3220,6 +3359,9 @@ typedef struct nir_shader {
     */
    void *constant_data;
    unsigned constant_data_size;
+
+   /** Arena instructions and control flow nodes are allocated from, if any */
+   void *arena;
 } nir_shader;
 
 #define nir_foreach_function(func, shader) \
@@ -3294,6 +3436,13 @@ nir_function_impl *nir_cf_node_get_function(nir_cf_node *node);
 void nir_metadata_require(nir_function_impl *impl, nir_metadata required, ...);
 /** dirties all but the preserved metadata */
 void nir_metadata_preserve(nir_function_impl *impl, nir_metadata preserved);
+
+/** Marks metadata computed from IR which just changed as out of date. */
+static inline void
+nir_metadata_dirty(nir_function_impl *impl, nir_metadata metadata)
+{
+   impl->tracked_metadata = (nir_metadata)(impl->tracked_metadata & ~metadata);
+}
 /** Preserves all metadata for the given shader */
 void nir_shader_preserve_all_metadata(nir_shader *shader);
 
@@ -3552,6 +3701,16 @@ nir_instr_insert_after_cf_list(struct exec_list *list, nir_instr *after)
    nir_instr_insert(nir_after_cf_list(list), after);
 }
 
+/**
+ * Moves an instruction which is already in a block to the given cursor,
+ * keeping its sources and defs as they are.  Unlike editing the instruction
+ * lists by hand, this keeps nir_function_impl::tracked_metadata correct.
+ *
+ * Jumps are moved like any other instruction, without updating the CFG, so
+ * they may only be reordered within their block.
+ */
+void nir_instr_move(nir_cursor cursor, nir_instr *instr);
+
 void nir_instr_remove_v(nir_instr *instr);
 
 static inline nir_cursor
@@ -3691,6 +3850,8 @@ unsigned nir_index_instrs(nir_function_impl *impl);
 
 void nir_index_blocks(nir_function_impl *impl);
 
+void nir_calc_ssa_use_table_impl(nir_function_impl *impl);
+
 void nir_index_vars(nir_shader *shader, nir_function_impl *impl, nir_variable_mode modes);
 
 void nir_print_shader(nir_shader *shader, FILE *fp);
@@ -4609,6 +4770,32 @@ void nir_strip(nir_shader *shader);
 
 void nir_sweep(nir_shader *shader);
 
+/** Steals everything reachable from \p function to \p shader. */
+void nir_sweep_function(nir_shader *shader, nir_function *function);
+
+typedef struct nir_opt_loop_pass {
+   const char *name;
+   bool (*pass)(nir_shader *shader);
+} nir_opt_loop_pass;
+
+typedef struct nir_opt_loop_stats {
+   /** Number of times the pass was run, over all functions */
+   unsigned runs;
+
+   /** Number of runs which made progress */
+   unsigned progress;
+
+   /** Time spent in the pass, summed over all threads */
+   uint64_t time_ns;
+} nir_opt_loop_stats;
+
+struct util_queue;
+
+bool nir_opt_loop(nir_shader **shaders, unsigned num_shaders,
+                  const nir_opt_loop_pass *passes, unsigned num_passes,
+                  unsigned max_iterations, struct util_queue *queue,
+                  nir_opt_loop_stats *stats);
+
 void nir_remap_dual_slot_attributes(nir_shader *shader,
                                     uint64_t *dual_slot_inputs);
 uint64_t nir_get_single_slot_attribs_mask(uint64_t attribs, uint64_t dual_slot);
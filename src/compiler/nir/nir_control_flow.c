@@ -470,6 +470,7 @@ nir_handle_add_jump(nir_block *block)
 
    nir_function_impl *impl = nir_cf_node_get_function(&block->cf_node);
    nir_metadata_preserve(impl, nir_metadata_none);
+   nir_metadata_dirty(impl, nir_metadata_all);
 
    switch (jump_instr->type) {
    case nir_jump_return:
@@ -520,6 +521,7 @@ nir_handle_remove_jump(nir_block *block, nir_jump_type type)
 
    nir_function_impl *impl = nir_cf_node_get_function(&block->cf_node);
    nir_metadata_preserve(impl, nir_metadata_none);
+   nir_metadata_dirty(impl, nir_metadata_all);
 }
 
 static void
@@ -582,6 +584,9 @@ nir_cf_node_insert(nir_cursor cursor, nir_cf_node *node)
 
    split_block_cursor(cursor, &before, &after);
 
+   nir_metadata_dirty(nir_cf_node_get_function(&before->cf_node),
+                      nir_metadata_all);
+
    if (node->type == nir_cf_node_block) {
       nir_block *block = nir_cf_node_as_block(node);
       exec_node_insert_after(&before->cf_node.node, &block->cf_node.node);
@@ -688,6 +693,7 @@ nir_cf_extract(nir_cf_list *extracted, nir_cursor begin, nir_cursor end)
 
    /* Dominance and other block-related information is toast. */
    nir_metadata_preserve(extracted->impl, nir_metadata_none);
+   nir_metadata_dirty(extracted->impl, nir_metadata_all);
 
    nir_cf_node *cf_node = &block_begin->cf_node;
    nir_cf_node *cf_node_end = &block_end->cf_node;
@@ -717,6 +723,9 @@ nir_cf_reinsert(nir_cf_list *cf_list, nir_cursor cursor)
 
    split_block_cursor(cursor, &before, &after);
 
+   nir_metadata_dirty(nir_cf_node_get_function(&before->cf_node),
+                      nir_metadata_all);
+
    foreach_list_typed_safe(nir_cf_node, node, node, &cf_list->list) {
       exec_node_remove(&node->node);
       node->parent = before->cf_node.parent;
@@ -25,15 +25,50 @@
  */
 
 #include "nir.h"
+#include "nir_vla.h"
 
 /*
  * Handles management of the metadata.
  */
 
+/* Metadata which can be tracked, see nir_function_impl::tracked_metadata */
+#define TRACKED_METADATA (nir_metadata_block_index | \
+                          nir_metadata_dominance | \
+                          nir_metadata_live_ssa_defs | \
+                          nir_metadata_ssa_uses)
+
+#ifndef NDEBUG
+static bool
+should_validate_metadata(void)
+{
+   static int should_validate = -1;
+   if (should_validate < 0)
+      should_validate = env_var_as_boolean("NIR_VALIDATE_METADATA", false);
+
+   return should_validate;
+}
+
+static void
+validate_metadata(nir_function_impl *impl, nir_metadata metadata);
+#endif
+
 void
 nir_metadata_require(nir_function_impl *impl, nir_metadata required, ...)
 {
-#define NEEDS_UPDATE(X) ((required & ~impl->valid_metadata) & (X))
+   /* The use table is only ever up to date through tracking, so that passes
+    * which change uses but preserve "everything but" some metadata don't
+    * have to know about it.
+    */
+   nir_metadata valid = (impl->valid_metadata & ~nir_metadata_ssa_uses) |
+                        impl->tracked_metadata;
+
+#define NEEDS_UPDATE(X) ((required & ~valid) & (X))
+
+#ifndef NDEBUG
+   /* Check what isn't recomputed against a full recomputation. */
+   if (should_validate_metadata())
+      validate_metadata(impl, required & valid & TRACKED_METADATA);
+#endif
 
    if (NEEDS_UPDATE(nir_metadata_block_index))
       nir_index_blocks(impl);
@@ -41,6 +76,8 @@ nir_metadata_require(nir_function_impl *impl, nir_metadata required, ...)
       nir_calc_dominance_impl(impl);
    if (NEEDS_UPDATE(nir_metadata_live_ssa_defs))
       nir_live_ssa_defs_impl(impl);
+   if (NEEDS_UPDATE(nir_metadata_ssa_uses))
+      nir_calc_ssa_use_table_impl(impl);
    if (NEEDS_UPDATE(nir_metadata_loop_analysis)) {
       va_list ap;
       va_start(ap, required);
@@ -51,6 +88,7 @@ nir_metadata_require(nir_function_impl *impl, nir_metadata required, ...)
 #undef NEEDS_UPDATE
 
    impl->valid_metadata |= required;
+   impl->tracked_metadata |= required & TRACKED_METADATA;
 }
 
 void
@@ -102,4 +140,212 @@ nir_metadata_check_validation_flag(nir_shader *shader)
       }
    }
 }
+
+static void PRINTFLIKE(2, 3)
+metadata_mismatch(nir_function_impl *impl, const char *format, ...)
+{
+   va_list args;
+
+   fprintf(stderr, "NIR metadata validation failed in function %s: ",
+           impl->function ? impl->function->name : "(unknown)");
+
+   va_start(args, format);
+   vfprintf(stderr, format, args);
+   va_end(args);
+
+   fprintf(stderr, "\n");
+   if (impl->function)
+      nir_print_shader(impl->function->shader, stderr);
+   abort();
+}
+
+static void
+validate_block_index(nir_function_impl *impl)
+{
+   unsigned index = 0;
+
+   nir_foreach_block(block, impl) {
+      if (block->index != index) {
+         metadata_mismatch(impl, "block %u has index %u", index,
+                           block->index);
+      }
+      index++;
+   }
+
+   if (impl->num_blocks != index) {
+      metadata_mismatch(impl, "%u blocks, %u counted", impl->num_blocks,
+                        index);
+   }
+}
+
+static void
+validate_dominance(nir_function_impl *impl)
+{
+   NIR_VLA(nir_block *, imm_dom, impl->num_blocks);
+
+   nir_foreach_block(block, impl)
+      imm_dom[block->index] = block->imm_dom;
+
+   impl->valid_metadata &= ~nir_metadata_dominance;
+   nir_calc_dominance_impl(impl);
+   impl->valid_metadata |= nir_metadata_dominance;
+
+   nir_foreach_block(block, impl) {
+      if (block->imm_dom != imm_dom[block->index]) {
+         metadata_mismatch(impl, "immediate dominator of block %u is %d "
+                           "instead of %d", block->index,
+                           imm_dom[block->index] ?
+                              (int)imm_dom[block->index]->index : -1,
+                           block->imm_dom ? (int)block->imm_dom->index : -1);
+      }
+   }
+}
+
+struct validate_live_index_state {
+   nir_function_impl *impl;
+   unsigned index;
+};
+
+static bool
+validate_live_index(nir_ssa_def *def, void *void_state)
+{
+   struct validate_live_index_state *state = void_state;
+   unsigned index = 0;
+
+   if (def->parent_instr->type != nir_instr_type_ssa_undef)
+      index = state->index++;
+
+   if (def->live_index != index) {
+      metadata_mismatch(state->impl, "ssa_%u has live index %u instead of %u",
+                        def->index, def->live_index, index);
+   }
+
+   return true;
+}
+
+static void
+validate_liveness(nir_function_impl *impl)
+{
+   /* If the SSA defs are those liveness was computed for, they are indexed
+    * the same way liveness indexes them and the live sets have the size the
+    * recomputed ones will have.
+    */
+   struct validate_live_index_state state = { impl, 1 };
+   nir_foreach_block(block, impl) {
+      nir_foreach_instr(instr, block)
+         nir_foreach_ssa_def(instr, validate_live_index, &state);
+   }
+
+   const unsigned words = BITSET_WORDS(state.index);
+   BITSET_WORD *live = ralloc_array(NULL, BITSET_WORD,
+                                    2 * words * impl->num_blocks);
+
+   nir_foreach_block(block, impl) {
+      if (!block->live_in || !block->live_out)
+         metadata_mismatch(impl, "block %u has no live sets", block->index);
+
+      memcpy(&live[2 * words * block->index], block->live_in,
+             words * sizeof(BITSET_WORD));
+      memcpy(&live[(2 * block->index + 1) * words], block->live_out,
+             words * sizeof(BITSET_WORD));
+   }
+
+   nir_live_ssa_defs_impl(impl);
+
+   nir_foreach_block(block, impl) {
+      if (memcmp(&live[2 * words * block->index], block->live_in,
+                 words * sizeof(BITSET_WORD))) {
+         metadata_mismatch(impl, "live in of block %u", block->index);
+      }
+      if (memcmp(&live[(2 * block->index + 1) * words], block->live_out,
+                 words * sizeof(BITSET_WORD))) {
+         metadata_mismatch(impl, "live out of block %u", block->index);
+      }
+   }
+
+   ralloc_free(live);
+}
+
+static void
+validate_use_list(nir_function_impl *impl, nir_ssa_def *def,
+                  struct list_head *uses, nir_src **srcs, unsigned num_srcs,
+                  bool if_uses)
+{
+   unsigned count = 0;
+
+   list_for_each_entry(nir_src, src, uses, use_link) {
+      if (count >= num_srcs || srcs[count] != src) {
+         metadata_mismatch(impl, "%s of ssa_%u differ from the use table",
+                           if_uses ? "if uses" : "uses", def->index);
+      }
+      count++;
+   }
+
+   if (count != num_srcs) {
+      metadata_mismatch(impl, "ssa_%u has %u %s, %u in the use table",
+                        def->index, count, if_uses ? "if uses" : "uses",
+                        num_srcs);
+   }
+}
+
+static bool
+validate_ssa_uses_cb(nir_ssa_def *def, void *state)
+{
+   nir_function_impl *impl = state;
+   nir_ssa_use_table *table = &impl->ssa_uses;
+
+   if (def->index >= table->num_defs)
+      metadata_mismatch(impl, "ssa_%u isn't in the use table", def->index);
+
+   /* Stale ranges are filled in from the lists before they are read. */
+   const nir_ssa_use_range *range = &table->defs[def->index];
+   if (range->stale)
+      return true;
+
+   if (range->start + range->size > table->num_srcs ||
+       range->num_uses + range->num_if_uses > range->size)
+      metadata_mismatch(impl, "ssa_%u has a broken range", def->index);
+
+   nir_src **srcs = &table->srcs[range->start];
+   validate_use_list(impl, def, &def->uses, srcs, range->num_uses, false);
+   validate_use_list(impl, def, &def->if_uses, srcs + range->num_uses,
+                     range->num_if_uses, true);
+
+   return true;
+}
+
+/* The table holds the uses of every def in the order of its lists. */
+static void
+validate_ssa_uses(nir_function_impl *impl)
+{
+   if (impl->ssa_uses.num_defs < impl->ssa_alloc) {
+      metadata_mismatch(impl, "use table has %u defs instead of %u",
+                        impl->ssa_uses.num_defs, impl->ssa_alloc);
+   }
+
+   nir_foreach_block(block, impl) {
+      nir_foreach_instr(instr, block)
+         nir_foreach_ssa_def(instr, validate_ssa_uses_cb, impl);
+   }
+}
+
+/**
+ * Checks metadata which is about to be reused, because a pass preserved it
+ * or because the IR it depends on didn't change, against a recomputation.
+ *
+ * Enabled by NIR_VALIDATE_METADATA.
+ */
+static void
+validate_metadata(nir_function_impl *impl, nir_metadata metadata)
+{
+   /* Dominance and liveness are laid out by block index. */
+   if (metadata & ~nir_metadata_ssa_uses)
+      validate_block_index(impl);
+   if (metadata & nir_metadata_dominance)
+      validate_dominance(impl);
+   if (metadata & nir_metadata_live_ssa_defs)
+      validate_liveness(impl);
+   if (metadata & nir_metadata_ssa_uses)
+      validate_ssa_uses(impl);
+}
 #endif
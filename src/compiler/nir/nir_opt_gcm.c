@@ -644,6 +644,8 @@ opt_gcm_impl(nir_function_impl *impl, bool value_number)
    ralloc_free(state.blocks);
    ralloc_free(state.instr_infos);
 
+   /* Instructions were moved around without nir_instr_insert(). */
+   nir_metadata_dirty(impl, nir_metadata_live_ssa_defs);
    nir_metadata_preserve(impl, nir_metadata_block_index |
                                nir_metadata_dominance);
 
@@ -1290,9 +1290,7 @@ opt_if_merge(nir_if *nif)
                if (instr->type != nir_instr_type_phi)
                   break;
 
-               exec_node_remove(&instr->node);
-               exec_list_push_tail(&next_blk->instr_list, &instr->node);
-               instr->block = next_blk;
+               nir_instr_move(nir_after_block(next_blk), instr);
             }
 
             nir_cf_node_remove(&next_if->cf_node);
@@ -0,0 +1,218 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "nir.h"
+#include "util/os_time.h"
+#include "util/u_queue.h"
+
+/**
+ * \file nir_opt_loop.c
+ *
+ * Runs a list of optimization passes to a fixed point, separately on every
+ * function of one or more shaders.  Functions are independent, so with a
+ * util_queue they are optimized in parallel.
+ *
+ * While it is optimized, each function is moved to a shader of its own,
+ * along with all of its memory.  This way passes running on different
+ * functions never allocate from, or free into, the same ralloc context.
+ * Such a shader shares the options and shader_info of the original shader
+ * but holds no variables and no other functions, so the passes must only
+ * look at and change the function they are given: changes to the shader
+ * itself are lost.  Dead code elimination, copy propagation, CSE, algebraic
+ * optimizations and the like qualify.
+ */
+
+struct opt_loop_job {
+   /** The shader the function belongs to */
+   nir_shader *shader;
+
+   /** The shader the function is moved to while it is optimized */
+   nir_shader *function_shader;
+
+   nir_function *function;
+
+   const nir_opt_loop_pass *passes;
+   unsigned num_passes;
+   unsigned max_iterations;
+
+   /** Statistics for this function only, or NULL */
+   nir_opt_loop_stats *stats;
+
+   bool progress;
+
+   struct util_queue_fence fence;
+};
+
+static void
+opt_loop_execute(void *data, int thread_index)
+{
+   struct opt_loop_job *job = data;
+   nir_shader *shader = job->function_shader;
+   unsigned iterations = 0;
+   bool progress;
+
+   do {
+      progress = false;
+
+      for (unsigned i = 0; i < job->num_passes; i++) {
+         /* Once built, the use table is kept up to date for the walks in
+          * nir_ssa_def_rewrite_uses() and nir_opt_algebraic(), until a pass
+          * changes the CFG.
+          */
+         nir_metadata_require(job->function->impl, nir_metadata_ssa_uses);
+
+         int64_t start = job->stats ? os_time_get_nano() : 0;
+         bool pass_progress = job->passes[i].pass(shader);
+
+         if (job->stats) {
+            job->stats[i].runs++;
+            job->stats[i].progress += pass_progress;
+            job->stats[i].time_ns += os_time_get_nano() - start;
+         }
+
+         progress |= pass_progress;
+      }
+
+      job->progress |= progress;
+   } while (progress && ++iterations < job->max_iterations);
+}
+
+/**
+ * Runs \p passes in order over every function of \p shaders, until none of
+ * them makes progress or \p max_iterations rounds have been run (0 for no
+ * limit).
+ *
+ * Functions are queued to \p queue if it isn't NULL, and are optimized in
+ * the calling thread otherwise.  If \p stats isn't NULL, it must point to
+ * \p num_passes entries, which are added to.
+ *
+ * Returns whether any pass made progress.
+ */
+bool
+nir_opt_loop(nir_shader **shaders, unsigned num_shaders,
+             const nir_opt_loop_pass *passes, unsigned num_passes,
+             unsigned max_iterations, struct util_queue *queue,
+             nir_opt_loop_stats *stats)
+{
+   void *mem_ctx = ralloc_context(NULL);
+   unsigned num_functions = 0, num_jobs = 0;
+   bool progress = false;
+
+   unsigned *shader_num_functions = ralloc_array(mem_ctx, unsigned,
+                                                 num_shaders);
+   for (unsigned s = 0; s < num_shaders; s++) {
+      shader_num_functions[s] = exec_list_length(&shaders[s]->functions);
+      num_functions += shader_num_functions[s];
+   }
+
+   nir_function **functions = ralloc_array(mem_ctx, nir_function *,
+                                           num_functions);
+   struct opt_loop_job *jobs = rzalloc_array(mem_ctx, struct opt_loop_job,
+                                             num_functions);
+   nir_opt_loop_stats *job_stats =
+      stats ? rzalloc_array(mem_ctx, nir_opt_loop_stats,
+                            num_functions * num_passes) : NULL;
+
+   /* Take every function with an impl out of its shader, together with
+    * everything it owns.
+    */
+   unsigned f = 0;
+   for (unsigned s = 0; s < num_shaders; s++) {
+      nir_shader *shader = shaders[s];
+
+      foreach_list_typed_safe(nir_function, function, node,
+                              &shader->functions) {
+         functions[f++] = function;
+
+         if (!function->impl)
+            continue;
+
+         nir_shader *function_shader =
+            nir_shader_create(NULL, shader->info.stage, shader->options,
+                              &shader->info);
+
+         exec_node_remove(&function->node);
+         exec_list_push_tail(&function_shader->functions, &function->node);
+         function->shader = function_shader;
+         nir_sweep_function(function_shader, function);
+
+         struct opt_loop_job *job = &jobs[num_jobs];
+         job->shader = shader;
+         job->function_shader = function_shader;
+         job->function = function;
+         job->passes = passes;
+         job->num_passes = num_passes;
+         job->max_iterations = max_iterations ? max_iterations : UINT_MAX;
+         job->stats = job_stats ? &job_stats[num_jobs * num_passes] : NULL;
+         util_queue_fence_init(&job->fence);
+         num_jobs++;
+      }
+   }
+
+   for (unsigned j = 0; j < num_jobs; j++) {
+      if (queue && num_jobs > 1) {
+         util_queue_add_job(queue, &jobs[j], &jobs[j].fence,
+                            opt_loop_execute, NULL, 0);
+      } else {
+         opt_loop_execute(&jobs[j], 0);
+      }
+   }
+
+   /* Give the functions and their memory back. */
+   for (unsigned j = 0; j < num_jobs; j++) {
+      struct opt_loop_job *job = &jobs[j];
+
+      util_queue_fence_wait(&job->fence);
+      util_queue_fence_destroy(&job->fence);
+
+      exec_node_remove(&job->function->node);
+      job->function->shader = job->shader;
+      ralloc_adopt(job->shader, job->function_shader);
+      ralloc_free(job->function_shader);
+
+      progress |= job->progress;
+
+      if (stats) {
+         for (unsigned i = 0; i < num_passes; i++) {
+            stats[i].runs += job->stats[i].runs;
+            stats[i].progress += job->stats[i].progress;
+            stats[i].time_ns += job->stats[i].time_ns;
+         }
+      }
+   }
+
+   /* Functions without an impl were left in place, put them back in order
+    * as well.
+    */
+   f = 0;
+   for (unsigned s = 0; s < num_shaders; s++) {
+      exec_list_make_empty(&shaders[s]->functions);
+      for (unsigned i = 0; i < shader_num_functions[s]; i++) {
+         exec_list_push_tail(&shaders[s]->functions, &functions[f++]->node);
+      }
+   }
+
+   ralloc_free(mem_ctx);
+
+   return progress;
+}
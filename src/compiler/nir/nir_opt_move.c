@@ -60,12 +60,10 @@ move_source(nir_src *src, nir_block *block, nir_instr *before, nir_move_options
    nir_instr *src_instr = src->ssa->parent_instr;
 
    if (src_instr->block == block && nir_can_move_instr(src_instr, options)) {
-      exec_node_remove(&src_instr->node);
-
       if (before)
-         exec_node_insert_node_before(&before->node, &src_instr->node);
+         nir_instr_move(nir_before_instr(before), src_instr);
       else
-         exec_list_push_tail(&block->instr_list, &src_instr->node);
+         nir_instr_move(nir_after_block(block), src_instr);
 
       return true;
    }
@@ -160,8 +158,7 @@ nir_opt_move(nir_shader *shader, nir_move_options options)
 
       if (impl_progress) {
          nir_metadata_preserve(func->impl, nir_metadata_block_index |
-                                           nir_metadata_dominance |
-                                           nir_metadata_live_ssa_defs);
+                                           nir_metadata_dominance);
          progress = true;
       } else {
          nir_metadata_preserve(func->impl, nir_metadata_all);
@@ -243,17 +243,11 @@ nir_opt_peephole_select_block(nir_block *block, nir_shader *shader,
     * block before.  We have already guaranteed that this is safe by
     * calling block_check_for_allowed_instrs()
     */
-   nir_foreach_instr_safe(instr, then_block) {
-      exec_node_remove(&instr->node);
-      instr->block = prev_block;
-      exec_list_push_tail(&prev_block->instr_list, &instr->node);
-   }
+   nir_foreach_instr_safe(instr, then_block)
+      nir_instr_move(nir_after_block(prev_block), instr);
 
-   nir_foreach_instr_safe(instr, else_block) {
-      exec_node_remove(&instr->node);
-      instr->block = prev_block;
-      exec_list_push_tail(&prev_block->instr_list, &instr->node);
-   }
+   nir_foreach_instr_safe(instr, else_block)
+      nir_instr_move(nir_after_block(prev_block), instr);
 
    nir_foreach_instr_safe(instr, block) {
       if (instr->type != nir_instr_type_phi)
@@ -195,8 +195,7 @@ insert_after_phi(nir_instr *instr, nir_block *block)
       if (instr2->type == nir_instr_type_phi)
          continue;
 
-      exec_node_insert_node_before(&instr2->node,
-                                   &instr->node);
+      nir_instr_move(nir_before_instr(instr2), instr);
 
       return;
    }
@@ -204,7 +203,7 @@ insert_after_phi(nir_instr *instr, nir_block *block)
    /* if haven't inserted it, push to tail (ie. empty block or possibly
     * a block only containing phi's?)
     */
-   exec_list_push_tail(&block->instr_list, &instr->node);
+   nir_instr_move(nir_after_block(block), instr);
 }
 
 bool
@@ -240,12 +239,8 @@ nir_opt_sink(nir_shader *shader, nir_move_options options)
             if (!use_block || use_block == instr->block)
                continue;
 
-            exec_node_remove(&instr->node);
-
             insert_after_phi(instr, use_block);
 
-            instr->block = use_block;
-
             progress = true;
          }
       }
@@ -95,6 +95,11 @@ typedef struct {
    /* Map from nir_instr to nir_schedule_node * */
    struct hash_table *instr_map;
 
+   /* Uses of the SSA defs of the function being scheduled.  Scheduling only
+    * reorders instructions within blocks, so this stays valid throughout.
+    */
+   nir_ssa_use_table *ssa_uses;
+
    /* Set of nir_register * or nir_ssa_def * that have had any instruction
     * scheduled on them.
     */
@@ -287,7 +292,7 @@ nir_schedule_ssa_deps(nir_ssa_def *def, void *in_state)
    struct hash_table *instr_map = state->scoreboard->instr_map;
    nir_schedule_node *def_n = nir_schedule_get_node(instr_map, def->parent_instr);
 
-   nir_foreach_use(src, def) {
+   nir_foreach_use_in_table(src, state->scoreboard->ssa_uses, def) {
       nir_schedule_node *use_n = nir_schedule_get_node(instr_map,
                                                        src->parent_instr);
 
@@ -769,7 +774,7 @@ nir_schedule_mark_src_scheduled(nir_src *src, void *state)
        */
       if (src->is_ssa &&
           src->ssa->parent_instr->type != nir_instr_type_load_const) {
-         nir_foreach_use(other_src, src->ssa) {
+         nir_foreach_use_in_table(other_src, scoreboard->ssa_uses, src->ssa) {
             if (other_src->parent_instr == src->parent_instr)
                continue;
 
@@ -883,8 +888,7 @@ nir_schedule_instructions(nir_schedule_scoreboard *scoreboard, nir_block *block)
       /* Move the instruction to the end (so our first chosen instructions are
        * the start of the program).
        */
-      exec_node_remove(&chosen->instr->node);
-      exec_list_push_tail(&block->instr_list, &chosen->instr->node);
+      nir_instr_move(nir_after_block(block), chosen->instr);
 
       if (debug)
          fprintf(stderr, "\n");
@@ -973,7 +977,7 @@ nir_schedule_ssa_def_init_scoreboard(nir_ssa_def *def, void *state)
 
    _mesa_set_add(def_uses, def->parent_instr);
 
-   nir_foreach_use(src, def) {
+   nir_foreach_use_in_table(src, scoreboard->ssa_uses, def) {
       _mesa_set_add(def_uses, src->parent_instr);
    }
 
@@ -1014,6 +1018,9 @@ nir_schedule_get_scoreboard(nir_shader *shader,
          }
       }
 
+      nir_metadata_require(function->impl, nir_metadata_ssa_uses);
+      scoreboard->ssa_uses = &function->impl->ssa_uses;
+
       nir_foreach_block(block, function->impl) {
          nir_foreach_instr(instr, block) {
             nir_foreach_ssa_def(instr, nir_schedule_ssa_def_init_scoreboard,
@@ -1085,9 +1092,15 @@ nir_schedule(nir_shader *shader,
       if (!function->impl)
          continue;
 
+      nir_metadata_require(function->impl, nir_metadata_ssa_uses);
+      scoreboard->ssa_uses = &function->impl->ssa_uses;
+
       nir_foreach_block(block, function->impl) {
          nir_schedule_block(scoreboard, block);
       }
+
+      nir_metadata_preserve(function->impl, nir_metadata_block_index |
+                                            nir_metadata_dominance);
    }
 
    nir_schedule_validate_uses(scoreboard);
@@ -648,10 +648,17 @@ UNUSED static void dump_value(const nir_search_value *val)
 }
 
 static void
-add_uses_to_worklist(nir_instr *instr, nir_instr_worklist *worklist)
+add_uses_to_worklist(nir_instr *instr, nir_instr_worklist *worklist,
+                     nir_ssa_use_table *uses)
 {
    nir_ssa_def *def = nir_instr_ssa_def(instr);
 
+   if (uses) {
+      nir_foreach_use_in_table(use_src, uses, def)
+         nir_instr_worklist_push_tail(worklist, use_src->parent_instr);
+      return;
+   }
+
    nir_foreach_use_safe(use_src, def) {
       nir_instr_worklist_push_tail(worklist, use_src->parent_instr);
    }
@@ -661,7 +668,8 @@ static void
 nir_algebraic_update_automaton(nir_instr *new_instr,
                                nir_instr_worklist *algebraic_worklist,
                                struct util_dynarray *states,
-                               const struct per_op_table *pass_op_table)
+                               const struct per_op_table *pass_op_table,
+                               nir_ssa_use_table *uses)
 {
 
    nir_instr_worklist *automaton_worklist = nir_instr_worklist_create();
@@ -669,14 +677,14 @@ nir_algebraic_update_automaton(nir_instr *new_instr,
    /* Walk through the tree of uses of our new instruction's SSA value,
     * recursively updating the automaton state until it stabilizes.
     */
-   add_uses_to_worklist(new_instr, automaton_worklist);
+   add_uses_to_worklist(new_instr, automaton_worklist, uses);
 
    nir_instr *instr;
    while ((instr = nir_instr_worklist_pop_head(automaton_worklist))) {
       if (nir_algebraic_automaton(instr, states, pass_op_table)) {
          nir_instr_worklist_push_tail(algebraic_worklist, instr);
 
-         add_uses_to_worklist(instr, automaton_worklist);
+         add_uses_to_worklist(instr, automaton_worklist, uses);
       }
    }
 
@@ -794,7 +802,8 @@ nir_replace_instr(nir_builder *build, nir_alu_instr *instr,
     */
    nir_ssa_def_rewrite_uses(&instr->dest.dest.ssa, nir_src_for_ssa(ssa_val));
    nir_algebraic_update_automaton(ssa_val->parent_instr, algebraic_worklist,
-                                  states, pass_op_table);
+                                  states, pass_op_table,
+                                  nir_impl_ssa_use_table(build->impl));
 
    /* Nothing uses the instr any more, so drop it out of the program.  Note
     * that the instr may be in the worklist still, so we can't free it
@@ -138,10 +138,11 @@ sweep_impl(nir_shader *nir, nir_function_impl *impl)
 
    /* Wipe out all the metadata, if any. */
    nir_metadata_preserve(impl, nir_metadata_none);
+   nir_metadata_dirty(impl, nir_metadata_all);
 }
 
-static void
-sweep_function(nir_shader *nir, nir_function *f)
+void
+nir_sweep_function(nir_shader *nir, nir_function *f)
 {
    ralloc_steal(nir, f);
    ralloc_steal(nir, f->params);
@@ -172,11 +173,18 @@ nir_sweep(nir_shader *nir)
 
    /* Recurse into functions, stealing their contents back. */
    foreach_list_typed(nir_function, func, node, &nir->functions) {
-      sweep_function(nir, func);
+      nir_sweep_function(nir, func);
    }
 
    ralloc_steal(nir, nir->constant_data);
 
+   /* The arena handle is live as well.  Freeing the dead instructions and
+    * control flow nodes carved out of it releases the chunks which no longer
+    * hold anything live.
+    */
+   if (nir->arena)
+      ralloc_steal(nir, nir->arena);
+
    /* Free everything we didn't steal back. */
    ralloc_free(rubbish);
 }
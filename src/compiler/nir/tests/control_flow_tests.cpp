@@ -149,3 +149,85 @@ TEST_F(nir_cf_test, delete_break_in_loop)
 
    nir_metadata_require(b.impl, nir_metadata_dominance);
 }
+
+TEST_F(nir_cf_test, metadata_tracked_across_local_edits)
+{
+   /* Create IR:
+    *
+    * x = load_const
+    * if (x) { y = fneg x } else { }
+    */
+   nir_ssa_def *x = nir_imm_bool(&b, true);
+   nir_push_if(&b, x);
+   nir_fneg(&b, nir_imm_float(&b, 1.0));
+   nir_pop_if(&b, NULL);
+
+   const nir_metadata tracked = (nir_metadata)
+      (nir_metadata_block_index | nir_metadata_dominance |
+       nir_metadata_live_ssa_defs);
+
+   nir_metadata_require(b.impl, tracked);
+   EXPECT_EQ(tracked, b.impl->tracked_metadata);
+
+   /* A pass dropping everything doesn't change the IR the metadata was
+    * computed from.
+    */
+   nir_metadata_preserve(b.impl, nir_metadata_none);
+   EXPECT_EQ(tracked, b.impl->tracked_metadata);
+
+   /* Adding an instruction only changes liveness. */
+   nir_fadd(&b, x, x);
+   EXPECT_EQ(nir_metadata_block_index | nir_metadata_dominance,
+             b.impl->tracked_metadata);
+
+   nir_metadata_require(b.impl, tracked);
+   EXPECT_EQ(tracked, b.impl->tracked_metadata);
+
+   nir_block *start = nir_start_block(b.impl);
+   nir_block *after = nir_cursor_current_block(b.cursor);
+   EXPECT_EQ(start, after->imm_dom);
+   EXPECT_TRUE(BITSET_TEST(after->live_in, x->live_index));
+
+   /* Changing the CFG invalidates everything. */
+   nir_push_if(&b, x);
+   nir_pop_if(&b, NULL);
+   nir_metadata_preserve(b.impl, nir_metadata_none);
+   EXPECT_EQ(nir_metadata_none, b.impl->tracked_metadata);
+
+   nir_metadata_require(b.impl, tracked);
+   EXPECT_EQ(tracked, b.impl->tracked_metadata);
+}
+
+TEST_F(nir_cf_test, metadata_tracked_across_instr_move)
+{
+   /* Create IR:
+    *
+    * x = load_const
+    * y = fadd x, x
+    * z = fmul x, x
+    */
+   nir_ssa_def *x = nir_imm_float(&b, 1.0);
+   nir_ssa_def *y = nir_fadd(&b, x, x);
+   nir_ssa_def *z = nir_fmul(&b, x, x);
+
+   const nir_metadata tracked = (nir_metadata)
+      (nir_metadata_block_index | nir_metadata_dominance |
+       nir_metadata_live_ssa_defs | nir_metadata_ssa_uses);
+
+   nir_metadata_require(b.impl, tracked);
+   EXPECT_LT(y->live_index, z->live_index);
+
+   /* Reordering instructions keeps the CFG and the uses but not the live
+    * indices.
+    */
+   nir_instr_move(nir_before_instr(y->parent_instr), z->parent_instr);
+   nir_metadata_preserve(b.impl, nir_metadata_none);
+   EXPECT_EQ(nir_metadata_block_index | nir_metadata_dominance |
+             nir_metadata_ssa_uses,
+             b.impl->tracked_metadata);
+   EXPECT_EQ(z->parent_instr, nir_instr_prev(y->parent_instr));
+   EXPECT_EQ(nir_start_block(b.impl), z->parent_instr->block);
+
+   nir_metadata_require(b.impl, tracked);
+   EXPECT_LT(z->live_index, y->live_index);
+}
@@ -0,0 +1,222 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file metadata_bench.cpp
+ *
+ * Runs a driver-style optimization loop on a shader with many ifs and
+ * requires block indices, dominance and liveness after every pass, the way
+ * a pass such as nir_opt_gcm() or nir_convert_from_ssa() would.  This is
+ * done once with nir_function_impl::tracked_metadata and once with it
+ * cleared after every pass, which is how nir_metadata_require() behaved
+ * before the tracking.  Reports how often dominance and liveness had to be
+ * recomputed and the time spent in nir_metadata_require() and in the whole
+ * loop.
+ *
+ * Usage: nir_metadata_bench [instructions [rounds]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "nir.h"
+#include "nir_builder.h"
+#include "util/os_time.h"
+
+static bool
+opt_if(nir_shader *shader)
+{
+   return nir_opt_if(shader, false);
+}
+
+static bool
+opt_peephole_select(nir_shader *shader)
+{
+   return nir_opt_peephole_select(shader, 8, true, true);
+}
+
+static const struct {
+   const char *name;
+   bool (*pass)(nir_shader *shader);
+} passes[] = {
+   { "nir_lower_vars_to_ssa", nir_lower_vars_to_ssa },
+   { "nir_copy_prop", nir_copy_prop },
+   { "nir_opt_remove_phis", nir_opt_remove_phis },
+   { "nir_opt_dce", nir_opt_dce },
+   { "nir_opt_if", opt_if },
+   { "nir_opt_dead_cf", nir_opt_dead_cf },
+   { "nir_opt_cse", nir_opt_cse },
+   { "nir_opt_peephole_select", opt_peephole_select },
+   { "nir_opt_algebraic", nir_opt_algebraic },
+   { "nir_opt_constant_folding", nir_opt_constant_folding },
+   { "nir_opt_undef", nir_opt_undef },
+};
+
+static const nir_metadata required = (nir_metadata)
+   (nir_metadata_block_index | nir_metadata_dominance |
+    nir_metadata_live_ssa_defs);
+
+struct result {
+   unsigned dominance, liveness; /* recomputations */
+   double require_ms, total_ms;
+   unsigned num_instrs;
+};
+
+/* A chain of arithmetic with redundant and foldable instructions, and an if
+ * every few steps whose branches both store to a variable that is read
+ * after it, so that nir_lower_vars_to_ssa() leaves phis behind.  The
+ * conditions aren't constant, so most of the ifs stay.
+ */
+static nir_shader *
+build_shader(const nir_shader_compiler_options *options, unsigned num_instrs)
+{
+   nir_builder b;
+   nir_builder_init_simple_shader(&b, NULL, MESA_SHADER_FRAGMENT, options);
+   nir_variable *in =
+      nir_variable_create(b.shader, nir_var_shader_in, glsl_float_type(), "in");
+   nir_variable *tmp =
+      nir_local_variable_create(b.impl, glsl_float_type(), "tmp");
+   nir_variable *out =
+      nir_variable_create(b.shader, nir_var_shader_out, glsl_float_type(),
+                          "out");
+
+   nir_ssa_def *first = nir_load_var(&b, in);
+   nir_ssa_def *v = first;
+
+   for (unsigned i = 0; i < num_instrs / 8; i++) {
+      nir_ssa_def *k = nir_imm_float(&b, i % 13);
+      nir_ssa_def *a = nir_fadd(&b, v, k);
+      nir_ssa_def *c = nir_fadd(&b, v, k);
+      nir_ssa_def *m = nir_fmul(&b, a, nir_imm_float(&b, 1.0));
+      v = nir_fadd(&b, m, c);
+
+      if (i % 8 == 7) {
+         nir_push_if(&b, nir_flt(&b, v, first));
+         nir_store_var(&b, tmp, nir_fadd(&b, v, first), 0x1);
+         nir_push_else(&b, NULL);
+         nir_store_var(&b, tmp, nir_fmul(&b, v, first), 0x1);
+         nir_pop_if(&b, NULL);
+         v = nir_load_var(&b, tmp);
+         nir_store_var(&b, out, v, 0x1);
+      }
+   }
+
+   return b.shader;
+}
+
+static unsigned
+count_instrs(nir_function_impl *impl)
+{
+   unsigned count = 0;
+
+   nir_foreach_block(block, impl) {
+      nir_foreach_instr(instr, block)
+         count++;
+   }
+
+   return count;
+}
+
+static struct result
+optimize(nir_shader *shader, bool tracking)
+{
+   nir_function_impl *impl = nir_shader_get_entrypoint(shader);
+   struct result r = {};
+   int64_t require_ns = 0;
+
+   int64_t start = os_time_get_nano();
+   bool progress;
+   do {
+      progress = false;
+      for (unsigned i = 0; i < ARRAY_SIZE(passes); i++) {
+         progress |= passes[i].pass(shader);
+
+         if (!tracking)
+            nir_metadata_dirty(impl, required);
+
+         unsigned valid = impl->valid_metadata | impl->tracked_metadata;
+         r.dominance += !(valid & nir_metadata_dominance);
+         r.liveness += !(valid & nir_metadata_live_ssa_defs);
+
+         int64_t require_start = os_time_get_nano();
+         nir_metadata_require(impl, required);
+         require_ns += os_time_get_nano() - require_start;
+      }
+   } while (progress);
+
+   r.total_ms = (os_time_get_nano() - start) / 1000000.0;
+   r.require_ms = require_ns / 1000000.0;
+   r.num_instrs = count_instrs(impl);
+
+   return r;
+}
+
+int
+main(int argc, char **argv)
+{
+   unsigned num_instrs = argc > 1 ? atoi(argv[1]) : 20000;
+   unsigned rounds = argc > 2 ? atoi(argv[2]) : 5;
+
+   if (num_instrs < 64 || !rounds) {
+      fprintf(stderr, "usage: %s [instructions [rounds]]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   glsl_type_singleton_init_or_ref();
+
+   nir_shader_compiler_options options = {};
+   nir_shader *shader = build_shader(&options, num_instrs);
+   struct result best[2];
+
+   for (unsigned r = 0; r < rounds; r++) {
+      for (unsigned tracking = 0; tracking < 2; tracking++) {
+         nir_shader *clone = nir_shader_clone(NULL, shader);
+         struct result res = optimize(clone, tracking);
+         ralloc_free(clone);
+
+         if (r == 0 || res.total_ms < best[tracking].total_ms)
+            best[tracking] = res;
+      }
+   }
+
+   if (best[0].num_instrs != best[1].num_instrs) {
+      fprintf(stderr, "the two runs left %u and %u instructions\n",
+              best[0].num_instrs, best[1].num_instrs);
+      return EXIT_FAILURE;
+   }
+
+   printf("%u -> %u instructions, %zu passes per iteration, best of %u\n\n",
+          count_instrs(nir_shader_get_entrypoint(shader)), best[0].num_instrs,
+          ARRAY_SIZE(passes), rounds);
+   printf("%-12s %10s %10s %12s %10s\n", "", "dominance", "liveness",
+          "require ms", "total ms");
+   printf("%-12s %10u %10u %12.1f %10.1f\n", "untracked", best[0].dominance,
+          best[0].liveness, best[0].require_ms, best[0].total_ms);
+   printf("%-12s %10u %10u %12.1f %10.1f\n", "tracked", best[1].dominance,
+          best[1].liveness, best[1].require_ms, best[1].total_ms);
+
+   ralloc_free(shader);
+   glsl_type_singleton_decref();
+
+   return 0;
+}
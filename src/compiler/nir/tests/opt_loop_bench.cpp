@@ -0,0 +1,248 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file opt_loop_bench.cpp
+ *
+ * Times nir_opt_loop() on compute kernels with many functions that were
+ * not inlined, as an OpenCL kernel has before nir_inline_functions(), once
+ * in the calling thread and once with a util_queue.
+ *
+ * The first kernel is made of small functions built the way the shaders of
+ * comparison_pre_tests.cpp and vars_tests.cpp are.  In the second, each
+ * function is a long chain of arithmetic with redundant, foldable and dead
+ * instructions, and an if whose branches repeat work done before it.  The
+ * per-pass counters of the threaded runs are printed as well.
+ *
+ * Usage: nir_opt_loop_bench [functions [instructions [threads]]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "nir.h"
+#include "nir_builder.h"
+#include "util/os_time.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_queue.h"
+
+static const nir_opt_loop_pass passes[] = {
+   { "nir_copy_prop", nir_copy_prop },
+   { "nir_opt_cse", nir_opt_cse },
+   { "nir_opt_algebraic", nir_opt_algebraic },
+   { "nir_opt_constant_folding", nir_opt_constant_folding },
+   { "nir_opt_dce", nir_opt_dce },
+};
+
+static void
+build_function(nir_function *function, unsigned num_instrs)
+{
+   nir_function_impl *impl = nir_function_impl_create(function);
+   nir_builder b;
+
+   nir_builder_init(&b, impl);
+   b.cursor = nir_after_cf_list(&impl->body);
+
+   nir_variable *in = nir_local_variable_create(impl, glsl_float_type(), "in");
+   nir_variable *out =
+      nir_local_variable_create(impl, glsl_float_type(), "out");
+
+   nir_ssa_def *v = nir_load_var(&b, in);
+   nir_ssa_def *first = v;
+
+   /* Each step adds about ten instructions, most of which go away. */
+   for (unsigned i = 0; i < num_instrs / 10; i++) {
+      nir_ssa_def *k = nir_fadd(&b, nir_imm_float(&b, i % 7),
+                                nir_imm_float(&b, 1.0));
+      nir_ssa_def *a = nir_fadd(&b, v, k);
+      nir_ssa_def *c = nir_fadd(&b, v, k);
+      nir_ssa_def *m = nir_fmul(&b, a, nir_imm_float(&b, 1.0));
+      nir_fsub(&b, c, m);
+      v = nir_fadd(&b, m, c);
+
+      if (i % 16 == 15)
+         nir_store_var(&b, out, v, 0x1);
+   }
+
+   nir_push_if(&b, nir_flt(&b, v, first));
+   nir_store_var(&b, out, nir_fadd(&b, first, nir_imm_float(&b, 1.0)), 0x1);
+   nir_push_else(&b, NULL);
+   nir_store_var(&b, out, nir_fmul(&b, first, nir_imm_float(&b, 1.0)), 0x1);
+   nir_pop_if(&b, NULL);
+}
+
+/* A few of the shaders of comparison_pre_tests.cpp and vars_tests.cpp,
+ * each repeated with different constants.
+ */
+static void
+build_test_function(nir_function *function, unsigned seed)
+{
+   nir_function_impl *impl = nir_function_impl_create(function);
+   nir_builder b;
+
+   nir_builder_init(&b, impl);
+   b.cursor = nir_after_cf_list(&impl->body);
+
+   nir_variable *out =
+      nir_local_variable_create(impl, glsl_float_type(), "out");
+   nir_variable *v[2];
+   for (unsigned i = 0; i < ARRAY_SIZE(v); i++) {
+      v[i] = nir_local_variable_create(impl, glsl_vector_type(GLSL_TYPE_INT, 2),
+                                       "v");
+   }
+
+   for (unsigned i = 0; i < 8; i++) {
+      float k = (seed + i) % 5;
+
+      /* comparison_pre_test.a_lt_b_vs_neg_a_plus_b */
+      nir_ssa_def *v1 = nir_imm_vec4(&b, -2.0, -1.0, k, 2.0);
+      nir_ssa_def *v3 = nir_imm_vec4(&b, 3.0, 4.0, 5.0, k);
+      nir_ssa_def *one = nir_imm_float(&b, 1.0f);
+      nir_ssa_def *a = nir_channel(&b, nir_fadd(&b, v1, v3), i % 4);
+
+      nir_push_if(&b, nir_flt(&b, a, one));
+      nir_store_var(&b, out, nir_fadd(&b, nir_fneg(&b, a), one), 0x1);
+      nir_pop_if(&b, NULL);
+
+      /* comparison_pre_test.a_lt_b_vs_a_minus_b */
+      nir_ssa_def *x = nir_channel(&b, nir_fadd(&b, v3, v1), (i + 1) % 4);
+
+      nir_push_if(&b, nir_flt(&b, one, x));
+      nir_store_var(&b, out, nir_fadd(&b, x, nir_fneg(&b, one)), 0x1);
+      nir_pop_if(&b, NULL);
+
+      /* nir_copy_prop_vars_test.simple_store_load_in_two_blocks */
+      nir_store_var(&b, v[0], nir_imm_ivec2(&b, 10, seed + i), 0x3);
+      nir_pop_if(&b, nir_push_if(&b, nir_imm_int(&b, 0)));
+      nir_store_var(&b, v[1], nir_load_var(&b, v[0]), 0x3);
+   }
+}
+
+static unsigned
+count_instrs(nir_shader *shader)
+{
+   unsigned count = 0;
+
+   nir_foreach_function(function, shader) {
+      nir_foreach_block(block, function->impl) {
+         nir_foreach_instr(instr, block)
+            count++;
+      }
+   }
+
+   return count;
+}
+
+static double
+run_ms(nir_shader *kernel, struct util_queue *queue,
+       nir_opt_loop_stats *stats, unsigned *num_instrs)
+{
+   nir_shader *shader = nir_shader_clone(NULL, kernel);
+
+   int64_t start = os_time_get_nano();
+   nir_opt_loop(&shader, 1, passes, ARRAY_SIZE(passes), 0, queue, stats);
+   int64_t ns = os_time_get_nano() - start;
+
+   *num_instrs = count_instrs(shader);
+   ralloc_free(shader);
+
+   return ns / 1000000.0;
+}
+
+static void
+bench(const char *name, nir_shader *kernel, struct util_queue *queue,
+      unsigned num_threads)
+{
+   nir_opt_loop_stats stats[ARRAY_SIZE(passes)] = {};
+   unsigned serial_instrs, threaded_instrs;
+
+   double serial = run_ms(kernel, NULL, NULL, &serial_instrs);
+   double threaded = run_ms(kernel, queue, stats, &threaded_instrs);
+
+   if (serial_instrs != threaded_instrs) {
+      fprintf(stderr, "%s: serial run left %u instructions, threaded run %u\n",
+              name, serial_instrs, threaded_instrs);
+      exit(EXIT_FAILURE);
+   }
+
+   printf("%s: %u functions, %u -> %u instructions\n", name,
+          exec_list_length(&kernel->functions), count_instrs(kernel),
+          serial_instrs);
+   printf("serial:     %8.1f ms\n", serial);
+   printf("%2u threads: %8.1f ms (%.2fx)\n", num_threads, threaded,
+          serial / threaded);
+
+   printf("\n%-26s %8s %8s %10s\n", "pass", "runs", "progress", "ms");
+   for (unsigned i = 0; i < ARRAY_SIZE(passes); i++) {
+      printf("%-26s %8u %8u %10.1f\n", passes[i].name, stats[i].runs,
+             stats[i].progress, stats[i].time_ns / 1000000.0);
+   }
+   printf("\n");
+}
+
+int
+main(int argc, char **argv)
+{
+   unsigned num_functions = argc > 1 ? atoi(argv[1]) : 64;
+   unsigned num_instrs = argc > 2 ? atoi(argv[2]) : 4000;
+   unsigned num_threads;
+
+   util_cpu_detect();
+   num_threads = argc > 3 ? atoi(argv[3]) : util_cpu_caps.nr_cpus;
+
+   if (!num_functions || num_instrs < 10 || !num_threads) {
+      fprintf(stderr, "usage: %s [functions [instructions [threads]]]\n",
+              argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   glsl_type_singleton_init_or_ref();
+
+   nir_shader_compiler_options options = {};
+   nir_shader *tests =
+      nir_shader_create(NULL, MESA_SHADER_KERNEL, &options, NULL);
+   for (unsigned i = 0; i < num_functions * 4; i++)
+      build_test_function(nir_function_create(tests, "func"), i);
+
+   nir_shader *synthetic =
+      nir_shader_create(NULL, MESA_SHADER_KERNEL, &options, NULL);
+   for (unsigned i = 0; i < num_functions; i++)
+      build_function(nir_function_create(synthetic, "func"), num_instrs);
+
+   struct util_queue queue;
+   if (!util_queue_init(&queue, "nir_opt", num_functions * 4, num_threads,
+                        0)) {
+      fprintf(stderr, "failed to start %u threads\n", num_threads);
+      return EXIT_FAILURE;
+   }
+
+   bench("test shaders", tests, &queue, num_threads);
+   bench("synthetic", synthetic, &queue, num_threads);
+
+   util_queue_destroy(&queue);
+   ralloc_free(tests);
+   ralloc_free(synthetic);
+   glsl_type_singleton_decref();
+
+   return 0;
+}
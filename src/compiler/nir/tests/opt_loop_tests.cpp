@@ -0,0 +1,207 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <gtest/gtest.h>
+#include "nir.h"
+#include "nir_builder.h"
+#include "util/u_queue.h"
+
+namespace {
+
+const unsigned num_functions = 8;
+
+const nir_opt_loop_pass passes[] = {
+   { "nir_copy_prop", nir_copy_prop },
+   { "nir_opt_cse", nir_opt_cse },
+   { "nir_opt_algebraic", nir_opt_algebraic },
+   { "nir_opt_constant_folding", nir_opt_constant_folding },
+   { "nir_opt_dce", nir_opt_dce },
+};
+
+class nir_opt_loop_test : public ::testing::Test {
+protected:
+   nir_opt_loop_test();
+   ~nir_opt_loop_test();
+
+   nir_shader *create_shader(gl_shader_stage stage);
+   void build_function(nir_shader *shader, nir_function *function);
+   unsigned count_instrs(nir_shader *shader);
+
+   nir_shader_compiler_options options;
+   void *mem_ctx;
+};
+
+nir_opt_loop_test::nir_opt_loop_test()
+{
+   glsl_type_singleton_init_or_ref();
+
+   memset(&options, 0, sizeof(options));
+   mem_ctx = ralloc_context(NULL);
+}
+
+nir_opt_loop_test::~nir_opt_loop_test()
+{
+   ralloc_free(mem_ctx);
+   glsl_type_singleton_decref();
+}
+
+void
+nir_opt_loop_test::build_function(nir_shader *shader, nir_function *function)
+{
+   nir_function_impl *impl = nir_function_impl_create(function);
+   nir_builder b;
+
+   nir_builder_init(&b, impl);
+   b.cursor = nir_after_cf_list(&impl->body);
+
+   nir_variable *out =
+      nir_local_variable_create(impl, glsl_float_type(), "out");
+
+   /* Redundant and foldable arithmetic, plus dead code. */
+   nir_ssa_def *x = nir_load_var(&b, out);
+   nir_ssa_def *a = nir_fadd(&b, x, nir_imm_float(&b, 1.0));
+   nir_ssa_def *c = nir_fadd(&b, x, nir_imm_float(&b, 1.0));
+   nir_fmul(&b, a, c);
+   nir_ssa_def *d = nir_fmul(&b, c, nir_fadd(&b, nir_imm_float(&b, 2.0),
+                                                 nir_imm_float(&b, 3.0)));
+   nir_store_var(&b, out, nir_fadd(&b, a, d), 0x1);
+}
+
+nir_shader *
+nir_opt_loop_test::create_shader(gl_shader_stage stage)
+{
+   nir_shader *shader = nir_shader_create(mem_ctx, stage, &options, NULL);
+
+   for (unsigned i = 0; i < num_functions; i++) {
+      nir_function *function = nir_function_create(shader, "func");
+
+      /* Leave a few functions without an impl. */
+      if (i % 3 != 2)
+         build_function(shader, function);
+   }
+
+   return shader;
+}
+
+unsigned
+nir_opt_loop_test::count_instrs(nir_shader *shader)
+{
+   unsigned count = 0;
+
+   nir_foreach_function(function, shader) {
+      if (!function->impl)
+         continue;
+
+      nir_foreach_block(block, function->impl) {
+         nir_foreach_instr(instr, block)
+            count++;
+      }
+   }
+
+   return count;
+}
+
+} /* namespace */
+
+TEST_F(nir_opt_loop_test, matches_serial_passes)
+{
+   nir_shader *serial = create_shader(MESA_SHADER_COMPUTE);
+   nir_shader *shader = create_shader(MESA_SHADER_COMPUTE);
+   unsigned initial = count_instrs(shader);
+
+   bool progress;
+   do {
+      progress = false;
+      for (unsigned i = 0; i < ARRAY_SIZE(passes); i++)
+         progress |= passes[i].pass(serial);
+   } while (progress);
+
+   EXPECT_TRUE(nir_opt_loop(&shader, 1, passes, ARRAY_SIZE(passes), 0,
+                            NULL, NULL));
+   nir_validate_shader(shader, "after nir_opt_loop");
+
+   EXPECT_LT(count_instrs(shader), initial);
+   EXPECT_EQ(count_instrs(shader), count_instrs(serial));
+
+   /* A second run has nothing left to do. */
+   EXPECT_FALSE(nir_opt_loop(&shader, 1, passes, ARRAY_SIZE(passes), 0,
+                             NULL, NULL));
+}
+
+TEST_F(nir_opt_loop_test, parallel)
+{
+   nir_shader *serial = create_shader(MESA_SHADER_VERTEX);
+   nir_shader *shaders[] = {
+      create_shader(MESA_SHADER_VERTEX),
+      create_shader(MESA_SHADER_FRAGMENT),
+   };
+
+   nir_function *functions[ARRAY_SIZE(shaders)][num_functions];
+   for (unsigned s = 0; s < ARRAY_SIZE(shaders); s++) {
+      unsigned i = 0;
+      nir_foreach_function(function, shaders[s])
+         functions[s][i++] = function;
+   }
+
+   struct util_queue queue;
+   ASSERT_TRUE(util_queue_init(&queue, "nir_opt", 32, 4, 0));
+
+   nir_opt_loop_stats stats[ARRAY_SIZE(passes)];
+   memset(stats, 0, sizeof(stats));
+
+   EXPECT_TRUE(nir_opt_loop(shaders, ARRAY_SIZE(shaders),
+                            passes, ARRAY_SIZE(passes), 0, &queue, stats));
+   EXPECT_TRUE(nir_opt_loop(&serial, 1, passes, ARRAY_SIZE(passes), 0,
+                            NULL, NULL));
+
+   util_queue_destroy(&queue);
+
+   for (unsigned s = 0; s < ARRAY_SIZE(shaders); s++) {
+      nir_validate_shader(shaders[s], "after nir_opt_loop");
+      EXPECT_EQ(count_instrs(shaders[s]), count_instrs(serial));
+
+      /* The functions are back in their shader, in order. */
+      unsigned i = 0;
+      nir_foreach_function(function, shaders[s]) {
+         ASSERT_LT(i, num_functions);
+         EXPECT_EQ(function, functions[s][i++]);
+         EXPECT_EQ(function->shader, shaders[s]);
+      }
+      EXPECT_EQ(i, num_functions);
+   }
+
+   /* Every pass ran at least twice on each impl: once making progress, and
+    * once more to find that there was nothing left to do.
+    */
+   unsigned num_impls = 0;
+   nir_foreach_function(function, shaders[0])
+      num_impls += function->impl != NULL;
+
+   for (unsigned i = 0; i < ARRAY_SIZE(passes); i++)
+      EXPECT_GE(stats[i].runs, 2 * num_impls * ARRAY_SIZE(shaders));
+   EXPECT_GT(stats[1].progress, 0);
+
+   /* The memory of the functions went back to the shaders. */
+   nir_sweep(shaders[0]);
+   ralloc_free(shaders[0]);
+   nir_validate_shader(shaders[1], "after freeing another shader");
+}
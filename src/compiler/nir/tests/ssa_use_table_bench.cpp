@@ -0,0 +1,322 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file ssa_use_table_bench.cpp
+ *
+ * Builds a large shader and runs the usual optimization loop on it, once
+ * with the use lists only and once keeping nir_function_impl::ssa_uses up
+ * to date, which nir_ssa_def_rewrite_uses() and nir_opt_algebraic() then
+ * walk instead of the lists.  Then walks the uses of every SSA def, the way
+ * nir_schedule does, first through the use lists and then through the
+ * table.  Reports the wall time of each, and the cache misses where perf
+ * events are available.
+ *
+ * Usage: nir_ssa_use_table_bench [instructions [rounds]]
+ */
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "nir.h"
+#include "nir_builder.h"
+#include "util/os_time.h"
+
+struct measurement {
+   double ms;
+   int64_t cache_misses; /* -1 if not available */
+};
+
+struct counter {
+   int fd;
+   int64_t start;
+};
+
+static int
+open_cache_misses(void)
+{
+#ifdef __linux__
+   struct perf_event_attr attr;
+
+   memset(&attr, 0, sizeof(attr));
+   attr.size = sizeof(attr);
+   attr.type = PERF_TYPE_HARDWARE;
+   attr.config = PERF_COUNT_HW_CACHE_MISSES;
+   attr.disabled = 1;
+   attr.exclude_kernel = 1;
+   attr.exclude_hv = 1;
+
+   return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+   return -1;
+#endif
+}
+
+static void
+counter_start(struct counter *c, int fd)
+{
+   c->fd = fd;
+#ifdef __linux__
+   if (fd >= 0) {
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+   }
+#endif
+   c->start = os_time_get_nano();
+}
+
+static struct measurement
+counter_stop(const struct counter *c)
+{
+   struct measurement m;
+
+   m.ms = (os_time_get_nano() - c->start) / 1000000.0;
+   m.cache_misses = -1;
+#ifdef __linux__
+   if (c->fd >= 0) {
+      uint64_t count;
+      ioctl(c->fd, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(c->fd, &count, sizeof(count)) == sizeof(count))
+         m.cache_misses = count;
+   }
+#endif
+
+   return m;
+}
+
+static void
+print(const char *what, struct measurement m)
+{
+   if (m.cache_misses >= 0) {
+      printf("%-20s %10.1f ms %12" PRId64 " cache misses\n", what, m.ms,
+             m.cache_misses);
+   } else {
+      printf("%-20s %10.1f ms          n/a cache misses\n", what, m.ms);
+   }
+}
+
+/* A chain of arithmetic, with redundant, foldable and dead instructions for
+ * the optimization loop to remove, defs that are used several times, and
+ * ifs so that there are if uses as well.
+ */
+static nir_shader *
+build_shader(const nir_shader_compiler_options *options, unsigned num_instrs)
+{
+   nir_builder b;
+   nir_builder_init_simple_shader(&b, NULL, MESA_SHADER_COMPUTE, options);
+   nir_variable *in =
+      nir_local_variable_create(b.impl, glsl_float_type(), "in");
+   nir_variable *out =
+      nir_local_variable_create(b.impl, glsl_float_type(), "out");
+
+   nir_ssa_def *first = nir_load_var(&b, in);
+   nir_ssa_def *recent[8];
+   for (unsigned i = 0; i < ARRAY_SIZE(recent); i++)
+      recent[i] = first;
+
+   nir_ssa_def *v = first;
+   for (unsigned i = 0; i < num_instrs / 8; i++) {
+      nir_ssa_def *k = nir_imm_float(&b, i % 13);
+      nir_ssa_def *a = nir_fadd(&b, v, k);
+      nir_ssa_def *c = nir_fadd(&b, v, k);
+      nir_ssa_def *m = nir_fmul(&b, a, nir_imm_float(&b, 1.0));
+      nir_ssa_def *w = nir_fmul(&b, m, recent[i % ARRAY_SIZE(recent)]);
+      v = nir_fadd(&b, w, c);
+      recent[i % ARRAY_SIZE(recent)] = v;
+
+      if (i % 16 == 15)
+         nir_store_var(&b, out, v, 0x1);
+
+      if (i % 64 == 63) {
+         nir_push_if(&b, nir_flt(&b, v, first));
+         nir_store_var(&b, out, recent[0], 0x1);
+         nir_push_else(&b, NULL);
+         nir_store_var(&b, out, recent[1], 0x1);
+         nir_pop_if(&b, NULL);
+      }
+   }
+
+   return b.shader;
+}
+
+static unsigned
+count_instrs(nir_function_impl *impl)
+{
+   unsigned count = 0;
+
+   nir_foreach_block(block, impl) {
+      nir_foreach_instr(instr, block)
+         count++;
+   }
+
+   return count;
+}
+
+static struct measurement
+optimize(nir_shader *shader, bool use_table, int fd)
+{
+   nir_function_impl *impl = nir_shader_get_entrypoint(shader);
+   struct counter c;
+
+   counter_start(&c, fd);
+   bool progress;
+   do {
+      progress = false;
+      if (use_table)
+         nir_metadata_require(impl, nir_metadata_ssa_uses);
+      progress |= nir_copy_prop(shader);
+      progress |= nir_opt_cse(shader);
+      progress |= nir_opt_algebraic(shader);
+      progress |= nir_opt_constant_folding(shader);
+      progress |= nir_opt_dce(shader);
+   } while (progress);
+
+   return counter_stop(&c);
+}
+
+static bool
+add_def(nir_ssa_def *def, void *state)
+{
+   std::vector<nir_ssa_def *> *defs = (std::vector<nir_ssa_def *> *) state;
+   defs->push_back(def);
+   return true;
+}
+
+static uintptr_t
+walk_lists(const std::vector<nir_ssa_def *> &defs)
+{
+   uintptr_t sum = 0;
+
+   for (nir_ssa_def *def : defs) {
+      nir_foreach_use(src, def)
+         sum += (uintptr_t) src->parent_instr;
+      nir_foreach_if_use(src, def)
+         sum += (uintptr_t) src->parent_if;
+   }
+
+   return sum;
+}
+
+static uintptr_t
+walk_table(nir_ssa_use_table *table,
+           const std::vector<nir_ssa_def *> &defs)
+{
+   uintptr_t sum = 0;
+
+   for (nir_ssa_def *def : defs) {
+      nir_foreach_use_in_table(src, table, def)
+         sum += (uintptr_t) src->parent_instr;
+      nir_foreach_if_use_in_table(src, table, def)
+         sum += (uintptr_t) src->parent_if;
+   }
+
+   return sum;
+}
+
+int
+main(int argc, char **argv)
+{
+   unsigned num_instrs = argc > 1 ? atoi(argv[1]) : 100000;
+   unsigned rounds = argc > 2 ? atoi(argv[2]) : 20;
+
+   if (num_instrs < 8 || !rounds) {
+      fprintf(stderr, "usage: %s [instructions [rounds]]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   glsl_type_singleton_init_or_ref();
+
+   nir_shader_compiler_options options = {};
+   nir_shader *shader = build_shader(&options, num_instrs);
+   nir_shader *tracked = nir_shader_clone(NULL, shader);
+   nir_function_impl *impl = nir_shader_get_entrypoint(shader);
+   int fd = open_cache_misses();
+   struct counter c;
+
+   printf("optimization loop:\n");
+   print("use lists", optimize(shader, false, fd));
+   print("use table", optimize(tracked, true, fd));
+
+   if (count_instrs(impl) !=
+       count_instrs(nir_shader_get_entrypoint(tracked))) {
+      fprintf(stderr, "the optimization loop gave different results\n");
+      return EXIT_FAILURE;
+   }
+   ralloc_free(tracked);
+
+   std::vector<nir_ssa_def *> defs;
+   nir_foreach_block(block, impl) {
+      nir_foreach_instr(instr, block)
+         nir_foreach_ssa_def(instr, add_def, &defs);
+   }
+   printf("%zu defs left\n\n", defs.size());
+
+   uintptr_t list_sum = 0, table_sum = 0;
+
+   counter_start(&c, fd);
+   for (unsigned r = 0; r < rounds; r++)
+      list_sum += walk_lists(defs);
+   struct measurement lists = counter_stop(&c);
+
+   counter_start(&c, fd);
+   nir_metadata_dirty(impl, nir_metadata_ssa_uses);
+   nir_metadata_require(impl, nir_metadata_ssa_uses);
+   struct measurement build = counter_stop(&c);
+
+   counter_start(&c, fd);
+   for (unsigned r = 0; r < rounds; r++)
+      table_sum += walk_table(&impl->ssa_uses, defs);
+   struct measurement table = counter_stop(&c);
+
+   if (list_sum != table_sum) {
+      fprintf(stderr, "the use lists and the use table differ\n");
+      return EXIT_FAILURE;
+   }
+
+   printf("%u rounds over all uses:\n", rounds);
+   print("use lists", lists);
+   print("use table", table);
+   print("building the table", build);
+   printf("%.2fx faster with the table, %.2fx with the time to build it\n",
+          lists.ms / table.ms, lists.ms / (table.ms + build.ms));
+
+#ifdef __linux__
+   if (fd >= 0)
+      close(fd);
+#endif
+   ralloc_free(shader);
+   glsl_type_singleton_decref();
+
+   return 0;
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <gtest/gtest.h>
+#include "nir.h"
+#include "nir_builder.h"
+
+class nir_ssa_use_table_test : public ::testing::Test {
+protected:
+   nir_ssa_use_table_test();
+   ~nir_ssa_use_table_test();
+
+   void expect_uses_in_list_order(nir_ssa_def *def);
+
+   nir_builder b;
+};
+
+nir_ssa_use_table_test::nir_ssa_use_table_test()
+{
+   glsl_type_singleton_init_or_ref();
+
+   static const nir_shader_compiler_options options = { };
+   nir_builder_init_simple_shader(&b, NULL, MESA_SHADER_VERTEX, &options);
+}
+
+nir_ssa_use_table_test::~nir_ssa_use_table_test()
+{
+   ralloc_free(b.shader);
+   glsl_type_singleton_decref();
+}
+
+void
+nir_ssa_use_table_test::expect_uses_in_list_order(nir_ssa_def *def)
+{
+   nir_ssa_use_table *table = &b.impl->ssa_uses;
+   nir_src **srcs = nir_ssa_use_table_srcs(table, def);
+   unsigned i = 0;
+
+   nir_foreach_use(src, def)
+      EXPECT_EQ(src, srcs[i++]);
+   EXPECT_EQ(i, nir_ssa_use_table_num_uses(table, def));
+
+   nir_foreach_if_use(src, def)
+      EXPECT_EQ(src, srcs[i++]);
+   EXPECT_EQ(i, nir_ssa_use_table_num_uses(table, def) +
+                nir_ssa_use_table_num_if_uses(table, def));
+}
+
+TEST_F(nir_ssa_use_table_test, build)
+{
+   /* Create IR:
+    *
+    * x = load_const
+    * y = iand x, x
+    * if (x) { z = inot y } else { }
+    */
+   nir_ssa_def *x = nir_imm_bool(&b, true);
+   nir_ssa_def *y = nir_iand(&b, x, x);
+   nir_push_if(&b, x);
+   nir_ssa_def *z = nir_inot(&b, y);
+   nir_pop_if(&b, NULL);
+
+   nir_metadata_require(b.impl, nir_metadata_ssa_uses);
+   nir_ssa_use_table *table = &b.impl->ssa_uses;
+
+   EXPECT_EQ(b.impl->ssa_alloc, table->num_defs);
+   EXPECT_EQ(2, nir_ssa_use_table_num_uses(table, x));
+   EXPECT_EQ(1, nir_ssa_use_table_num_if_uses(table, x));
+   EXPECT_EQ(1, nir_ssa_use_table_num_uses(table, y));
+   EXPECT_EQ(0, nir_ssa_use_table_num_if_uses(table, y));
+   EXPECT_EQ(0, nir_ssa_use_table_num_uses(table, z));
+
+   nir_foreach_use_in_table(src, table, x)
+      EXPECT_EQ(y->parent_instr, src->parent_instr);
+   nir_foreach_if_use_in_table(src, table, x)
+      EXPECT_EQ(x, src->ssa);
+   nir_foreach_use_in_table(src, table, y)
+      EXPECT_EQ(z->parent_instr, src->parent_instr);
+
+   /* Passes don't need to preserve it. */
+   nir_metadata_preserve(b.impl, nir_metadata_none);
+   EXPECT_TRUE(b.impl->tracked_metadata & nir_metadata_ssa_uses);
+
+   /* Renumbering the defs makes it out of date. */
+   nir_instr_remove(z->parent_instr);
+   nir_index_ssa_defs(b.impl);
+   EXPECT_FALSE(b.impl->tracked_metadata & nir_metadata_ssa_uses);
+
+   nir_metadata_require(b.impl, nir_metadata_ssa_uses);
+   EXPECT_EQ(b.impl->ssa_alloc, table->num_defs);
+   EXPECT_EQ(0, nir_ssa_use_table_num_uses(table, y));
+}
+
+TEST_F(nir_ssa_use_table_test, kept_up_to_date)
+{
+   /* Create IR:
+    *
+    * x = load_const
+    * y = iand x, x
+    * c = inot x
+    * if (x) { z = inot y } else { }
+    * w = ior y, x
+    */
+   nir_ssa_def *x = nir_imm_bool(&b, true);
+   nir_ssa_def *y = nir_iand(&b, x, x);
+   nir_ssa_def *c = nir_inot(&b, x);
+   nir_push_if(&b, x);
+   nir_ssa_def *z = nir_inot(&b, y);
+   nir_pop_if(&b, NULL);
+   nir_ssa_def *w = nir_ior(&b, y, x);
+
+   nir_metadata_require(b.impl, nir_metadata_ssa_uses);
+   nir_ssa_use_table *table = &b.impl->ssa_uses;
+
+   /* Rewriting uses moves them in the table as well. */
+   nir_ssa_def_rewrite_uses(y, nir_src_for_ssa(x));
+   EXPECT_TRUE(b.impl->tracked_metadata & nir_metadata_ssa_uses);
+   EXPECT_EQ(6, nir_ssa_use_table_num_uses(table, x));
+   EXPECT_EQ(1, nir_ssa_use_table_num_if_uses(table, x));
+   EXPECT_EQ(0, nir_ssa_use_table_num_uses(table, y));
+   expect_uses_in_list_order(x);
+
+   /* So does adding instructions, with new defs. */
+   nir_ssa_def *v = nir_iand(&b, w, z);
+   nir_ssa_def *u = nir_ior(&b, v, x);
+   EXPECT_TRUE(b.impl->tracked_metadata & nir_metadata_ssa_uses);
+   EXPECT_EQ(7, nir_ssa_use_table_num_uses(table, x));
+   EXPECT_EQ(1, nir_ssa_use_table_num_uses(table, v));
+   EXPECT_EQ(0, nir_ssa_use_table_num_uses(table, u));
+   expect_uses_in_list_order(x);
+
+   /* And removing them. */
+   nir_instr_remove(y->parent_instr);
+   nir_instr_remove(u->parent_instr);
+   EXPECT_EQ(4, nir_ssa_use_table_num_uses(table, x));
+   EXPECT_EQ(0, nir_ssa_use_table_num_uses(table, v));
+   expect_uses_in_list_order(x);
+
+   /* And moving uses between if conditions and instructions. */
+   nir_if *nif = nir_block_get_following_if(nir_start_block(b.impl));
+   nir_if_rewrite_condition(nif, nir_src_for_ssa(c));
+   nir_instr_rewrite_src(v->parent_instr,
+                         &nir_instr_as_alu(v->parent_instr)->src[1].src,
+                         nir_src_for_ssa(x));
+   EXPECT_EQ(5, nir_ssa_use_table_num_uses(table, x));
+   EXPECT_EQ(0, nir_ssa_use_table_num_if_uses(table, x));
+   EXPECT_EQ(1, nir_ssa_use_table_num_if_uses(table, c));
+   EXPECT_EQ(0, nir_ssa_use_table_num_uses(table, z));
+   expect_uses_in_list_order(x);
+   expect_uses_in_list_order(c);
+
+   nir_metadata_require(b.impl, nir_metadata_ssa_uses);
+   nir_validate_shader(b.shader, NULL);
+}
+
+TEST_F(nir_ssa_use_table_test, grows)
+{
+   nir_ssa_def *x = nir_imm_float(&b, 1.0);
+   nir_ssa_def *y = nir_imm_float(&b, 2.0);
+   nir_variable *out =
+      nir_local_variable_create(b.impl, glsl_float_type(), "out");
+
+   nir_metadata_require(b.impl, nir_metadata_ssa_uses);
+   nir_ssa_use_table *table = &b.impl->ssa_uses;
+
+   /* Every def outgrows its range many times, which moves them to the end
+    * of the table, and the table gets compacted along the way.
+    */
+   for (unsigned i = 0; i < 1000; i++) {
+      nir_ssa_def *sum = nir_fadd(&b, x, y);
+      nir_store_var(&b, out, nir_fmul(&b, sum, x), 0x1);
+   }
+
+   EXPECT_TRUE(b.impl->tracked_metadata & nir_metadata_ssa_uses);
+   EXPECT_EQ(2000, nir_ssa_use_table_num_uses(table, x));
+   EXPECT_EQ(1000, nir_ssa_use_table_num_uses(table, y));
+   EXPECT_LE(table->num_srcs, table->srcs_size);
+   expect_uses_in_list_order(x);
+   expect_uses_in_list_order(y);
+
+   nir_ssa_def_rewrite_uses(y, nir_src_for_ssa(x));
+   EXPECT_EQ(3000, nir_ssa_use_table_num_uses(table, x));
+   EXPECT_EQ(0, nir_ssa_use_table_num_uses(table, y));
+   expect_uses_in_list_order(x);
+}
@@ -69,9 +69,7 @@ move_instruction_to_start_block(state *state, nir_instr *instr)
 
 	/* and then move the instruction itself:
 	 */
-	exec_node_remove(&instr->node);
-	exec_list_push_tail(&state->start_block->instr_list, &instr->node);
-	instr->block = state->start_block;
+	nir_instr_move(nir_after_block(state->start_block), instr);
 }
 
 static bool
@@ -396,6 +396,7 @@ hud_thread_busy_install(struct hud_pane *pane, const char *name, bool main)
 struct counter_info {
    enum hud_counter counter;
    unsigned last_value;
+   unsigned frames;
    int64_t last_time;
 };
 
@@ -412,6 +413,7 @@ static unsigned get_counter(struct hud_graph *gr, enum hud_counter counter)
    case HUD_COUNTER_DIRECT:
       return mon->num_direct_items;
    case HUD_COUNTER_SYNCS:
+   case HUD_COUNTER_SYNCS_PER_FRAME:
       return mon->num_syncs;
    default:
       assert(0);
@@ -425,18 +427,27 @@ query_thread_counter(struct hud_graph *gr, struct pipe_context *pipe)
    struct counter_info *info = gr->query_data;
    int64_t now = os_time_get_nano();
 
+   /* This is called once per frame. */
+   info->frames++;
+
    if (info->last_time) {
       if (info->last_time + gr->pane->period*1000 <= now) {
          unsigned current_value = get_counter(gr, info->counter);
+         double value = current_value - info->last_value;
+
+         if (info->counter == HUD_COUNTER_SYNCS_PER_FRAME)
+            value /= info->frames;
 
-         hud_graph_add_value(gr, current_value - info->last_value);
+         hud_graph_add_value(gr, value);
          info->last_value = current_value;
          info->last_time = now;
+         info->frames = 0;
       }
    } else {
       /* initialize */
       info->last_value = get_counter(gr, info->counter);
       info->last_time = now;
+      info->frames = 0;
    }
 }
 
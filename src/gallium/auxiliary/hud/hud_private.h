@@ -38,6 +38,7 @@ enum hud_counter {
    HUD_COUNTER_OFFLOADED,
    HUD_COUNTER_DIRECT,
    HUD_COUNTER_SYNCS,
+   HUD_COUNTER_SYNCS_PER_FRAME,
 };
 
 struct hud_context {
@@ -19,6 +19,7 @@ DRI_CONF_SECTION_END
 DRI_CONF_SECTION_DEBUG
    DRI_CONF_FORCE_GLSL_EXTENSIONS_WARN("false")
    DRI_CONF_DISABLE_GLSL_LINE_CONTINUATIONS("false")
+   DRI_CONF_DISABLE_GLSL_PREPROCESSOR_FAST_PATH("false")
    DRI_CONF_DISABLE_BLEND_FUNC_EXTENDED("false")
    DRI_CONF_DISABLE_ARB_GPU_SHADER5("false")
    DRI_CONF_FORCE_GLSL_VERSION(0)
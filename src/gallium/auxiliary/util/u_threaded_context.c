@@ -29,6 +29,7 @@
 #include "util/format/u_format.h"
 #include "util/u_inlines.h"
 #include "util/u_memory.h"
+#include "util/os_time.h"
 #include "util/u_upload_mgr.h"
 
 /* 0 = disabled, 1 = assertions, 2 = printfs */
@@ -85,21 +86,52 @@ tc_batch_execute(void *job, UNUSED int thread_index)
    struct tc_batch *batch = job;
    struct pipe_context *pipe = batch->pipe;
    struct tc_call *last = &batch->call[batch->num_total_call_slots];
+   unsigned num_calls = 0;
 
    tc_batch_check(batch);
 
    assert(!batch->token);
 
+   if (batch->flush_time) {
+      struct threaded_context *tc = batch->tc;
+      unsigned latency_us = (os_time_get_nano() - batch->flush_time) / 1000;
+
+      p_atomic_set(&tc->batch_latency_us, latency_us);
+   }
+
    for (struct tc_call *iter = batch->call; iter != last;
         iter += iter->num_call_slots) {
       tc_assert(iter->sentinel == TC_SENTINEL);
       execute_func[iter->call_id](pipe, &iter->payload);
+      num_calls++;
+   }
+
+   if (batch->flush_time) {
+      p_atomic_add(&batch->tc->num_offloaded_calls, num_calls);
+      batch->flush_time = 0;
    }
 
    tc_batch_check(batch);
    batch->num_total_call_slots = 0;
 }
 
+/* Adapt the batch size to the queue latency measured by the driver thread,
+ * see TC_MIN_CALLS_PER_BATCH.
+ */
+static void
+tc_update_batch_size(struct threaded_context *tc)
+{
+   unsigned latency_us = p_atomic_read(&tc->batch_latency_us);
+
+   if (latency_us < TC_LOW_BATCH_LATENCY_US) {
+      tc->batch_size = MAX2(tc->batch_size - TC_BATCH_SIZE_STEP,
+                            TC_MIN_CALLS_PER_BATCH);
+   } else if (latency_us > TC_HIGH_BATCH_LATENCY_US) {
+      tc->batch_size = MIN2(tc->batch_size + TC_BATCH_SIZE_STEP,
+                            TC_CALLS_PER_BATCH);
+   }
+}
+
 static void
 tc_batch_flush(struct threaded_context *tc)
 {
@@ -109,13 +141,17 @@ tc_batch_flush(struct threaded_context *tc)
    tc_batch_check(next);
    tc_debug_check(tc);
    tc->bytes_mapped_estimate = 0;
+   tc->last_draw = NULL;
    p_atomic_add(&tc->num_offloaded_slots, next->num_total_call_slots);
+   p_atomic_inc(&tc->num_batches);
+   tc_update_batch_size(tc);
 
    if (next->token) {
       next->token->tc = NULL;
       tc_unflushed_batch_token_reference(&next->token, NULL);
    }
 
+   next->flush_time = os_time_get_nano();
    util_queue_add_job(&tc->queue, next, &next->fence, tc_batch_execute,
                       NULL, 0);
    tc->last = tc->next;
@@ -136,7 +172,10 @@ tc_add_sized_call(struct threaded_context *tc, enum tc_call_id id,
 
    tc_debug_check(tc);
 
-   if (unlikely(next->num_total_call_slots + num_call_slots > TC_CALLS_PER_BATCH)) {
+   tc_assert(num_call_slots <= TC_MIN_CALLS_PER_BATCH);
+
+   if (unlikely(next->num_total_call_slots + num_call_slots > tc->batch_size)) {
+      p_atomic_inc(&tc->num_full_batches);
       tc_batch_flush(tc);
       next = &tc->batch_slots[tc->next];
       tc_assert(next->num_total_call_slots == 0);
@@ -186,11 +225,13 @@ _tc_sync(struct threaded_context *tc, UNUSED const char *info, UNUSED const char
    struct tc_batch *last = &tc->batch_slots[tc->last];
    struct tc_batch *next = &tc->batch_slots[tc->next];
    bool synced = false;
+   int64_t start = 0;
 
    tc_debug_check(tc);
 
    /* Only wait for queued calls... */
    if (!util_queue_fence_is_signalled(&last->fence)) {
+      start = os_time_get_nano();
       util_queue_fence_wait(&last->fence);
       synced = true;
    }
@@ -204,14 +245,19 @@ _tc_sync(struct threaded_context *tc, UNUSED const char *info, UNUSED const char
 
    /* .. and execute unflushed calls directly. */
    if (next->num_total_call_slots) {
+      if (!start)
+         start = os_time_get_nano();
+
       p_atomic_add(&tc->num_direct_slots, next->num_total_call_slots);
       tc->bytes_mapped_estimate = 0;
+      tc->last_draw = NULL;
       tc_batch_execute(next, 0);
       synced = true;
    }
 
    if (synced) {
       p_atomic_inc(&tc->num_syncs);
+      p_atomic_add(&tc->sync_time_ns, os_time_get_nano() - start);
 
       if (tc_strcmp(func, "tc_destroy") != 0) {
          tc_printf("sync %s %s\n", func, info);
@@ -2122,6 +2168,97 @@ tc_add_draw_vbo(struct pipe_context *_pipe, bool indirect)
                                        sizeof(struct pipe_draw_info));
 }
 
+static struct tc_call *
+tc_payload_to_call(void *payload)
+{
+   return (struct tc_call*)((uint8_t*)payload -
+                            offsetof(struct tc_call, payload));
+}
+
+/* A draw_vbo call that direct draws have been appended to. "info" contains
+ * the first draw and "slot" the others.
+ */
+struct tc_draw_multi {
+   struct pipe_draw_info info;
+   unsigned num_draws;
+   struct {
+      unsigned start;
+      unsigned count;
+      unsigned min_index;
+      unsigned max_index;
+   } slot[0]; /* more will be allocated if needed */
+};
+
+static void
+tc_call_draw_multi(struct pipe_context *pipe, union tc_payload *payload)
+{
+   struct tc_draw_multi *p = (struct tc_draw_multi*)payload;
+
+   pipe->draw_vbo(pipe, &p->info);
+
+   for (unsigned i = 0; i < p->num_draws; i++) {
+      p->info.start = p->slot[i].start;
+      p->info.count = p->slot[i].count;
+      p->info.min_index = p->slot[i].min_index;
+      p->info.max_index = p->slot[i].max_index;
+      pipe->draw_vbo(pipe, &p->info);
+   }
+
+   if (p->info.index_size)
+      pipe_resource_reference(&p->info.index.resource, NULL);
+}
+
+/* Append a direct draw to the last call of the current batch if it's a draw
+ * that only differs in the vertex range. "index_buffer" and "start" replace
+ * the user index buffer of "info".
+ */
+static bool
+tc_merge_draw(struct threaded_context *tc, const struct pipe_draw_info *info,
+              struct pipe_resource *index_buffer, unsigned start)
+{
+   struct tc_batch *next = &tc->batch_slots[tc->next];
+   struct tc_call *call = tc->last_draw;
+
+   if (!call || call + call->num_call_slots !=
+                &next->call[next->num_total_call_slots])
+      return false;
+
+   struct tc_draw_multi *p = (struct tc_draw_multi*)&call->payload;
+
+   if (p->info.mode != info->mode ||
+       p->info.index_size != info->index_size ||
+       p->info.primitive_restart != info->primitive_restart ||
+       p->info.vertices_per_patch != info->vertices_per_patch ||
+       p->info.start_instance != info->start_instance ||
+       p->info.instance_count != info->instance_count ||
+       p->info.drawid != info->drawid ||
+       p->info.index_bias != info->index_bias ||
+       p->info.restart_index != info->restart_index ||
+       (info->index_size && p->info.index.resource != index_buffer))
+      return false;
+
+   unsigned num_draws = call->call_id == TC_CALL_draw_multi ? p->num_draws : 0;
+   unsigned size = offsetof(struct tc_call, payload) + sizeof(*p) +
+                   (num_draws + 1) * sizeof(p->slot[0]);
+   unsigned num_call_slots = DIV_ROUND_UP(size, sizeof(struct tc_call));
+   unsigned new_slots = num_call_slots - call->num_call_slots;
+
+   if (next->num_total_call_slots + new_slots > tc->batch_size)
+      return false;
+
+   next->num_total_call_slots += new_slots;
+   call->num_call_slots = num_call_slots;
+   call->call_id = TC_CALL_draw_multi;
+
+   p->slot[num_draws].start = start;
+   p->slot[num_draws].count = info->count;
+   p->slot[num_draws].min_index = info->min_index;
+   p->slot[num_draws].max_index = info->max_index;
+   p->num_draws = num_draws + 1;
+   p_atomic_inc(&tc->num_merged_draws);
+   return true;
+}
+
 static void
 tc_draw_vbo(struct pipe_context *_pipe, const struct pipe_draw_info *info)
 {
@@ -2147,6 +2284,14 @@ tc_draw_vbo(struct pipe_context *_pipe, const struct pipe_draw_info *info)
       if (unlikely(!buffer))
          return;
 
+      unsigned start = offset >> util_logbase2(index_size);
+
+      if (!info->count_from_stream_output &&
+          tc_merge_draw(tc, info, buffer, start)) {
+         pipe_resource_reference(&buffer, NULL);
+         return;
+      }
+
       struct tc_full_draw_info *p = tc_add_draw_vbo(_pipe, false);
       p->draw.count_from_stream_output = NULL;
       pipe_so_target_reference(&p->draw.count_from_stream_output,
@@ -2154,9 +2299,18 @@ tc_draw_vbo(struct pipe_context *_pipe, const struct pipe_draw_info *info)
       memcpy(&p->draw, info, sizeof(*info));
       p->draw.has_user_indices = false;
       p->draw.index.resource = buffer;
-      p->draw.start = offset >> util_logbase2(index_size);
+      p->draw.start = start;
+
+      if (!info->count_from_stream_output)
+         tc->last_draw = tc_payload_to_call(p);
    } else {
       /* Non-indexed call or indexed with a real index buffer. */
+      bool mergeable = !indirect && !info->count_from_stream_output;
+
+      if (mergeable &&
+          tc_merge_draw(tc, info, info->index.resource, info->start))
+         return;
+
       struct tc_full_draw_info *p = tc_add_draw_vbo(_pipe, indirect != NULL);
       p->draw.count_from_stream_output = NULL;
       pipe_so_target_reference(&p->draw.count_from_stream_output,
@@ -2174,6 +2328,9 @@ tc_draw_vbo(struct pipe_context *_pipe, const struct pipe_draw_info *info)
          memcpy(&p->indirect, indirect, sizeof(*indirect));
          p->draw.indirect = &p->indirect;
       }
+
+      if (mergeable)
+         tc->last_draw = tc_payload_to_call(p);
    }
 }
 
@@ -2648,6 +2805,7 @@ threaded_context_create(struct pipe_context *pipe,
    tc->pipe = pipe;
    tc->replace_buffer_storage = replace_buffer;
    tc->create_fence = create_fence;
+   tc->batch_size = TC_CALLS_PER_BATCH;
    tc->map_buffer_alignment =
       pipe->screen->get_param(pipe->screen, PIPE_CAP_MIN_MAP_BUFFER_ALIGNMENT);
    tc->base.priv = pipe; /* priv points to the wrapped driver context */
@@ -2674,6 +2832,7 @@ threaded_context_create(struct pipe_context *pipe,
    for (unsigned i = 0; i < TC_MAX_BATCHES; i++) {
       tc->batch_slots[i].sentinel = TC_SENTINEL;
       tc->batch_slots[i].pipe = pipe;
+      tc->batch_slots[i].tc = tc;
       util_queue_fence_init(&tc->batch_slots[i].fence);
    }
 
@@ -176,6 +176,11 @@
  * The batches are ordered in a ring and reused once they are idle again.
  * The batching is necessary for low queue/mutex overhead.
  *
+ * A direct draw that follows another direct draw with the same parameters
+ * except the vertex range is appended to the previous call instead of adding
+ * a new one. It takes 1 call slot instead of 5 and doesn't reference the index
+ * buffer again. The driver still receives one draw_vbo call per draw.
+ *
  */
 
 #ifndef U_THREADED_CONTEXT_H
@@ -222,6 +227,19 @@ struct tc_unflushed_batch_token;
  */
 #define TC_CALLS_PER_BATCH    768
 
+/* The number of call slots after which a batch is flushed adapts to how long
+ * flushed batches wait in the queue before the driver thread starts executing
+ * them. If they are picked up right away, the driver thread is idle, and
+ * smaller batches let it start working sooner. If they wait long, the driver
+ * thread is behind, and larger batches reduce the queuing overhead.
+ *
+ * The minimum must be larger than the biggest call.
+ */
+#define TC_MIN_CALLS_PER_BATCH   128
+#define TC_BATCH_SIZE_STEP       64
+#define TC_LOW_BATCH_LATENCY_US  100
+#define TC_HIGH_BATCH_LATENCY_US 1000
+
 /* Threshold for when to use the queue or sync. */
 #define TC_MAX_STRING_MARKER_BYTES  512
 
@@ -339,9 +357,11 @@ struct tc_unflushed_batch_token {
 
 struct tc_batch {
    struct pipe_context *pipe;
+   struct threaded_context *tc;
    unsigned sentinel;
    unsigned num_total_call_slots;
    struct tc_unflushed_batch_token *token;
+   int64_t flush_time; /* 0 if the batch wasn't flushed to the queue */
    struct util_queue_fence fence;
    struct tc_call call[TC_CALLS_PER_BATCH];
 };
@@ -360,6 +380,22 @@ struct threaded_context {
    unsigned num_offloaded_slots;
    unsigned num_direct_slots;
    unsigned num_syncs;
+   unsigned num_batches;        /* batches flushed to the queue */
+   unsigned num_full_batches;   /* batches flushed for running out of space */
+   unsigned num_offloaded_calls; /* calls executed from the queue */
+   unsigned num_merged_draws;   /* draws appended to a previous draw call */
+   uint64_t sync_time_ns;       /* time spent in tc_sync, atomic */
+
+   /* The current batch size limit in call slots and the queue latency of
+    * the last executed batch, see TC_MIN_CALLS_PER_BATCH.
+    */
+   unsigned batch_size;
+   unsigned batch_latency_us;
+
+   /* The last call of the current batch if it's a direct draw that the next
+    * draw may be merged into.
+    */
+   struct tc_call *last_draw;
 
    /* Estimation of how much vram/gtt bytes are mmap'd in
     * the current tc_batch.
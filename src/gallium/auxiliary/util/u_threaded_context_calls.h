@@ -26,6 +26,7 @@ CALL(buffer_subdata)
 CALL(texture_subdata)
 CALL(emit_string_marker)
 CALL(draw_vbo)
+CALL(draw_multi)
 CALL(launch_grid)
 CALL(resource_copy_region)
 CALL(blit)
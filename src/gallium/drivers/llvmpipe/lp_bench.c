@@ -0,0 +1,459 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * @file
+ * Timings of llvmpipe paths, mostly run through the gallium interface on
+ * a null winsys.
+ *
+ * Usage: lp_bench <test> [iterations]
+ *
+ *   startup  time to the first finished frame with an empty and with a
+ *            filled shader cache
+ *   scenes   frames per second when frames are flushed without waiting,
+ *            so that binning the next frame can overlap rasterizing the
+ *            previous one; compare LP_NUM_SCENES=1 against the default,
+ *            or vary LP_NUM_THREADS to see how rasterization scales
+ *   compute  dispatches of many empty work-groups straight to the compute
+ *            thread pool, which measures handing them out to the threads,
+ *            from one context and from four contexts at once
+ */
+
+#define _XOPEN_SOURCE 500 /* for nftw */
+
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cso_cache/cso_context.h"
+#include "nir/tgsi_to_nir.h"
+#include "pipe/p_context.h"
+#include "pipe/p_defines.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "sw/null/null_sw_winsys.h"
+#include "tgsi/tgsi_text.h"
+#include "util/os_time.h"
+#include "util/u_debug.h"
+#include "util/u_draw_quad.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"
+#include "util/u_thread.h"
+
+#include "lp_cs_tpool.h"
+#include "lp_public.h"
+#include "lp_screen.h"
+
+#define WIDTH 1024
+#define HEIGHT 1024
+
+#define CACHE_DIR "./lp-bench-cache"
+
+struct bench {
+   struct pipe_screen *screen;
+   struct pipe_context *pipe;
+   struct cso_context *cso;
+
+   struct pipe_resource *target;
+   struct pipe_surface *surf;
+   struct pipe_resource *vbuf;
+
+   void *vs;
+   void *fs;
+};
+
+/* The shaders are handed to the driver as NIR, as the GL frontend does,
+ * since only NIR shaders go through the llvmpipe disk cache.
+ */
+static const char vs_text[] =
+   "VERT\n"
+   "DCL IN[0]\n"
+   "DCL IN[1]\n"
+   "DCL OUT[0], POSITION\n"
+   "DCL OUT[1], COLOR\n"
+   "  0: MOV OUT[0], IN[0]\n"
+   "  1: MOV OUT[1], IN[1]\n"
+   "  2: END\n";
+
+static const char fs_text[] =
+   "FRAG\n"
+   "DCL IN[0], COLOR, PERSPECTIVE\n"
+   "DCL OUT[0], COLOR\n"
+   "DCL TEMP[0]\n"
+   "IMM[0] FLT32 { 0.5, 0.25, 2.0, 1.0 }\n"
+   "  0: MUL TEMP[0], IN[0], IMM[0]\n"
+   "  1: MAD TEMP[0], TEMP[0], TEMP[0], IN[0]\n"
+   "  2: MIN OUT[0], TEMP[0], IMM[0].wwww\n"
+   "  3: END\n";
+
+static void *
+create_shader(struct bench *b, enum pipe_shader_type stage, const char *text)
+{
+   struct tgsi_token tokens[1024];
+   struct pipe_shader_state state;
+
+   if (!tgsi_text_translate(text, tokens, ARRAY_SIZE(tokens))) {
+      fprintf(stderr, "could not translate shader:\n%s", text);
+      exit(EXIT_FAILURE);
+   }
+
+   memset(&state, 0, sizeof(state));
+   state.type = PIPE_SHADER_IR_NIR;
+   state.ir.nir = tgsi_to_nir(tokens, b->screen, false);
+
+   if (stage == PIPE_SHADER_VERTEX)
+      return b->pipe->create_vs_state(b->pipe, &state);
+   else
+      return b->pipe->create_fs_state(b->pipe, &state);
+}
+
+static void
+bench_init(struct bench *b)
+{
+   memset(b, 0, sizeof(*b));
+
+   b->screen = llvmpipe_create_screen(null_sw_create());
+   if (!b->screen) {
+      fprintf(stderr, "could not create the screen\n");
+      exit(EXIT_FAILURE);
+   }
+
+   b->pipe = b->screen->context_create(b->screen, NULL, 0);
+   b->cso = cso_create_context(b->pipe, 0);
+
+   struct pipe_resource tmpl;
+   memset(&tmpl, 0, sizeof(tmpl));
+   tmpl.target = PIPE_TEXTURE_2D;
+   tmpl.format = PIPE_FORMAT_B8G8R8A8_UNORM;
+   tmpl.width0 = WIDTH;
+   tmpl.height0 = HEIGHT;
+   tmpl.depth0 = 1;
+   tmpl.array_size = 1;
+   tmpl.bind = PIPE_BIND_RENDER_TARGET;
+   b->target = b->screen->resource_create(b->screen, &tmpl);
+
+   struct pipe_surface surf_tmpl;
+   memset(&surf_tmpl, 0, sizeof(surf_tmpl));
+   surf_tmpl.format = PIPE_FORMAT_B8G8R8A8_UNORM;
+   b->surf = b->pipe->create_surface(b->pipe, b->target, &surf_tmpl);
+
+   /* A full-screen quad of two triangles, with a color per vertex. */
+   static const float vertices[6][2][4] = {
+      { { -1.0f, -1.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f, 0.5f } },
+      { {  1.0f, -1.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f, 0.5f } },
+      { { -1.0f,  1.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, 1.0f, 0.5f } },
+      { { -1.0f,  1.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, 1.0f, 0.5f } },
+      { {  1.0f, -1.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f, 0.5f } },
+      { {  1.0f,  1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 0.5f } },
+   };
+   b->vbuf = pipe_buffer_create(b->screen, PIPE_BIND_VERTEX_BUFFER,
+                                PIPE_USAGE_DEFAULT, sizeof(vertices));
+   pipe_buffer_write(b->pipe, b->vbuf, 0, sizeof(vertices), vertices);
+
+   b->vs = create_shader(b, PIPE_SHADER_VERTEX, vs_text);
+   b->fs = create_shader(b, PIPE_SHADER_FRAGMENT, fs_text);
+
+   struct pipe_framebuffer_state fb;
+   memset(&fb, 0, sizeof(fb));
+   fb.width = WIDTH;
+   fb.height = HEIGHT;
+   fb.nr_cbufs = 1;
+   fb.cbufs[0] = b->surf;
+   cso_set_framebuffer(b->cso, &fb);
+
+   struct pipe_depth_stencil_alpha_state dsa;
+   memset(&dsa, 0, sizeof(dsa));
+   cso_set_depth_stencil_alpha(b->cso, &dsa);
+
+   struct pipe_rasterizer_state rast;
+   memset(&rast, 0, sizeof(rast));
+   rast.cull_face = PIPE_FACE_NONE;
+   rast.half_pixel_center = 1;
+   rast.bottom_edge_rule = 1;
+   rast.depth_clip_near = 1;
+   rast.depth_clip_far = 1;
+   cso_set_rasterizer(b->cso, &rast);
+
+   struct pipe_viewport_state vp;
+   memset(&vp, 0, sizeof(vp));
+   vp.scale[0] = WIDTH / 2.0f;
+   vp.scale[1] = HEIGHT / 2.0f;
+   vp.scale[2] = 0.5f;
+   vp.translate[0] = WIDTH / 2.0f;
+   vp.translate[1] = HEIGHT / 2.0f;
+   vp.translate[2] = 0.5f;
+   cso_set_viewport(b->cso, &vp);
+
+   struct cso_velems_state velem;
+   memset(&velem, 0, sizeof(velem));
+   velem.count = 2;
+   velem.velems[0].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+   velem.velems[1].src_offset = 4 * sizeof(float);
+   velem.velems[1].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+   cso_set_vertex_elements(b->cso, &velem);
+
+   cso_set_vertex_shader_handle(b->cso, b->vs);
+   cso_set_fragment_shader_handle(b->cso, b->fs);
+}
+
+static void
+bench_fini(struct bench *b)
+{
+   cso_destroy_context(b->cso);
+   b->pipe->delete_vs_state(b->pipe, b->vs);
+   b->pipe->delete_fs_state(b->pipe, b->fs);
+   pipe_surface_reference(&b->surf, NULL);
+   pipe_resource_reference(&b->target, NULL);
+   pipe_resource_reference(&b->vbuf, NULL);
+   b->pipe->destroy(b->pipe);
+   b->screen->destroy(b->screen);
+}
+
+static void
+set_blend(struct bench *b, bool enable)
+{
+   struct pipe_blend_state blend;
+   memset(&blend, 0, sizeof(blend));
+   blend.rt[0].colormask = PIPE_MASK_RGBA;
+   if (enable) {
+      blend.rt[0].blend_enable = 1;
+      blend.rt[0].rgb_func = PIPE_BLEND_ADD;
+      blend.rt[0].rgb_src_factor = PIPE_BLENDFACTOR_SRC_ALPHA;
+      blend.rt[0].rgb_dst_factor = PIPE_BLENDFACTOR_INV_SRC_ALPHA;
+      blend.rt[0].alpha_func = PIPE_BLEND_ADD;
+      blend.rt[0].alpha_src_factor = PIPE_BLENDFACTOR_ONE;
+      blend.rt[0].alpha_dst_factor = PIPE_BLENDFACTOR_ZERO;
+   }
+   cso_set_blend(b->cso, &blend);
+}
+
+static void
+draw_quads(struct bench *b, unsigned count)
+{
+   for (unsigned i = 0; i < count; i++)
+      util_draw_vertex_buffer(b->pipe, b->cso, b->vbuf, 0, 0,
+                              PIPE_PRIM_TRIANGLES, 6, 2);
+}
+
+static void
+finish(struct bench *b)
+{
+   struct pipe_fence_handle *fence = NULL;
+   b->pipe->flush(b->pipe, &fence, 0);
+   b->screen->fence_finish(b->screen, NULL, fence, PIPE_TIMEOUT_INFINITE);
+   b->screen->fence_reference(b->screen, &fence, NULL);
+}
+
+static int
+remove_entry(const char *path, const struct stat *sb, int typeflag,
+             struct FTW *ftwbuf)
+{
+   return remove(path);
+}
+
+/* One frame that needs a few fragment and setup variants: a clear, then
+ * opaque and blended quads.
+ */
+static double
+first_frame_ms(void)
+{
+   struct bench b;
+   int64_t start = os_time_get_nano();
+
+   bench_init(&b);
+
+   union pipe_color_union color = { .f = { 0.3f, 0.1f, 0.3f, 1.0f } };
+   b.pipe->clear(b.pipe, PIPE_CLEAR_COLOR, NULL, &color, 0, 0);
+   set_blend(&b, false);
+   draw_quads(&b, 1);
+   set_blend(&b, true);
+   draw_quads(&b, 1);
+   finish(&b);
+
+   double ms = (os_time_get_nano() - start) / 1e6;
+   bench_fini(&b);
+   return ms;
+}
+
+static void
+bench_startup(unsigned iterations)
+{
+   setenv("MESA_GLSL_CACHE_DIR", CACHE_DIR, 1);
+
+   /* Pay for the one-time LLVM initialization up front. */
+   struct pipe_screen *screen = llvmpipe_create_screen(null_sw_create());
+   screen->destroy(screen);
+
+   double cold = 0, warm = 0;
+   for (unsigned i = 0; i < iterations; i++) {
+      nftw(CACHE_DIR, remove_entry, 64, FTW_DEPTH | FTW_PHYS);
+      cold += first_frame_ms();
+      warm += first_frame_ms();
+   }
+   nftw(CACHE_DIR, remove_entry, 64, FTW_DEPTH | FTW_PHYS);
+
+   printf("first frame: %.2f ms with an empty shader cache, "
+          "%.2f ms with a filled one\n", cold / iterations, warm / iterations);
+}
+
+/* Each frame is a clear and a few blended full-screen quads.  Only the last
+ * frame is waited for.
+ */
+static void
+bench_scenes(unsigned iterations)
+{
+   const unsigned frames = 10 * iterations;
+   struct bench b;
+
+   bench_init(&b);
+   set_blend(&b, true);
+
+   /* Compile the variants outside of the timed loop. */
+   union pipe_color_union color = { .f = { 0.3f, 0.1f, 0.3f, 1.0f } };
+   b.pipe->clear(b.pipe, PIPE_CLEAR_COLOR, NULL, &color, 0, 0);
+   draw_quads(&b, 1);
+   finish(&b);
+
+   int64_t start = os_time_get_nano();
+   for (unsigned i = 0; i < frames; i++) {
+      b.pipe->clear(b.pipe, PIPE_CLEAR_COLOR, NULL, &color, 0, 0);
+      draw_quads(&b, 4);
+      b.pipe->flush(b.pipe, NULL, 0);
+   }
+   finish(&b);
+   double secs = (os_time_get_nano() - start) / 1e9;
+
+   struct llvmpipe_screen *screen = llvmpipe_screen(b.screen);
+   printf("%u frames on %u threads with %u scenes: %.1f frames per second\n",
+          frames, screen->num_threads, screen->num_scenes, frames / secs);
+
+   bench_fini(&b);
+}
+
+/* A work-group that does next to nothing, so that the time goes to handing
+ * the work-groups out to the threads.
+ */
+static void
+compute_work(void *data, int iter_idx, struct lp_cs_local_mem *lmem)
+{
+   unsigned *groups = data;
+   groups[iter_idx] = iter_idx;
+}
+
+#define COMPUTE_GROUPS (64 * 1024)
+
+struct compute_context {
+   struct lp_cs_tpool *pool;
+   unsigned dispatches;
+   unsigned *data;
+};
+
+/* Like a context, waits for each dispatch before queueing the next one. */
+static int
+compute_dispatch(void *data)
+{
+   struct compute_context *ctx = data;
+
+   for (unsigned i = 0; i < ctx->dispatches; i++) {
+      struct lp_cs_tpool_task *task =
+         lp_cs_tpool_queue_task(ctx->pool, compute_work, ctx->data,
+                                COMPUTE_GROUPS);
+      lp_cs_tpool_wait_for_task(ctx->pool, &task);
+   }
+
+   return 0;
+}
+
+/* Dispatches from one context run back to back, so only dispatches from
+ * several contexts can overlap in the pool.  Each context gets a thread of
+ * its own that queues its share of the dispatches.
+ */
+static void
+run_compute(struct lp_cs_tpool *pool, unsigned num_contexts,
+            unsigned dispatches)
+{
+   struct compute_context ctx[4];
+   thrd_t threads[4];
+
+   assert(num_contexts <= ARRAY_SIZE(ctx));
+
+   for (unsigned i = 0; i < num_contexts; i++) {
+      ctx[i].pool = pool;
+      ctx[i].dispatches = dispatches / num_contexts;
+      ctx[i].data = CALLOC(COMPUTE_GROUPS, sizeof(*ctx[i].data));
+   }
+
+   int64_t start = os_time_get_nano();
+   for (unsigned i = 0; i < num_contexts; i++)
+      threads[i] = u_thread_create(compute_dispatch, &ctx[i]);
+   for (unsigned i = 0; i < num_contexts; i++)
+      thrd_join(threads[i], NULL);
+   double ms = (os_time_get_nano() - start) / 1e6;
+
+   printf("%u dispatches of %u work-groups from %u context(s) on %u threads: "
+          "%.3f ms per dispatch, %.1f M work-groups per second\n",
+          dispatches, COMPUTE_GROUPS, num_contexts, pool->num_threads,
+          ms / dispatches, (double)dispatches * COMPUTE_GROUPS / ms / 1e3);
+
+   for (unsigned i = 0; i < num_contexts; i++)
+      FREE(ctx[i].data);
+}
+
+static void
+bench_compute(unsigned iterations)
+{
+   const unsigned dispatches = 12 * iterations;
+   unsigned num_threads = debug_get_num_option("LP_NUM_THREADS", 4);
+
+   struct lp_cs_tpool *pool = lp_cs_tpool_create(num_threads);
+
+   run_compute(pool, 1, dispatches);
+   run_compute(pool, 4, dispatches);
+
+   lp_cs_tpool_destroy(pool);
+}
+
+int
+main(int argc, char **argv)
+{
+   const char *test = argc > 1 ? argv[1] : "";
+   unsigned iterations = argc > 2 ? atoi(argv[2]) : 10;
+
+   if (!iterations)
+      iterations = 1;
+
+   if (!strcmp(test, "startup")) {
+      bench_startup(iterations);
+   } else if (!strcmp(test, "scenes")) {
+      bench_scenes(iterations);
+   } else if (!strcmp(test, "compute")) {
+      bench_compute(iterations);
+   } else {
+      fprintf(stderr, "usage: %s startup|scenes|compute [iterations]\n",
+              argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   return EXIT_SUCCESS;
+}
@@ -108,6 +108,10 @@ struct llvmpipe_context {
 
    unsigned active_primgen_queries;
 
+   /** Compute dispatch counters, for the driver-specific queries */
+   uint64_t cs_dispatches;
+   uint64_t cs_dispatch_time;  /**< in nanoseconds */
+
    bool queries_disabled;
 
    unsigned dirty; /**< Mask of LP_NEW_x flags */
@@ -26,12 +26,52 @@
 /**
  * compute shader thread pool.
  * based on threadpool.c but modified heavily to be compute shader tuned.
+ *
+ * Workers claim chunks of iterations of the task at the head of the queue
+ * with atomics, and only take the pool mutex to pick up or leave a task.
+ * Once all iterations of a task are claimed it leaves the queue, so the
+ * idle workers start on the next dispatch while it finishes.
  */
 
+#include "util/u_atomic.h"
 #include "util/u_thread.h"
+#include "util/u_math.h"
 #include "util/u_memory.h"
 #include "lp_cs_tpool.h"
 
+/**
+ * Claim the next chunk of iterations of a task, without taking the pool
+ * mutex.  Chunks are a fraction of the remaining iterations, so they are
+ * large at the start of a dispatch and shrink towards the end, which keeps
+ * all the threads busy until the task is done while only touching the
+ * shared counter a few times per thread.
+ */
+static bool
+lp_cs_tpool_claim_chunk(const struct lp_cs_tpool *pool,
+                        struct lp_cs_tpool_task *task,
+                        unsigned *iter_start, unsigned *num_iters)
+{
+   unsigned start = p_atomic_read(&task->iter_start);
+
+   for (;;) {
+      unsigned remaining, chunk, prev;
+
+      if (start >= task->iter_total)
+         return false;
+
+      remaining = task->iter_total - start;
+      chunk = MAX2(1, remaining / (2 * pool->num_threads));
+
+      prev = p_atomic_cmpxchg(&task->iter_start, start, start + chunk);
+      if (prev == start) {
+         *iter_start = start;
+         *num_iters = chunk;
+         return true;
+      }
+      start = prev;
+   }
+}
+
 static int
 lp_cs_tpool_worker(void *data)
 {
@@ -43,6 +83,7 @@ lp_cs_tpool_worker(void *data)
 
    while (!pool->shutdown) {
       struct lp_cs_tpool_task *task;
+      unsigned iter_start, num_iters;
 
       while (list_is_empty(&pool->workqueue) && !pool->shutdown)
          cnd_wait(&pool->new_work, &pool->m);
@@ -52,16 +93,24 @@ lp_cs_tpool_worker(void *data)
 
       task = list_first_entry(&pool->workqueue, struct lp_cs_tpool_task,
                               list);
-      unsigned this_iter = task->iter_start++;
+      task->num_workers++;
+      mtx_unlock(&pool->m);
 
-      if (task->iter_start == task->iter_total)
-         list_del(&task->list);
+      while (lp_cs_tpool_claim_chunk(pool, task, &iter_start, &num_iters)) {
+         for (unsigned i = 0; i < num_iters; i++)
+            task->work(task->data, iter_start + i, &lmem);
+         p_atomic_add(&task->iter_finished, num_iters);
+      }
 
-      mtx_unlock(&pool->m);
-      task->work(task->data, this_iter, &lmem);
       mtx_lock(&pool->m);
-      task->iter_finished++;
-      if (task->iter_finished == task->iter_total)
+      /* Every iteration has been claimed, so let the workers move on to
+       * the next task while the last chunks of this one finish.
+       */
+      if (!list_is_empty(&task->list))
+         list_delinit(&task->list);
+      task->num_workers--;
+      if (task->num_workers == 0 &&
+          p_atomic_read(&task->iter_finished) == task->iter_total)
          cnd_broadcast(&task->finish);
    }
    mtx_unlock(&pool->m);
@@ -81,7 +130,15 @@ lp_cs_tpool_create(unsigned num_threads)
    cnd_init(&pool->new_work);
 
    list_inithead(&pool->workqueue);
-   assert (num_threads <= LP_MAX_THREADS);
+   if (num_threads) {
+      pool->threads = CALLOC(num_threads, sizeof(*pool->threads));
+      if (!pool->threads) {
+         cnd_destroy(&pool->new_work);
+         mtx_destroy(&pool->m);
+         FREE(pool);
+         return NULL;
+      }
+   }
    pool->num_threads = num_threads;
    for (unsigned i = 0; i < num_threads; i++)
       pool->threads[i] = u_thread_create(lp_cs_tpool_worker, pool);
@@ -105,6 +162,7 @@ lp_cs_tpool_destroy(struct lp_cs_tpool *pool)
 
    cnd_destroy(&pool->new_work);
    mtx_destroy(&pool->m);
+   FREE(pool->threads);
    FREE(pool);
 }
 
@@ -151,8 +209,12 @@ lp_cs_tpool_wait_for_task(struct lp_cs_tpool *pool,
    if (!pool || !task)
       return;
 
+   /* Wait for the workers to be done with the task too, not just for the
+    * iterations to be finished, as they still reference it afterwards.
+    */
    mtx_lock(&pool->m);
-   while (task->iter_finished < task->iter_total)
+   while (task->num_workers ||
+          p_atomic_read(&task->iter_finished) < task->iter_total)
       cnd_wait(&task->finish, &pool->m);
    mtx_unlock(&pool->m);
 
@@ -45,7 +45,7 @@ struct lp_cs_tpool {
    mtx_t m;
    cnd_t new_work;
 
-   thrd_t threads[LP_MAX_THREADS];
+   thrd_t *threads;
    unsigned num_threads;
    struct list_head workqueue;
    bool shutdown;
@@ -64,8 +64,9 @@ struct lp_cs_tpool_task {
    struct list_head list;
    cnd_t finish;
    unsigned iter_total;
-   unsigned iter_start;
-   unsigned iter_finished;
+   unsigned iter_start;    /* next unclaimed iteration, updated atomically */
+   unsigned iter_finished; /* updated atomically */
+   unsigned num_workers;   /* workers holding the task, under the pool mutex */
 };
 
 struct lp_cs_tpool *lp_cs_tpool_create(unsigned num_threads);
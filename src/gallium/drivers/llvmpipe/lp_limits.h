@@ -66,7 +66,11 @@
 
 #define LP_MAX_SAMPLES 4
 
-#define LP_MAX_THREADS 16
+/**
+ * Max number of scenes per context.  While one scene is being rasterized,
+ * the next ones can be binned.
+ */
+#define LP_MAX_SCENES 4
 
 
 /**
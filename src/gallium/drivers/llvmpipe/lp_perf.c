@@ -105,6 +105,25 @@ lp_print_counters(void)
       debug_printf("llvmpipe: nr_llvm_compiles:             %u\n", lp_count.nr_llvm_compiles);
       debug_printf("llvmpipe: total LLVM compile time:      %.2f sec\n", lp_count.llvm_compile_time / 1000000.0);
       debug_printf("llvmpipe: average LLVM compile time:    %.2f sec\n", lp_count.llvm_compile_time / 1000000.0 / lp_count.nr_llvm_compiles);
+      debug_printf("llvmpipe: nr_fs_compile_stalls_avoided: %u\n", lp_count.nr_fs_compile_stalls_avoided);
+      debug_printf("llvmpipe: nr_fs_async_compiles:         %u\n", lp_count.nr_fs_async_compiles);
+      debug_printf("llvmpipe: total async FS compile time:  %.2f sec\n", lp_count.fs_async_compile_time / 1000000.0);
 
    }
 }
+
+
+/**
+ * Print the per rasterizer thread counters, which are kept by the
+ * rasterizer tasks rather than in lp_count.
+ */
+void
+lp_print_thread_counters(unsigned thread_index,
+                         unsigned nr_tiles_executed,
+                         unsigned nr_tiles_stolen)
+{
+   if (LP_DEBUG & DEBUG_COUNTERS) {
+      debug_printf("llvmpipe: thread %3u nr_tiles:          %9u (%u stolen)\n",
+                   thread_index, nr_tiles_executed, nr_tiles_stolen);
+   }
+}
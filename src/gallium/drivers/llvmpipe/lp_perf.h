@@ -34,6 +34,7 @@
 #define LP_PERF_H
 
 #include "pipe/p_compiler.h"
+#include "util/u_atomic.h"
 
 /**
  * Various counters
@@ -58,6 +59,9 @@ struct lp_counters
    unsigned nr_non_empty_4;
    unsigned nr_llvm_compiles;
    int64_t llvm_compile_time;  /**< total, in microseconds */
+   unsigned nr_fs_compile_stalls_avoided;
+   unsigned nr_fs_async_compiles;
+   int64_t fs_async_compile_time;  /**< total, in microseconds */
 
    unsigned nr_color_tile_clear;
    unsigned nr_color_tile_load;
@@ -73,10 +77,13 @@ extern struct lp_counters lp_count;
 #define LP_COUNT(counter) lp_count.counter++
 #define LP_COUNT_ADD(counter, incr)  lp_count.counter += (incr)
 #define LP_COUNT_GET(counter) (lp_count.counter)
+/** For counters updated from several threads */
+#define LP_COUNT_ADD_ATOMIC(counter, incr) p_atomic_add(&lp_count.counter, (incr))
 #else
 #define LP_COUNT(counter) do {} while (0)
 #define LP_COUNT_ADD(counter, incr) (void)(incr)
 #define LP_COUNT_GET(counter) 0
+#define LP_COUNT_ADD_ATOMIC(counter, incr) (void)(incr)
 #endif
 
 
@@ -88,4 +95,10 @@ extern void
 lp_print_counters(void);
 
 
+extern void
+lp_print_thread_counters(unsigned thread_index,
+                         unsigned nr_tiles_executed,
+                         unsigned nr_tiles_stolen);
+
+
 #endif /* LP_PERF_H */
@@ -53,15 +53,27 @@ llvmpipe_create_query(struct pipe_context *pipe,
                       unsigned type,
                       unsigned index)
 {
+   struct llvmpipe_screen *screen = llvmpipe_screen(pipe->screen);
    struct llvmpipe_query *pq;
 
-   assert(type < PIPE_QUERY_TYPES);
+   assert(type < PIPE_QUERY_TYPES ||
+          type == LP_QUERY_CS_DISPATCHES ||
+          type == LP_QUERY_CS_DISPATCH_TIME);
 
    pq = CALLOC_STRUCT( llvmpipe_query );
 
    if (pq) {
       pq->type = type;
       pq->index = index;
+      pq->num_threads = MAX2(1, screen->num_threads);
+      pq->start = CALLOC(pq->num_threads, sizeof(*pq->start));
+      pq->end = CALLOC(pq->num_threads, sizeof(*pq->end));
+      if (!pq->start || !pq->end) {
+         FREE(pq->start);
+         FREE(pq->end);
+         FREE(pq);
+         return NULL;
+      }
    }
 
    return (struct pipe_query *) pq;
@@ -86,6 +98,8 @@ llvmpipe_destroy_query(struct pipe_context *pipe, struct pipe_query *q)
       lp_fence_reference(&pq->fence, NULL);
    }
 
+   FREE(pq->start);
+   FREE(pq->end);
    FREE(pq);
 }
 
@@ -171,6 +185,13 @@ llvmpipe_get_query_result(struct pipe_context *pipe,
       stats->primitives_storage_needed = pq->num_primitives_generated[0];
    }
       break;
+   case LP_QUERY_CS_DISPATCHES:
+      *result = pq->end[0];
+      break;
+   case LP_QUERY_CS_DISPATCH_TIME:
+      /* reported in microseconds */
+      *result = pq->end[0] / 1000;
+      break;
    case PIPE_QUERY_PIPELINE_STATISTICS: {
       struct pipe_query_data_pipeline_statistics *stats =
          (struct pipe_query_data_pipeline_statistics *)vresult;
@@ -267,6 +288,12 @@ llvmpipe_get_query_result_resource(struct pipe_context *pipe,
       case PIPE_QUERY_SO_OVERFLOW_PREDICATE:
          value = !!(pq->num_primitives_generated[0] > pq->num_primitives_written[0]);
          break;
+      case LP_QUERY_CS_DISPATCHES:
+         value = pq->end[0];
+         break;
+      case LP_QUERY_CS_DISPATCH_TIME:
+         value = pq->end[0] / 1000;
+         break;
       case PIPE_QUERY_PIPELINE_STATISTICS:
          switch ((enum pipe_statistics_query_index)index) {
          case PIPE_STAT_QUERY_IA_VERTICES:
@@ -351,17 +378,18 @@ llvmpipe_begin_query(struct pipe_context *pipe, struct pipe_query *q)
    struct llvmpipe_context *llvmpipe = llvmpipe_context( pipe );
    struct llvmpipe_query *pq = llvmpipe_query(q);
 
-   /* Check if the query is already in the scene.  If so, we need to
-    * flush the scene now.  Real apps shouldn't re-use a query in a
+   /* Check if the query is already in a scene.  If so, we need to
+    * flush the scene and wait for it now, as the rasterizer may still be
+    * writing the results.  Real apps shouldn't re-use a query in a
     * frame of rendering.
     */
-   if (pq->fence && !lp_fence_issued(pq->fence)) {
+   if (pq->fence && !lp_fence_signalled(pq->fence)) {
       llvmpipe_finish(pipe, __FUNCTION__);
    }
 
 
-   memset(pq->start, 0, sizeof(pq->start));
-   memset(pq->end, 0, sizeof(pq->end));
+   memset(pq->start, 0, pq->num_threads * sizeof(*pq->start));
+   memset(pq->end, 0, pq->num_threads * sizeof(*pq->end));
    lp_setup_begin_query(llvmpipe->setup, pq);
 
    switch (pq->type) {
@@ -401,6 +429,12 @@ llvmpipe_begin_query(struct pipe_context *pipe, struct pipe_query *q)
       llvmpipe->active_occlusion_queries++;
       llvmpipe->dirty |= LP_NEW_OCCLUSION_QUERY;
       break;
+   case LP_QUERY_CS_DISPATCHES:
+      pq->start[0] = llvmpipe->cs_dispatches;
+      break;
+   case LP_QUERY_CS_DISPATCH_TIME:
+      pq->start[0] = llvmpipe->cs_dispatch_time;
+      break;
    default:
       break;
    }
@@ -480,6 +514,12 @@ llvmpipe_end_query(struct pipe_context *pipe, struct pipe_query *q)
       llvmpipe->active_occlusion_queries--;
       llvmpipe->dirty |= LP_NEW_OCCLUSION_QUERY;
       break;
+   case LP_QUERY_CS_DISPATCHES:
+      pq->end[0] = llvmpipe->cs_dispatches - pq->start[0];
+      break;
+   case LP_QUERY_CS_DISPATCH_TIME:
+      pq->end[0] = llvmpipe->cs_dispatch_time - pq->start[0];
+      break;
    default:
       break;
    }
@@ -529,3 +569,25 @@ void llvmpipe_init_query_funcs(struct llvmpipe_context *llvmpipe )
 }
 
 
+static const struct pipe_driver_query_info lp_driver_query_list[] = {
+   {"cs-dispatches", LP_QUERY_CS_DISPATCHES, {0},
+    PIPE_DRIVER_QUERY_TYPE_UINT64, PIPE_DRIVER_QUERY_RESULT_TYPE_AVERAGE},
+   {"cs-dispatch-time", LP_QUERY_CS_DISPATCH_TIME, {0},
+    PIPE_DRIVER_QUERY_TYPE_MICROSECONDS, PIPE_DRIVER_QUERY_RESULT_TYPE_AVERAGE},
+};
+
+
+int
+llvmpipe_get_driver_query_info(struct pipe_screen *screen,
+                               unsigned index,
+                               struct pipe_driver_query_info *info)
+{
+   if (!info)
+      return ARRAY_SIZE(lp_driver_query_list);
+
+   if (index >= ARRAY_SIZE(lp_driver_query_list))
+      return 0;
+
+   *info = lp_driver_query_list[index];
+   return 1;
+}
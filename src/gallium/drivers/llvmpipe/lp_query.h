@@ -42,8 +42,9 @@ struct llvmpipe_context;
 
 
 struct llvmpipe_query {
-   uint64_t start[LP_MAX_THREADS];  /* start count value for each thread */
-   uint64_t end[LP_MAX_THREADS];    /* end count value for each thread */
+   uint64_t *start;                 /* start count value for each thread */
+   uint64_t *end;                   /* end count value for each thread */
+   unsigned num_threads;            /* size of the start/end arrays */
    struct lp_fence *fence;          /* fence from last scene this was binned in */
    unsigned type;                   /* PIPE_QUERY_* */
    unsigned index;
@@ -54,8 +55,18 @@ struct llvmpipe_query {
 };
 
 
+/** Driver-specific queries, see llvmpipe_get_driver_query_info() */
+#define LP_QUERY_CS_DISPATCHES      (PIPE_QUERY_DRIVER_SPECIFIC + 0)
+#define LP_QUERY_CS_DISPATCH_TIME   (PIPE_QUERY_DRIVER_SPECIFIC + 1)
+
+
 extern void llvmpipe_init_query_funcs(struct llvmpipe_context * );
 
+extern int
+llvmpipe_get_driver_query_info(struct pipe_screen *screen,
+                               unsigned index,
+                               struct pipe_driver_query_info *info);
+
 extern boolean llvmpipe_check_render_cond(struct llvmpipe_context *);
 
 #endif /* LP_QUERY_H */
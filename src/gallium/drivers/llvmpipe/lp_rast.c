@@ -28,6 +28,7 @@
 #include <limits.h>
 #include "util/u_memory.h"
 #include "util/u_math.h"
+#include "util/u_cpu_detect.h"
 #include "util/u_rect.h"
 #include "util/u_surface.h"
 #include "util/u_pack_color.h"
@@ -74,15 +75,18 @@ lp_rast_begin( struct lp_rasterizer *rast,
    LP_DBG(DEBUG_RAST, "%s\n", __FUNCTION__);
 
    lp_scene_begin_rasterization( scene );
-   lp_scene_bin_iter_begin( scene );
+   lp_scene_bin_iter_begin( scene, MAX2(1, rast->num_threads) );
 }
 
 
+/**
+ * End rasterizing a scene.
+ * The scene itself is released by the setup code once its fence has
+ * been signalled, see lp_setup_get_empty_scene().
+ */
 static void
 lp_rast_end( struct lp_rasterizer *rast )
 {
-   lp_scene_end_rasterization( rast->curr_scene );
-
    rast->curr_scene = NULL;
 }
 
@@ -730,12 +734,18 @@ rasterize_scene(struct lp_rasterizer_task *task,
       /* loop over scene bins, rasterize each */
       {
          struct cmd_bin *bin;
+         boolean stolen;
          int i, j;
 
          assert(scene);
-         while ((bin = lp_scene_bin_iter_next(scene, &i, &j))) {
-            if (!is_empty_bin( bin ))
+         while ((bin = lp_scene_bin_iter_next(scene, task->thread_index,
+                                              &i, &j, &stolen))) {
+            if (!is_empty_bin( bin )) {
                rasterize_bin(task, bin, i, j);
+               task->nr_tiles_executed++;
+               if (stolen)
+                  task->nr_tiles_stolen++;
+            }
          }
       }
    }
@@ -807,29 +817,12 @@ lp_rast_queue_scene( struct lp_rasterizer *rast,
 }
 
 
-void
-lp_rast_finish( struct lp_rasterizer *rast )
-{
-   if (rast->num_threads == 0) {
-      /* nothing to do */
-   }
-   else {
-      int i;
-
-      /* wait for work to complete */
-      for (i = 0; i < rast->num_threads; i++) {
-         pipe_semaphore_wait(&rast->tasks[i].work_done);
-      }
-   }
-}
-
-
 /**
  * This is the thread's main entrypoint.
  * It's a simple loop:
  *   1. wait for work
  *   2. do work
- *   3. signal that we're done
+ * Completion of each scene is signalled through the scene's fence.
  */
 static int
 thread_function(void *init_data)
@@ -888,11 +881,8 @@ thread_function(void *init_data)
          lp_rast_end( rast );
       }
 
-      /* signal done with work */
       if (debug)
          debug_printf("thread %d done working\n", task->thread_index);
-
-      pipe_semaphore_signal(&task->work_done);
    }
 
 #ifdef _WIN32
@@ -903,6 +893,34 @@ thread_function(void *init_data)
 }
 
 
+/**
+ * On machines with several L3 caches (multi-socket or multi-module CPUs),
+ * pin consecutive rasterizer threads to the cores sharing one L3.
+ * Consecutive threads own adjacent bands of tiles (see
+ * lp_scene_bin_iter_begin()) and steal from their neighbours first, so
+ * each group of cores mostly touches its own part of the framebuffer.
+ */
+static void
+pin_rast_threads(struct lp_rasterizer *rast)
+{
+   unsigned cores_per_L3 = util_cpu_caps.cores_per_L3;
+   unsigned num_L3_caches, i;
+
+   if (!cores_per_L3 || !rast->num_threads)
+      return;
+
+   num_L3_caches = DIV_ROUND_UP(util_cpu_caps.nr_cpus, cores_per_L3);
+   if (num_L3_caches <= 1)
+      return;
+
+   for (i = 0; i < rast->num_threads; i++) {
+      util_pin_thread_to_L3(rast->threads[i],
+                            i * num_L3_caches / rast->num_threads,
+                            cores_per_L3);
+   }
+}
+
+
 /**
  * Initialize semaphores and spawn the threads.
  */
@@ -922,6 +940,8 @@ create_rast_threads(struct lp_rasterizer *rast)
          break;
       }
    }
+
+   pin_rast_threads(rast);
 }
 
 
@@ -947,6 +967,18 @@ lp_rast_create( unsigned num_threads )
       goto no_full_scenes;
    }
 
+   rast->tasks = CALLOC(MAX2(1, num_threads), sizeof(*rast->tasks));
+   if (!rast->tasks) {
+      goto no_tasks;
+   }
+
+   if (num_threads) {
+      rast->threads = CALLOC(num_threads, sizeof(*rast->threads));
+      if (!rast->threads) {
+         goto no_thread_data_cache;
+      }
+   }
+
    for (i = 0; i < MAX2(1, num_threads); i++) {
       struct lp_rasterizer_task *task = &rast->tasks[i];
       task->rast = rast;
@@ -974,12 +1006,15 @@ lp_rast_create( unsigned num_threads )
    return rast;
 
 no_thread_data_cache:
-   for (i = 0; i < MAX2(1, rast->num_threads); i++) {
+   for (i = 0; i < MAX2(1, num_threads); i++) {
       if (rast->tasks[i].thread_data.cache) {
          align_free(rast->tasks[i].thread_data.cache);
       }
    }
 
+   FREE(rast->threads);
+   FREE(rast->tasks);
+no_tasks:
    lp_scene_queue_destroy(rast->full_scenes);
 no_full_scenes:
    FREE(rast);
@@ -1020,6 +1055,8 @@ void lp_rast_destroy( struct lp_rasterizer *rast )
       pipe_semaphore_destroy(&rast->tasks[i].work_done);
    }
    for (i = 0; i < MAX2(1, rast->num_threads); i++) {
+      lp_print_thread_counters(i, rast->tasks[i].nr_tiles_executed,
+                               rast->tasks[i].nr_tiles_stolen);
       align_free(rast->tasks[i].thread_data.cache);
    }
 
@@ -1030,6 +1067,8 @@ void lp_rast_destroy( struct lp_rasterizer *rast )
 
    lp_scene_queue_destroy(rast->full_scenes);
 
+   FREE(rast->threads);
+   FREE(rast->tasks);
    FREE(rast);
 }
 
@@ -102,6 +102,10 @@ struct lp_rasterizer_task
 
    pipe_semaphore work_ready;
    pipe_semaphore work_done;
+
+   /** Non-empty tiles rendered / taken from other threads */
+   unsigned nr_tiles_executed;
+   unsigned nr_tiles_stolen;
 };
 
 
@@ -122,10 +126,10 @@ struct lp_rasterizer
    struct lp_scene *curr_scene;
 
    /** A task object for each rasterization thread */
-   struct lp_rasterizer_task tasks[LP_MAX_THREADS];
+   struct lp_rasterizer_task *tasks;
 
    unsigned num_threads;
-   thrd_t threads[LP_MAX_THREADS];
+   thrd_t *threads;
 
    /** For synchronizing the rasterization threads */
    util_barrier barrier;
@@ -25,6 +25,7 @@
  *
  **************************************************************************/
 
+#include "util/u_atomic.h"
 #include "util/u_framebuffer.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
@@ -32,6 +33,7 @@
 #include "util/simple_list.h"
 #include "util/format/u_format.h"
 #include "lp_scene.h"
+#include "lp_screen.h"
 #include "lp_fence.h"
 #include "lp_debug.h"
 
@@ -62,7 +64,16 @@ lp_scene_create( struct pipe_context *pipe )
    scene->data.head =
       CALLOC_STRUCT(data_block);
 
-   (void) mtx_init(&scene->mutex, mtx_plain);
+   /* one range of bins per rasterizer thread */
+   STATIC_ASSERT(sizeof(*scene->bin_ranges) == 64);
+   scene->bin_ranges = align_calloc(MAX2(1, llvmpipe_screen(pipe->screen)->num_threads) *
+                                    sizeof(*scene->bin_ranges), 64);
+   if (!scene->data.head || !scene->bin_ranges) {
+      FREE(scene->data.head);
+      align_free(scene->bin_ranges);
+      FREE(scene);
+      return NULL;
+   }
 
 #ifdef DEBUG
    /* Do some scene limit sanity checks here */
@@ -90,9 +101,9 @@ void
 lp_scene_destroy(struct lp_scene *scene)
 {
    lp_fence_reference(&scene->fence, NULL);
-   mtx_destroy(&scene->mutex);
    assert(scene->data.head->next == NULL);
    FREE(scene->data.head);
+   align_free(scene->bin_ranges);
    FREE(scene);
 }
 
@@ -210,8 +221,32 @@ lp_scene_begin_rasterization(struct lp_scene *scene)
 
 
 
+/**
+ * Drop the references held by a list of resource reference blocks.
+ */
+static void
+release_resource_references(struct resource_ref *list)
+{
+   struct resource_ref *ref;
+   int i;
+
+   for (ref = list; ref; ref = ref->next) {
+      for (i = 0; i < ref->count; i++) {
+         if (LP_DEBUG & DEBUG_SETUP)
+            debug_printf("resource %p %dx%d sz %d\n",
+                         (void *) ref->resource[i],
+                         ref->resource[i]->width0,
+                         ref->resource[i]->height0,
+                         llvmpipe_resource_size(ref->resource[i]));
+         pipe_resource_reference(&ref->resource[i], NULL);
+      }
+   }
+}
+
+
 /**
  * Free all the temporary data in a scene.
+ * Must not be called before the scene's fence has been signalled.
  */
 void
 lp_scene_end_rasterization(struct lp_scene *scene )
@@ -258,28 +293,12 @@ lp_scene_end_rasterization(struct lp_scene *scene )
 
    /* Decrement texture ref counts
     */
-   {
-      struct resource_ref *ref;
-      int i, j = 0;
-
-      for (ref = scene->resources; ref; ref = ref->next) {
-         for (i = 0; i < ref->count; i++) {
-            if (LP_DEBUG & DEBUG_SETUP)
-               debug_printf("resource %d: %p %dx%d sz %d\n",
-                            j,
-                            (void *) ref->resource[i],
-                            ref->resource[i]->width0,
-                            ref->resource[i]->height0,
-                            llvmpipe_resource_size(ref->resource[i]));
-            j++;
-            pipe_resource_reference(&ref->resource[i], NULL);
-         }
-      }
+   release_resource_references(scene->resources);
+   release_resource_references(scene->writeable_resources);
 
-      if (LP_DEBUG & DEBUG_SETUP)
-         debug_printf("scene %d resources, sz %d\n",
-                      j, scene->resource_reference_size);
-   }
+   if (LP_DEBUG & DEBUG_SETUP)
+      debug_printf("scene resources, sz %d\n",
+                   scene->resource_reference_size);
 
    /* Free all scene data blocks:
     */
@@ -299,6 +318,7 @@ lp_scene_end_rasterization(struct lp_scene *scene )
    lp_fence_reference(&scene->fence, NULL);
 
    scene->resources = NULL;
+   scene->writeable_resources = NULL;
    scene->scene_size = 0;
    scene->resource_reference_size = 0;
 
@@ -376,19 +396,20 @@ lp_scene_data_size( const struct lp_scene *scene )
 
 
 /**
- * Add a reference to a resource by the scene.
+ * Add a reference to a resource to the given list of the scene.
  */
-boolean
-lp_scene_add_resource_reference(struct lp_scene *scene,
-                                struct pipe_resource *resource,
-                                boolean initializing_scene)
+static boolean
+add_resource_reference(struct lp_scene *scene,
+                       struct resource_ref **list,
+                       struct pipe_resource *resource,
+                       boolean initializing_scene)
 {
-   struct resource_ref *ref, **last = &scene->resources;
+   struct resource_ref *ref, **last = list;
    int i;
 
    /* Look at existing resource blocks:
     */
-   for (ref = scene->resources; ref; ref = ref->next) {
+   for (ref = *list; ref; ref = ref->next) {
       last = &ref->next;
 
       /* Search for this resource:
@@ -435,16 +456,39 @@ lp_scene_add_resource_reference(struct lp_scene *scene,
 
 
 /**
- * Does this scene have a reference to the given resource?
+ * Add a reference to a resource by the scene.
  */
 boolean
-lp_scene_is_resource_referenced(const struct lp_scene *scene,
-                                const struct pipe_resource *resource)
+lp_scene_add_resource_reference(struct lp_scene *scene,
+                                struct pipe_resource *resource,
+                                boolean initializing_scene)
+{
+   return add_resource_reference(scene, &scene->resources,
+                                 resource, initializing_scene);
+}
+
+
+/**
+ * Add a reference to a resource the scene may write to (ssbo, image).
+ */
+boolean
+lp_scene_add_writeable_resource_reference(struct lp_scene *scene,
+                                          struct pipe_resource *resource,
+                                          boolean initializing_scene)
+{
+   return add_resource_reference(scene, &scene->writeable_resources,
+                                 resource, initializing_scene);
+}
+
+
+static boolean
+is_resource_in_list(const struct resource_ref *list,
+                    const struct pipe_resource *resource)
 {
    const struct resource_ref *ref;
    int i;
 
-   for (ref = scene->resources; ref; ref = ref->next) {
+   for (ref = list; ref; ref = ref->next) {
       for (i = 0; i < ref->count; i++)
          if (ref->resource[i] == resource)
             return TRUE;
@@ -454,63 +498,139 @@ lp_scene_is_resource_referenced(const struct lp_scene *scene,
 }
 
 
+/**
+ * Does this scene have a reference to the given resource?
+ * Returns a mask of LP_REFERENCED_FOR_READ/WRITE.  The framebuffer of
+ * the scene is checked as well, as the scene may still be rasterizing
+ * into it after the context bound a different one.
+ */
+unsigned
+lp_scene_is_resource_referenced(const struct lp_scene *scene,
+                                const struct pipe_resource *resource)
+{
+   unsigned i;
 
+   for (i = 0; i < scene->fb.nr_cbufs; i++) {
+      if (scene->fb.cbufs[i] && scene->fb.cbufs[i]->texture == resource)
+         return LP_REFERENCED_FOR_READ | LP_REFERENCED_FOR_WRITE;
+   }
+   if (scene->fb.zsbuf && scene->fb.zsbuf->texture == resource)
+      return LP_REFERENCED_FOR_READ | LP_REFERENCED_FOR_WRITE;
 
-/** advance curr_x,y to the next bin */
-static boolean
-next_bin(struct lp_scene *scene)
+   if (is_resource_in_list(scene->writeable_resources, resource))
+      return LP_REFERENCED_FOR_READ | LP_REFERENCED_FOR_WRITE;
+
+   if (is_resource_in_list(scene->resources, resource))
+      return LP_REFERENCED_FOR_READ;
+
+   return LP_UNREFERENCED;
+}
+
+
+
+
+/**
+ * Pack a [begin, end) range of bin indices into a single word, so that it
+ * can be updated with one compare-and-swap.
+ */
+static inline uint64_t
+pack_bin_range(unsigned begin, unsigned end)
 {
-   scene->curr_x++;
-   if (scene->curr_x >= scene->tiles_x) {
-      scene->curr_x = 0;
-      scene->curr_y++;
-   }
-   if (scene->curr_y >= scene->tiles_y) {
-      /* no more bins */
-      return FALSE;
-   }
-   return TRUE;
+   return ((uint64_t)end << 32) | begin;
 }
 
 
+/**
+ * Split the bins of the scene into one range per rasterizer thread.
+ * Bins are numbered in row-major order, so each range is a band of tile
+ * rows and a thread mostly works on a coherent region of the framebuffer.
+ * Must be called before the threads start calling lp_scene_bin_iter_next().
+ */
 void
-lp_scene_bin_iter_begin( struct lp_scene *scene )
+lp_scene_bin_iter_begin( struct lp_scene *scene, unsigned num_threads )
 {
-   scene->curr_x = scene->curr_y = -1;
+   const unsigned num_bins = lp_scene_get_num_bins(scene);
+   unsigned i;
+
+   assert(num_threads > 0);
+   assert(num_threads <= MAX2(1, llvmpipe_screen(scene->pipe->screen)->num_threads));
+
+   scene->num_bin_ranges = num_threads;
+   for (i = 0; i < num_threads; i++) {
+      scene->bin_ranges[i].range =
+         pack_bin_range(num_bins * i / num_threads,
+                        num_bins * (i + 1) / num_threads);
+   }
 }
 
 
 /**
- * Return pointer to next bin to be rendered.
- * The lp_scene::curr_x and ::curr_y fields will be advanced.
+ * Take one bin index off a range, from the front (for the owning thread)
+ * or from the back (for a thread stealing work).
+ */
+static boolean
+take_bin(uint64_t *range, boolean from_back, unsigned *index)
+{
+   uint64_t old = p_atomic_read(range);
+
+   for (;;) {
+      unsigned begin = (unsigned)old;
+      unsigned end = (unsigned)(old >> 32);
+      uint64_t new_range, prev;
+
+      if (begin >= end)
+         return FALSE;
+
+      if (from_back)
+         new_range = pack_bin_range(begin, end - 1);
+      else
+         new_range = pack_bin_range(begin + 1, end);
+
+      prev = p_atomic_cmpxchg(range, old, new_range);
+      if (prev == old) {
+         *index = from_back ? end - 1 : begin;
+         return TRUE;
+      }
+      old = prev;
+   }
+}
+
+
+/**
+ * Return pointer to next bin to be rendered by the given thread.
  * Multiple rendering threads will call this function to get a chunk
- * of work (a bin) to work on.
+ * of work (a bin) to work on.  Each thread first drains its own range of
+ * bins, then steals from the back of the other threads' ranges, nearest
+ * first: thread_index + 1, thread_index - 1, thread_index + 2, and so on,
+ * wrapping around.  This never blocks.
+ * \param stolen  set to whether the bin came from another thread's range
  */
 struct cmd_bin *
-lp_scene_bin_iter_next( struct lp_scene *scene , int *x, int *y)
+lp_scene_bin_iter_next( struct lp_scene *scene, unsigned thread_index,
+                        int *x, int *y, boolean *stolen )
 {
-   struct cmd_bin *bin = NULL;
+   const unsigned num_ranges = scene->num_bin_ranges;
+   unsigned index, i;
 
-   mtx_lock(&scene->mutex);
+   assert(thread_index < num_ranges);
 
-   if (scene->curr_x < 0) {
-      /* first bin */
-      scene->curr_x = 0;
-      scene->curr_y = 0;
-   }
-   else if (!next_bin(scene)) {
-      /* no more bins left */
-      goto end;
+   for (i = 0; i < num_ranges; i++) {
+      /* Alternate between the ranges after and before our own.  With an
+       * even number of ranges, the farthest one comes up only once.
+       */
+      unsigned distance = (i + 1) / 2;
+      unsigned victim = (i & 1) ? (thread_index + distance) % num_ranges :
+         (thread_index + num_ranges - distance) % num_ranges;
+
+      if (take_bin(&scene->bin_ranges[victim].range, i != 0, &index)) {
+         *x = index % scene->tiles_x;
+         *y = index / scene->tiles_x;
+         *stolen = i != 0;
+         return lp_scene_get_bin(scene, *x, *y);
+      }
    }
 
-   bin = lp_scene_get_bin(scene, scene->curr_x, scene->curr_y);
-   *x = scene->curr_x;
-   *y = scene->curr_y;
-
-end:
-   /*printf("return bin %p at %d, %d\n", (void *) bin, *bin_x, *bin_y);*/
-   mtx_unlock(&scene->mutex);
-   return bin;
+   return NULL;
 }
 
 
@@ -162,6 +162,9 @@ struct lp_scene {
    /** list of resources referenced by the scene commands */
    struct resource_ref *resources;
 
+   /** list of resources the scene commands may write to (ssbos, images) */
+   struct resource_ref *writeable_resources;
+
    /** Total memory used by the scene (in bytes).  This sums all the
     * data blocks and counts all bins, state, resource references and
     * other random allocations within the scene.
@@ -180,8 +183,16 @@ struct lp_scene {
     */
    unsigned tiles_x, tiles_y;
 
-   int curr_x, curr_y;  /**< for iterating over bins */
-   mtx_t mutex;
+   /**
+    * Per rasterizer thread ranges of bins still to be rendered, see
+    * lp_scene_bin_iter_next().  Padded and allocated 64-byte aligned
+    * to keep each one on its own cache line.
+    */
+   struct lp_bin_range {
+      uint64_t range;
+      uint8_t pad[56];
+   } *bin_ranges;
+   unsigned num_bin_ranges;
 
    struct cmd_bin tile[TILES_X][TILES_Y];
    struct data_block_list data;
@@ -206,8 +217,12 @@ boolean lp_scene_add_resource_reference(struct lp_scene *scene,
                                         struct pipe_resource *resource,
                                         boolean initializing_scene);
 
-boolean lp_scene_is_resource_referenced(const struct lp_scene *scene,
-                                        const struct pipe_resource *resource );
+boolean lp_scene_add_writeable_resource_reference(struct lp_scene *scene,
+                                                  struct pipe_resource *resource,
+                                                  boolean initializing_scene);
+
+unsigned lp_scene_is_resource_referenced(const struct lp_scene *scene,
+                                         const struct pipe_resource *resource );
 
 
 /**
@@ -386,10 +401,11 @@ lp_scene_get_num_bins( const struct lp_scene *scene )
 
 
 void
-lp_scene_bin_iter_begin( struct lp_scene *scene );
+lp_scene_bin_iter_begin( struct lp_scene *scene, unsigned num_threads );
 
 struct cmd_bin *
-lp_scene_bin_iter_next( struct lp_scene *scene, int *x, int *y );
+lp_scene_bin_iter_next( struct lp_scene *scene, unsigned thread_index,
+                        int *x, int *y, boolean *stolen );
 
 
 
@@ -38,6 +38,7 @@
 #include "draw/draw_context.h"
 #include "gallivm/lp_bld_type.h"
 #include "gallivm/lp_bld_nir.h"
+#include "gallivm/lp_bld_debug.h"
 #include "util/disk_cache.h"
 #include "util/os_misc.h"
 #include "util/os_time.h"
@@ -48,6 +49,7 @@
 #include "lp_context.h"
 #include "lp_debug.h"
 #include "lp_public.h"
+#include "lp_query.h"
 #include "lp_limits.h"
 #include "lp_rast.h"
 #include "lp_cs_tpool.h"
@@ -635,6 +637,7 @@ static const struct nir_shader_compiler_options gallivm_nir_options = {
    .max_unroll_iterations = 32,
    .use_interpolated_input_intrinsics = true,
    .lower_to_scalar = true,
+   .use_ir_arena = true,
 };
 
 static void
@@ -788,6 +791,13 @@ llvmpipe_destroy_screen( struct pipe_screen *_screen )
    struct llvmpipe_screen *screen = llvmpipe_screen(_screen);
    struct sw_winsys *winsys = screen->winsys;
 
+   if (screen->num_compile_threads) {
+      util_queue_destroy(&screen->fs_compile_queue);
+      for (unsigned i = 0; i < screen->num_compile_threads; i++)
+         LLVMContextDispose(screen->compile_contexts[i]);
+      FREE(screen->compile_contexts);
+   }
+
    if (screen->cs_tpool)
       lp_cs_tpool_destroy(screen->cs_tpool);
 
@@ -806,7 +816,6 @@ llvmpipe_destroy_screen( struct pipe_screen *_screen )
    glsl_type_singleton_decref();
 
    mtx_destroy(&screen->rast_mutex);
-   mtx_destroy(&screen->cs_mutex);
    FREE(screen);
 }
 
@@ -860,6 +869,7 @@ llvmpipe_get_timestamp(struct pipe_screen *_screen)
 static void lp_disk_cache_create(struct llvmpipe_screen *screen)
 {
    struct mesa_sha1 ctx;
+   struct util_cpu_caps cpu_caps;
    unsigned char sha1[20];
    char cache_id[20 * 2 + 1];
    _mesa_sha1_init(&ctx);
@@ -868,6 +878,17 @@ static void lp_disk_cache_create(struct llvmpipe_screen *screen)
        !disk_cache_get_function_identifier(LLVMLinkInMCJIT, &ctx))
       return;
 
+   /* The cache holds machine code, which depends on the CPU features and
+    * on the code generation options, but not on the number of cores.
+    */
+   memcpy(&cpu_caps, &util_cpu_caps, sizeof(cpu_caps));
+   cpu_caps.nr_cpus = 0;
+   cpu_caps.cores_per_L3 = 0;
+   _mesa_sha1_update(&ctx, &cpu_caps, sizeof(cpu_caps));
+   _mesa_sha1_update(&ctx, &gallivm_perf, sizeof(gallivm_perf));
+   _mesa_sha1_update(&ctx, &lp_native_vector_width,
+                     sizeof(lp_native_vector_width));
+
    _mesa_sha1_final(&ctx, sha1);
    disk_cache_format_hex_id(cache_id, sha1, 20 * 2);
 
@@ -962,6 +983,7 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    screen->base.fence_finish = llvmpipe_fence_finish;
 
    screen->base.get_timestamp = llvmpipe_get_timestamp;
+   screen->base.get_driver_query_info = llvmpipe_get_driver_query_info;
 
    screen->base.finalize_nir = llvmpipe_finalize_nir;
 
@@ -974,7 +996,14 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    screen->num_threads = 0;
 #endif
    screen->num_threads = debug_get_num_option("LP_NUM_THREADS", screen->num_threads);
-   screen->num_threads = MIN2(screen->num_threads, LP_MAX_THREADS);
+
+   screen->num_scenes = debug_get_num_option("LP_NUM_SCENES", LP_MAX_SCENES);
+   screen->num_scenes = CLAMP(screen->num_scenes, 1, LP_MAX_SCENES);
+   /* Without rasterizer threads scenes are rendered synchronously, so there
+    * is nothing to overlap binning with.
+    */
+   if (!screen->num_threads)
+      screen->num_scenes = 1;
 
    screen->rast = lp_rast_create(screen->num_threads);
    if (!screen->rast) {
@@ -991,7 +1020,34 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
       FREE(screen);
       return NULL;
    }
-   (void) mtx_init(&screen->cs_mutex, mtx_plain);
+
+   /* Fragment shader variants are compiled in the background, using a
+    * quickly compiled fallback until they are ready.
+    */
+   screen->num_compile_threads =
+      debug_get_num_option("LP_NUM_COMPILE_THREADS",
+                           screen->num_threads ? 2 : 0);
+   screen->num_compile_threads = MIN2(screen->num_compile_threads,
+                                      util_cpu_caps.nr_cpus);
+#ifdef USE_GLOBAL_LLVM_CONTEXT
+   /* The global context can't be used by several threads at once. */
+   screen->num_compile_threads = 0;
+#endif
+   if (screen->num_compile_threads) {
+      screen->compile_contexts = CALLOC(screen->num_compile_threads,
+                                        sizeof(LLVMContextRef));
+      if (!screen->compile_contexts ||
+          !util_queue_init(&screen->fs_compile_queue, "lpfs", 64,
+                           screen->num_compile_threads,
+                           UTIL_QUEUE_INIT_RESIZE_IF_FULL |
+                           UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY)) {
+         FREE(screen->compile_contexts);
+         screen->compile_contexts = NULL;
+         screen->num_compile_threads = 0;
+      }
+      for (unsigned i = 0; i < screen->num_compile_threads; i++)
+         screen->compile_contexts[i] = LLVMContextCreate();
+   }
 
    lp_disk_cache_create(screen);
    return &screen->base;
@@ -37,6 +37,7 @@
 #include "pipe/p_screen.h"
 #include "pipe/p_defines.h"
 #include "os/os_thread.h"
+#include "util/u_queue.h"
 #include "gallivm/lp_bld.h"
 #include "gallivm/lp_bld_misc.h"
 
@@ -50,6 +51,7 @@ struct llvmpipe_screen
    struct sw_winsys *winsys;
 
    unsigned num_threads;
+   unsigned num_scenes;
 
    /* Increments whenever textures are modified.  Contexts can track this.
     */
@@ -59,7 +61,13 @@ struct llvmpipe_screen
    mtx_t rast_mutex;
 
    struct lp_cs_tpool *cs_tpool;
-   mtx_t cs_mutex;
+
+   /* Background compilation of fragment shader variants, each thread
+    * has its own LLVM context.
+    */
+   unsigned num_compile_threads;
+   struct util_queue fs_compile_queue;
+   LLVMContextRef *compile_contexts;
 
    bool use_tgsi;
 
@@ -64,13 +64,18 @@ static boolean set_scene_state( struct lp_setup_context *, enum setup_state,
 static boolean try_update_scene_state( struct lp_setup_context *setup );
 
 
+/**
+ * Pick the next scene of the pool for binning.  Scenes are recycled in
+ * submission order, so this only blocks when all the scenes are still
+ * in flight in the rasterizer.
+ */
 static void
 lp_setup_get_empty_scene(struct lp_setup_context *setup)
 {
    assert(setup->scene == NULL);
 
    setup->scene_idx++;
-   setup->scene_idx %= ARRAY_SIZE(setup->scenes);
+   setup->scene_idx %= setup->num_scenes;
 
    setup->scene = setup->scenes[setup->scene_idx];
 
@@ -80,6 +85,7 @@ lp_setup_get_empty_scene(struct lp_setup_context *setup)
                       __FUNCTION__, setup->scene->fence->id);
 
       lp_fence_wait(setup->scene->fence);
+      lp_scene_end_rasterization(setup->scene);
    }
 
    lp_scene_begin_binning(setup->scene, &setup->fb);
@@ -147,6 +153,21 @@ void lp_setup_reset( struct lp_setup_context *setup )
 }
 
 
+static boolean
+scene_has_display_target(const struct lp_scene *scene)
+{
+   unsigned i;
+
+   for (i = 0; i < scene->fb.nr_cbufs; i++) {
+      if (scene->fb.cbufs[i] &&
+          llvmpipe_resource(scene->fb.cbufs[i]->texture)->dt)
+         return TRUE;
+   }
+
+   return FALSE;
+}
+
+
 /** Rasterize all scene's bins */
 static void
 lp_setup_rasterize_scene( struct lp_setup_context *setup )
@@ -166,22 +187,20 @@ lp_setup_rasterize_scene( struct lp_setup_context *setup )
       setup->last_fence->issued = TRUE;
 
    mtx_lock(&screen->rast_mutex);
-
-   /* FIXME: We enqueue the scene then wait on the rasterizer to finish.
-    * This means we never actually run any vertex stuff in parallel to
-    * rasterization (not in the same context at least) which is what the
-    * multiple scenes per setup is about - when we get a new empty scene
-    * any old one is already empty again because we waited here for
-    * raster tasks to be finished. Ideally, we shouldn't need to wait here
-    * and rely on fences elsewhere when waiting is necessary.
-    * Certainly, lp_scene_end_rasterization() would need to be deferred too
-    * and there's probably other bits why this doesn't actually work.
-    */
    lp_rast_queue_scene(screen->rast, scene);
-   lp_rast_finish(screen->rast);
    mtx_unlock(&screen->rast_mutex);
 
-   lp_scene_end_rasterization(setup->scene);
+   /* Scenes rendering to a display target are finished right away: the
+    * frontends present them without waiting on a fence, and the winsys
+    * only gets the display target unmapped in lp_scene_end_rasterization().
+    * Otherwise the scene stays in flight until it gets recycled.
+    */
+   if (setup->num_scenes == 1 || scene_has_display_target(scene)) {
+      if (scene->fence)
+         lp_fence_wait(scene->fence);
+      lp_scene_end_rasterization(scene);
+   }
+
    lp_setup_reset( setup );
 
    LP_DBG(DEBUG_SETUP, "%s done \n", __FUNCTION__);
@@ -1070,6 +1089,7 @@ unsigned
 lp_setup_is_resource_referenced( const struct lp_setup_context *setup,
                                 const struct pipe_resource *texture )
 {
+   unsigned referenced = LP_UNREFERENCED;
    unsigned i;
 
    /* check the render targets */
@@ -1081,11 +1101,11 @@ lp_setup_is_resource_referenced( const struct lp_setup_context *setup,
       return LP_REFERENCED_FOR_READ | LP_REFERENCED_FOR_WRITE;
    }
 
-   /* check textures referenced by the scene */
-   for (i = 0; i < ARRAY_SIZE(setup->scenes); i++) {
-      if (lp_scene_is_resource_referenced(setup->scenes[i], texture)) {
-         return LP_REFERENCED_FOR_READ;
-      }
+   /* check resources referenced by the scenes, including the ones
+    * still being rasterized
+    */
+   for (i = 0; i < setup->num_scenes; i++) {
+      referenced |= lp_scene_is_resource_referenced(setup->scenes[i], texture);
    }
 
    for (i = 0; i < ARRAY_SIZE(setup->ssbos); i++) {
@@ -1098,7 +1118,7 @@ lp_setup_is_resource_referenced( const struct lp_setup_context *setup,
          return LP_REFERENCED_FOR_READ | LP_REFERENCED_FOR_WRITE;
    }
 
-   return LP_UNREFERENCED;
+   return referenced;
 }
 
 
@@ -1298,6 +1318,31 @@ try_update_scene_state( struct lp_setup_context *setup )
                }
             }
          }
+
+         /* Shader buffers and images may be written by the scene, which
+          * can outlive the bindings while it is still being rasterized.
+          */
+         for (i = 0; i < ARRAY_SIZE(setup->ssbos); i++) {
+            if (setup->ssbos[i].current.buffer) {
+               if (!lp_scene_add_writeable_resource_reference(scene,
+                                                              setup->ssbos[i].current.buffer,
+                                                              new_scene)) {
+                  assert(!new_scene);
+                  return FALSE;
+               }
+            }
+         }
+
+         for (i = 0; i < ARRAY_SIZE(setup->images); i++) {
+            if (setup->images[i].current.resource) {
+               if (!lp_scene_add_writeable_resource_reference(scene,
+                                                              setup->images[i].current.resource,
+                                                              new_scene)) {
+                  assert(!new_scene);
+                  return FALSE;
+               }
+            }
+         }
       }
    }
 
@@ -1417,12 +1462,15 @@ lp_setup_destroy( struct lp_setup_context *setup )
       pipe_resource_reference(&setup->ssbos[i].current.buffer, NULL);
    }
 
-   /* free the scenes in the 'empty' queue */
-   for (i = 0; i < ARRAY_SIZE(setup->scenes); i++) {
+   /* wait for the scenes still in flight and free them */
+   for (i = 0; i < setup->num_scenes; i++) {
       struct lp_scene *scene = setup->scenes[i];
 
-      if (scene->fence)
-         lp_fence_wait(scene->fence);
+      if (scene->fence) {
+         if (lp_fence_issued(scene->fence))
+            lp_fence_wait(scene->fence);
+         lp_scene_end_rasterization(scene);
+      }
 
       lp_scene_destroy(scene);
    }
@@ -1459,6 +1507,7 @@ lp_setup_create( struct pipe_context *pipe,
 
 
    setup->num_threads = screen->num_threads;
+   setup->num_scenes = screen->num_scenes;
    setup->vbuf = draw_vbuf_stage(draw, &setup->base);
    if (!setup->vbuf) {
       goto no_vbuf;
@@ -1468,7 +1517,7 @@ lp_setup_create( struct pipe_context *pipe,
    draw_set_render(draw, &setup->base);
 
    /* create some empty scenes */
-   for (i = 0; i < MAX_SCENES; i++) {
+   for (i = 0; i < setup->num_scenes; i++) {
       setup->scenes[i] = lp_scene_create( pipe );
       if (!setup->scenes[i]) {
          goto no_scenes;
@@ -1488,7 +1537,7 @@ lp_setup_create( struct pipe_context *pipe,
    return setup;
 
 no_scenes:
-   for (i = 0; i < MAX_SCENES; i++) {
+   for (i = 0; i < setup->num_scenes; i++) {
       if (setup->scenes[i]) {
          lp_scene_destroy(setup->scenes[i]);
       }
@@ -1332,12 +1332,19 @@ static void llvmpipe_launch_grid(struct pipe_context *pipe,
    int num_tasks = job_info.grid_size[2] * job_info.grid_size[1] * job_info.grid_size[0];
    if (num_tasks) {
       struct lp_cs_tpool_task *task;
-      mtx_lock(&screen->cs_mutex);
+      int64_t t0 = os_time_get_nano();
+
+      /* The thread pool runs dispatches from other contexts concurrently,
+       * but this one has to complete before returning: the job references
+       * the kernel inputs and the bound state of the caller.
+       */
       task = lp_cs_tpool_queue_task(screen->cs_tpool, cs_exec_fn, &job_info, num_tasks);
 
       lp_cs_tpool_wait_for_task(screen->cs_tpool, &task);
-      mtx_unlock(&screen->cs_mutex);
+
+      llvmpipe->cs_dispatch_time += os_time_get_nano() - t0;
    }
+   llvmpipe->cs_dispatches++;
    llvmpipe->pipeline_statistics.cs_invocations += num_tasks * info->block[0] * info->block[1] * info->block[2];
 }
 
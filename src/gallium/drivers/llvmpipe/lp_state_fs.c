@@ -68,6 +68,7 @@
 #include "util/simple_list.h"
 #include "util/u_dual_blend.h"
 #include "util/os_time.h"
+#include "util/u_atomic.h"
 #include "pipe/p_shader_tokens.h"
 #include "draw/draw_context.h"
 #include "tgsi/tgsi_dump.h"
@@ -754,9 +755,17 @@ generate_fs_loop(struct gallivm_state *gallivm,
    if (shader->base.type == PIPE_SHADER_IR_TGSI)
       lp_build_tgsi_soa(gallivm, tokens, &params,
                         outputs);
-   else
-      lp_build_nir_soa(gallivm, shader->base.ir.nir, &params,
+   else {
+      /* lp_build_nir_soa() modifies the NIR it translates, and other
+       * variants of this shader may be compiled, or serialized for their
+       * cache key, at the same time by the compiler threads.  So translate
+       * a private copy and leave the shader's NIR untouched.
+       */
+      struct nir_shader *nir = nir_shader_clone(NULL, shader->base.ir.nir);
+      lp_build_nir_soa(gallivm, nir, &params,
                        outputs);
+      ralloc_free(nir);
+   }
 
    /* Alpha test */
    if (key->alpha.enabled) {
@@ -2757,8 +2766,7 @@ generate_unswizzled_blend(struct gallivm_state *gallivm,
  * 2x2 pixels.
  */
 static void
-generate_fragment(struct llvmpipe_context *lp,
-                  struct lp_fragment_shader *shader,
+generate_fragment(struct lp_fragment_shader *shader,
                   struct lp_fragment_shader_variant *variant,
                   unsigned partial_mask)
 {
@@ -2883,7 +2891,8 @@ generate_fragment(struct llvmpipe_context *lp,
       if(LLVMGetTypeKind(arg_types[i]) == LLVMPointerTypeKind)
          lp_add_function_attr(function, i + 1, LP_FUNC_ATTR_NOALIAS);
 
-   if (variant->gallivm->cache->data_size)
+   /* Fallback variants are built without a cache */
+   if (variant->gallivm->cache && variant->gallivm->cache->data_size)
       return;
 
    context_ptr  = LLVMGetParam(function, 0);
@@ -3305,9 +3314,107 @@ lp_fs_get_ir_cache_key(struct lp_fragment_shader_variant *variant,
    blob_finish(&blob);
 }
 
+/**
+ * Generate and compile the code of a fragment shader variant into
+ * variant->gallivm.  With \p edge_test_only the edge test function is
+ * also used for whole tiles, rather than building the specialized opaque
+ * one.
+ * \return the number of LLVM instructions generated
+ */
+static unsigned
+generate_variant_code(struct lp_fragment_shader_variant *variant,
+                      boolean edge_test_only)
+{
+   struct lp_fragment_shader *shader = variant->shader;
+   lp_jit_frag_func jit_function[2] = { NULL, NULL };
+   unsigned nr_instrs;
+
+   variant->function[RAST_WHOLE] = NULL;
+   variant->function[RAST_EDGE_TEST] = NULL;
+
+   lp_jit_init_types(variant);
+
+   generate_fragment(shader, variant, RAST_EDGE_TEST);
+
+   if (variant->opaque && !edge_test_only) {
+      /* Specialized shader, which doesn't need to read the color buffer. */
+      generate_fragment(shader, variant, RAST_WHOLE);
+   }
+
+   /*
+    * Compile everything
+    */
+
+   gallivm_compile_module(variant->gallivm);
+
+   nr_instrs = lp_build_count_ir_module(variant->gallivm->module);
+
+   jit_function[RAST_EDGE_TEST] = (lp_jit_frag_func)
+         gallivm_jit_function(variant->gallivm,
+                              variant->function[RAST_EDGE_TEST]);
+
+   if (variant->function[RAST_WHOLE]) {
+      jit_function[RAST_WHOLE] = (lp_jit_frag_func)
+            gallivm_jit_function(variant->gallivm,
+                                 variant->function[RAST_WHOLE]);
+   } else {
+      jit_function[RAST_WHOLE] = jit_function[RAST_EDGE_TEST];
+   }
+
+   /* The rasterizer threads may be running the fallback code of this
+    * variant, any mix of old and new functions is fine.
+    */
+   p_atomic_set(&variant->jit_function[RAST_WHOLE], jit_function[RAST_WHOLE]);
+   p_atomic_set(&variant->jit_function[RAST_EDGE_TEST],
+                jit_function[RAST_EDGE_TEST]);
+
+   return nr_instrs;
+}
+
+
+/**
+ * Compile the optimized code of a variant which is running its fallback
+ * code.  Runs on the fs_compile_queue.
+ */
+static void
+generate_variant_async(void *job, int thread_index)
+{
+   struct lp_fragment_shader_variant *variant = job;
+   struct llvmpipe_screen *screen = variant->screen;
+   struct lp_cached_code cached = { 0 };
+   char module_name[64];
+   int64_t t0;
+
+   t0 = os_time_get();
+
+   snprintf(module_name, sizeof(module_name), "fs%u_variant%u",
+            variant->shader->no, variant->no);
+
+   variant->gallivm = gallivm_create(module_name,
+                                     screen->compile_contexts[thread_index],
+                                     &cached);
+   if (!variant->gallivm)
+      return;
+
+   generate_variant_code(variant, FALSE);
+
+   if (variant->shader->base.ir.nir)
+      lp_disk_cache_insert_shader(screen, &cached, variant->ir_sha1_cache_key);
+
+   gallivm_free_ir(variant->gallivm);
+
+   LP_COUNT_ADD_ATOMIC(fs_async_compile_time, os_time_get() - t0);
+   LP_COUNT_ADD_ATOMIC(nr_fs_async_compiles, 1);
+}
+
+
 /**
  * Generate a new fragment shader variant from the shader code and
  * other state indicated by the key.
+ *
+ * Unless the code is in the disk cache, or there are no compiler threads,
+ * only an unoptimized fallback is compiled here, and the real code is
+ * compiled in the background and swapped in once it is ready.
  */
 static struct lp_fragment_shader_variant *
 generate_variant(struct llvmpipe_context *lp,
@@ -3318,8 +3425,8 @@ generate_variant(struct llvmpipe_context *lp,
    struct lp_fragment_shader_variant *variant;
    const struct util_format_description *cbuf0_format_desc = NULL;
    boolean fullcolormask;
+   boolean async;
    char module_name[64];
-   unsigned char ir_sha1_cache_key[20];
    struct lp_cached_code cached = { 0 };
    bool needs_caching = false;
    variant = MALLOC(sizeof *variant + shader->variant_key_size - sizeof variant->key);
@@ -3331,17 +3438,27 @@ generate_variant(struct llvmpipe_context *lp,
             shader->no, shader->variants_created);
 
    variant->shader = shader;
+   variant->screen = screen;
+   util_queue_fence_init(&variant->ready);
    memcpy(&variant->key, key, shader->variant_key_size);
 
    if (shader->base.ir.nir) {
-      lp_fs_get_ir_cache_key(variant, ir_sha1_cache_key);
+      lp_fs_get_ir_cache_key(variant, variant->ir_sha1_cache_key);
 
-      lp_disk_cache_find_shader(screen, &cached, ir_sha1_cache_key);
+      lp_disk_cache_find_shader(screen, &cached, variant->ir_sha1_cache_key);
       if (!cached.data_size)
          needs_caching = true;
    }
-   variant->gallivm = gallivm_create(module_name, lp->context, &cached);
+
+   /* Loading cached code is quick enough to do here. */
+   async = screen->num_compile_threads && !cached.data_size;
+
+   if (async)
+      variant->gallivm = gallivm_create_unoptimized(module_name, lp->context);
+   else
+      variant->gallivm = gallivm_create(module_name, lp->context, &cached);
    if (!variant->gallivm) {
+      util_queue_fence_destroy(&variant->ready);
       FREE(variant);
       return NULL;
    }
@@ -3378,46 +3495,21 @@ generate_variant(struct llvmpipe_context *lp,
       lp_debug_fs_variant(variant);
    }
 
-   lp_jit_init_types(variant);
-   
-   if (variant->jit_function[RAST_EDGE_TEST] == NULL)
-      generate_fragment(lp, shader, variant, RAST_EDGE_TEST);
-
-   if (variant->jit_function[RAST_WHOLE] == NULL) {
-      if (variant->opaque) {
-         /* Specialized shader, which doesn't need to read the color buffer. */
-         generate_fragment(lp, shader, variant, RAST_WHOLE);
-      }
-   }
-
-   /*
-    * Compile everything
-    */
-
-   gallivm_compile_module(variant->gallivm);
+   variant->nr_instrs = generate_variant_code(variant, async);
 
-   variant->nr_instrs += lp_build_count_ir_module(variant->gallivm->module);
-
-   if (variant->function[RAST_EDGE_TEST]) {
-      variant->jit_function[RAST_EDGE_TEST] = (lp_jit_frag_func)
-            gallivm_jit_function(variant->gallivm,
-                                 variant->function[RAST_EDGE_TEST]);
+   if (needs_caching && !async) {
+      lp_disk_cache_insert_shader(screen, &cached, variant->ir_sha1_cache_key);
    }
 
-   if (variant->function[RAST_WHOLE]) {
-         variant->jit_function[RAST_WHOLE] = (lp_jit_frag_func)
-               gallivm_jit_function(variant->gallivm,
-                                    variant->function[RAST_WHOLE]);
-   } else if (!variant->jit_function[RAST_WHOLE]) {
-      variant->jit_function[RAST_WHOLE] = variant->jit_function[RAST_EDGE_TEST];
-   }
+   gallivm_free_ir(variant->gallivm);
 
-   if (needs_caching) {
-      lp_disk_cache_insert_shader(screen, &cached, ir_sha1_cache_key);
+   if (async) {
+      variant->fallback_gallivm = variant->gallivm;
+      variant->gallivm = NULL;
+      util_queue_add_job(&screen->fs_compile_queue, variant, &variant->ready,
+                         generate_variant_async, NULL, 0);
    }
 
-   gallivm_free_ir(variant->gallivm);
-
    return variant;
 }
 
@@ -3559,7 +3651,14 @@ llvmpipe_remove_shader_variant(struct llvmpipe_context *lp,
                    lp->nr_fs_variants, variant->nr_instrs, lp->nr_fs_instrs);
    }
 
-   gallivm_destroy(variant->gallivm);
+   /* Wait for the background compilation, if any */
+   util_queue_fence_wait(&variant->ready);
+   util_queue_fence_destroy(&variant->ready);
+
+   if (variant->gallivm)
+      gallivm_destroy(variant->gallivm);
+   if (variant->fallback_gallivm)
+      gallivm_destroy(variant->fallback_gallivm);
 
    /* remove from shader's list */
    remove_from_list(&variant->list_item_local);
@@ -4009,6 +4108,9 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
        * deletion of shader's when we have too many.
        */
       move_to_head(&lp->fs_variants_list, &variant->list_item_global);
+
+      if (!util_queue_fence_is_signalled(&variant->ready))
+         LP_COUNT(nr_fs_compile_stalls_avoided);
    }
    else {
       /* variant not found, create it now */
@@ -4077,6 +4179,8 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
 
       /* Put the new variant into the list */
       if (variant) {
+         if (!util_queue_fence_is_signalled(&variant->ready))
+            LP_COUNT(nr_fs_compile_stalls_avoided);
          insert_at_head(&shader->variants, &variant->list_item_local);
          insert_at_head(&lp->fs_variants_list, &variant->list_item_global);
          lp->nr_fs_variants++;
@@ -32,6 +32,7 @@
 
 #include "pipe/p_compiler.h"
 #include "pipe/p_state.h"
+#include "util/u_queue.h"
 #include "tgsi/tgsi_scan.h" /* for tgsi_shader_info */
 #include "gallivm/lp_bld_sample.h" /* for struct lp_sampler_static_state */
 #include "gallivm/lp_bld_tgsi.h" /* for lp_tgsi_info */
@@ -141,7 +142,9 @@ struct lp_fragment_shader_variant
 
    lp_jit_frag_func jit_function[2];
 
-   /* Total number of LLVM instructions generated */
+   /* Total number of LLVM instructions generated, not counting the
+    * optimized code of a variant compiled in the background.
+    */
    unsigned nr_instrs;
 
    struct lp_fs_variant_list_item list_item_global, list_item_local;
@@ -150,6 +153,17 @@ struct lp_fragment_shader_variant
    /* For debugging/profiling purposes */
    unsigned no;
 
+   /*
+    * When the variant is compiled in the background, jit_function[] points
+    * at the code of fallback_gallivm, an unoptimized build of the edge test
+    * function only, until the optimized code replaces it and the fence is
+    * signalled.
+    */
+   struct gallivm_state *fallback_gallivm;
+   struct util_queue_fence ready;
+   struct llvmpipe_screen *screen;
+   unsigned char ir_sha1_cache_key[20];
+
    /* key is variable-sized, must be last */
    struct lp_fragment_shader_variant_key key;
 };
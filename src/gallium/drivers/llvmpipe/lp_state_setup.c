@@ -30,6 +30,7 @@
 #include "util/u_memory.h"
 #include "util/simple_list.h"
 #include "util/os_time.h"
+#include "util/mesa-sha1.h"
 #include "gallivm/lp_bld_arit.h"
 #include "gallivm/lp_bld_bitarit.h"
 #include "gallivm/lp_bld_const.h"
@@ -700,49 +701,19 @@ init_args(struct gallivm_state *gallivm,
 }
 
 /**
- * Generate the runtime callable function for the coefficient calculation.
- *
+ * Build the IR of the coefficient calculation function.
  */
-static struct lp_setup_variant *
-generate_setup_variant(struct lp_setup_variant_key *key,
-                       struct llvmpipe_context *lp)
+static boolean
+generate_setup_function(struct gallivm_state *gallivm,
+                        struct lp_setup_variant *variant,
+                        const char *func_name)
 {
-   struct lp_setup_variant *variant = NULL;
-   struct gallivm_state *gallivm;
    struct lp_setup_args args;
-   char func_name[64];
    LLVMTypeRef vec4f_type;
    LLVMTypeRef func_type;
    LLVMTypeRef arg_types[7];
    LLVMBasicBlockRef block;
-   LLVMBuilderRef builder;
-   int64_t t0 = 0, t1;
-
-   if (0)
-      goto fail;
-
-   variant = CALLOC_STRUCT(lp_setup_variant);
-   if (!variant)
-      goto fail;
-
-   variant->no = setup_no++;
-
-   snprintf(func_name, sizeof(func_name), "setup_variant_%u",
-            variant->no);
-
-   variant->gallivm = gallivm = gallivm_create(func_name, lp->context, NULL);
-   if (!variant->gallivm) {
-      goto fail;
-   }
-
-   builder = gallivm->builder;
-
-   if (LP_DEBUG & DEBUG_COUNTERS) {
-      t0 = os_time_get();
-   }
-
-   memcpy(&variant->key, key, key->size);
-   variant->list_item_global.base = variant;
+   LLVMBuilderRef builder = gallivm->builder;
 
    /* Currently always deal with full 4-wide vertex attributes from
     * the vertices.
@@ -763,7 +734,7 @@ generate_setup_variant(struct lp_setup_variant_key *key,
 
    variant->function = LLVMAddFunction(gallivm->module, func_name, func_type);
    if (!variant->function)
-      goto fail;
+      return FALSE;
 
    LLVMSetFunctionCallConv(variant->function, LLVMCCallConv);
 
@@ -775,6 +746,10 @@ generate_setup_variant(struct lp_setup_variant_key *key,
    args.dadx     = LLVMGetParam(variant->function, 5);
    args.dady     = LLVMGetParam(variant->function, 6);
 
+   /* Only the declaration is needed to look up cached code */
+   if (gallivm->cache->data_size)
+      return TRUE;
+
    lp_build_name(args.v0, "in_v0");
    lp_build_name(args.v1, "in_v1");
    lp_build_name(args.v2, "in_v2");
@@ -798,6 +773,80 @@ generate_setup_variant(struct lp_setup_variant_key *key,
 
    gallivm_verify_function(gallivm, variant->function);
 
+   return TRUE;
+}
+
+
+/**
+ * The code of a setup variant only depends on its key, so that is all
+ * that goes into its disk cache key.
+ */
+static void
+lp_setup_get_cache_key(const struct lp_setup_variant_key *key,
+                       unsigned char sha1_cache_key[20])
+{
+   struct mesa_sha1 ctx;
+
+   _mesa_sha1_init(&ctx);
+   _mesa_sha1_update(&ctx, "setup", 5);
+   _mesa_sha1_update(&ctx, key, key->size);
+   _mesa_sha1_final(&ctx, sha1_cache_key);
+}
+
+
+/**
+ * Generate the runtime callable function for the coefficient calculation.
+ *
+ * When the machine code is in the disk cache, only the function
+ * declaration is generated.
+ */
+static struct lp_setup_variant *
+generate_setup_variant(struct lp_setup_variant_key *key,
+                       struct llvmpipe_context *lp)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
+   struct lp_setup_variant *variant = NULL;
+   struct gallivm_state *gallivm;
+   struct lp_cached_code cached = { 0 };
+   unsigned char sha1_cache_key[20];
+   bool needs_caching;
+   char module_name[64];
+   /* The name must not depend on the variant, cached code is found by it */
+   const char *func_name = "setup_variant";
+   int64_t t0 = 0, t1;
+
+   if (0)
+      goto fail;
+
+   variant = CALLOC_STRUCT(lp_setup_variant);
+   if (!variant)
+      goto fail;
+
+   variant->no = setup_no++;
+
+   snprintf(module_name, sizeof(module_name), "setup_variant_%u",
+            variant->no);
+
+   memcpy(&variant->key, key, key->size);
+   variant->list_item_global.base = variant;
+
+   lp_setup_get_cache_key(&variant->key, sha1_cache_key);
+   lp_disk_cache_find_shader(screen, &cached, sha1_cache_key);
+   needs_caching = !cached.data_size;
+
+   variant->gallivm = gallivm = gallivm_create(module_name, lp->context,
+                                               &cached);
+   if (!variant->gallivm) {
+      goto fail;
+   }
+
+   if (LP_DEBUG & DEBUG_COUNTERS) {
+      t0 = os_time_get();
+   }
+
+   if (!generate_setup_function(gallivm, variant, func_name))
+      goto fail;
+
    gallivm_compile_module(gallivm);
 
    variant->jit_function = (lp_jit_setup_triangle)
@@ -805,6 +854,10 @@ generate_setup_variant(struct lp_setup_variant_key *key,
    if (!variant->jit_function)
       goto fail;
 
+   if (needs_caching) {
+      lp_disk_cache_insert_shader(screen, &cached, sha1_cache_key);
+   }
+
    gallivm_free_ir(variant->gallivm);
 
    /*
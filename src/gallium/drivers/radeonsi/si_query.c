@@ -198,6 +198,21 @@ static bool si_query_sw_begin(struct si_context *sctx, struct si_query *squery)
    case SI_QUERY_TC_NUM_SYNCS:
       query->begin_result = sctx->tc ? sctx->tc->num_syncs : 0;
       break;
+   case SI_QUERY_TC_NUM_BATCHES:
+      query->begin_result = sctx->tc ? sctx->tc->num_batches : 0;
+      break;
+   case SI_QUERY_TC_FULL_BATCHES:
+      query->begin_result = sctx->tc ? sctx->tc->num_full_batches : 0;
+      break;
+   case SI_QUERY_TC_OFFLOADED_CALLS:
+      query->begin_result = sctx->tc ? sctx->tc->num_offloaded_calls : 0;
+      break;
+   case SI_QUERY_TC_MERGED_DRAWS:
+      query->begin_result = sctx->tc ? sctx->tc->num_merged_draws : 0;
+      break;
+   case SI_QUERY_TC_SYNC_TIME:
+      query->begin_result = sctx->tc ? p_atomic_read(&sctx->tc->sync_time_ns) : 0;
+      break;
    case SI_QUERY_REQUESTED_VRAM:
    case SI_QUERY_REQUESTED_GTT:
    case SI_QUERY_MAPPED_VRAM:
@@ -210,6 +225,7 @@ static bool si_query_sw_begin(struct si_context *sctx, struct si_query *squery)
    case SI_QUERY_CURRENT_GPU_MCLK:
    case SI_QUERY_BACK_BUFFER_PS_DRAW_RATIO:
    case SI_QUERY_NUM_MAPPED_BUFFERS:
+   case SI_QUERY_TC_BATCH_SIZE:
       query->begin_result = 0;
       break;
    case SI_QUERY_BUFFER_WAIT_TIME:
@@ -380,6 +396,21 @@ static bool si_query_sw_end(struct si_context *sctx, struct si_query *squery)
    case SI_QUERY_TC_NUM_SYNCS:
       query->end_result = sctx->tc ? sctx->tc->num_syncs : 0;
       break;
+   case SI_QUERY_TC_NUM_BATCHES:
+      query->end_result = sctx->tc ? sctx->tc->num_batches : 0;
+      break;
+   case SI_QUERY_TC_FULL_BATCHES:
+      query->end_result = sctx->tc ? sctx->tc->num_full_batches : 0;
+      break;
+   case SI_QUERY_TC_OFFLOADED_CALLS:
+      query->end_result = sctx->tc ? sctx->tc->num_offloaded_calls : 0;
+      break;
+   case SI_QUERY_TC_MERGED_DRAWS:
+      query->end_result = sctx->tc ? sctx->tc->num_merged_draws : 0;
+      break;
+   case SI_QUERY_TC_SYNC_TIME:
+      query->end_result = sctx->tc ? p_atomic_read(&sctx->tc->sync_time_ns) : 0;
+      break;
    case SI_QUERY_REQUESTED_VRAM:
    case SI_QUERY_REQUESTED_GTT:
    case SI_QUERY_MAPPED_VRAM:
@@ -416,6 +447,9 @@ static bool si_query_sw_end(struct si_context *sctx, struct si_query *squery)
       query->end_result = sctx->tc ? util_queue_get_thread_time_nano(&sctx->tc->queue, 0) : 0;
       query->end_time = os_time_get_nano();
       break;
+   case SI_QUERY_TC_BATCH_SIZE:
+      query->end_result = sctx->tc ? sctx->tc->batch_size : 0;
+      break;
    case SI_QUERY_GPU_LOAD:
    case SI_QUERY_GPU_SHADERS_BUSY:
    case SI_QUERY_GPU_TA_BUSY:
@@ -543,6 +577,7 @@ static bool si_query_sw_get_result(struct si_context *sctx, struct si_query *squ
 
    switch (query->b.type) {
    case SI_QUERY_BUFFER_WAIT_TIME:
+   case SI_QUERY_TC_SYNC_TIME:
    case SI_QUERY_GPU_TEMPERATURE:
       result->u64 /= 1000;
       break;
@@ -1685,6 +1720,12 @@ static struct pipe_driver_query_info si_driver_query_list[] = {
    X("tc-offloaded-slots", TC_OFFLOADED_SLOTS, UINT64, AVERAGE),
    X("tc-direct-slots", TC_DIRECT_SLOTS, UINT64, AVERAGE),
    X("tc-num-syncs", TC_NUM_SYNCS, UINT64, AVERAGE),
+   X("tc-num-batches", TC_NUM_BATCHES, UINT64, AVERAGE),
+   X("tc-full-batches", TC_FULL_BATCHES, UINT64, AVERAGE),
+   X("tc-offloaded-calls", TC_OFFLOADED_CALLS, UINT64, AVERAGE),
+   X("tc-merged-draws", TC_MERGED_DRAWS, UINT64, AVERAGE),
+   X("tc-sync-time", TC_SYNC_TIME, MICROSECONDS, CUMULATIVE),
+   X("tc-batch-size", TC_BATCH_SIZE, UINT64, AVERAGE),
    X("CS-thread-busy", CS_THREAD_BUSY, UINT64, AVERAGE),
    X("gallium-thread-busy", GALLIUM_THREAD_BUSY, UINT64, AVERAGE),
    X("requested-VRAM", REQUESTED_VRAM, BYTES, AVERAGE),
@@ -62,6 +62,12 @@ enum
    SI_QUERY_TC_OFFLOADED_SLOTS,
    SI_QUERY_TC_DIRECT_SLOTS,
    SI_QUERY_TC_NUM_SYNCS,
+   SI_QUERY_TC_NUM_BATCHES,
+   SI_QUERY_TC_FULL_BATCHES,
+   SI_QUERY_TC_OFFLOADED_CALLS,
+   SI_QUERY_TC_MERGED_DRAWS,
+   SI_QUERY_TC_SYNC_TIME,
+   SI_QUERY_TC_BATCH_SIZE,
    SI_QUERY_CS_THREAD_BUSY,
    SI_QUERY_GALLIUM_THREAD_BUSY,
    SI_QUERY_REQUESTED_VRAM,
@@ -22,6 +22,7 @@
 
 #include "invocation.hpp"
 
+#include <mutex>
 #include <tuple>
 
 #include "core/device.hpp"
@@ -33,7 +34,9 @@
 #include <compiler/glsl_types.h>
 #include <compiler/nir/nir_serialize.h>
 #include <compiler/spirv/nir_spirv.h>
+#include <util/u_cpu_detect.h>
 #include <util/u_math.h>
+#include <util/u_queue.h>
 
 using namespace clover;
 
@@ -51,6 +54,42 @@ public:
    }
 } glsl_type_ref;
 
+// Threads which optimize the functions of a kernel before they are inlined.
+static class opt_queue {
+public:
+   opt_queue() : started(false) {
+   }
+
+   ~opt_queue() {
+      if (started)
+         util_queue_destroy(&queue);
+   }
+
+   struct util_queue *
+   get() {
+      std::call_once(once, [this] {
+         util_cpu_detect();
+         started = util_queue_init(&queue, "clnir", 64,
+                                   util_cpu_caps.nr_cpus,
+                                   UTIL_QUEUE_INIT_RESIZE_IF_FULL);
+      });
+      return started ? &queue : nullptr;
+   }
+
+private:
+   std::once_flag once;
+   struct util_queue queue;
+   bool started;
+} opt_queue;
+
+static const nir_opt_loop_pass opt_passes[] = {
+   { "nir_copy_prop", nir_copy_prop },
+   { "nir_opt_dce", nir_opt_dce },
+   { "nir_opt_cse", nir_opt_cse },
+   { "nir_opt_algebraic", nir_opt_algebraic },
+   { "nir_opt_constant_folding", nir_opt_constant_folding },
+};
+
 static const nir_shader_compiler_options *
 dev_get_nir_compiler_options(const device &dev)
 {
@@ -111,6 +150,13 @@ module clover::nir::spirv_to_nir(const module &mod, const device &dev,
       // according to the comment on nir_inline_functions
       NIR_PASS_V(nir, nir_lower_variable_initializers, nir_var_function_temp);
       NIR_PASS_V(nir, nir_lower_returns);
+
+      // Optimize every function on its own, in parallel, so that what gets
+      // inlined is already small.
+      nir_opt_loop(&nir, 1, opt_passes, ARRAY_SIZE(opt_passes), 0,
+                   opt_queue.get(), NULL);
+      nir_validate_shader(nir, "clover after nir_opt_loop");
+
       NIR_PASS_V(nir, nir_inline_functions);
       NIR_PASS_V(nir, nir_opt_deref);
 
@@ -69,6 +69,8 @@ dri_fill_st_options(struct dri_screen *screen)
       driQueryOptionb(optionCache, "disable_arb_gpu_shader5");
    options->disable_glsl_line_continuations =
       driQueryOptionb(optionCache, "disable_glsl_line_continuations");
+   options->disable_glsl_preprocessor_fast_path =
+      driQueryOptionb(optionCache, "disable_glsl_preprocessor_fast_path");
    options->force_glsl_extensions_warn =
       driQueryOptionb(optionCache, "force_glsl_extensions_warn");
    options->force_glsl_version =
@@ -8394,7 +8394,7 @@ brw_nir_move_interpolation_to_top(nir_shader *nir)
          continue;
 
       nir_block *top = nir_start_block(f->impl);
-      exec_node *cursor_node = NULL;
+      nir_cursor cursor = nir_before_block(top);
 
       nir_foreach_block(block, f->impl) {
          if (block == top)
@@ -8424,14 +8424,8 @@ brw_nir_move_interpolation_to_top(nir_shader *nir)
 
             for (unsigned i = 0; i < ARRAY_SIZE(move); i++) {
                if (move[i]->block != top) {
-                  move[i]->block = top;
-                  exec_node_remove(&move[i]->node);
-                  if (cursor_node) {
-                     exec_node_insert_after(cursor_node, &move[i]->node);
-                  } else {
-                     exec_list_push_head(&top->instr_list, &move[i]->node);
-                  }
-                  cursor_node = &move[i]->node;
+                  nir_instr_move(cursor, move[i]);
+                  cursor = nir_after_instr(move[i]);
                   progress = true;
                }
             }
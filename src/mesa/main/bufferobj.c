@@ -1241,6 +1241,16 @@ _mesa_InternalBindElementBuffer(struct gl_context *ctx,
       *bindTarget = buf;
 }
 
+void
+_mesa_InternalBindPixelUnpackBuffer(struct gl_context *ctx,
+                                    struct gl_buffer_object *buf)
+{
+   /* Move the buffer reference from the parameter to the bind point. */
+   _mesa_reference_buffer_object(ctx, &ctx->Unpack.BufferObj, NULL);
+   if (buf)
+      ctx->Unpack.BufferObj = buf;
+}
+
 /**
  * Binds a buffer object to a binding point.
  *
@@ -155,6 +155,10 @@ void
 _mesa_InternalBindElementBuffer(struct gl_context *ctx,
                                 struct gl_buffer_object *buf);
 
+void
+_mesa_InternalBindPixelUnpackBuffer(struct gl_context *ctx,
+                                    struct gl_buffer_object *buf);
+
 void GLAPIENTRY
 _mesa_DeleteBuffers_no_error(GLsizei n, const GLuint * buffer);
 
@@ -35,6 +35,7 @@
 
 #include "context.h"
 #include "debug_output.h"
+#include "util/u_atomic.h"
 
 
 static FILE *LogFile = NULL;
@@ -359,6 +360,12 @@ _mesa_error( struct gl_context *ctx, GLenum error, const char *fmtString, ... )
    /* Set the GL context error state for glGetError. */
    if (ctx->ErrorValue == GL_NO_ERROR)
       ctx->ErrorValue = error;
+
+   /* glthread doesn't sync in glGetError with KHR_no_error unless this is
+    * set.
+    */
+   if (error == GL_OUT_OF_MEMORY)
+      p_atomic_set(&ctx->GLThread.OutOfMemory, true);
 }
 
 void
@@ -206,6 +206,7 @@ enum value_extra {
    EXTRA_EXT_FB_NO_ATTACH_GS,
    EXTRA_EXT_ES_GS,
    EXTRA_EXT_PROVOKING_VERTEX_32,
+   EXTRA_EXT_VAO,
 };
 
 #define NO_EXTRA NULL
@@ -635,6 +636,11 @@ static const int extra_EXT_provoking_vertex_32[] = {
    EXTRA_END
 };
 
+static const int extra_vertex_array_object[] = {
+   EXTRA_EXT_VAO,
+   EXTRA_END
+};
+
 static const int extra_EXT_disjoint_timer_query[] = {
    EXTRA_API_ES2,
    EXTRA_API_ES3,
@@ -1340,22 +1346,17 @@ find_custom_value(struct gl_context *ctx, const struct value_desc *d, union valu
 }
 
 /**
- * Check extra constraints on a struct value_desc descriptor
- *
- * If a struct value_desc has a non-NULL extra pointer, it means that
- * there are a number of extra constraints to check or actions to
- * perform.  The extras is just an integer array where each integer
- * encode different constraints or actions.
+ * Check the API, version and extension constraints of a struct value_desc
+ * descriptor.  This has no side effect.
  *
  * \param ctx current context
- * \param func name of calling glGet*v() function for error reporting
  * \param d the struct value_desc that has the extra constraints
  *
- * \return GL_FALSE if all of the constraints were not satisfied,
+ * \return GL_FALSE if the enum isn't supported by the context,
  *     otherwise GL_TRUE.
  */
 static GLboolean
-check_extra(struct gl_context *ctx, const char *func, const struct value_desc *d)
+check_extra_api(struct gl_context *ctx, const struct value_desc *d)
 {
    const GLuint version = ctx->Version;
    GLboolean api_check = GL_FALSE;
@@ -1420,32 +1421,11 @@ check_extra(struct gl_context *ctx, const char *func, const struct value_desc *d
             api_found = GL_TRUE;
          break;
       case EXTRA_NEW_BUFFERS:
-         if (ctx->NewState & _NEW_BUFFERS)
-            _mesa_update_state(ctx);
-         break;
       case EXTRA_FLUSH_CURRENT:
-         FLUSH_CURRENT(ctx, 0);
-         break;
       case EXTRA_VALID_DRAW_BUFFER:
-         if (d->pname - GL_DRAW_BUFFER0_ARB >= ctx->Const.MaxDrawBuffers) {
-            _mesa_error(ctx, GL_INVALID_OPERATION, "%s(draw buffer %u)",
-                        func, d->pname - GL_DRAW_BUFFER0_ARB);
-            return GL_FALSE;
-         }
-         break;
       case EXTRA_VALID_TEXTURE_UNIT:
-         if (ctx->Texture.CurrentUnit >= ctx->Const.MaxTextureCoordUnits) {
-            _mesa_error(ctx, GL_INVALID_OPERATION, "%s(texture %u)",
-                        func, ctx->Texture.CurrentUnit);
-            return GL_FALSE;
-         }
-         break;
       case EXTRA_VALID_CLIP_DISTANCE:
-         if (d->pname - GL_CLIP_DISTANCE0 >= ctx->Const.MaxClipPlanes) {
-            _mesa_error(ctx, GL_INVALID_ENUM, "%s(clip distance %u)",
-                        func, d->pname - GL_CLIP_DISTANCE0);
-            return GL_FALSE;
-         }
+         /* Handled by check_extra(). */
          break;
       case EXTRA_GLSL_130:
          api_check = GL_TRUE;
@@ -1503,6 +1483,12 @@ check_extra(struct gl_context *ctx, const char *func, const struct value_desc *d
          if (ctx->API == API_OPENGL_COMPAT || version == 32)
             api_found = ctx->Extensions.EXT_provoking_vertex;
          break;
+      case EXTRA_EXT_VAO:
+         api_check = GL_TRUE;
+         if (_mesa_is_desktop_gl(ctx) || _mesa_is_gles3(ctx) ||
+             _mesa_has_OES_vertex_array_object(ctx))
+            api_found = GL_TRUE;
+         break;
       case EXTRA_END:
          break;
       default: /* *e is a offset into the extension struct */
@@ -1513,12 +1499,70 @@ check_extra(struct gl_context *ctx, const char *func, const struct value_desc *d
       }
    }
 
-   if (api_check && !api_found) {
+   return !api_check || api_found;
+}
+
+/**
+ * Check extra constraints on a struct value_desc descriptor
+ *
+ * If a struct value_desc has a non-NULL extra pointer, it means that
+ * there are a number of extra constraints to check or actions to
+ * perform.  The extras is just an integer array where each integer
+ * encode different constraints or actions.
+ *
+ * \param ctx current context
+ * \param func name of calling glGet*v() function for error reporting
+ * \param d the struct value_desc that has the extra constraints
+ *
+ * \return GL_FALSE if all of the constraints were not satisfied,
+ *     otherwise GL_TRUE.
+ */
+static GLboolean
+check_extra(struct gl_context *ctx, const char *func, const struct value_desc *d)
+{
+   const int *e;
+
+   if (!check_extra_api(ctx, d)) {
       _mesa_error(ctx, GL_INVALID_ENUM, "%s(pname=%s)", func,
                   _mesa_enum_to_string(d->pname));
       return GL_FALSE;
    }
 
+   for (e = d->extra; *e != EXTRA_END; e++) {
+      switch (*e) {
+      case EXTRA_NEW_BUFFERS:
+         if (ctx->NewState & _NEW_BUFFERS)
+            _mesa_update_state(ctx);
+         break;
+      case EXTRA_FLUSH_CURRENT:
+         FLUSH_CURRENT(ctx, 0);
+         break;
+      case EXTRA_VALID_DRAW_BUFFER:
+         if (d->pname - GL_DRAW_BUFFER0_ARB >= ctx->Const.MaxDrawBuffers) {
+            _mesa_error(ctx, GL_INVALID_OPERATION, "%s(draw buffer %u)",
+                        func, d->pname - GL_DRAW_BUFFER0_ARB);
+            return GL_FALSE;
+         }
+         break;
+      case EXTRA_VALID_TEXTURE_UNIT:
+         if (ctx->Texture.CurrentUnit >= ctx->Const.MaxTextureCoordUnits) {
+            _mesa_error(ctx, GL_INVALID_OPERATION, "%s(texture %u)",
+                        func, ctx->Texture.CurrentUnit);
+            return GL_FALSE;
+         }
+         break;
+      case EXTRA_VALID_CLIP_DISTANCE:
+         if (d->pname - GL_CLIP_DISTANCE0 >= ctx->Const.MaxClipPlanes) {
+            _mesa_error(ctx, GL_INVALID_ENUM, "%s(clip distance %u)",
+                        func, d->pname - GL_CLIP_DISTANCE0);
+            return GL_FALSE;
+         }
+         break;
+      default:
+         break;
+      }
+   }
+
    return GL_TRUE;
 }
 
@@ -1526,37 +1570,21 @@ static const struct value_desc error_value =
    { 0, 0, TYPE_INVALID, NO_OFFSET, NO_EXTRA };
 
 /**
- * Find the struct value_desc corresponding to the enum 'pname'.
+ * Look up the struct value_desc corresponding to the enum 'pname' in the
+ * table of the context API.
  *
  * We hash the enum value to get an index into the 'table' array,
  * which holds the index in the 'values' array of struct value_desc.
- * Once we've found the entry, we do the extra checks, if any, then
- * look up the value and return a pointer to it.
- *
- * If the value has to be computed (for example, it's the result of a
- * function call or we need to add 1 to it), we use the tmp 'v' to
- * store the result.
  *
- * \param func name of glGet*v() func for error reporting
- * \param pname the enum value we're looking up
- * \param p is were we return the pointer to the value
- * \param v a tmp union value variable in the calling glGet*v() function
- *
- * \return the struct value_desc corresponding to the enum or a struct
- *     value_desc of TYPE_INVALID if not found.  This lets the calling
- *     glGet*v() function jump right into a switch statement and
- *     handle errors there instead of having to check for NULL.
+ * \return the struct value_desc or NULL if the enum isn't valid.
  */
 static const struct value_desc *
-find_value(const char *func, GLenum pname, void **p, union value *v)
+lookup_value(const struct gl_context *ctx, GLenum pname)
 {
-   GET_CURRENT_CONTEXT(ctx);
    int mask, hash;
    const struct value_desc *d;
    int api;
 
-   *p = NULL;
-
    api = ctx->API;
    /* We index into the table_set[] list of per-API hash tables using the API's
     * value in the gl_api enum. Since GLES 3 doesn't have an API_OPENGL* enum
@@ -1580,18 +1608,51 @@ find_value(const char *func, GLenum pname, void **p, union value *v)
       /* If the enum isn't valid, the hash walk ends with index 0,
        * pointing to the first entry of values[] which doesn't hold
        * any valid enum. */
-      if (unlikely(idx == 0)) {
-         _mesa_error(ctx, GL_INVALID_ENUM, "%s(pname=%s)", func,
-               _mesa_enum_to_string(pname));
-         return &error_value;
-      }
+      if (unlikely(idx == 0))
+         return NULL;
 
       d = &values[idx];
       if (likely(d->pname == pname))
-         break;
+         return d;
 
       hash += prime_step;
    }
+}
+
+/**
+ * Find the struct value_desc corresponding to the enum 'pname'.
+ *
+ * Once we've found the entry, we do the extra checks, if any, then
+ * look up the value and return a pointer to it.
+ *
+ * If the value has to be computed (for example, it's the result of a
+ * function call or we need to add 1 to it), we use the tmp 'v' to
+ * store the result.
+ *
+ * \param func name of glGet*v() func for error reporting
+ * \param pname the enum value we're looking up
+ * \param p is were we return the pointer to the value
+ * \param v a tmp union value variable in the calling glGet*v() function
+ *
+ * \return the struct value_desc corresponding to the enum or a struct
+ *     value_desc of TYPE_INVALID if not found.  This lets the calling
+ *     glGet*v() function jump right into a switch statement and
+ *     handle errors there instead of having to check for NULL.
+ */
+static const struct value_desc *
+find_value(const char *func, GLenum pname, void **p, union value *v)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   const struct value_desc *d;
+
+   *p = NULL;
+
+   d = lookup_value(ctx, pname);
+   if (unlikely(!d)) {
+      _mesa_error(ctx, GL_INVALID_ENUM, "%s(pname=%s)", func,
+                  _mesa_enum_to_string(pname));
+      return &error_value;
+   }
 
    if (unlikely(d->extra && !check_extra(ctx, func, d)))
       return &error_value;
@@ -1629,6 +1690,42 @@ find_value(const char *func, GLenum pname, void **p, union value *v)
    return &error_value;
 }
 
+/**
+ * Return whether glGet*v() accepts 'pname' in the context, without any side
+ * effect.
+ *
+ * Only the API, version and extension constraints are checked. Enums with
+ * other constraints, which depend on the state of the context, are reported
+ * as unsupported.
+ */
+bool
+_mesa_is_get_pname_supported(struct gl_context *ctx, GLenum pname)
+{
+   const struct value_desc *d = lookup_value(ctx, pname);
+   const int *e;
+
+   if (!d)
+      return false;
+
+   if (!d->extra)
+      return true;
+
+   for (e = d->extra; *e != EXTRA_END; e++) {
+      switch (*e) {
+      case EXTRA_NEW_BUFFERS:
+      case EXTRA_FLUSH_CURRENT:
+      case EXTRA_VALID_DRAW_BUFFER:
+      case EXTRA_VALID_TEXTURE_UNIT:
+      case EXTRA_VALID_CLIP_DISTANCE:
+         return false;
+      default:
+         break;
+      }
+   }
+
+   return check_extra_api(ctx, d);
+}
+
 static const int transpose[] = {
    0, 4,  8, 12,
    1, 5,  9, 13,
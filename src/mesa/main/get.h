@@ -32,6 +32,7 @@
 #define GET_H
 
 
+#include <stdbool.h>
 #include "glheader.h"
 
 
@@ -93,6 +94,11 @@ _mesa_GetError( void );
 extern GLenum GLAPIENTRY
 _mesa_GetGraphicsResetStatusARB( void );
 
+struct gl_context;
+
+extern bool
+_mesa_is_get_pname_supported(struct gl_context *ctx, GLenum pname);
+
 struct gl_vertex_array_object;
 
 extern void
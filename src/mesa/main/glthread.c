@@ -120,6 +120,8 @@ _mesa_glthread_init(struct gl_context *ctx)
    glthread->SupportsNonVBOUploads = glthread->SupportsBufferUploads &&
                                      ctx->Const.VertexBufferOffsetIsInt32;
 
+   _mesa_glthread_reload_state(ctx);
+
    ctx->CurrentClientDispatch = ctx->MarshalExec;
 
    /* Execute the thread initialization function in the thread. */
@@ -263,6 +265,12 @@ _mesa_glthread_finish(struct gl_context *ctx)
 
    if (synced)
       p_atomic_inc(&glthread->stats.num_syncs);
+
+   /* The worker is idle, so this is the time to catch up with the state
+    * glthread lost track of.
+    */
+   if (!glthread->StateValid)
+      _mesa_glthread_reload_state(ctx);
 }
 
 void
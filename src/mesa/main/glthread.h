@@ -46,17 +46,31 @@
 /* Special value for glEnableClientState(GL_PRIMITIVE_RESTART_NV). */
 #define VERT_ATTRIB_PRIMITIVE_RESTART_NV -1
 
+/* Enables shadowed by glthread. */
+#define GLTHREAD_ENABLE_BLEND               (1 << 0)
+#define GLTHREAD_ENABLE_CULL_FACE           (1 << 1)
+#define GLTHREAD_ENABLE_DEPTH_TEST          (1 << 2)
+#define GLTHREAD_ENABLE_DITHER              (1 << 3)
+#define GLTHREAD_ENABLE_POLYGON_OFFSET_FILL (1 << 4)
+#define GLTHREAD_ENABLE_SCISSOR_TEST        (1 << 5)
+#define GLTHREAD_ENABLE_STENCIL_TEST        (1 << 6)
+
 #include <inttypes.h>
 #include <stdbool.h>
 #include "util/u_queue.h"
 #include "GL/gl.h"
 #include "compiler/shader_enums.h"
 #include "main/config.h"
+#include "main/menums.h"
 
 struct gl_context;
 struct gl_buffer_object;
 struct _mesa_HashTable;
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 struct glthread_attrib_binding {
    struct gl_buffer_object *buffer; /**< where non-VBO data was uploaded */
    int offset;                      /**< offset to uploaded non-VBO data */
@@ -118,6 +132,11 @@ struct glthread_client_attrib {
 
    /** Whether this element of the client attrib stack contains saved state. */
    bool Valid;
+
+   /** Pixel store state, saved if PixelStoreValid is set. */
+   GLuint CurrentPixelUnpackBufferName;
+   GLint UnpackCompressedBlockSize;
+   bool PixelStoreValid;
 };
 
 struct glthread_state
@@ -175,6 +194,39 @@ struct glthread_state
    /** Currently-bound buffer object IDs. */
    GLuint CurrentArrayBufferName;
    GLuint CurrentDrawIndirectBufferName;
+   GLuint CurrentPixelUnpackBufferName;
+
+   /**
+    * GL_UNPACK_COMPRESSED_BLOCK_SIZE. If it's non-zero, compressed uploads
+    * can read more than imageSize bytes.
+    */
+   GLint UnpackCompressedBlockSize;
+
+   /** The mode of the display list being compiled, or 0. */
+   GLenum ListMode;
+
+   /** Set by the worker when it records GL_OUT_OF_MEMORY. */
+   bool OutOfMemory;
+
+   /**
+    * State shadowed by glthread, so that glGet* can be answered without
+    * a sync.
+    *
+    * This is only valid while StateValid is set. Calls that glthread can't
+    * follow, or that may fail, invalidate it, and the next
+    * _mesa_glthread_finish reloads it from the context.
+    */
+   bool StateValid;
+   GLuint ActiveTexture; /**< Index of the active texture unit. */
+   GLuint CurrentProgram;
+   GLuint CurrentDrawFramebuffer;
+   GLuint CurrentReadFramebuffer;
+   GLbitfield Enabled; /**< GLTHREAD_ENABLE_* bits. */
+   GLfloat Viewport[4];
+   GLint Scissor[4];
+
+   /** Texture names bound to each target of each unit. */
+   GLuint CurrentTex[MAX_COMBINED_TEXTURE_IMAGE_UNITS][NUM_TEXTURE_TARGETS];
 };
 
 void _mesa_glthread_init(struct gl_context *ctx);
@@ -191,6 +243,21 @@ void _mesa_glthread_upload(struct gl_context *ctx, const void *data,
                            uint8_t **out_ptr);
 void _mesa_glthread_reset_vao(struct glthread_vao *vao);
 
+void _mesa_glthread_reload_state(struct gl_context *ctx);
+void _mesa_glthread_invalidate_state(struct gl_context *ctx);
+void _mesa_glthread_set_enable(struct gl_context *ctx, GLenum cap, bool value);
+void _mesa_glthread_ActiveTexture(struct gl_context *ctx, GLenum texture);
+void _mesa_glthread_BindTexture(struct gl_context *ctx, GLenum target,
+                                GLuint texture);
+void _mesa_glthread_BindFramebuffer(struct gl_context *ctx, GLenum target,
+                                    GLuint framebuffer);
+void _mesa_glthread_Viewport(struct gl_context *ctx, GLint x, GLint y,
+                             GLsizei width, GLsizei height);
+void _mesa_glthread_Scissor(struct gl_context *ctx, GLint x, GLint y,
+                            GLsizei width, GLsizei height);
+
+void _mesa_glthread_PixelStorei(struct gl_context *ctx, GLenum pname,
+                                GLint param);
 void _mesa_glthread_BindBuffer(struct gl_context *ctx, GLenum target,
                                GLuint buffer);
 void _mesa_glthread_DeleteBuffers(struct gl_context *ctx, GLsizei n,
@@ -245,4 +312,8 @@ void _mesa_glthread_PushClientAttrib(struct gl_context *ctx, GLbitfield mask,
 void _mesa_glthread_PopClientAttrib(struct gl_context *ctx);
 void _mesa_glthread_ClientAttribDefault(struct gl_context *ctx, GLbitfield mask);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* _GLTHREAD_H*/
@@ -0,0 +1,475 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* This implements the state queries that glthread can answer from the state
+ * it shadows, so that glGet* doesn't have to wait for the worker thread.
+ *
+ * The shadow state is only updated by calls that can't fail, after glthread
+ * has checked the arguments the same way as the worker. Calls that may fail
+ * invalidate it instead, so that the next query syncs.
+ */
+
+#include <math.h>
+
+#include "main/glthread_marshal.h"
+#include "main/dispatch.h"
+#include "main/get.h"
+#include "main/hash.h"
+#include "main/texobj.h"
+#include "main/texstate.h"
+#include "main/viewport.h"
+#include "util/u_atomic.h"
+
+static GLbitfield
+enable_bit(GLenum cap)
+{
+   switch (cap) {
+   case GL_BLEND:
+      return GLTHREAD_ENABLE_BLEND;
+   case GL_CULL_FACE:
+      return GLTHREAD_ENABLE_CULL_FACE;
+   case GL_DEPTH_TEST:
+      return GLTHREAD_ENABLE_DEPTH_TEST;
+   case GL_DITHER:
+      return GLTHREAD_ENABLE_DITHER;
+   case GL_POLYGON_OFFSET_FILL:
+      return GLTHREAD_ENABLE_POLYGON_OFFSET_FILL;
+   case GL_SCISSOR_TEST:
+      return GLTHREAD_ENABLE_SCISSOR_TEST;
+   case GL_STENCIL_TEST:
+      return GLTHREAD_ENABLE_STENCIL_TEST;
+   default:
+      return 0;
+   }
+}
+
+/* Calls compiled into a display list with GL_COMPILE don't change the state
+ * until the display list is called.
+ */
+static inline bool
+is_compiling(struct gl_context *ctx)
+{
+   return ctx->GLThread.ListMode == GL_COMPILE;
+}
+
+/**
+ * Load the shadowed state from the context. The worker thread must be idle.
+ */
+void
+_mesa_glthread_reload_state(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+
+   glthread->ListMode = !ctx->ListState.CurrentList ? 0 :
+                        ctx->ExecuteFlag ? GL_COMPILE_AND_EXECUTE : GL_COMPILE;
+
+   glthread->ActiveTexture = ctx->Texture.CurrentUnit;
+   glthread->CurrentProgram =
+      ctx->Shader.ActiveProgram ? ctx->Shader.ActiveProgram->Name : 0;
+   glthread->CurrentDrawFramebuffer = ctx->DrawBuffer ? ctx->DrawBuffer->Name : 0;
+   glthread->CurrentReadFramebuffer = ctx->ReadBuffer ? ctx->ReadBuffer->Name : 0;
+
+   glthread->Enabled = 0;
+   if (ctx->Color.BlendEnabled & 1)
+      glthread->Enabled |= GLTHREAD_ENABLE_BLEND;
+   if (ctx->Polygon.CullFlag)
+      glthread->Enabled |= GLTHREAD_ENABLE_CULL_FACE;
+   if (ctx->Depth.Test)
+      glthread->Enabled |= GLTHREAD_ENABLE_DEPTH_TEST;
+   if (ctx->Color.DitherFlag)
+      glthread->Enabled |= GLTHREAD_ENABLE_DITHER;
+   if (ctx->Polygon.OffsetFill)
+      glthread->Enabled |= GLTHREAD_ENABLE_POLYGON_OFFSET_FILL;
+   if (ctx->Scissor.EnableFlags & 1)
+      glthread->Enabled |= GLTHREAD_ENABLE_SCISSOR_TEST;
+   if (ctx->Stencil.Enabled)
+      glthread->Enabled |= GLTHREAD_ENABLE_STENCIL_TEST;
+
+   glthread->Viewport[0] = ctx->ViewportArray[0].X;
+   glthread->Viewport[1] = ctx->ViewportArray[0].Y;
+   glthread->Viewport[2] = ctx->ViewportArray[0].Width;
+   glthread->Viewport[3] = ctx->ViewportArray[0].Height;
+
+   glthread->Scissor[0] = ctx->Scissor.ScissorArray[0].X;
+   glthread->Scissor[1] = ctx->Scissor.ScissorArray[0].Y;
+   glthread->Scissor[2] = ctx->Scissor.ScissorArray[0].Width;
+   glthread->Scissor[3] = ctx->Scissor.ScissorArray[0].Height;
+
+   for (unsigned i = 0; i < ARRAY_SIZE(glthread->CurrentTex); i++) {
+      for (unsigned t = 0; t < NUM_TEXTURE_TARGETS; t++)
+         glthread->CurrentTex[i][t] = ctx->Texture.Unit[i].CurrentTex[t]->Name;
+   }
+
+   /* The buffer and vertex array tracking follows failed calls too, e.g.
+    * within glBegin/glEnd, so correct it as well.
+    */
+   if (ctx->API != API_OPENGL_CORE) {
+      if (glthread->CurrentVAO->Name != ctx->Array.VAO->Name)
+         _mesa_glthread_BindVertexArray(ctx, ctx->Array.VAO->Name);
+
+      glthread->CurrentArrayBufferName =
+         ctx->Array.ArrayBufferObj ? ctx->Array.ArrayBufferObj->Name : 0;
+      if (glthread->CurrentVAO->Name == ctx->Array.VAO->Name) {
+         glthread->CurrentVAO->CurrentElementBufferName =
+            ctx->Array.VAO->IndexBufferObj ?
+               ctx->Array.VAO->IndexBufferObj->Name : 0;
+      }
+   }
+
+   glthread->StateValid = true;
+}
+
+void
+_mesa_glthread_invalidate_state(struct gl_context *ctx)
+{
+   ctx->GLThread.StateValid = false;
+}
+
+void
+_mesa_glthread_set_enable(struct gl_context *ctx, GLenum cap, bool value)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+
+   if (is_compiling(ctx))
+      return;
+
+   if (value)
+      glthread->Enabled |= enable_bit(cap);
+   else
+      glthread->Enabled &= ~enable_bit(cap);
+}
+
+void
+_mesa_glthread_ActiveTexture(struct gl_context *ctx, GLenum texture)
+{
+   GLuint unit = texture - GL_TEXTURE0;
+
+   if (is_compiling(ctx))
+      return;
+
+   /* Invalid units generate GL_INVALID_ENUM and don't change the state. */
+   if (unit < _mesa_max_tex_unit(ctx))
+      ctx->GLThread.ActiveTexture = unit;
+}
+
+/* The target of a texture object never changes once it's set. */
+static bool
+texture_has_target(struct gl_context *ctx, GLuint texture, GLenum target)
+{
+   struct _mesa_HashTable *textures = ctx->Shared->TexObjects;
+   struct gl_texture_object *texObj;
+   bool match;
+
+   _mesa_HashLockMutex(textures);
+   texObj = _mesa_HashLookupLocked(textures, texture);
+   match = texObj && texObj->Target == target;
+   _mesa_HashUnlockMutex(textures);
+
+   return match;
+}
+
+void
+_mesa_glthread_BindTexture(struct gl_context *ctx, GLenum target,
+                           GLuint texture)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+   int index = _mesa_tex_target_to_index(ctx, target);
+
+   /* Invalid targets generate GL_INVALID_ENUM and don't change the state. */
+   if (is_compiling(ctx) || index < 0)
+      return;
+
+   /* Binding a texture of another target fails, and so does binding a name
+    * that wasn't generated in a core context. Only textures that already
+    * have this target are known to succeed.
+    */
+   if (texture && !texture_has_target(ctx, texture, target)) {
+      _mesa_glthread_invalidate_state(ctx);
+      return;
+   }
+
+   glthread->CurrentTex[glthread->ActiveTexture][index] = texture;
+}
+
+void
+_mesa_glthread_BindFramebuffer(struct gl_context *ctx, GLenum target,
+                               GLuint framebuffer)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+
+   /* Core contexts only accept generated names. This is never compiled into
+    * display lists.
+    */
+   if (framebuffer && ctx->API == API_OPENGL_CORE &&
+       !_mesa_HashLookup(ctx->Shared->FrameBuffers, framebuffer)) {
+      _mesa_glthread_invalidate_state(ctx);
+      return;
+   }
+
+   switch (target) {
+   case GL_FRAMEBUFFER:
+      glthread->CurrentDrawFramebuffer = framebuffer;
+      glthread->CurrentReadFramebuffer = framebuffer;
+      break;
+   case GL_DRAW_FRAMEBUFFER:
+      glthread->CurrentDrawFramebuffer = framebuffer;
+      break;
+   case GL_READ_FRAMEBUFFER:
+      glthread->CurrentReadFramebuffer = framebuffer;
+      break;
+   }
+}
+
+void
+_mesa_glthread_Viewport(struct gl_context *ctx, GLint x, GLint y,
+                        GLsizei width, GLsizei height)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+   GLfloat v[4] = { x, y, width, height };
+
+   if (is_compiling(ctx) || width < 0 || height < 0)
+      return;
+
+   _mesa_clamp_viewport(ctx, &v[0], &v[1], &v[2], &v[3]);
+   memcpy(glthread->Viewport, v, sizeof(v));
+}
+
+void
+_mesa_glthread_Scissor(struct gl_context *ctx, GLint x, GLint y,
+                       GLsizei width, GLsizei height)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+
+   if (is_compiling(ctx) || width < 0 || height < 0)
+      return;
+
+   glthread->Scissor[0] = x;
+   glthread->Scissor[1] = y;
+   glthread->Scissor[2] = width;
+   glthread->Scissor[3] = height;
+}
+
+struct glthread_value {
+   unsigned count; /**< 0 if the value isn't shadowed by glthread. */
+   bool is_float;
+   union {
+      GLint i[4];
+      GLfloat f[4];
+   } v;
+};
+
+static int
+tex_binding_to_index(GLenum pname)
+{
+   switch (pname) {
+   case GL_TEXTURE_BINDING_1D:
+      return TEXTURE_1D_INDEX;
+   case GL_TEXTURE_BINDING_2D:
+      return TEXTURE_2D_INDEX;
+   case GL_TEXTURE_BINDING_3D:
+      return TEXTURE_3D_INDEX;
+   case GL_TEXTURE_BINDING_CUBE_MAP:
+      return TEXTURE_CUBE_INDEX;
+   case GL_TEXTURE_BINDING_RECTANGLE:
+      return TEXTURE_RECT_INDEX;
+   case GL_TEXTURE_BINDING_1D_ARRAY:
+      return TEXTURE_1D_ARRAY_INDEX;
+   case GL_TEXTURE_BINDING_2D_ARRAY:
+      return TEXTURE_2D_ARRAY_INDEX;
+   case GL_TEXTURE_BINDING_BUFFER:
+      return TEXTURE_BUFFER_INDEX;
+   case GL_TEXTURE_BINDING_CUBE_MAP_ARRAY:
+      return TEXTURE_CUBE_ARRAY_INDEX;
+   case GL_TEXTURE_BINDING_EXTERNAL_OES:
+      return TEXTURE_EXTERNAL_INDEX;
+   case GL_TEXTURE_BINDING_2D_MULTISAMPLE:
+      return TEXTURE_2D_MULTISAMPLE_INDEX;
+   case GL_TEXTURE_BINDING_2D_MULTISAMPLE_ARRAY:
+      return TEXTURE_2D_MULTISAMPLE_ARRAY_INDEX;
+   default:
+      return -1;
+   }
+}
+
+/**
+ * Return the value of pname if glthread knows it. Parameters that glGet*
+ * doesn't accept in this context are left to glGet*, which reports the
+ * error.
+ */
+static struct glthread_value
+get_value(struct gl_context *ctx, GLenum pname)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+   struct glthread_value value = {0};
+   int index;
+
+   if (!glthread->StateValid)
+      return value;
+
+   switch (pname) {
+   /* The buffer and vertex array bindings aren't tracked in core contexts,
+    * where binding a name that wasn't generated fails.
+    */
+   case GL_ARRAY_BUFFER_BINDING:
+      if (ctx->API != API_OPENGL_CORE) {
+         value.count = 1;
+         value.v.i[0] = glthread->CurrentArrayBufferName;
+      }
+      break;
+   case GL_ELEMENT_ARRAY_BUFFER_BINDING:
+      if (ctx->API != API_OPENGL_CORE) {
+         value.count = 1;
+         value.v.i[0] = glthread->CurrentVAO->CurrentElementBufferName;
+      }
+      break;
+   case GL_VERTEX_ARRAY_BINDING:
+      if (ctx->API != API_OPENGL_CORE) {
+         value.count = 1;
+         value.v.i[0] = glthread->CurrentVAO->Name;
+      }
+      break;
+   case GL_ACTIVE_TEXTURE:
+      value.count = 1;
+      value.v.i[0] = GL_TEXTURE0 + glthread->ActiveTexture;
+      break;
+   case GL_CURRENT_PROGRAM:
+      value.count = 1;
+      value.v.i[0] = glthread->CurrentProgram;
+      break;
+   case GL_DRAW_FRAMEBUFFER_BINDING:
+      value.count = 1;
+      value.v.i[0] = glthread->CurrentDrawFramebuffer;
+      break;
+   case GL_READ_FRAMEBUFFER_BINDING:
+      value.count = 1;
+      value.v.i[0] = glthread->CurrentReadFramebuffer;
+      break;
+   case GL_VIEWPORT:
+      value.count = 4;
+      value.is_float = true;
+      memcpy(value.v.f, glthread->Viewport, sizeof(value.v.f));
+      break;
+   case GL_SCISSOR_BOX:
+      value.count = 4;
+      memcpy(value.v.i, glthread->Scissor, sizeof(value.v.i));
+      break;
+   default:
+      index = tex_binding_to_index(pname);
+      if (index >= 0) {
+         value.count = 1;
+         value.v.i[0] = glthread->CurrentTex[glthread->ActiveTexture][index];
+      } else if (enable_bit(pname)) {
+         value.count = 1;
+         value.v.i[0] = !!(glthread->Enabled & enable_bit(pname));
+      }
+      break;
+   }
+
+   if (value.count && !_mesa_is_get_pname_supported(ctx, pname))
+      value.count = 0;
+
+   return value;
+}
+
+void GLAPIENTRY
+_mesa_marshal_GetBooleanv(GLenum pname, GLboolean *p)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   struct glthread_value value = get_value(ctx, pname);
+
+   if (!value.count) {
+      _mesa_glthread_finish_before(ctx, "GetBooleanv");
+      CALL_GetBooleanv(ctx->CurrentServerDispatch, (pname, p));
+      return;
+   }
+
+   for (unsigned i = 0; i < value.count; i++) {
+      if (value.is_float)
+         p[i] = value.v.f[i] != 0.0f ? GL_TRUE : GL_FALSE;
+      else
+         p[i] = value.v.i[i] ? GL_TRUE : GL_FALSE;
+   }
+}
+
+void GLAPIENTRY
+_mesa_marshal_GetFloatv(GLenum pname, GLfloat *p)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   struct glthread_value value = get_value(ctx, pname);
+
+   if (!value.count) {
+      _mesa_glthread_finish_before(ctx, "GetFloatv");
+      CALL_GetFloatv(ctx->CurrentServerDispatch, (pname, p));
+      return;
+   }
+
+   for (unsigned i = 0; i < value.count; i++)
+      p[i] = value.is_float ? value.v.f[i] : (GLfloat)value.v.i[i];
+}
+
+void GLAPIENTRY
+_mesa_marshal_GetIntegerv(GLenum pname, GLint *p)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   struct glthread_value value = get_value(ctx, pname);
+
+   if (!value.count) {
+      _mesa_glthread_finish_before(ctx, "GetIntegerv");
+      CALL_GetIntegerv(ctx->CurrentServerDispatch, (pname, p));
+      return;
+   }
+
+   for (unsigned i = 0; i < value.count; i++)
+      p[i] = value.is_float ? lroundf(value.v.f[i]) : value.v.i[i];
+}
+
+GLboolean GLAPIENTRY
+_mesa_marshal_IsEnabled(GLenum cap)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   struct glthread_state *glthread = &ctx->GLThread;
+
+   if (glthread->StateValid && enable_bit(cap))
+      return (glthread->Enabled & enable_bit(cap)) != 0;
+
+   _mesa_glthread_finish_before(ctx, "IsEnabled");
+   return CALL_IsEnabled(ctx->CurrentServerDispatch, (cap));
+}
+
+GLenum GLAPIENTRY
+_mesa_marshal_GetError(void)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   struct glthread_state *glthread = &ctx->GLThread;
+
+   /* With KHR_no_error, glGetError only reports GL_OUT_OF_MEMORY, which
+    * the worker flags when it records one. An out-of-memory error in a call
+    * that is still queued is reported by a later glGetError.
+    */
+   if (_mesa_is_no_error_enabled(ctx) && !p_atomic_read(&glthread->OutOfMemory))
+      return GL_NO_ERROR;
+
+   _mesa_glthread_finish_before(ctx, "GetError");
+   glthread->OutOfMemory = false;
+   return CALL_GetError(ctx->CurrentServerDispatch, ());
+}
@@ -0,0 +1,538 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* This implements the asynchronous marshalling of the functions that read
+ * pixel data from client memory or from the pixel unpack buffer.
+ *
+ * If an unpack buffer is bound, the pointer is an offset into it and is
+ * passed as is. Otherwise, small data is copied into the batch, and large
+ * data is copied into the glthread upload buffer, which the worker binds
+ * as the unpack buffer for the duration of the call.
+ */
+
+#include "main/glthread_marshal.h"
+#include "main/dispatch.h"
+#include "main/bufferobj.h"
+
+/** How the pixel data of a command is passed to the worker thread. */
+enum unpack_data_mode {
+   UNPACK_DATA_SYNC,    /**< execute the call synchronously */
+   UNPACK_DATA_POINTER, /**< pass the pointer, which is NULL or an offset */
+   UNPACK_DATA_INLINE,  /**< copy the data after the command */
+};
+
+void
+_mesa_glthread_PixelStorei(struct gl_context *ctx, GLenum pname, GLint param)
+{
+   /* Negative values are errors, which don't change the state. */
+   if (pname == GL_UNPACK_COMPRESSED_BLOCK_SIZE && param >= 0)
+      ctx->GLThread.UnpackCompressedBlockSize = param;
+}
+
+static enum unpack_data_mode
+get_unpack_data_mode(struct gl_context *ctx, int cmd_size, GLsizei size,
+                     const GLvoid **data,
+                     struct gl_buffer_object **upload_buffer)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+
+   /* The pointer is NULL or an offset into the bound unpack buffer. */
+   if (glthread->CurrentPixelUnpackBufferName || !*data)
+      return UNPACK_DATA_POINTER;
+
+   if (size < 0)
+      return UNPACK_DATA_SYNC;
+
+   if (cmd_size + size <= MARSHAL_MAX_CMD_SIZE)
+      return UNPACK_DATA_INLINE;
+
+   /* Display lists don't support reading compressed images from unpack
+    * buffers, so they can't use the upload buffer.
+    */
+   if (glthread->SupportsBufferUploads && !glthread->inside_dlist) {
+      unsigned upload_offset = 0;
+
+      _mesa_glthread_upload(ctx, *data, size, &upload_offset, upload_buffer,
+                            NULL);
+      if (*upload_buffer) {
+         *data = (const GLvoid *)(uintptr_t)upload_offset;
+         return UNPACK_DATA_POINTER;
+      }
+   }
+
+   return UNPACK_DATA_SYNC;
+}
+
+/* CompressedTexImage: marshalled asynchronously */
+struct marshal_cmd_CompressedTexImage3D
+{
+   struct marshal_cmd_base cmd_base;
+   GLubyte dims;
+   bool data_inline; /* If set, imageSize bytes of data follow */
+   GLenum target;
+   GLint level;
+   GLenum internalformat;
+   GLsizei width;
+   GLsizei height;
+   GLsizei depth;
+   GLint border;
+   GLsizei imageSize;
+   const GLvoid *data;
+   struct gl_buffer_object *upload_buffer;
+};
+
+static void
+call_CompressedTexImage(struct gl_context *ctx, unsigned dims, GLenum target,
+                        GLint level, GLenum internalformat, GLsizei width,
+                        GLsizei height, GLsizei depth, GLint border,
+                        GLsizei imageSize, const GLvoid *data)
+{
+   switch (dims) {
+   case 1:
+      CALL_CompressedTexImage1D(ctx->CurrentServerDispatch,
+                                (target, level, internalformat, width,
+                                 border, imageSize, data));
+      break;
+   case 2:
+      CALL_CompressedTexImage2D(ctx->CurrentServerDispatch,
+                                (target, level, internalformat, width,
+                                 height, border, imageSize, data));
+      break;
+   default:
+      CALL_CompressedTexImage3D(ctx->CurrentServerDispatch,
+                                (target, level, internalformat, width,
+                                 height, depth, border, imageSize, data));
+      break;
+   }
+}
+
+void
+_mesa_unmarshal_CompressedTexImage3D(struct gl_context *ctx,
+                                     const struct marshal_cmd_CompressedTexImage3D *cmd)
+{
+   struct gl_buffer_object *upload_buffer = cmd->upload_buffer;
+   const GLvoid *data = cmd->data_inline ? (const GLvoid *)(cmd + 1) :
+                                           cmd->data;
+
+   if (upload_buffer)
+      _mesa_InternalBindPixelUnpackBuffer(ctx, upload_buffer);
+
+   call_CompressedTexImage(ctx, cmd->dims, cmd->target, cmd->level,
+                           cmd->internalformat, cmd->width, cmd->height,
+                           cmd->depth, cmd->border, cmd->imageSize, data);
+
+   if (upload_buffer)
+      _mesa_InternalBindPixelUnpackBuffer(ctx, NULL);
+}
+
+void
+_mesa_unmarshal_CompressedTexImage2D(struct gl_context *ctx,
+                                     const struct marshal_cmd_CompressedTexImage2D *cmd)
+{
+   unreachable("never used - all CompressedTexImage variants use DISPATCH_CMD_CompressedTexImage3D");
+}
+
+void
+_mesa_unmarshal_CompressedTexImage1D(struct gl_context *ctx,
+                                     const struct marshal_cmd_CompressedTexImage1D *cmd)
+{
+   unreachable("never used - all CompressedTexImage variants use DISPATCH_CMD_CompressedTexImage3D");
+}
+
+static void
+_mesa_marshal_CompressedTexImage_merged(unsigned dims, GLenum target,
+                                        GLint level, GLenum internalformat,
+                                        GLsizei width, GLsizei height,
+                                        GLsizei depth, GLint border,
+                                        GLsizei imageSize, const GLvoid *data,
+                                        const char *func)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   struct gl_buffer_object *upload_buffer = NULL;
+   int cmd_size = sizeof(struct marshal_cmd_CompressedTexImage3D);
+   enum unpack_data_mode mode = UNPACK_DATA_SYNC;
+
+   /* With GL_UNPACK_COMPRESSED_BLOCK_SIZE, the skip and row length
+    * parameters can make the driver read more than imageSize bytes.
+    */
+   if (ctx->GLThread.CurrentPixelUnpackBufferName ||
+       !ctx->GLThread.UnpackCompressedBlockSize) {
+      mode = get_unpack_data_mode(ctx, cmd_size, imageSize, &data,
+                                  &upload_buffer);
+   }
+
+   if (unlikely(mode == UNPACK_DATA_SYNC)) {
+      _mesa_glthread_finish_before(ctx, func);
+      call_CompressedTexImage(ctx, dims, target, level, internalformat,
+                              width, height, depth, border, imageSize, data);
+      return;
+   }
+
+   if (mode == UNPACK_DATA_INLINE)
+      cmd_size += imageSize;
+
+   struct marshal_cmd_CompressedTexImage3D *cmd =
+      _mesa_glthread_allocate_command(ctx, DISPATCH_CMD_CompressedTexImage3D,
+                                      cmd_size);
+   cmd->dims = dims;
+   cmd->data_inline = mode == UNPACK_DATA_INLINE;
+   cmd->target = target;
+   cmd->level = level;
+   cmd->internalformat = internalformat;
+   cmd->width = width;
+   cmd->height = height;
+   cmd->depth = depth;
+   cmd->border = border;
+   cmd->imageSize = imageSize;
+   cmd->data = data;
+   cmd->upload_buffer = upload_buffer;
+
+   if (mode == UNPACK_DATA_INLINE)
+      memcpy(cmd + 1, data, imageSize);
+}
+
+void GLAPIENTRY
+_mesa_marshal_CompressedTexImage1D(GLenum target, GLint level,
+                                   GLenum internalformat, GLsizei width,
+                                   GLint border, GLsizei imageSize,
+                                   const GLvoid *data)
+{
+   _mesa_marshal_CompressedTexImage_merged(1, target, level, internalformat,
+                                           width, 1, 1, border, imageSize,
+                                           data, "CompressedTexImage1D");
+}
+
+void GLAPIENTRY
+_mesa_marshal_CompressedTexImage2D(GLenum target, GLint level,
+                                   GLenum internalformat, GLsizei width,
+                                   GLsizei height, GLint border,
+                                   GLsizei imageSize, const GLvoid *data)
+{
+   _mesa_marshal_CompressedTexImage_merged(2, target, level, internalformat,
+                                           width, height, 1, border,
+                                           imageSize, data,
+                                           "CompressedTexImage2D");
+}
+
+void GLAPIENTRY
+_mesa_marshal_CompressedTexImage3D(GLenum target, GLint level,
+                                   GLenum internalformat, GLsizei width,
+                                   GLsizei height, GLsizei depth,
+                                   GLint border, GLsizei imageSize,
+                                   const GLvoid *data)
+{
+   _mesa_marshal_CompressedTexImage_merged(3, target, level, internalformat,
+                                           width, height, depth, border,
+                                           imageSize, data,
+                                           "CompressedTexImage3D");
+}
+
+/* CompressedTexSubImage: marshalled asynchronously */
+struct marshal_cmd_CompressedTexSubImage3D
+{
+   struct marshal_cmd_base cmd_base;
+   GLubyte dims;
+   bool data_inline; /* If set, imageSize bytes of data follow */
+   GLenum target;
+   GLint level;
+   GLint xoffset;
+   GLint yoffset;
+   GLint zoffset;
+   GLsizei width;
+   GLsizei height;
+   GLsizei depth;
+   GLenum format;
+   GLsizei imageSize;
+   const GLvoid *data;
+   struct gl_buffer_object *upload_buffer;
+};
+
+static void
+call_CompressedTexSubImage(struct gl_context *ctx, unsigned dims,
+                           GLenum target, GLint level, GLint xoffset,
+                           GLint yoffset, GLint zoffset, GLsizei width,
+                           GLsizei height, GLsizei depth, GLenum format,
+                           GLsizei imageSize, const GLvoid *data)
+{
+   switch (dims) {
+   case 1:
+      CALL_CompressedTexSubImage1D(ctx->CurrentServerDispatch,
+                                   (target, level, xoffset, width, format,
+                                    imageSize, data));
+      break;
+   case 2:
+      CALL_CompressedTexSubImage2D(ctx->CurrentServerDispatch,
+                                   (target, level, xoffset, yoffset, width,
+                                    height, format, imageSize, data));
+      break;
+   default:
+      CALL_CompressedTexSubImage3D(ctx->CurrentServerDispatch,
+                                   (target, level, xoffset, yoffset, zoffset,
+                                    width, height, depth, format, imageSize,
+                                    data));
+      break;
+   }
+}
+
+void
+_mesa_unmarshal_CompressedTexSubImage3D(struct gl_context *ctx,
+                                        const struct marshal_cmd_CompressedTexSubImage3D *cmd)
+{
+   struct gl_buffer_object *upload_buffer = cmd->upload_buffer;
+   const GLvoid *data = cmd->data_inline ? (const GLvoid *)(cmd + 1) :
+                                           cmd->data;
+
+   if (upload_buffer)
+      _mesa_InternalBindPixelUnpackBuffer(ctx, upload_buffer);
+
+   call_CompressedTexSubImage(ctx, cmd->dims, cmd->target, cmd->level,
+                              cmd->xoffset, cmd->yoffset, cmd->zoffset,
+                              cmd->width, cmd->height, cmd->depth,
+                              cmd->format, cmd->imageSize, data);
+
+   if (upload_buffer)
+      _mesa_InternalBindPixelUnpackBuffer(ctx, NULL);
+}
+
+void
+_mesa_unmarshal_CompressedTexSubImage2D(struct gl_context *ctx,
+                                        const struct marshal_cmd_CompressedTexSubImage2D *cmd)
+{
+   unreachable("never used - all CompressedTexSubImage variants use DISPATCH_CMD_CompressedTexSubImage3D");
+}
+
+void
+_mesa_unmarshal_CompressedTexSubImage1D(struct gl_context *ctx,
+                                        const struct marshal_cmd_CompressedTexSubImage1D *cmd)
+{
+   unreachable("never used - all CompressedTexSubImage variants use DISPATCH_CMD_CompressedTexSubImage3D");
+}
+
+static void
+_mesa_marshal_CompressedTexSubImage_merged(unsigned dims, GLenum target,
+                                           GLint level, GLint xoffset,
+                                           GLint yoffset, GLint zoffset,
+                                           GLsizei width, GLsizei height,
+                                           GLsizei depth, GLenum format,
+                                           GLsizei imageSize,
+                                           const GLvoid *data,
+                                           const char *func)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   struct gl_buffer_object *upload_buffer = NULL;
+   int cmd_size = sizeof(struct marshal_cmd_CompressedTexSubImage3D);
+   enum unpack_data_mode mode = UNPACK_DATA_SYNC;
+
+   /* See _mesa_marshal_CompressedTexImage_merged. */
+   if (ctx->GLThread.CurrentPixelUnpackBufferName ||
+       !ctx->GLThread.UnpackCompressedBlockSize) {
+      mode = get_unpack_data_mode(ctx, cmd_size, imageSize, &data,
+                                  &upload_buffer);
+   }
+
+   if (unlikely(mode == UNPACK_DATA_SYNC)) {
+      _mesa_glthread_finish_before(ctx, func);
+      call_CompressedTexSubImage(ctx, dims, target, level, xoffset, yoffset,
+                                 zoffset, width, height, depth, format,
+                                 imageSize, data);
+      return;
+   }
+
+   if (mode == UNPACK_DATA_INLINE)
+      cmd_size += imageSize;
+
+   struct marshal_cmd_CompressedTexSubImage3D *cmd =
+      _mesa_glthread_allocate_command(ctx, DISPATCH_CMD_CompressedTexSubImage3D,
+                                      cmd_size);
+   cmd->dims = dims;
+   cmd->data_inline = mode == UNPACK_DATA_INLINE;
+   cmd->target = target;
+   cmd->level = level;
+   cmd->xoffset = xoffset;
+   cmd->yoffset = yoffset;
+   cmd->zoffset = zoffset;
+   cmd->width = width;
+   cmd->height = height;
+   cmd->depth = depth;
+   cmd->format = format;
+   cmd->imageSize = imageSize;
+   cmd->data = data;
+   cmd->upload_buffer = upload_buffer;
+
+   if (mode == UNPACK_DATA_INLINE)
+      memcpy(cmd + 1, data, imageSize);
+}
+
+void GLAPIENTRY
+_mesa_marshal_CompressedTexSubImage1D(GLenum target, GLint level,
+                                      GLint xoffset, GLsizei width,
+                                      GLenum format, GLsizei imageSize,
+                                      const GLvoid *data)
+{
+   _mesa_marshal_CompressedTexSubImage_merged(1, target, level, xoffset, 0, 0,
+                                              width, 1, 1, format, imageSize,
+                                              data, "CompressedTexSubImage1D");
+}
+
+void GLAPIENTRY
+_mesa_marshal_CompressedTexSubImage2D(GLenum target, GLint level,
+                                      GLint xoffset, GLint yoffset,
+                                      GLsizei width, GLsizei height,
+                                      GLenum format, GLsizei imageSize,
+                                      const GLvoid *data)
+{
+   _mesa_marshal_CompressedTexSubImage_merged(2, target, level, xoffset,
+                                              yoffset, 0, width, height, 1,
+                                              format, imageSize, data,
+                                              "CompressedTexSubImage2D");
+}
+
+void GLAPIENTRY
+_mesa_marshal_CompressedTexSubImage3D(GLenum target, GLint level,
+                                      GLint xoffset, GLint yoffset,
+                                      GLint zoffset, GLsizei width,
+                                      GLsizei height, GLsizei depth,
+                                      GLenum format, GLsizei imageSize,
+                                      const GLvoid *data)
+{
+   _mesa_marshal_CompressedTexSubImage_merged(3, target, level, xoffset,
+                                              yoffset, zoffset, width, height,
+                                              depth, format, imageSize, data,
+                                              "CompressedTexSubImage3D");
+}
+
+/* PixelMap: marshalled asynchronously */
+struct marshal_cmd_PixelMapfv
+{
+   struct marshal_cmd_base cmd_base;
+   bool values_inline; /* If set, mapsize values follow */
+   GLenum type; /* GL_FLOAT, GL_UNSIGNED_INT or GL_UNSIGNED_SHORT */
+   GLenum map;
+   GLsizei mapsize;
+   const GLvoid *values;
+};
+
+static void
+call_PixelMap(struct gl_context *ctx, GLenum type, GLenum map,
+              GLsizei mapsize, const GLvoid *values)
+{
+   switch (type) {
+   case GL_FLOAT:
+      CALL_PixelMapfv(ctx->CurrentServerDispatch,
+                      (map, mapsize, (const GLfloat *)values));
+      break;
+   case GL_UNSIGNED_INT:
+      CALL_PixelMapuiv(ctx->CurrentServerDispatch,
+                       (map, mapsize, (const GLuint *)values));
+      break;
+   default:
+      CALL_PixelMapusv(ctx->CurrentServerDispatch,
+                       (map, mapsize, (const GLushort *)values));
+      break;
+   }
+}
+
+void
+_mesa_unmarshal_PixelMapfv(struct gl_context *ctx,
+                           const struct marshal_cmd_PixelMapfv *cmd)
+{
+   const GLvoid *values = cmd->values_inline ? (const GLvoid *)(cmd + 1) :
+                                               cmd->values;
+
+   call_PixelMap(ctx, cmd->type, cmd->map, cmd->mapsize, values);
+}
+
+void
+_mesa_unmarshal_PixelMapuiv(struct gl_context *ctx,
+                            const struct marshal_cmd_PixelMapuiv *cmd)
+{
+   unreachable("never used - all PixelMap variants use DISPATCH_CMD_PixelMapfv");
+}
+
+void
+_mesa_unmarshal_PixelMapusv(struct gl_context *ctx,
+                            const struct marshal_cmd_PixelMapusv *cmd)
+{
+   unreachable("never used - all PixelMap variants use DISPATCH_CMD_PixelMapfv");
+}
+
+static void
+_mesa_marshal_PixelMap_merged(GLenum type, unsigned value_size, GLenum map,
+                              GLsizei mapsize, const GLvoid *values,
+                              const char *func)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   struct gl_buffer_object *upload_buffer = NULL;
+   int cmd_size = sizeof(struct marshal_cmd_PixelMapfv);
+   enum unpack_data_mode mode = UNPACK_DATA_SYNC;
+
+   /* The table is at most MAX_PIXEL_MAP_TABLE entries, which always fits
+    * in the batch. Larger sizes are errors.
+    */
+   if (mapsize <= MAX_PIXEL_MAP_TABLE) {
+      mode = get_unpack_data_mode(ctx, cmd_size, mapsize * value_size,
+                                  &values, &upload_buffer);
+      assert(!upload_buffer);
+   }
+
+   if (unlikely(mode == UNPACK_DATA_SYNC)) {
+      _mesa_glthread_finish_before(ctx, func);
+      call_PixelMap(ctx, type, map, mapsize, values);
+      return;
+   }
+
+   if (mode == UNPACK_DATA_INLINE)
+      cmd_size += mapsize * value_size;
+
+   struct marshal_cmd_PixelMapfv *cmd =
+      _mesa_glthread_allocate_command(ctx, DISPATCH_CMD_PixelMapfv, cmd_size);
+   cmd->values_inline = mode == UNPACK_DATA_INLINE;
+   cmd->type = type;
+   cmd->map = map;
+   cmd->mapsize = mapsize;
+   cmd->values = values;
+
+   if (mode == UNPACK_DATA_INLINE)
+      memcpy(cmd + 1, values, mapsize * value_size);
+}
+
+void GLAPIENTRY
+_mesa_marshal_PixelMapfv(GLenum map, GLsizei mapsize, const GLfloat *values)
+{
+   _mesa_marshal_PixelMap_merged(GL_FLOAT, sizeof(GLfloat), map, mapsize,
+                                 values, "PixelMapfv");
+}
+
+void GLAPIENTRY
+_mesa_marshal_PixelMapuiv(GLenum map, GLsizei mapsize, const GLuint *values)
+{
+   _mesa_marshal_PixelMap_merged(GL_UNSIGNED_INT, sizeof(GLuint), map,
+                                 mapsize, values, "PixelMapuiv");
+}
+
+void GLAPIENTRY
+_mesa_marshal_PixelMapusv(GLenum map, GLsizei mapsize, const GLushort *values)
+{
+   _mesa_marshal_PixelMap_merged(GL_UNSIGNED_SHORT, sizeof(GLushort), map,
+                                 mapsize, values, "PixelMapusv");
+}
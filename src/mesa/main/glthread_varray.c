@@ -573,6 +573,14 @@ _mesa_glthread_PushClientAttrib(struct gl_context *ctx, GLbitfield mask,
    struct glthread_client_attrib *top =
       &glthread->ClientAttribStack[glthread->ClientAttribStackTop];
 
+   if (mask & GL_CLIENT_PIXEL_STORE_BIT) {
+      top->CurrentPixelUnpackBufferName = glthread->CurrentPixelUnpackBufferName;
+      top->UnpackCompressedBlockSize = glthread->UnpackCompressedBlockSize;
+      top->PixelStoreValid = true;
+   } else {
+      top->PixelStoreValid = false;
+   }
+
    if (mask & GL_CLIENT_VERTEX_ARRAY_BIT) {
       top->VAO = *glthread->CurrentVAO;
       top->CurrentArrayBufferName = glthread->CurrentArrayBufferName;
@@ -604,6 +612,11 @@ _mesa_glthread_PopClientAttrib(struct gl_context *ctx)
    struct glthread_client_attrib *top =
       &glthread->ClientAttribStack[glthread->ClientAttribStackTop];
 
+   if (top->PixelStoreValid) {
+      glthread->CurrentPixelUnpackBufferName = top->CurrentPixelUnpackBufferName;
+      glthread->UnpackCompressedBlockSize = top->UnpackCompressedBlockSize;
+   }
+
    if (!top->Valid)
       return;
 
@@ -635,6 +648,10 @@ _mesa_glthread_ClientAttribDefault(struct gl_context *ctx, GLbitfield mask)
 {
    struct glthread_state *glthread = &ctx->GLThread;
 
+   /* This doesn't reset the compressed block parameters. */
+   if (mask & GL_CLIENT_PIXEL_STORE_BIT)
+      glthread->CurrentPixelUnpackBufferName = 0;
+
    if (!(mask & GL_CLIENT_VERTEX_ARRAY_BIT))
       return;
 
@@ -4074,6 +4074,12 @@ struct gl_constants
     */
    GLboolean DisableGLSLLineContinuations;
 
+   /**
+    * Always run the full GLSL preprocessor, rather than the fast path for
+    * shaders without macros or conditionals.
+    */
+   GLboolean DisableGLSLPreprocessorFastPath;
+
    /** GL_ARB_texture_multisample */
    GLint MaxColorTextureSamples;
    GLint MaxDepthTextureSamples;
@@ -0,0 +1,118 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file astc_bench.cpp
+ *
+ * Measures how many texels per second _mesa_unpack_astc_2d_ldr() produces,
+ * for a few block sizes.
+ *
+ * Usage: astc_bench [width height [iterations]]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "main/formats.h"
+#include "main/texcompress_astc.h"
+#include "util/macros.h"
+#include "util/os_time.h"
+
+static const mesa_format formats[] = {
+   MESA_FORMAT_RGBA_ASTC_4x4,
+   MESA_FORMAT_RGBA_ASTC_6x6,
+   MESA_FORMAT_RGBA_ASTC_8x8,
+   MESA_FORMAT_RGBA_ASTC_12x12,
+   MESA_FORMAT_SRGB8_ALPHA8_ASTC_8x8,
+};
+
+static double
+mtexels_per_second(mesa_format format,
+                   const std::vector<uint8_t> &blocks, unsigned blocks_x,
+                   std::vector<uint8_t> &texels, unsigned width,
+                   unsigned height, unsigned iterations)
+{
+   /* Fault in the destination first. */
+   _mesa_unpack_astc_2d_ldr(texels.data(), width * 4, blocks.data(),
+                            blocks_x * 16, width, height, format);
+
+   int64_t start = os_time_get_nano();
+
+   for (unsigned i = 0; i < iterations; i++) {
+      _mesa_unpack_astc_2d_ldr(texels.data(), width * 4, blocks.data(),
+                               blocks_x * 16, width, height, format);
+   }
+
+   int64_t ns = os_time_get_nano() - start;
+   return (double)width * height * iterations * 1000.0 / ns;
+}
+
+int
+main(int argc, char **argv)
+{
+   unsigned width = argc > 2 ? atoi(argv[1]) : 2048;
+   unsigned height = argc > 2 ? atoi(argv[2]) : 2048;
+   unsigned iterations = argc > 3 ? atoi(argv[3]) : 4;
+
+   if (!width || !height || !iterations) {
+      fprintf(stderr, "usage: %s [width height [iterations]]\n", argv[0]);
+      return 1;
+   }
+
+   srand(1);
+
+   for (unsigned f = 0; f < ARRAY_SIZE(formats); f++) {
+      unsigned bw, bh, bd;
+      _mesa_get_format_block_size_3d(formats[f], &bw, &bh, &bd);
+
+      unsigned blocks_x = (width + bw - 1) / bw;
+      unsigned blocks_y = (height + bh - 1) / bh;
+      std::vector<uint8_t> blocks(blocks_x * blocks_y * 16);
+      std::vector<uint8_t> texels(width * height * 4);
+      std::vector<uint8_t> block_texels(bw * bh * 4);
+
+      /* Only keep blocks that don't decode to the error colour. */
+      for (unsigned b = 0; b < blocks_x * blocks_y; b++) {
+         uint8_t *block = &blocks[b * 16];
+         bool error = true;
+
+         for (unsigned tries = 0; tries < 1000 && error; tries++) {
+            for (unsigned i = 0; i < 16; i++)
+               block[i] = rand();
+
+            _mesa_unpack_astc_2d_ldr(block_texels.data(), bw * 4,
+                                     block, 16, bw, bh, formats[f]);
+            error = block_texels[0] == 0xff && block_texels[1] == 0 &&
+                    block_texels[2] == 0xff && block_texels[3] == 0xff;
+         }
+      }
+
+      printf("%-36s %8.1f MTexel/s\n", _mesa_get_format_name(formats[f]),
+             mtexels_per_second(formats[f], blocks, blocks_x, texels,
+                                width, height, iterations));
+   }
+
+   return 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file etc2_bench.cpp
+ *
+ * Measures how many texels per second _mesa_unpack_etc2_format() produces,
+ * for the ETC2 and EAC formats.
+ *
+ * Usage: etc2_bench [width height [iterations]]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "main/formats.h"
+#include "main/texcompress_etc.h"
+#include "util/macros.h"
+#include "util/os_time.h"
+
+static const mesa_format formats[] = {
+   MESA_FORMAT_ETC2_RGB8,
+   MESA_FORMAT_ETC2_RGBA8_EAC,
+   MESA_FORMAT_ETC2_R11_EAC,
+   MESA_FORMAT_ETC2_RG11_EAC,
+   MESA_FORMAT_ETC2_SIGNED_RG11_EAC,
+   MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1,
+   MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC,
+};
+
+static double
+mtexels_per_second(mesa_format format,
+                   const std::vector<uint8_t> &blocks, unsigned src_stride,
+                   std::vector<uint8_t> &texels, unsigned dst_stride,
+                   unsigned width, unsigned height, unsigned iterations)
+{
+   /* Fault in the destination first. */
+   _mesa_unpack_etc2_format(texels.data(), dst_stride, blocks.data(),
+                            src_stride, width, height, format, false);
+
+   int64_t start = os_time_get_nano();
+
+   for (unsigned i = 0; i < iterations; i++) {
+      _mesa_unpack_etc2_format(texels.data(), dst_stride, blocks.data(),
+                               src_stride, width, height, format, false);
+   }
+
+   int64_t ns = os_time_get_nano() - start;
+   return (double)width * height * iterations * 1000.0 / ns;
+}
+
+int
+main(int argc, char **argv)
+{
+   unsigned width = argc > 2 ? atoi(argv[1]) : 2048;
+   unsigned height = argc > 2 ? atoi(argv[2]) : 2048;
+   unsigned iterations = argc > 3 ? atoi(argv[3]) : 8;
+
+   if (!width || !height || !iterations) {
+      fprintf(stderr, "usage: %s [width height [iterations]]\n", argv[0]);
+      return 1;
+   }
+
+   srand(1);
+
+   for (unsigned f = 0; f < ARRAY_SIZE(formats); f++) {
+      unsigned block_size = _mesa_get_format_bytes(formats[f]);
+      unsigned blocks_x = (width + 3) / 4;
+      unsigned blocks_y = (height + 3) / 4;
+      std::vector<uint8_t> blocks(blocks_x * blocks_y * block_size);
+      std::vector<uint8_t> texels(width * height * 4);
+
+      /* Any bit pattern is a valid block. */
+      for (size_t i = 0; i < blocks.size(); i++)
+         blocks[i] = rand();
+
+      printf("%-42s %8.1f MTexel/s\n", _mesa_get_format_name(formats[f]),
+             mtexels_per_second(formats[f], blocks, blocks_x * block_size,
+                                texels, width * 4, width, height,
+                                iterations));
+   }
+
+   return 0;
+}
@@ -0,0 +1,266 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file glthread_bench.c
+ *
+ * Measures the upload throughput of glCompressedTexSubImage2D and
+ * glPixelMapfv from client memory, with glthread disabled and enabled.
+ *
+ * Small uploads are copied into the glthread batch and large ones go through
+ * the glthread upload buffer. Both the time the application thread spends in
+ * the calls and the time until glFinish returns are reported.
+ *
+ * It creates a surfaceless EGL context with whichever driver libEGL loads.
+ * "meson test --benchmark" points LD_LIBRARY_PATH and LIBGL_DRIVERS_PATH at
+ * the build tree, so that it doesn't measure the installed drivers. Each mode
+ * runs in a child process, because mesa_glthread is only read when the
+ * display is initialized.
+ *
+ * Usage: glthread_bench [iterations]
+ */
+
+#include <dlfcn.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include "util/macros.h"
+#include "util/os_time.h"
+
+#define TEX_SIZE 1024
+
+static struct {
+   PFNEGLGETPLATFORMDISPLAYEXTPROC GetPlatformDisplayEXT;
+   PFNEGLINITIALIZEPROC Initialize;
+   PFNEGLTERMINATEPROC Terminate;
+   PFNEGLBINDAPIPROC BindAPI;
+   PFNEGLCREATECONTEXTPROC CreateContext;
+   PFNEGLMAKECURRENTPROC MakeCurrent;
+   PFNEGLDESTROYCONTEXTPROC DestroyContext;
+} egl;
+
+static struct {
+   void (GLAPIENTRY *GenTextures)(GLsizei, GLuint *);
+   void (GLAPIENTRY *BindTexture)(GLenum, GLuint);
+   void (GLAPIENTRY *DeleteTextures)(GLsizei, const GLuint *);
+   PFNGLCOMPRESSEDTEXIMAGE2DPROC CompressedTexImage2D;
+   PFNGLCOMPRESSEDTEXSUBIMAGE2DPROC CompressedTexSubImage2D;
+   void (GLAPIENTRY *PixelMapfv)(GLenum, GLsizei, const GLfloat *);
+   void (GLAPIENTRY *Finish)(void);
+   GLenum (GLAPIENTRY *GetError)(void);
+} gl;
+
+static bool
+load_functions(void)
+{
+   void *lib = dlopen("libEGL.so.1", RTLD_NOW);
+   if (!lib)
+      return false;
+
+   PFNEGLGETPROCADDRESSPROC get_proc_address =
+      (PFNEGLGETPROCADDRESSPROC)dlsym(lib, "eglGetProcAddress");
+   if (!get_proc_address)
+      return false;
+
+#define GET(table, prefix, name) \
+   *(void **)&table.name = (void *)get_proc_address(prefix #name); \
+   if (!table.name) \
+      return false;
+
+   GET(egl, "egl", GetPlatformDisplayEXT);
+   GET(egl, "egl", Initialize);
+   GET(egl, "egl", Terminate);
+   GET(egl, "egl", BindAPI);
+   GET(egl, "egl", CreateContext);
+   GET(egl, "egl", MakeCurrent);
+   GET(egl, "egl", DestroyContext);
+
+   GET(gl, "gl", GenTextures);
+   GET(gl, "gl", BindTexture);
+   GET(gl, "gl", DeleteTextures);
+   GET(gl, "gl", CompressedTexImage2D);
+   GET(gl, "gl", CompressedTexSubImage2D);
+   GET(gl, "gl", PixelMapfv);
+   GET(gl, "gl", Finish);
+   GET(gl, "gl", GetError);
+#undef GET
+
+   return true;
+}
+
+static void
+bench_compressed(const char *mode, const uint8_t *data, unsigned iterations)
+{
+   /* RGTC1 is core in GL 3.0: 8 bytes per 4x4 block. */
+   const GLenum format = GL_COMPRESSED_RED_RGTC1;
+   GLuint tex;
+
+   gl.GenTextures(1, &tex);
+   gl.BindTexture(GL_TEXTURE_2D, tex);
+   gl.CompressedTexImage2D(GL_TEXTURE_2D, 0, format, TEX_SIZE, TEX_SIZE, 0,
+                           TEX_SIZE * TEX_SIZE / 2, NULL);
+   gl.Finish();
+
+   for (unsigned size = 16; size <= TEX_SIZE; size *= 4) {
+      const unsigned image_size = size * size / 2;
+      const unsigned per_row = TEX_SIZE / size;
+      /* Upload the same number of bytes for every size. */
+      const unsigned count = iterations * per_row * per_row;
+
+      int64_t start = os_time_get_nano();
+
+      for (unsigned i = 0; i < count; i++) {
+         unsigned x = (i % per_row) * size;
+         unsigned y = (i / per_row % per_row) * size;
+
+         gl.CompressedTexSubImage2D(GL_TEXTURE_2D, 0, x, y, size, size,
+                                    format, image_size,
+                                    data + (size_t)y * TEX_SIZE / 2 + x * 2);
+      }
+
+      int64_t app_ns = os_time_get_nano() - start;
+      gl.Finish();
+      int64_t total_ns = os_time_get_nano() - start;
+      double mb = (double)count * image_size / (1024 * 1024);
+
+      printf("%-8s CompressedTexSubImage2D %4ux%-4u %8.1f MB/s "
+             "(app thread %8.1f MB/s)\n", mode, size, size,
+             mb * 1e9 / total_ns, mb * 1e9 / app_ns);
+   }
+
+   gl.DeleteTextures(1, &tex);
+}
+
+static void
+bench_pixel_map(const char *mode, unsigned iterations)
+{
+   GLfloat values[256];
+   const unsigned count = iterations * 10000;
+
+   for (unsigned i = 0; i < ARRAY_SIZE(values); i++)
+      values[i] = i / 255.0f;
+
+   int64_t start = os_time_get_nano();
+
+   for (unsigned i = 0; i < count; i++)
+      gl.PixelMapfv(GL_PIXEL_MAP_R_TO_R, ARRAY_SIZE(values), values);
+
+   int64_t app_ns = os_time_get_nano() - start;
+   gl.Finish();
+   int64_t total_ns = os_time_get_nano() - start;
+
+   printf("%-8s PixelMapfv              %4u     %8.1f Kcalls/s "
+          "(app thread %8.1f Kcalls/s)\n", mode,
+          (unsigned)ARRAY_SIZE(values), count * 1e6 / total_ns,
+          count * 1e6 / app_ns);
+}
+
+static int
+run(bool glthread, unsigned iterations)
+{
+   const char *mode = glthread ? "glthread" : "direct";
+
+   setenv("mesa_glthread", glthread ? "true" : "false", 1);
+
+   if (!load_functions()) {
+      fprintf(stderr, "can't load libEGL or the GL functions\n");
+      return 77;
+   }
+
+   EGLDisplay dpy = egl.GetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA,
+                                              EGL_DEFAULT_DISPLAY, NULL);
+   if (dpy == EGL_NO_DISPLAY || !egl.Initialize(dpy, NULL, NULL) ||
+       !egl.BindAPI(EGL_OPENGL_API)) {
+      fprintf(stderr, "can't initialize a surfaceless EGL display\n");
+      return 77;
+   }
+
+   EGLContext ctx = egl.CreateContext(dpy, EGL_NO_CONFIG_KHR,
+                                      EGL_NO_CONTEXT, NULL);
+   if (ctx == EGL_NO_CONTEXT ||
+       !egl.MakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx)) {
+      fprintf(stderr, "can't create an OpenGL context\n");
+      egl.Terminate(dpy);
+      return 77;
+   }
+
+   uint8_t *data = malloc(TEX_SIZE * TEX_SIZE / 2);
+   if (!data)
+      return 1;
+
+   srand(1);
+   for (unsigned i = 0; i < TEX_SIZE * TEX_SIZE / 2; i++)
+      data[i] = rand();
+
+   bench_compressed(mode, data, iterations);
+   bench_pixel_map(mode, iterations);
+
+   GLenum error = gl.GetError();
+   if (error != GL_NO_ERROR)
+      fprintf(stderr, "%s: GL error 0x%x\n", mode, error);
+
+   free(data);
+   egl.MakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+   egl.DestroyContext(dpy, ctx);
+   egl.Terminate(dpy);
+   return error != GL_NO_ERROR;
+}
+
+int
+main(int argc, char **argv)
+{
+   unsigned iterations = argc > 1 ? atoi(argv[1]) : 16;
+   int result = 0;
+
+   if (!iterations) {
+      fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+      return 1;
+   }
+
+   for (unsigned glthread = 0; glthread < 2; glthread++) {
+      fflush(stdout);
+
+      pid_t pid = fork();
+      if (pid < 0)
+         return 1;
+      if (pid == 0)
+         return run(glthread, iterations);
+
+      int status;
+      if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status))
+         return 1;
+      if (WEXITSTATUS(status))
+         result = WEXITSTATUS(status);
+   }
+
+   return result;
+}
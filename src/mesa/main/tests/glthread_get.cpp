@@ -0,0 +1,254 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "GL/gl.h"
+#include "GL/glext.h"
+#include "main/api_exec.h"
+#include "main/context.h"
+#include "main/errors.h"
+#include "main/glthread.h"
+#include "main/texobj.h"
+#include "main/vtxfmt.h"
+#include "glapi/glapi.h"
+#include "drivers/common/driverfuncs.h"
+
+#include "vbo/vbo.h"
+
+extern "C" {
+#include "main/marshal_generated.h"
+}
+
+class glthread_get_test : public ::testing::Test {
+public:
+   virtual void SetUp();
+   virtual void TearDown();
+   void SetUpCtx(gl_api api, unsigned int version);
+   GLenum get_error();
+
+   struct gl_config visual;
+   struct dd_function_table driver_functions;
+   struct gl_context ctx;
+};
+
+void
+glthread_get_test::SetUp()
+{
+   memset(&visual, 0, sizeof(visual));
+   memset(&driver_functions, 0, sizeof(driver_functions));
+   memset(&ctx, 0, sizeof(ctx));
+
+   _mesa_init_driver_functions(&driver_functions);
+}
+
+void
+glthread_get_test::TearDown()
+{
+   _glapi_set_context(NULL);
+}
+
+/* The worker thread isn't started, so syncs call the context directly. */
+void
+glthread_get_test::SetUpCtx(gl_api api, unsigned int version)
+{
+   _mesa_initialize_context(&ctx,
+                            api,
+                            &visual,
+                            NULL, // share_list
+                            &driver_functions);
+   _vbo_CreateContext(&ctx, false);
+
+   _mesa_override_extensions(&ctx);
+   ctx.Version = version;
+   ctx.Extensions.Version = version;
+
+   _mesa_initialize_dispatch_tables(&ctx);
+   _mesa_initialize_vbo_vtxfmt(&ctx);
+
+   _glapi_set_context(&ctx);
+   _glapi_set_dispatch(ctx.Exec);
+
+   ctx.GLThread.CurrentVAO = &ctx.GLThread.DefaultVAO;
+   _mesa_glthread_reload_state(&ctx);
+}
+
+GLenum
+glthread_get_test::get_error()
+{
+   GLenum error = ctx.ErrorValue;
+
+   ctx.ErrorValue = GL_NO_ERROR;
+   return error;
+}
+
+/* Queries of shadowed state are answered without calling the context. */
+TEST_F(glthread_get_test, answers_shadowed_state)
+{
+   GLint box[4];
+
+   SetUpCtx(API_OPENGL_COMPAT, 21);
+
+   _mesa_glthread_Scissor(&ctx, 1, 2, 3, 4);
+   EXPECT_EQ(0, ctx.Scissor.ScissorArray[0].X);
+
+   _mesa_marshal_GetIntegerv(GL_SCISSOR_BOX, box);
+   EXPECT_EQ(1, box[0]);
+   EXPECT_EQ(2, box[1]);
+   EXPECT_EQ(3, box[2]);
+   EXPECT_EQ(4, box[3]);
+   EXPECT_EQ(GL_NO_ERROR, get_error());
+
+   /* Negative sizes fail and don't change the state. */
+   _mesa_glthread_Scissor(&ctx, 5, 6, -1, 8);
+   _mesa_marshal_GetIntegerv(GL_SCISSOR_BOX, box);
+   EXPECT_EQ(1, box[0]);
+}
+
+/* Parameters that aren't in the API are left to glGet*, which fails. */
+TEST_F(glthread_get_test, api_checks)
+{
+   GLint value = -1;
+
+   SetUpCtx(API_OPENGLES2, 20);
+
+   _mesa_glthread_BindFramebuffer(&ctx, GL_READ_FRAMEBUFFER, 5);
+   ASSERT_TRUE(ctx.GLThread.StateValid);
+
+   _mesa_marshal_GetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &value);
+   EXPECT_EQ(GL_INVALID_ENUM, get_error());
+   EXPECT_EQ(-1, value);
+
+   _mesa_marshal_GetIntegerv(GL_TEXTURE_BINDING_1D, &value);
+   EXPECT_EQ(GL_INVALID_ENUM, get_error());
+   EXPECT_EQ(-1, value);
+
+   _mesa_marshal_GetIntegerv(GL_CURRENT_PROGRAM, &value);
+   EXPECT_EQ(GL_NO_ERROR, get_error());
+   EXPECT_EQ(0, value);
+}
+
+TEST_F(glthread_get_test, vertex_array_binding_needs_extension)
+{
+   GLint value = -1;
+
+   SetUpCtx(API_OPENGLES2, 20);
+
+   _mesa_marshal_GetIntegerv(GL_VERTEX_ARRAY_BINDING, &value);
+   EXPECT_EQ(GL_NO_ERROR, get_error());
+   EXPECT_EQ(0, value);
+
+   /* OES_vertex_array_object is always supported, so hide it along with
+    * the other extensions that are.
+    */
+   ctx.Extensions.dummy_true = false;
+   value = -1;
+
+   _mesa_marshal_GetIntegerv(GL_VERTEX_ARRAY_BINDING, &value);
+   EXPECT_EQ(GL_INVALID_ENUM, get_error());
+   EXPECT_EQ(-1, value);
+}
+
+TEST_F(glthread_get_test, vertex_array_binding_not_tracked_in_core)
+{
+   GLint value = -1;
+
+   SetUpCtx(API_OPENGL_CORE, 31);
+
+   /* glthread doesn't track the VAO in core contexts, so this shows whether
+    * the query went to the context.
+    */
+   ctx.GLThread.DefaultVAO.Name = 1;
+
+   _mesa_marshal_GetIntegerv(GL_VERTEX_ARRAY_BINDING, &value);
+   EXPECT_EQ(GL_NO_ERROR, get_error());
+   EXPECT_EQ(0, value);
+}
+
+TEST_F(glthread_get_test, texture_bindings)
+{
+   GLint value = -1;
+
+   SetUpCtx(API_OPENGL_COMPAT, 21);
+
+   _mesa_BindTexture(GL_TEXTURE_2D, 7);
+   _mesa_glthread_reload_state(&ctx);
+
+   _mesa_marshal_GetIntegerv(GL_TEXTURE_BINDING_2D, &value);
+   EXPECT_EQ(7, value);
+
+   /* Binding 0 and textures of the same target can't fail. */
+   _mesa_glthread_BindTexture(&ctx, GL_TEXTURE_2D, 0);
+   EXPECT_TRUE(ctx.GLThread.StateValid);
+   _mesa_marshal_GetIntegerv(GL_TEXTURE_BINDING_2D, &value);
+   EXPECT_EQ(0, value);
+
+   _mesa_glthread_BindTexture(&ctx, GL_TEXTURE_2D, 7);
+   EXPECT_TRUE(ctx.GLThread.StateValid);
+   _mesa_marshal_GetIntegerv(GL_TEXTURE_BINDING_2D, &value);
+   EXPECT_EQ(7, value);
+
+   /* The binding is per unit. */
+   _mesa_glthread_ActiveTexture(&ctx, GL_TEXTURE1);
+   _mesa_marshal_GetIntegerv(GL_TEXTURE_BINDING_2D, &value);
+   EXPECT_EQ(0, value);
+   _mesa_glthread_ActiveTexture(&ctx, GL_TEXTURE0);
+
+   /* A texture of another target fails, and so may a new name. */
+   _mesa_glthread_BindTexture(&ctx, GL_TEXTURE_3D, 7);
+   EXPECT_FALSE(ctx.GLThread.StateValid);
+
+   _mesa_glthread_reload_state(&ctx);
+   _mesa_glthread_BindTexture(&ctx, GL_TEXTURE_2D, 8);
+   EXPECT_FALSE(ctx.GLThread.StateValid);
+}
+
+TEST_F(glthread_get_test, framebuffer_names_in_core)
+{
+   SetUpCtx(API_OPENGL_CORE, 31);
+
+   /* Binding a name that wasn't generated fails in core contexts. */
+   _mesa_glthread_BindFramebuffer(&ctx, GL_FRAMEBUFFER, 3);
+   EXPECT_FALSE(ctx.GLThread.StateValid);
+
+   _mesa_glthread_reload_state(&ctx);
+   _mesa_glthread_BindFramebuffer(&ctx, GL_FRAMEBUFFER, 0);
+   EXPECT_TRUE(ctx.GLThread.StateValid);
+}
+
+TEST_F(glthread_get_test, get_error)
+{
+   SetUpCtx(API_OPENGL_COMPAT, 21);
+
+   _mesa_error(&ctx, GL_INVALID_VALUE, "test");
+   EXPECT_EQ((GLenum)GL_INVALID_VALUE, _mesa_marshal_GetError());
+   EXPECT_EQ((GLenum)GL_NO_ERROR, _mesa_marshal_GetError());
+
+   /* With KHR_no_error, only GL_OUT_OF_MEMORY is reported. */
+   ctx.Const.ContextFlags |= GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR;
+   EXPECT_EQ((GLenum)GL_NO_ERROR, _mesa_marshal_GetError());
+
+   _mesa_error(&ctx, GL_OUT_OF_MEMORY, "test");
+   EXPECT_EQ((GLenum)GL_OUT_OF_MEMORY, _mesa_marshal_GetError());
+   EXPECT_EQ((GLenum)GL_NO_ERROR, _mesa_marshal_GetError());
+}
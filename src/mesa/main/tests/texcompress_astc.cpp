@@ -0,0 +1,190 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file texcompress_astc.cpp
+ *
+ * Checks _mesa_unpack_astc_2d_ldr() against checksums of known good output,
+ * for every 2D ASTC format.  The checksums were taken from the
+ * block-by-block decoder that the UNORM8 path replaced, so they hold for
+ * both the SSE4.1 and the plain C path.
+ */
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <vector>
+
+#include "main/formats.h"
+#include "main/texcompress_astc.h"
+#include "util/crc32.h"
+#include "util/macros.h"
+
+namespace {
+
+struct golden {
+   mesa_format format;
+   uint32_t npot;               /* 203x157 */
+   uint32_t smaller_than_block; /* 3x2 */
+};
+
+const golden astc_golden[] = {
+   { MESA_FORMAT_RGBA_ASTC_4x4,              0x7d5301fb, 0xf0ce015a },
+   { MESA_FORMAT_RGBA_ASTC_5x4,              0x571ef7c3, 0x9509c079 },
+   { MESA_FORMAT_RGBA_ASTC_5x5,              0xe8bf9c02, 0x9509c079 },
+   { MESA_FORMAT_RGBA_ASTC_6x5,              0x698156d5, 0x7905ce40 },
+   { MESA_FORMAT_RGBA_ASTC_6x6,              0xb63a6cab, 0x7905ce40 },
+   { MESA_FORMAT_RGBA_ASTC_8x5,              0xc9b304e3, 0x6fc75607 },
+   { MESA_FORMAT_RGBA_ASTC_8x6,              0x3bae12e1, 0x6fc75607 },
+   { MESA_FORMAT_RGBA_ASTC_8x8,              0x0a850f14, 0x6fc75607 },
+   { MESA_FORMAT_RGBA_ASTC_10x5,             0x5a68ec62, 0x63666951 },
+   { MESA_FORMAT_RGBA_ASTC_10x6,             0xa5946209, 0x5a04fb34 },
+   { MESA_FORMAT_RGBA_ASTC_10x8,             0xf8ed25a4, 0x38482716 },
+   { MESA_FORMAT_RGBA_ASTC_10x10,            0x2d4110a2, 0x38482716 },
+   { MESA_FORMAT_RGBA_ASTC_12x10,            0x5eb009f4, 0x9f8291d3 },
+   { MESA_FORMAT_RGBA_ASTC_12x12,            0x58ca12ba, 0x5ca1690f },
+   { MESA_FORMAT_SRGB8_ALPHA8_ASTC_4x4,      0x6ba7a19c, 0xf0ce015a },
+   { MESA_FORMAT_SRGB8_ALPHA8_ASTC_5x4,      0x526d103b, 0x590b8a0e },
+   { MESA_FORMAT_SRGB8_ALPHA8_ASTC_5x5,      0x5e8e3b48, 0x590b8a0e },
+   { MESA_FORMAT_SRGB8_ALPHA8_ASTC_6x5,      0x7e101fa2, 0x7905ce40 },
+   { MESA_FORMAT_SRGB8_ALPHA8_ASTC_6x6,      0x2bd2c0eb, 0x7905ce40 },
+   { MESA_FORMAT_SRGB8_ALPHA8_ASTC_8x5,      0x0dcadc09, 0x6fc75607 },
+   { MESA_FORMAT_SRGB8_ALPHA8_ASTC_8x6,      0xa26ca9bf, 0x6fc75607 },
+   { MESA_FORMAT_SRGB8_ALPHA8_ASTC_8x8,      0x0b6a73a7, 0x6fc75607 },
+   { MESA_FORMAT_SRGB8_ALPHA8_ASTC_10x5,     0xfb42c2e2, 0x082f284a },
+   { MESA_FORMAT_SRGB8_ALPHA8_ASTC_10x6,     0xf9c61065, 0x5a04fb34 },
+   { MESA_FORMAT_SRGB8_ALPHA8_ASTC_10x8,     0xef2c60d4, 0x38482716 },
+   { MESA_FORMAT_SRGB8_ALPHA8_ASTC_10x10,    0x33b27d7f, 0x38482716 },
+   { MESA_FORMAT_SRGB8_ALPHA8_ASTC_12x10,    0x88a9deef, 0xd26a91b4 },
+   { MESA_FORMAT_SRGB8_ALPHA8_ASTC_12x12,    0x77d020c6, 0x11496968 },
+};
+
+/* xorshift32, rather than rand(), so that the blocks and with them the
+ * checksums are the same with every C library.
+ */
+uint8_t
+next_byte(uint32_t *state)
+{
+   uint32_t x = *state;
+   x ^= x << 13;
+   x ^= x >> 17;
+   x ^= x << 5;
+   *state = x;
+   return x >> 24;
+}
+
+/* Most random bit patterns are illegal blocks, which decode to the error
+ * colour.  Keep drawing until a block decodes to something else, so that
+ * partitions, dual planes and the weight grids are all exercised.  Every
+ * 7th block is a void-extent block.
+ */
+std::vector<uint8_t>
+make_blocks(mesa_format format, unsigned num_blocks, uint32_t seed)
+{
+   unsigned bw, bh, bd;
+   _mesa_get_format_block_size_3d(format, &bw, &bh, &bd);
+
+   std::vector<uint8_t> blocks(num_blocks * 16);
+   std::vector<uint8_t> texels(bw * bh * 4);
+
+   for (unsigned b = 0; b < num_blocks; b++) {
+      uint8_t *block = &blocks[b * 16];
+
+      for (unsigned tries = 0; tries < 1000; tries++) {
+         for (unsigned i = 0; i < 16; i++)
+            block[i] = next_byte(&seed);
+
+         if (b % 7 == 6) {
+            block[0] = 0xfc;
+            block[1] = 0xfd;
+         }
+
+         _mesa_unpack_astc_2d_ldr(texels.data(), bw * 4, block, 16,
+                                  bw, bh, format);
+
+         bool error = true;
+         for (unsigned i = 0; i < bw * bh && error; i++) {
+            error = texels[i * 4 + 0] == 0xff && texels[i * 4 + 1] == 0 &&
+                    texels[i * 4 + 2] == 0xff && texels[i * 4 + 3] == 0xff;
+         }
+         if (!error)
+            break;
+      }
+   }
+
+   return blocks;
+}
+
+void
+check_format(mesa_format format, unsigned width, unsigned height,
+             uint32_t seed, uint32_t expected)
+{
+   unsigned bw, bh, bd;
+   _mesa_get_format_block_size_3d(format, &bw, &bh, &bd);
+
+   unsigned blocks_x = (width + bw - 1) / bw;
+   unsigned blocks_y = (height + bh - 1) / bh;
+   std::vector<uint8_t> blocks = make_blocks(format, blocks_x * blocks_y,
+                                             seed);
+
+   /* Pad the rows, so that writing past the width would show. */
+   unsigned stride = width * 4 + 12;
+   std::vector<uint8_t> texels(stride * height, 0x55);
+
+   _mesa_unpack_astc_2d_ldr(texels.data(), stride, blocks.data(),
+                            blocks_x * 16, width, height, format);
+
+   for (unsigned y = 0; y < height; y++) {
+      for (unsigned x = width * 4; x < stride; x++) {
+         ASSERT_EQ(texels[y * stride + x], 0x55)
+            << _mesa_get_format_name(format) << " " << width << "x" << height
+            << ": wrote byte " << x << " of row " << y;
+      }
+   }
+
+   EXPECT_EQ(util_hash_crc32(texels.data(), texels.size()), expected)
+      << _mesa_get_format_name(format) << " " << width << "x" << height;
+}
+
+} /* namespace */
+
+TEST(texcompress_astc, npot)
+{
+   for (unsigned i = 0; i < ARRAY_SIZE(astc_golden); i++)
+      check_format(astc_golden[i].format, 203, 157, 1, astc_golden[i].npot);
+}
+
+TEST(texcompress_astc, smaller_than_block)
+{
+   for (unsigned i = 0; i < ARRAY_SIZE(astc_golden); i++) {
+      check_format(astc_golden[i].format, 3, 2, 2,
+                   astc_golden[i].smaller_than_block);
+   }
+}
+
+/* Large enough to be split up between threads. */
+TEST(texcompress_astc, large)
+{
+   check_format(MESA_FORMAT_RGBA_ASTC_4x4, 509, 512, 3, 0x3c1502e7);
+   check_format(MESA_FORMAT_SRGB8_ALPHA8_ASTC_6x6, 600, 511, 3, 0x5788a3c9);
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file texcompress_bench.cpp
+ *
+ * Measures how many texels per second the S3TC and BPTC encoders compress,
+ * with each MESA_TEXCOMPRESS_QUALITY preset, and the PSNR of the result.
+ *
+ * The source image is made up of smooth gradients with some noise, which is
+ * roughly what rendered or generated textures look like.
+ *
+ * Usage: texcompress_bench [width height [iterations]]
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "util/format/u_format_bptc.h"
+#include "util/format/u_format_compress.h"
+#include "util/format/u_format_s3tc.h"
+#include "util/macros.h"
+#include "util/os_time.h"
+
+typedef void (*pack_func)(uint8_t *dst_row, unsigned dst_stride,
+                          const uint8_t *src_row, unsigned src_stride,
+                          unsigned width, unsigned height);
+typedef void (*unpack_func)(uint8_t *dst_row, unsigned dst_stride,
+                            const uint8_t *src_row, unsigned src_stride,
+                            unsigned width, unsigned height);
+
+struct format_info {
+   const char *name;
+   pack_func pack;
+   unpack_func unpack;
+   unsigned block_bytes;
+   unsigned channels;
+   bool has_presets;
+};
+
+static const format_info formats[] = {
+   { "DXT1 RGB", util_format_dxt1_rgb_pack_rgba_8unorm,
+     util_format_dxt1_rgb_unpack_rgba_8unorm, 8, 3, true },
+   { "DXT1 RGBA", util_format_dxt1_rgba_pack_rgba_8unorm,
+     util_format_dxt1_rgba_unpack_rgba_8unorm, 8, 4, true },
+   { "DXT3 RGBA", util_format_dxt3_rgba_pack_rgba_8unorm,
+     util_format_dxt3_rgba_unpack_rgba_8unorm, 16, 4, true },
+   { "DXT5 RGBA", util_format_dxt5_rgba_pack_rgba_8unorm,
+     util_format_dxt5_rgba_unpack_rgba_8unorm, 16, 4, true },
+   /* The BPTC encoder has a single, already fast, endpoint search. */
+   { "BPTC RGBA UNORM", util_format_bptc_rgba_unorm_pack_rgba_8unorm,
+     util_format_bptc_rgba_unorm_unpack_rgba_8unorm, 16, 4, false },
+};
+
+static std::vector<uint8_t>
+make_image(unsigned width, unsigned height)
+{
+   std::vector<uint8_t> texels(width * height * 4);
+
+   for (unsigned y = 0; y < height; y++) {
+      for (unsigned x = 0; x < width; x++) {
+         uint8_t *texel = &texels[(y * width + x) * 4];
+         float fx = (float)x / width, fy = (float)y / height;
+
+         texel[0] = CLAMP(128 + 100 * sinf(fx * 17 + fy * 5) +
+                          rand() % 16 - 8, 0, 255);
+         texel[1] = CLAMP(255 * fx * fy + rand() % 8 - 4, 0, 255);
+         texel[2] = CLAMP(128 + 120 * cosf(fy * 23 - fx * 3), 0, 255);
+         /* Mostly opaque, with some soft and some hard edges. */
+         texel[3] = ((x / 64 + y / 64) % 4 == 0) ? 0 :
+                    CLAMP(255 * (1.5f - fy), 0, 255);
+      }
+   }
+
+   return texels;
+}
+
+static double
+psnr(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b,
+     unsigned channels)
+{
+   double sum = 0;
+
+   size_t count = 0;
+
+   for (size_t i = 0; i < a.size(); i += 4) {
+      for (unsigned c = 0; c < channels; c++) {
+         /* The colour of transparent texels doesn't matter. */
+         if (c < 3 && channels == 4 && a[i + 3] == 0)
+            continue;
+
+         double diff = (double)a[i + c] - b[i + c];
+         sum += diff * diff;
+         count++;
+      }
+   }
+
+   double mse = sum / count;
+   return mse > 0 ? 10 * log10(255.0 * 255.0 / mse) : INFINITY;
+}
+
+int
+main(int argc, char **argv)
+{
+   unsigned width = argc > 2 ? atoi(argv[1]) : 2048;
+   unsigned height = argc > 2 ? atoi(argv[2]) : 2048;
+   unsigned iterations = argc > 3 ? atoi(argv[3]) : 4;
+
+   /* The S3TC encoders read whole blocks. */
+   if (!width || !height || !iterations || width % 4 || height % 4) {
+      fprintf(stderr, "usage: %s [width height [iterations]]\n"
+              "width and height must be multiples of 4\n", argv[0]);
+      return 1;
+   }
+
+   static const struct {
+      const char *name;
+      enum util_format_compress_quality quality;
+   } presets[] = {
+      { "default", UTIL_FORMAT_COMPRESS_QUALITY_DEFAULT },
+      { "fast", UTIL_FORMAT_COMPRESS_QUALITY_FAST },
+   };
+
+   srand(1);
+   std::vector<uint8_t> image = make_image(width, height);
+   std::vector<uint8_t> decoded(image.size());
+
+   for (unsigned f = 0; f < ARRAY_SIZE(formats); f++) {
+      const format_info *format = &formats[f];
+      unsigned stride = width / 4 * format->block_bytes;
+      std::vector<uint8_t> blocks(stride * (height / 4));
+
+      for (unsigned p = 0; p < ARRAY_SIZE(presets); p++) {
+         if (p > 0 && !format->has_presets)
+            break;
+
+         util_format_set_compress_quality(presets[p].quality);
+
+         /* Fault in the destination first. */
+         format->pack(blocks.data(), stride, image.data(), width * 4,
+                      width, height);
+
+         int64_t start = os_time_get_nano();
+
+         for (unsigned i = 0; i < iterations; i++) {
+            format->pack(blocks.data(), stride, image.data(), width * 4,
+                         width, height);
+         }
+
+         int64_t ns = os_time_get_nano() - start;
+
+         format->unpack(decoded.data(), width * 4, blocks.data(), stride,
+                        width, height);
+
+         printf("%-16s %-8s %8.2f MTexel/s  PSNR %6.2f dB\n",
+                format->name, format->has_presets ? presets[p].name : "-",
+                (double)width * height * iterations * 1000.0 / ns,
+                psnr(image, decoded, format->channels));
+      }
+   }
+
+   return 0;
+}
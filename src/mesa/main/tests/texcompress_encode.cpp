@@ -0,0 +1,192 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file texcompress_encode.cpp
+ *
+ * Checks the S3TC and BPTC encoders: large images, which are encoded by
+ * several threads, must give the same blocks as encoding the image a few
+ * block rows at a time, and the fast quality preset must not be much worse
+ * than the default one.
+ */
+
+#include <gtest/gtest.h>
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "util/format/u_format_bptc.h"
+#include "util/format/u_format_compress.h"
+#include "util/format/u_format_s3tc.h"
+#include "util/macros.h"
+
+namespace {
+
+typedef void (*pack_func)(uint8_t *dst_row, unsigned dst_stride,
+                          const uint8_t *src_row, unsigned src_stride,
+                          unsigned width, unsigned height);
+typedef void (*unpack_func)(uint8_t *dst_row, unsigned dst_stride,
+                            const uint8_t *src_row, unsigned src_stride,
+                            unsigned width, unsigned height);
+
+struct format_info {
+   const char *name;
+   pack_func pack;
+   unpack_func unpack;
+   unsigned block_bytes;
+   /* DXT1 alpha is only one bit, so it isn't compared. */
+   unsigned channels;
+};
+
+const format_info formats[] = {
+   { "DXT1 RGB", util_format_dxt1_rgb_pack_rgba_8unorm,
+     util_format_dxt1_rgb_unpack_rgba_8unorm, 8, 3 },
+   { "DXT1 RGBA", util_format_dxt1_rgba_pack_rgba_8unorm,
+     util_format_dxt1_rgba_unpack_rgba_8unorm, 8, 3 },
+   { "DXT3 RGBA", util_format_dxt3_rgba_pack_rgba_8unorm,
+     util_format_dxt3_rgba_unpack_rgba_8unorm, 16, 4 },
+   { "DXT5 RGBA", util_format_dxt5_rgba_pack_rgba_8unorm,
+     util_format_dxt5_rgba_unpack_rgba_8unorm, 16, 4 },
+   { "BPTC RGBA UNORM", util_format_bptc_rgba_unorm_pack_rgba_8unorm,
+     util_format_bptc_rgba_unorm_unpack_rgba_8unorm, 16, 4 },
+};
+
+const enum util_format_compress_quality qualities[] = {
+   UTIL_FORMAT_COMPRESS_QUALITY_DEFAULT,
+   UTIL_FORMAT_COMPRESS_QUALITY_FAST,
+};
+
+/* Smooth gradients with a little noise, and some transparent squares. */
+std::vector<uint8_t>
+make_image(unsigned width, unsigned height)
+{
+   std::vector<uint8_t> texels(width * height * 4);
+
+   for (unsigned y = 0; y < height; y++) {
+      for (unsigned x = 0; x < width; x++) {
+         uint8_t *texel = &texels[(y * width + x) * 4];
+
+         texel[0] = CLAMP(x * 255 / width + rand() % 9 - 4, 0, 255);
+         texel[1] = CLAMP(y * 255 / height + rand() % 9 - 4, 0, 255);
+         texel[2] = (x + y) * 127 / (width + height) + rand() % 4;
+         texel[3] = (x / 32 + y / 32) % 5 == 0 ? 0 : 255 - y * 128 / height;
+      }
+   }
+
+   return texels;
+}
+
+double
+psnr(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b,
+     unsigned channels)
+{
+   double sum = 0;
+   size_t count = 0;
+
+   for (size_t i = 0; i < a.size(); i += 4) {
+      for (unsigned c = 0; c < channels; c++) {
+         /* The colour of transparent texels doesn't matter. */
+         if (c < 3 && a[i + 3] == 0)
+            continue;
+
+         double diff = (double)a[i + c] - b[i + c];
+         sum += diff * diff;
+         count++;
+      }
+   }
+
+   return 10 * log10(255.0 * 255.0 * count / MAX2(sum, 1.0));
+}
+
+} /* namespace */
+
+TEST(texcompress_encode, threads_match_bands)
+{
+   const unsigned width = 1024, height = 512;
+   const unsigned band_height = 8;
+
+   srand(1);
+   std::vector<uint8_t> image = make_image(width, height);
+
+   for (unsigned q = 0; q < ARRAY_SIZE(qualities); q++) {
+      util_format_set_compress_quality(qualities[q]);
+
+      for (unsigned f = 0; f < ARRAY_SIZE(formats); f++) {
+         const format_info *format = &formats[f];
+         unsigned stride = width / 4 * format->block_bytes;
+         /* Single-alpha DXT5 blocks leave their second byte alone. */
+         std::vector<uint8_t> whole(stride * height / 4);
+         std::vector<uint8_t> bands(stride * height / 4);
+
+         format->pack(whole.data(), stride, image.data(), width * 4,
+                      width, height);
+
+         /* Too few blocks at a time to be split up between threads. */
+         for (unsigned y = 0; y < height; y += band_height) {
+            format->pack(&bands[y / 4 * stride], stride,
+                         &image[y * width * 4], width * 4,
+                         width, band_height);
+         }
+
+         ASSERT_TRUE(whole == bands) << format->name << " quality " << q;
+      }
+   }
+
+   util_format_set_compress_quality(UTIL_FORMAT_COMPRESS_QUALITY_DEFAULT);
+}
+
+TEST(texcompress_encode, fast_quality)
+{
+   const unsigned width = 256, height = 256;
+
+   srand(2);
+   std::vector<uint8_t> image = make_image(width, height);
+   std::vector<uint8_t> decoded(image.size());
+
+   for (unsigned f = 0; f < ARRAY_SIZE(formats); f++) {
+      const format_info *format = &formats[f];
+      unsigned stride = width / 4 * format->block_bytes;
+      std::vector<uint8_t> blocks(stride * height / 4);
+      double quality[ARRAY_SIZE(qualities)];
+
+      for (unsigned q = 0; q < ARRAY_SIZE(qualities); q++) {
+         util_format_set_compress_quality(qualities[q]);
+         format->pack(blocks.data(), stride, image.data(), width * 4,
+                      width, height);
+         format->unpack(decoded.data(), width * 4, blocks.data(), stride,
+                        width, height);
+         quality[q] = psnr(image, decoded, format->channels);
+      }
+
+      /* This also catches decoders that don't match the encoders. */
+      EXPECT_GT(quality[0], 30.0)
+         << format->name << ": " << quality[0] << " dB";
+      EXPECT_GT(quality[1], quality[0] - 1.0)
+         << format->name << ": " << quality[1] << " dB, default preset "
+         << quality[0] << " dB";
+   }
+
+   util_format_set_compress_quality(UTIL_FORMAT_COMPRESS_QUALITY_DEFAULT);
+}
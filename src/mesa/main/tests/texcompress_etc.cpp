@@ -0,0 +1,169 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file texcompress_etc.cpp
+ *
+ * Checks _mesa_unpack_etc2_format() against checksums of known good output,
+ * for every ETC2 and EAC format.  The checksums were taken from the texel
+ * by texel decoder that the block decoder replaced, so they hold for both
+ * the SSE4.1 and the plain C path.
+ */
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <vector>
+
+#include "main/formats.h"
+#include "main/texcompress_etc.h"
+#include "util/crc32.h"
+#include "util/macros.h"
+
+namespace {
+
+struct golden {
+   mesa_format format;
+   uint32_t npot;      /* 203x157 */
+   uint32_t npot_bgra; /* 203x157, with bgra set, which only the sRGB
+                        * formats look at */
+   uint32_t small;     /* 3x2 */
+   uint32_t tiny;      /* 1x1 */
+   uint32_t large;     /* 509x511 */
+};
+
+const golden etc2_golden[] = {
+   { MESA_FORMAT_ETC2_RGB8,
+     0x595f199d, 0x595f199d, 0x0b025ca4, 0xb256eff8, 0x709bf0bf },
+   { MESA_FORMAT_ETC2_SRGB8,
+     0x595f199d, 0x3b32263d, 0x0b025ca4, 0xb256eff8, 0x709bf0bf },
+   { MESA_FORMAT_ETC2_RGBA8_EAC,
+     0x4447127e, 0x4447127e, 0x1d216646, 0xe2278698, 0xc74b4fdc },
+   { MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC,
+     0x4447127e, 0x043a6274, 0x1d216646, 0xe2278698, 0xc74b4fdc },
+   { MESA_FORMAT_ETC2_R11_EAC,
+     0xf67fb6d3, 0xf67fb6d3, 0x3eb63a5a, 0x6e7f6e9b, 0x328a356e },
+   { MESA_FORMAT_ETC2_RG11_EAC,
+     0x50b1fd37, 0x50b1fd37, 0xfe801473, 0x7ade7705, 0xf9d50aa8 },
+   { MESA_FORMAT_ETC2_SIGNED_R11_EAC,
+     0x8752de60, 0x8752de60, 0x95661ccd, 0x122815cc, 0x66e0bf2f },
+   { MESA_FORMAT_ETC2_SIGNED_RG11_EAC,
+     0x1f9b1bee, 0x1f9b1bee, 0x6f4f1765, 0xe17516ba, 0xdb88e598 },
+   { MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1,
+     0x10119b76, 0x10119b76, 0x0b025ca4, 0xb256eff8, 0xeae8e076 },
+   { MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1,
+     0x10119b76, 0x5fb823ba, 0x0b025ca4, 0xb256eff8, 0xeae8e076 },
+};
+
+unsigned
+texel_size(mesa_format format)
+{
+   switch (format) {
+   case MESA_FORMAT_ETC2_R11_EAC:
+   case MESA_FORMAT_ETC2_SIGNED_R11_EAC:
+      return 2;
+   default:
+      return 4;
+   }
+}
+
+/* xorshift32, rather than rand(), so that the blocks and with them the
+ * checksums are the same with every C library.
+ */
+uint8_t
+next_byte(uint32_t *state)
+{
+   uint32_t x = *state;
+   x ^= x << 13;
+   x ^= x >> 17;
+   x ^= x << 5;
+   *state = x;
+   return x >> 24;
+}
+
+/* Every bit pattern is a valid ETC2 or EAC block, so random blocks cover
+ * all of the modes: individual, differential, T, H and planar.
+ */
+void
+check_format(mesa_format format, bool bgra, unsigned width, unsigned height,
+             uint32_t seed, uint32_t expected)
+{
+   unsigned block_size = _mesa_get_format_bytes(format);
+   unsigned blocks_x = (width + 3) / 4;
+   unsigned blocks_y = (height + 3) / 4;
+   std::vector<uint8_t> blocks(blocks_x * blocks_y * block_size);
+
+   for (size_t i = 0; i < blocks.size(); i++)
+      blocks[i] = next_byte(&seed);
+
+   /* Pad the rows, so that writing past the width would show. */
+   unsigned row_size = width * texel_size(format);
+   unsigned stride = row_size + 12;
+   std::vector<uint8_t> texels(stride * height, 0x55);
+
+   _mesa_unpack_etc2_format(texels.data(), stride, blocks.data(),
+                            blocks_x * block_size, width, height,
+                            format, bgra);
+
+   for (unsigned y = 0; y < height; y++) {
+      for (unsigned x = row_size; x < stride; x++) {
+         ASSERT_EQ(texels[y * stride + x], 0x55)
+            << _mesa_get_format_name(format) << (bgra ? " (BGRA) " : " ")
+            << width << "x" << height << ": wrote byte " << x
+            << " of row " << y;
+      }
+   }
+
+   EXPECT_EQ(util_hash_crc32(texels.data(), texels.size()), expected)
+      << _mesa_get_format_name(format) << (bgra ? " (BGRA) " : " ")
+      << width << "x" << height;
+}
+
+} /* namespace */
+
+TEST(texcompress_etc, npot)
+{
+   for (unsigned i = 0; i < ARRAY_SIZE(etc2_golden); i++) {
+      const golden *g = &etc2_golden[i];
+      check_format(g->format, false, 203, 157, 1, g->npot);
+      check_format(g->format, true, 203, 157, 1, g->npot_bgra);
+   }
+}
+
+TEST(texcompress_etc, smaller_than_block)
+{
+   for (unsigned i = 0; i < ARRAY_SIZE(etc2_golden); i++) {
+      const golden *g = &etc2_golden[i];
+      check_format(g->format, false, 3, 2, 2, g->small);
+      check_format(g->format, false, 1, 1, 2, g->tiny);
+   }
+}
+
+/* Large enough to be split up between threads. */
+TEST(texcompress_etc, large)
+{
+   for (unsigned i = 0; i < ARRAY_SIZE(etc2_golden); i++) {
+      const golden *g = &etc2_golden[i];
+      check_format(g->format, false, 509, 511, 3, g->large);
+   }
+}
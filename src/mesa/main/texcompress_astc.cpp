@@ -34,8 +34,12 @@
  */
 
 #include "texcompress_astc.h"
+#include "texcompress_astc_sse41.h"
 #include "macros.h"
+#include "util/format/u_format_compress.h"
 #include "util/half_float.h"
+#include "util/u_cpu_detect.h"
+#include "c11/threads.h"
 #include <stdio.h>
 #include <cstdlib>  // for abort() on windows
 
@@ -48,6 +52,12 @@ uint16_div_64k_to_half_to_unorm8(uint16_t v)
    return _mesa_half_to_unorm8(_mesa_uint16_div_64k_to_half(v));
 }
 
+/* uint16_div_64k_to_half_to_unorm8() of every interpolated UNORM16 value,
+ * except that 65535 is exactly 0xff.
+ */
+static uint8_t unorm8_table[65536];
+static once_flag decoder_once = ONCE_FLAG_INIT;
+
 class decode_error
 {
 public:
@@ -276,43 +286,22 @@ static uint32_t hash52(uint32_t p)
    return p;
 }
 
-static int select_partition(int seed, int x, int y, int z, int partitioncount,
-                            int small_block)
+/* Sets up the partition selection function of the ASTC spec for a whole 2D
+ * block, so that only the part that depends on x and y is left per texel.
+ */
+static void select_partition_params(int seed, int partitioncount,
+                                    int small_block,
+                                    astc_texel_params *params)
 {
-   if (small_block) {
-      x <<= 1;
-      y <<= 1;
-      z <<= 1;
-   }
    seed += (partitioncount - 1) * 1024;
    uint32_t rnum = hash52(seed);
-   uint8_t seed1 = rnum & 0xF;
-   uint8_t seed2 = (rnum >> 4) & 0xF;
-   uint8_t seed3 = (rnum >> 8) & 0xF;
-   uint8_t seed4 = (rnum >> 12) & 0xF;
-   uint8_t seed5 = (rnum >> 16) & 0xF;
-   uint8_t seed6 = (rnum >> 20) & 0xF;
-   uint8_t seed7 = (rnum >> 24) & 0xF;
-   uint8_t seed8 = (rnum >> 28) & 0xF;
-   uint8_t seed9 = (rnum >> 18) & 0xF;
-   uint8_t seed10 = (rnum >> 22) & 0xF;
-   uint8_t seed11 = (rnum >> 26) & 0xF;
-   uint8_t seed12 = ((rnum >> 30) | (rnum << 2)) & 0xF;
-
-   seed1 *= seed1;
-   seed2 *= seed2;
-   seed3 *= seed3;
-   seed4 *= seed4;
-   seed5 *= seed5;
-   seed6 *= seed6;
-   seed7 *= seed7;
-   seed8 *= seed8;
-   seed9 *= seed9;
-   seed10 *= seed10;
-   seed11 *= seed11;
-   seed12 *= seed12;
-
-   int sh1, sh2, sh3;
+   uint8_t seeds[8];
+   for (int i = 0; i < 8; i++) {
+      seeds[i] = (rnum >> (4 * i)) & 0xF;
+      seeds[i] *= seeds[i];
+   }
+
+   int sh1, sh2;
    if (seed & 1) {
       sh1 = (seed & 2 ? 4 : 5);
       sh2 = (partitioncount == 3 ? 6 : 5);
@@ -320,44 +309,19 @@ static int select_partition(int seed, int x, int y, int z, int partitioncount,
       sh1 = (partitioncount == 3 ? 6 : 5);
       sh2 = (seed & 2 ? 4 : 5);
    }
-   sh3 = (seed & 0x10) ? sh1 : sh2;
-
-   seed1 >>= sh1;
-   seed2 >>= sh2;
-   seed3 >>= sh1;
-   seed4 >>= sh2;
-   seed5 >>= sh1;
-   seed6 >>= sh2;
-   seed7 >>= sh1;
-   seed8 >>= sh2;
-   seed9 >>= sh3;
-   seed10 >>= sh3;
-   seed11 >>= sh3;
-   seed12 >>= sh3;
-
-   int a = seed1 * x + seed2 * y + seed11 * z + (rnum >> 14);
-   int b = seed3 * x + seed4 * y + seed12 * z + (rnum >> 10);
-   int c = seed5 * x + seed6 * y + seed9 * z + (rnum >> 6);
-   int d = seed7 * x + seed8 * y + seed10 * z + (rnum >> 2);
-
-   a &= 0x3F;
-   b &= 0x3F;
-   c &= 0x3F;
-   d &= 0x3F;
-
-   if (partitioncount < 4)
-      d = 0;
-   if (partitioncount < 3)
-      c = 0;
-
-   if (a >= b && a >= c && a >= d)
-      return 0;
-   else if (b >= c && b >= d)
-      return 1;
-   else if (c >= d)
-      return 2;
-   else
-      return 3;
+
+   int scale = small_block ? 2 : 1;
+   for (int i = 0; i < 4; i++) {
+      if (i < partitioncount) {
+         params->partition_x[i] = (seeds[i * 2] >> sh1) * scale;
+         params->partition_y[i] = (seeds[i * 2 + 1] >> sh2) * scale;
+         params->partition_add[i] = rnum >> (14 - 4 * i);
+      } else {
+         params->partition_x[i] = 0;
+         params->partition_y[i] = 0;
+         params->partition_add[i] = 0;
+      }
+   }
 }
 
 
@@ -539,17 +503,47 @@ struct OutputBitVector
 };
 
 
+/* How to infill the weight of a texel, see Block::compute_infill_weights(). */
+struct infill_texel
+{
+   uint8_t v0;
+   uint8_t w00, w01, w10, w11;
+};
+
 class Decoder
 {
 public:
    Decoder(int block_w, int block_h, int block_d, bool srgb, bool output_unorm8)
       : block_w(block_w), block_h(block_h), block_d(block_d), srgb(srgb),
-        output_unorm8(output_unorm8) {}
+        output_unorm8(output_unorm8)
+   {
+      memset(infill_tables, 0, sizeof(infill_tables));
+   }
+
+   ~Decoder()
+   {
+      for (int i = 0; i < 13; i++) {
+         for (int j = 0; j < 13; j++)
+            free(infill_tables[i][j]);
+      }
+   }
 
-   decode_error::type decode(const uint8_t *in, uint16_t *output) const;
+   /* Decodes a 2D block straight to the RGBA UNORM8 texels of dst, of which
+    * only the first width x height are written.
+    */
+   decode_error::type decode_unorm8(const uint8_t *in, uint8_t *dst,
+                                    unsigned dst_stride,
+                                    unsigned width, unsigned height);
+
+   const infill_texel *get_infill_table(int wt_w, int wt_h);
 
    int block_w, block_h, block_d;
    bool srgb, output_unorm8;
+
+   /* The infill of each 2D weight grid size seen so far, which is the same
+    * for all blocks.
+    */
+   infill_texel *infill_tables[13][13];
 };
 
 struct Block
@@ -638,40 +632,84 @@ struct Block
    void decode_colour_endpoints();
    void unpack_weights(InputBitVector in);
    void compute_infill_weights(int block_w, int block_h, int block_d);
+   void compute_infill_weights_2d(const infill_texel *table, int num_texels);
 
-   void write_decoded(const Decoder &decoder, uint16_t *output);
+   void write_unorm8(const Decoder &decoder, uint8_t *dst, unsigned dst_stride,
+                     unsigned width, unsigned height);
 };
 
 
-decode_error::type Decoder::decode(const uint8_t *in, uint16_t *output) const
+decode_error::type Decoder::decode_unorm8(const uint8_t *in, uint8_t *dst,
+                                          unsigned dst_stride,
+                                          unsigned width, unsigned height)
 {
+   assert(block_d == 1 && output_unorm8);
+
    Block blk;
    InputBitVector in_vec;
    memcpy(&in_vec.data, in, 16);
    decode_error::type err = blk.decode(*this, in_vec);
    if (err == decode_error::ok) {
-      blk.write_decoded(*this, output);
+      if (!blk.is_void_extent) {
+         const infill_texel *table = get_infill_table(blk.wt_w, blk.wt_h);
+         if (table)
+            blk.compute_infill_weights_2d(table, block_w * block_h);
+         else
+            blk.compute_infill_weights(block_w, block_h, block_d);
+      }
+      blk.write_unorm8(*this, dst, dst_stride, width, height);
    } else {
       /* Fill output with the error colour */
-      for (int i = 0; i < block_w * block_h * block_d; ++i) {
-         if (output_unorm8) {
-            output[i*4+0] = 0xff;
-            output[i*4+1] = 0;
-            output[i*4+2] = 0xff;
-            output[i*4+3] = 0xff;
-         } else {
-            assert(!srgb); /* srgb must use unorm8 */
-
-            output[i*4+0] = FP16_ONE;
-            output[i*4+1] = FP16_ZERO;
-            output[i*4+2] = FP16_ONE;
-            output[i*4+3] = FP16_ONE;
+      for (unsigned y = 0; y < height; ++y) {
+         for (unsigned x = 0; x < width; ++x) {
+            uint8_t *texel = dst + y * dst_stride + x * 4;
+            texel[0] = 0xff;
+            texel[1] = 0;
+            texel[2] = 0xff;
+            texel[3] = 0xff;
          }
       }
    }
    return err;
 }
 
+const infill_texel *Decoder::get_infill_table(int wt_w, int wt_h)
+{
+   assert(wt_w <= 12 && wt_h <= 12);
+
+   infill_texel *table = infill_tables[wt_w][wt_h];
+   if (table)
+      return table;
+
+   table = (infill_texel *) malloc(block_w * block_h * sizeof(*table));
+   if (!table)
+      return NULL;
+
+   /* This is compute_infill_weights() without the weights. */
+   int Ds = block_w <= 1 ? 0 : (1024 + block_w / 2) / (block_w - 1);
+   int Dt = block_h <= 1 ? 0 : (1024 + block_h / 2) / (block_h - 1);
+   for (int t = 0; t < block_h; ++t) {
+      for (int s = 0; s < block_w; ++s) {
+         int gs = (Ds * s * (wt_w - 1) + 32) >> 6;
+         int gt = (Dt * t * (wt_h - 1) + 32) >> 6;
+         int js = gs >> 4;
+         int fs = gs & 0xf;
+         int jt = gt >> 4;
+         int ft = gt & 0xf;
+
+         infill_texel *texel = &table[s + t * block_w];
+         texel->v0 = js + jt * wt_w;
+         texel->w11 = (fs * ft + 8) >> 4;
+         texel->w10 = ft - texel->w11;
+         texel->w01 = fs - texel->w11;
+         texel->w00 = 16 - fs - ft + texel->w11;
+      }
+   }
+
+   infill_tables[wt_w][wt_h] = table;
+   return table;
+}
+
 
 decode_error::type Block::decode_void_extent(InputBitVector block)
 {
@@ -1325,6 +1363,50 @@ void Block::compute_infill_weights(int block_w, int block_h, int block_d)
          }
       }
    }
+
+   if (VERBOSE_DECODE) {
+      for (int plane = 0; plane <= dual_plane; ++plane) {
+         printf("infilled weights (plane %d):\n", plane);
+         int i = 0;
+         (void)i;
+
+         for (int r = 0; r < block_d; ++r) {
+            for (int t = 0; t < block_h; ++t) {
+               for (int s = 0; s < block_w; ++s) {
+                  printf("%3d", infill_weights[plane][i++]);
+               }
+               printf("\n");
+            }
+            if (r < block_d - 1)
+               printf("\n");
+         }
+      }
+      printf("\n");
+   }
+}
+
+void Block::compute_infill_weights_2d(const infill_texel *table, int num_texels)
+{
+   for (int i = 0; i < num_texels; ++i) {
+      const infill_texel *texel = &table[i];
+
+      if (dual_plane) {
+         const uint8_t *p = &weights[texel->v0 * 2];
+         const uint8_t *p1 = &weights[(texel->v0 + wt_w) * 2];
+         infill_weights[0][i] = (p[0] * texel->w00 + p[2] * texel->w01 +
+                                 p1[0] * texel->w10 + p1[2] * texel->w11 +
+                                 8) >> 4;
+         infill_weights[1][i] = (p[1] * texel->w00 + p[3] * texel->w01 +
+                                 p1[1] * texel->w10 + p1[3] * texel->w11 +
+                                 8) >> 4;
+      } else {
+         const uint8_t *p = &weights[texel->v0];
+         const uint8_t *p1 = &weights[texel->v0 + wt_w];
+         infill_weights[0][i] = (p[0] * texel->w00 + p[1] * texel->w01 +
+                                 p1[0] * texel->w10 + p1[1] * texel->w11 +
+                                 8) >> 4;
+      }
+   }
 }
 
 void Block::unquantise_colour_endpoints()
@@ -1580,145 +1662,119 @@ decode_error::type Block::decode(const Decoder &decoder, InputBitVector in)
       }
    }
 
-   compute_infill_weights(decoder.block_w, decoder.block_h, decoder.block_d);
-
-   if (VERBOSE_DECODE) {
-      for (int plane = 0; plane <= dual_plane; ++plane) {
-         printf("infilled weights (plane %d):\n", plane);
-         int i = 0;
-         (void)i;
+   return decode_error::ok;
+}
 
-         for (int r = 0; r < decoder.block_d; ++r) {
-            for (int t = 0; t < decoder.block_h; ++t) {
-               for (int s = 0; s < decoder.block_w; ++s) {
-                  printf("%3d", infill_weights[plane][i++]);
-               }
-               printf("\n");
-            }
-            if (r < decoder.block_d - 1)
-               printf("\n");
-         }
-      }
+static inline int
+select_partition_2d(const astc_texel_params *params, int x, int y)
+{
+   int v[4];
+   for (int i = 0; i < 4; ++i) {
+      v[i] = (x * params->partition_x[i] + y * params->partition_y[i] +
+              params->partition_add[i]) & 0x3F;
    }
-   if (VERBOSE_DECODE)
-      printf("\n");
 
-   return decode_error::ok;
+   if (v[0] >= v[1] && v[0] >= v[2] && v[0] >= v[3])
+      return 0;
+   else if (v[1] >= v[2] && v[1] >= v[3])
+      return 1;
+   else if (v[2] >= v[3])
+      return 2;
+   else
+      return 3;
 }
 
-void Block::write_decoded(const Decoder &decoder, uint16_t *output)
+/* Writes a decoded 2D block as UNORM8, with the partition selection set up
+ * once for the block and the float conversions done through unorm8_table.
+ */
+void Block::write_unorm8(const Decoder &decoder, uint8_t *dst,
+                         unsigned dst_stride, unsigned width, unsigned height)
 {
-   /* sRGB can only be stored as unorm8. */
-   assert(!decoder.srgb || decoder.output_unorm8);
-
    if (is_void_extent) {
-      for (int idx = 0; idx < decoder.block_w*decoder.block_h*decoder.block_d; ++idx) {
-         if (decoder.output_unorm8) {
-            if (decoder.srgb) {
-               output[idx*4+0] = void_extent_colour_r >> 8;
-               output[idx*4+1] = void_extent_colour_g >> 8;
-               output[idx*4+2] = void_extent_colour_b >> 8;
-            } else {
-               output[idx*4+0] = uint16_div_64k_to_half_to_unorm8(void_extent_colour_r);
-               output[idx*4+1] = uint16_div_64k_to_half_to_unorm8(void_extent_colour_g);
-               output[idx*4+2] = uint16_div_64k_to_half_to_unorm8(void_extent_colour_b);
-            }
-            output[idx*4+3] = uint16_div_64k_to_half_to_unorm8(void_extent_colour_a);
-         } else {
-            /* Store the color as FP16. */
-            output[idx*4+0] = _mesa_uint16_div_64k_to_half(void_extent_colour_r);
-            output[idx*4+1] = _mesa_uint16_div_64k_to_half(void_extent_colour_g);
-            output[idx*4+2] = _mesa_uint16_div_64k_to_half(void_extent_colour_b);
-            output[idx*4+3] = _mesa_uint16_div_64k_to_half(void_extent_colour_a);
-         }
+      uint8_t colour[4];
+      if (decoder.srgb) {
+         colour[0] = void_extent_colour_r >> 8;
+         colour[1] = void_extent_colour_g >> 8;
+         colour[2] = void_extent_colour_b >> 8;
+      } else {
+         colour[0] = uint16_div_64k_to_half_to_unorm8(void_extent_colour_r);
+         colour[1] = uint16_div_64k_to_half_to_unorm8(void_extent_colour_g);
+         colour[2] = uint16_div_64k_to_half_to_unorm8(void_extent_colour_b);
+      }
+      colour[3] = uint16_div_64k_to_half_to_unorm8(void_extent_colour_a);
+
+      for (unsigned y = 0; y < height; ++y) {
+         for (unsigned x = 0; x < width; ++x)
+            memcpy(dst + y * dst_stride + x * 4, colour, 4);
       }
       return;
    }
 
-   int small_block = (decoder.block_w * decoder.block_h * decoder.block_d) < 31;
-
-   int idx = 0;
-   for (int z = 0; z < decoder.block_d; ++z) {
-      for (int y = 0; y < decoder.block_h; ++y) {
-         for (int x = 0; x < decoder.block_w; ++x) {
-
-            int partition;
-            if (num_parts > 1) {
-               partition = select_partition(partition_index, x, y, z, num_parts, small_block);
-               assert(partition < num_parts);
-            } else {
-               partition = 0;
-            }
-
-            /* TODO: HDR */
-
-            uint8x4_t e0 = endpoints_decoded[0][partition];
-            uint8x4_t e1 = endpoints_decoded[1][partition];
-            uint16_t c0[4], c1[4];
+   astc_texel_params params;
 
-            /* Expand to 16 bits. */
-            if (decoder.srgb) {
-               c0[0] = (uint16_t)((e0.v[0] << 8) | 0x80);
-               c0[1] = (uint16_t)((e0.v[1] << 8) | 0x80);
-               c0[2] = (uint16_t)((e0.v[2] << 8) | 0x80);
-               c0[3] = (uint16_t)((e0.v[3] << 8) | 0x80);
-
-               c1[0] = (uint16_t)((e1.v[0] << 8) | 0x80);
-               c1[1] = (uint16_t)((e1.v[1] << 8) | 0x80);
-               c1[2] = (uint16_t)((e1.v[2] << 8) | 0x80);
-               c1[3] = (uint16_t)((e1.v[3] << 8) | 0x80);
-            } else {
-               c0[0] = (uint16_t)((e0.v[0] << 8) | e0.v[0]);
-               c0[1] = (uint16_t)((e0.v[1] << 8) | e0.v[1]);
-               c0[2] = (uint16_t)((e0.v[2] << 8) | e0.v[2]);
-               c0[3] = (uint16_t)((e0.v[3] << 8) | e0.v[3]);
-
-               c1[0] = (uint16_t)((e1.v[0] << 8) | e1.v[0]);
-               c1[1] = (uint16_t)((e1.v[1] << 8) | e1.v[1]);
-               c1[2] = (uint16_t)((e1.v[2] << 8) | e1.v[2]);
-               c1[3] = (uint16_t)((e1.v[3] << 8) | e1.v[3]);
-            }
+   /* Expand to 16 bits. */
+   for (int p = 0; p < num_parts; ++p) {
+      for (int e = 0; e < 2; ++e) {
+         for (int c = 0; c < 4; ++c) {
+            int v = endpoints_decoded[e][p].v[c];
+            params.endpoints[p][e][c] = decoder.srgb ? (v << 8) | 0x80 :
+                                                       (v << 8) | v;
+         }
+      }
+   }
 
-            int w[4];
-            if (dual_plane) {
-               int w0 = infill_weights[0][idx];
-               int w1 = infill_weights[1][idx];
-               w[0] = w[1] = w[2] = w[3] = w0;
-               w[colour_component_selector] = w1;
-            } else {
-               int w0 = infill_weights[0][idx];
-               w[0] = w[1] = w[2] = w[3] = w0;
-            }
+   params.num_parts = num_parts;
+   if (num_parts > 1) {
+      int small_block = (decoder.block_w * decoder.block_h) < 31;
+      select_partition_params(partition_index, num_parts, small_block,
+                              &params);
+   }
 
-            /* Interpolate to produce UNORM16, applying weights. */
-            uint16_t c[4] = {
-               (uint16_t)((c0[0] * (64 - w[0]) + c1[0] * w[0] + 32) >> 6),
-               (uint16_t)((c0[1] * (64 - w[1]) + c1[1] * w[1] + 32) >> 6),
-               (uint16_t)((c0[2] * (64 - w[2]) + c1[2] * w[2] + 32) >> 6),
-               (uint16_t)((c0[3] * (64 - w[3]) + c1[3] * w[3] + 32) >> 6),
-            };
-
-            if (decoder.output_unorm8) {
-               if (decoder.srgb) {
-                  output[idx*4+0] = c[0] >> 8;
-                  output[idx*4+1] = c[1] >> 8;
-                  output[idx*4+2] = c[2] >> 8;
-               } else {
-                  output[idx*4+0] = c[0] == 65535 ? 0xff : uint16_div_64k_to_half_to_unorm8(c[0]);
-                  output[idx*4+1] = c[1] == 65535 ? 0xff : uint16_div_64k_to_half_to_unorm8(c[1]);
-                  output[idx*4+2] = c[2] == 65535 ? 0xff : uint16_div_64k_to_half_to_unorm8(c[2]);
-               }
-               output[idx*4+3] = c[3] == 65535 ? 0xff : uint16_div_64k_to_half_to_unorm8(c[3]);
-            } else {
-               /* Store the color as FP16. */
-               output[idx*4+0] = c[0] == 65535 ? FP16_ONE : _mesa_uint16_div_64k_to_half(c[0]);
-               output[idx*4+1] = c[1] == 65535 ? FP16_ONE : _mesa_uint16_div_64k_to_half(c[1]);
-               output[idx*4+2] = c[2] == 65535 ? FP16_ONE : _mesa_uint16_div_64k_to_half(c[2]);
-               output[idx*4+3] = c[3] == 65535 ? FP16_ONE : _mesa_uint16_div_64k_to_half(c[3]);
-            }
+   params.weights[0] = infill_weights[0];
+   params.weights[1] = infill_weights[1];
+   params.dual_plane = dual_plane;
+   params.colour_component_selector = colour_component_selector;
+   params.srgb = decoder.srgb;
+
+#if defined(USE_SSE41)
+   if (util_cpu_caps.has_sse4_1) {
+      _mesa_astc_write_texels_unorm8_sse41(dst, dst_stride, width, height,
+                                           decoder.block_w, &params,
+                                           unorm8_table);
+      return;
+   }
+#endif
+
+   for (unsigned y = 0; y < height; ++y) {
+      for (unsigned x = 0; x < width; ++x) {
+         int idx = y * decoder.block_w + x;
+         int partition = num_parts > 1 ?
+            select_partition_2d(&params, x, y) : 0;
+
+         int w[4];
+         w[0] = w[1] = w[2] = w[3] = infill_weights[0][idx];
+         if (dual_plane)
+            w[colour_component_selector] = infill_weights[1][idx];
+
+         /* Interpolate to produce UNORM16, applying weights. */
+         uint16_t c[4];
+         for (int i = 0; i < 4; ++i) {
+            int c0 = params.endpoints[partition][0][i];
+            int c1 = params.endpoints[partition][1][i];
+            c[i] = (c0 * (64 - w[i]) + c1 * w[i] + 32) >> 6;
+         }
 
-            idx++;
+         uint8_t *texel = dst + y * dst_stride + x * 4;
+         if (decoder.srgb) {
+            texel[0] = c[0] >> 8;
+            texel[1] = c[1] >> 8;
+            texel[2] = c[2] >> 8;
+         } else {
+            texel[0] = unorm8_table[c[0]];
+            texel[1] = unorm8_table[c[1]];
+            texel[2] = unorm8_table[c[2]];
          }
+         texel[3] = unorm8_table[c[3]];
       }
    }
 }
@@ -1814,9 +1870,61 @@ decode_error::type Block::calculate_colour_endpoints_size()
    return decode_error::invalid_colour_endpoints_size;
 }
 
+static void
+init_astc_decoder(void)
+{
+   util_cpu_detect();
+
+   for (unsigned i = 0; i < 65535; i++)
+      unorm8_table[i] = uint16_div_64k_to_half_to_unorm8(i);
+   unorm8_table[65535] = 0xff;
+}
+
+struct astc_decode_job {
+   uint8_t *dst_row;
+   unsigned dst_stride;
+   const uint8_t *src_row;
+   unsigned src_stride;
+   unsigned src_width;
+   unsigned src_height;
+   unsigned blk_w, blk_h;
+   bool srgb;
+};
+
+static void
+astc_decode_rows(void *data, unsigned first_row, unsigned num_rows)
+{
+   struct astc_decode_job *job = (struct astc_decode_job *) data;
+   const unsigned block_size = 16;
+   unsigned blk_w = job->blk_w, blk_h = job->blk_h;
+   unsigned x_blocks = (job->src_width + blk_w - 1) / blk_w;
+   const uint8_t *src_row = job->src_row + first_row * job->src_stride;
+   uint8_t *dst_row = job->dst_row + first_row * blk_h * job->dst_stride;
+
+   Decoder dec(blk_w, blk_h, 1, job->srgb, true);
+
+   for (unsigned y = first_row; y < first_row + num_rows; ++y) {
+      /* This can be smaller with NPOT dimensions. */
+      unsigned dst_blk_h = MIN2(blk_h, job->src_height - y*blk_h);
+
+      for (unsigned x = 0; x < x_blocks; ++x) {
+         unsigned dst_blk_w = MIN2(blk_w, job->src_width - x*blk_w);
+
+         dec.decode_unorm8(src_row + x * block_size,
+                           dst_row + x * blk_w * 4, job->dst_stride,
+                           dst_blk_w, dst_blk_h);
+      }
+      src_row += job->src_stride;
+      dst_row += job->dst_stride * blk_h;
+   }
+}
+
 /**
  * Decode ASTC 2D LDR texture data.
  *
+ * Large images are split into bands of block rows, which are decoded in
+ * parallel.
+ *
  * \param src_width in pixels
  * \param src_height in pixels
  * \param dst_stride in bytes
@@ -1836,37 +1944,21 @@ _mesa_unpack_astc_2d_ldr(uint8_t *dst_row,
    unsigned blk_w, blk_h;
    _mesa_get_format_block_size(format, &blk_w, &blk_h);
 
-   const unsigned block_size = 16;
    unsigned x_blocks = (src_width + blk_w - 1) / blk_w;
    unsigned y_blocks = (src_height + blk_h - 1) / blk_h;
 
-   Decoder dec(blk_w, blk_h, 1, srgb, true);
-
-   for (unsigned y = 0; y < y_blocks; ++y) {
-      for (unsigned x = 0; x < x_blocks; ++x) {
-         /* Same size as the largest block. */
-         uint16_t block_out[12 * 12 * 4];
-
-         dec.decode(src_row + x * block_size, block_out);
-
-         /* This can be smaller with NPOT dimensions. */
-         unsigned dst_blk_w = MIN2(blk_w, src_width  - x*blk_w);
-         unsigned dst_blk_h = MIN2(blk_h, src_height - y*blk_h);
+   call_once(&decoder_once, init_astc_decoder);
 
-         for (unsigned sub_y = 0; sub_y < dst_blk_h; ++sub_y) {
-            for (unsigned sub_x = 0; sub_x < dst_blk_w; ++sub_x) {
-               uint8_t *dst = dst_row + sub_y * dst_stride +
-                              (x * blk_w + sub_x) * 4;
-               const uint16_t *src = &block_out[(sub_y * blk_w + sub_x) * 4];
+   struct astc_decode_job job;
+   job.dst_row = dst_row;
+   job.dst_stride = dst_stride;
+   job.src_row = src_row;
+   job.src_stride = src_stride;
+   job.src_width = src_width;
+   job.src_height = src_height;
+   job.blk_w = blk_w;
+   job.blk_h = blk_h;
+   job.srgb = srgb;
 
-               dst[0] = src[0];
-               dst[1] = src[1];
-               dst[2] = src[2];
-               dst[3] = src[3];
-            }
-         }
-      }
-      src_row += src_stride;
-      dst_row += dst_stride * blk_h;
-   }
+   util_format_block_rows_parallel(x_blocks, y_blocks, astc_decode_rows, &job);
 }
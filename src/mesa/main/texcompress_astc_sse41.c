@@ -0,0 +1,138 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "main/texcompress_astc_sse41.h"
+#include <smmintrin.h>
+
+/* Returns a mask of the lanes where a >= b. */
+static inline __m128i
+cmpge_epi32(__m128i a, __m128i b)
+{
+   return _mm_xor_si128(_mm_cmpgt_epi32(b, a), _mm_set1_epi32(-1));
+}
+
+/* Returns the partitions of the texels (x, y) to (x + 3, y), see
+ * select_partition() in texcompress_astc.cpp.
+ */
+static inline __m128i
+select_partitions(const struct astc_texel_params *params, int x, int y)
+{
+   const __m128i xs = _mm_add_epi32(_mm_set1_epi32(x),
+                                    _mm_setr_epi32(0, 1, 2, 3));
+   __m128i v[4];
+
+   for (unsigned i = 0; i < 4; i++) {
+      __m128i add = _mm_set1_epi32(y * params->partition_y[i] +
+                                   params->partition_add[i]);
+      v[i] = _mm_mullo_epi32(xs, _mm_set1_epi32(params->partition_x[i]));
+      v[i] = _mm_and_si128(_mm_add_epi32(v[i], add), _mm_set1_epi32(0x3f));
+   }
+
+   __m128i is0 = _mm_and_si128(_mm_and_si128(cmpge_epi32(v[0], v[1]),
+                                             cmpge_epi32(v[0], v[2])),
+                               cmpge_epi32(v[0], v[3]));
+   __m128i is1 = _mm_and_si128(cmpge_epi32(v[1], v[2]),
+                               cmpge_epi32(v[1], v[3]));
+   __m128i is2 = cmpge_epi32(v[2], v[3]);
+
+   __m128i part = _mm_set1_epi32(3);
+   part = _mm_blendv_epi8(part, _mm_set1_epi32(2), is2);
+   part = _mm_blendv_epi8(part, _mm_set1_epi32(1), is1);
+   part = _mm_blendv_epi8(part, _mm_setzero_si128(), is0);
+   return part;
+}
+
+/**
+ * Interpolates the endpoints of each texel of a block with its weights and
+ * writes the texels as RGBA UNORM8, the same way as Block::write_unorm8()
+ * in texcompress_astc.cpp.
+ *
+ * Each texel is done in one vector, with a channel in each lane: as
+ * (c0 * (64 - w) + c1 * w + 32) >> 6 is (c0 * 64 + 32 + (c1 - c0) * w) >> 6,
+ * that is a single multiplication per texel.  The partitions are selected
+ * for four texels at a time.
+ */
+void
+_mesa_astc_write_texels_unorm8_sse41(uint8_t *dst, unsigned dst_stride,
+                                     unsigned width, unsigned height,
+                                     unsigned block_w,
+                                     const struct astc_texel_params *params,
+                                     const uint8_t *unorm8_table)
+{
+   __m128i base[4], delta[4];
+   for (int i = 0; i < params->num_parts; i++) {
+      __m128i c0 = _mm_loadu_si128((const __m128i *)params->endpoints[i][0]);
+      __m128i c1 = _mm_loadu_si128((const __m128i *)params->endpoints[i][1]);
+
+      base[i] = _mm_add_epi32(_mm_slli_epi32(c0, 6), _mm_set1_epi32(32));
+      delta[i] = _mm_sub_epi32(c1, c0);
+   }
+
+   /* The lane of the channel that takes its weight from the second plane. */
+   __m128i plane1_mask = _mm_setzero_si128();
+   if (params->dual_plane) {
+      plane1_mask = _mm_cmpeq_epi32(_mm_setr_epi32(0, 1, 2, 3),
+                        _mm_set1_epi32(params->colour_component_selector));
+   }
+
+   for (unsigned y = 0; y < height; y++) {
+      const uint8_t *w0 = params->weights[0] + y * block_w;
+      const uint8_t *w1 = params->weights[1] + y * block_w;
+      uint8_t *texel = dst + y * dst_stride;
+
+      for (unsigned x = 0; x < width; x += 4) {
+         int32_t parts[4] = { 0 };
+
+         if (params->num_parts > 1) {
+            _mm_storeu_si128((__m128i *)parts,
+                             select_partitions(params, x, y));
+         }
+
+         for (unsigned i = 0; i < 4 && x + i < width; i++) {
+            __m128i w = _mm_set1_epi32(w0[x + i]);
+            if (params->dual_plane) {
+               w = _mm_blendv_epi8(w, _mm_set1_epi32(w1[x + i]),
+                                   plane1_mask);
+            }
+
+            __m128i c = _mm_mullo_epi32(delta[parts[i]], w);
+            c = _mm_srli_epi32(_mm_add_epi32(base[parts[i]], c), 6);
+
+            uint32_t cv[4];
+            _mm_storeu_si128((__m128i *)cv, c);
+
+            if (params->srgb) {
+               texel[0] = cv[0] >> 8;
+               texel[1] = cv[1] >> 8;
+               texel[2] = cv[2] >> 8;
+            } else {
+               texel[0] = unorm8_table[cv[0]];
+               texel[1] = unorm8_table[cv[1]];
+               texel[2] = unorm8_table[cv[2]];
+            }
+            texel[3] = unorm8_table[cv[3]];
+            texel += 4;
+         }
+      }
+   }
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef TEXCOMPRESS_ASTC_SSE41_H
+#define TEXCOMPRESS_ASTC_SSE41_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * What is left to do to write the texels of an ASTC LDR block, once its
+ * colour endpoints and infilled weights are decoded.
+ */
+struct astc_texel_params {
+   /** The endpoints of each partition, expanded to 16 bits per channel */
+   int32_t endpoints[4][2][4];
+
+   /**
+    * The texel at (x, y) is in the partition i with the largest
+    * (x * partition_x[i] + y * partition_y[i] + partition_add[i]) & 0x3f,
+    * or the first of them if several are the largest.  Partitions past
+    * num_parts have all zeros.
+    */
+   int32_t partition_x[4];
+   int32_t partition_y[4];
+   int32_t partition_add[4];
+   int num_parts;
+
+   /** The weight of each texel of the block, for each plane */
+   const uint8_t *weights[2];
+   bool dual_plane;
+   int colour_component_selector;
+
+   bool srgb;
+};
+
+void
+_mesa_astc_write_texels_unorm8_sse41(uint8_t *dst, unsigned dst_stride,
+                                     unsigned width, unsigned height,
+                                     unsigned block_w,
+                                     const struct astc_texel_params *params,
+                                     const uint8_t *unorm8_table);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEXCOMPRESS_ASTC_SSE41_H */
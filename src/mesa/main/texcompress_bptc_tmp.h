@@ -29,6 +29,7 @@
 #define TEXCOMPRESS_BPTC_TMP_H
 
 #include "util/format_srgb.h"
+#include "util/format/u_format_compress.h"
 #include "util/half_float.h"
 #include "macros.h"
 
@@ -661,7 +662,7 @@ decompress_rgba_unorm_block(int src_width, int src_height,
 {
    int mode_num = ffs(block[0]);
    const struct bptc_unorm_mode *mode;
-   int bit_offset, secondary_bit_offset;
+   int bit_offset, secondary_bit_offset, indices_offset;
    int partition_num;
    int subset_num;
    int rotation;
@@ -725,7 +726,8 @@ decompress_rgba_unorm_block(int src_width, int src_height,
       index_selection = 0;
    }
 
-   bit_offset = extract_unorm_endpoints(mode, block, bit_offset, endpoints);
+   indices_offset = extract_unorm_endpoints(mode, block, bit_offset,
+                                            endpoints);
 
    for(y = 0; y < src_height; y += 1) {
       uint8_t *result = dst_row;
@@ -738,14 +740,15 @@ decompress_rgba_unorm_block(int src_width, int src_height,
                                                            texel);
 
          /* Calculate the offset to the secondary index */
-         secondary_bit_offset = (bit_offset +
+         secondary_bit_offset = (indices_offset +
                                  BLOCK_SIZE * BLOCK_SIZE * mode->n_index_bits -
                                  mode->n_subsets +
                                  mode->n_secondary_index_bits * texel -
                                  anchors_before_texel);
 
          /* Calculate the offset to the primary index for this texel */
-         bit_offset += mode->n_index_bits * texel - anchors_before_texel;
+         bit_offset = (indices_offset +
+                       mode->n_index_bits * texel - anchors_before_texel);
 
          subset_num = (subsets >> (texel * 2)) & 3;
 
@@ -1052,7 +1055,7 @@ decompress_rgb_float_block(unsigned src_width, unsigned src_height,
 {
    int mode_num;
    const struct bptc_float_mode *mode;
-   int bit_offset;
+   int bit_offset, indices_offset;
    int partition_num;
    int subset_num;
    int index_bits;
@@ -1103,6 +1106,8 @@ decompress_rgb_float_block(unsigned src_width, unsigned src_height,
       n_subsets = 1;
    }
 
+   indices_offset = bit_offset;
+
    for(y = 0; y < src_height; y += 1) {
       float *result = dst_row;
       for(x = 0; x < src_width; x += 1) {
@@ -1114,7 +1119,8 @@ decompress_rgb_float_block(unsigned src_width, unsigned src_height,
             count_anchors_before_texel(n_subsets, partition_num, texel);
 
          /* Calculate the offset to the primary index for this texel */
-         bit_offset += mode->n_index_bits * texel - anchors_before_texel;
+         bit_offset = (indices_offset +
+                       mode->n_index_bits * texel - anchors_before_texel);
 
          subset_num = (subsets >> (texel * 2)) & 3;
 
@@ -1452,32 +1458,62 @@ compress_rgba_unorm_block(int src_width, int src_height,
                              endpoints);
 }
 
+struct compress_rgba_unorm_job {
+   int width, height;
+   const uint8_t *src;
+   int src_rowstride;
+   uint8_t *dst;
+   int dst_row_pitch;
+};
+
 static void
-compress_rgba_unorm(int width, int height,
-                    const uint8_t *src, int src_rowstride,
-                    uint8_t *dst, int dst_rowstride)
+compress_rgba_unorm_rows(void *data, unsigned first_row, unsigned num_rows)
 {
-   int dst_row_diff;
+   const struct compress_rgba_unorm_job *job = data;
    int y, x;
 
-   if (dst_rowstride >= width * 4)
-      dst_row_diff = dst_rowstride - ((width + 3) & ~3) * 4;
-   else
-      dst_row_diff = 0;
+   for (y = first_row * BLOCK_SIZE;
+        y < MIN2(job->height, (first_row + num_rows) * BLOCK_SIZE);
+        y += BLOCK_SIZE) {
+      uint8_t *dst = job->dst + y / BLOCK_SIZE * job->dst_row_pitch;
 
-   for (y = 0; y < height; y += BLOCK_SIZE) {
-      for (x = 0; x < width; x += BLOCK_SIZE) {
-         compress_rgba_unorm_block(MIN2(width - x, BLOCK_SIZE),
-                                   MIN2(height - y, BLOCK_SIZE),
-                                   src + x * 4 + y * src_rowstride,
-                                   src_rowstride,
+      for (x = 0; x < job->width; x += BLOCK_SIZE) {
+         compress_rgba_unorm_block(MIN2(job->width - x, BLOCK_SIZE),
+                                   MIN2(job->height - y, BLOCK_SIZE),
+                                   job->src + x * 4 + y * job->src_rowstride,
+                                   job->src_rowstride,
                                    dst);
          dst += BLOCK_BYTES;
       }
-      dst += dst_row_diff;
    }
 }
 
+static void
+compress_rgba_unorm(int width, int height,
+                    const uint8_t *src, int src_rowstride,
+                    uint8_t *dst, int dst_rowstride)
+{
+   struct compress_rgba_unorm_job job;
+
+   job.width = width;
+   job.height = height;
+   job.src = src;
+   job.src_rowstride = src_rowstride;
+   job.dst = dst;
+
+   if (dst_rowstride >= width * 4)
+      job.dst_row_pitch = dst_rowstride;
+   else
+      job.dst_row_pitch = ((width + 3) & ~3) * 4;
+
+   /* Every block is encoded on its own, so large images can be split up
+    * between threads.
+    */
+   util_format_block_rows_parallel(DIV_ROUND_UP(width, BLOCK_SIZE),
+                                   DIV_ROUND_UP(height, BLOCK_SIZE),
+                                   compress_rgba_unorm_rows, &job);
+}
+
 static float
 get_average_luminance_float(int width, int height,
                             const float *src, int src_rowstride)
@@ -1715,33 +1751,62 @@ compress_rgb_float_block(int src_width, int src_height,
                            endpoints);
 }
 
+struct compress_rgb_float_job {
+   int width, height;
+   const float *src;
+   int src_rowstride;
+   uint8_t *dst;
+   int dst_row_pitch;
+   bool is_signed;
+};
+
+static void
+compress_rgb_float_rows(void *data, unsigned first_row, unsigned num_rows)
+{
+   const struct compress_rgb_float_job *job = data;
+   int y, x;
+
+   for (y = first_row * BLOCK_SIZE;
+        y < MIN2(job->height, (first_row + num_rows) * BLOCK_SIZE);
+        y += BLOCK_SIZE) {
+      uint8_t *dst = job->dst + y / BLOCK_SIZE * job->dst_row_pitch;
+
+      for (x = 0; x < job->width; x += BLOCK_SIZE) {
+         compress_rgb_float_block(MIN2(job->width - x, BLOCK_SIZE),
+                                  MIN2(job->height - y, BLOCK_SIZE),
+                                  job->src + x * 3 +
+                                  y * job->src_rowstride / sizeof (float),
+                                  job->src_rowstride,
+                                  dst,
+                                  job->is_signed);
+         dst += BLOCK_BYTES;
+      }
+   }
+}
+
 static void
 compress_rgb_float(int width, int height,
                    const float *src, int src_rowstride,
                    uint8_t *dst, int dst_rowstride,
                    bool is_signed)
 {
-   int dst_row_diff;
-   int y, x;
+   struct compress_rgb_float_job job;
+
+   job.width = width;
+   job.height = height;
+   job.src = src;
+   job.src_rowstride = src_rowstride;
+   job.dst = dst;
+   job.is_signed = is_signed;
 
    if (dst_rowstride >= width * 4)
-      dst_row_diff = dst_rowstride - ((width + 3) & ~3) * 4;
+      job.dst_row_pitch = dst_rowstride;
    else
-      dst_row_diff = 0;
+      job.dst_row_pitch = ((width + 3) & ~3) * 4;
 
-   for (y = 0; y < height; y += BLOCK_SIZE) {
-      for (x = 0; x < width; x += BLOCK_SIZE) {
-         compress_rgb_float_block(MIN2(width - x, BLOCK_SIZE),
-                                  MIN2(height - y, BLOCK_SIZE),
-                                  src + x * 3 +
-                                  y * src_rowstride / sizeof (float),
-                                  src_rowstride,
-                                  dst,
-                                  is_signed);
-         dst += BLOCK_BYTES;
-      }
-      dst += dst_row_diff;
-   }
+   util_format_block_rows_parallel(DIV_ROUND_UP(width, BLOCK_SIZE),
+                                   DIV_ROUND_UP(height, BLOCK_SIZE),
+                                   compress_rgb_float_rows, &job);
 }
 
 #endif
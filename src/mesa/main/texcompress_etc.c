@@ -45,6 +45,12 @@
 #include "macros.h"
 #include "format_unpack.h"
 #include "util/format_srgb.h"
+#include "util/format/u_format_compress.h"
+#include "util/u_cpu_detect.h"
+
+#if defined(USE_SSE41)
+#include "texcompress_etc_sse41.h"
+#endif
 
 
 struct etc2_block {
@@ -668,528 +674,420 @@ etc2_rgba8_fetch_texel(const struct etc2_block *block,
    etc2_alpha8_fetch_texel(block, x, y, dst);
 }
 
-static void
-etc2_unpack_rgb8(uint8_t *dst_row,
-                 unsigned dst_stride,
-                 const uint8_t *src_row,
-                 unsigned src_stride,
-                 unsigned width,
-                 unsigned height)
+/* ETC2 texture formats are valid in glCompressedTexImage2D and
+ * glCompressedTexSubImage2D functions */
+GLboolean
+_mesa_texstore_etc2_rgb8(UNUSED_TEXSTORE_PARAMS)
 {
-   const unsigned bw = 4, bh = 4, bs = 8, comps = 4;
-   struct etc2_block block;
-   unsigned x, y, i, j;
-
-   for (y = 0; y < height; y += bh) {
-      const uint8_t *src = src_row;
-      /*
-       * Destination texture may not be a multiple of four texels in
-       * height. Compute a safe height to avoid writing outside the texture.
-       */
-      const unsigned h = MIN2(bh, height - y);
+   assert(0);
 
-      for (x = 0; x < width; x+= bw) {
-         /*
-          * Destination texture may not be a multiple of four texels in
-          * width. Compute a safe width to avoid writing outside the texture.
-          */
-         const unsigned w = MIN2(bw, width - x);
-
-         etc2_rgb8_parse_block(&block, src,
-                               false /* punchthrough_alpha */);
-
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < w; i++) {
-               etc2_rgb8_fetch_texel(&block, i, j, dst,
-                                     false /* punchthrough_alpha */);
-               dst[3] = 255;
-               dst += comps;
-            }
-         }
+   return GL_FALSE;
+}
 
-         src += bs;
-      }
+GLboolean
+_mesa_texstore_etc2_srgb8(UNUSED_TEXSTORE_PARAMS)
+{
+   assert(0);
 
-      src_row += src_stride;
-   }
+   return GL_FALSE;
 }
 
-static void
-etc2_unpack_srgb8(uint8_t *dst_row,
-                  unsigned dst_stride,
-                  const uint8_t *src_row,
-                  unsigned src_stride,
-                  unsigned width,
-		  unsigned height,
-		  bool bgra)
+GLboolean
+_mesa_texstore_etc2_rgba8_eac(UNUSED_TEXSTORE_PARAMS)
 {
-   const unsigned bw = 4, bh = 4, bs = 8, comps = 4;
-   struct etc2_block block;
-   unsigned x, y, i, j;
-   uint8_t tmp;
-
-   for (y = 0; y < height; y += bh) {
-      const uint8_t *src = src_row;
-      const unsigned h = MIN2(bh, height - y);
-
-      for (x = 0; x < width; x+= bw) {
-         const unsigned w = MIN2(bw, width - x);
-         etc2_rgb8_parse_block(&block, src,
-                               false /* punchthrough_alpha */);
-
-
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < w; i++) {
-               etc2_rgb8_fetch_texel(&block, i, j, dst,
-                                     false /* punchthrough_alpha */);
-
-	       if (bgra) {
-		  /* Convert to MESA_FORMAT_B8G8R8A8_SRGB */
-		  tmp = dst[0];
-		  dst[0] = dst[2];
-		  dst[2] = tmp;
-		  dst[3] = 255;
-	       }
-
-               dst += comps;
-            }
-         }
-         src += bs;
-      }
+   assert(0);
 
-      src_row += src_stride;
-   }
+   return GL_FALSE;
 }
 
-static void
-etc2_unpack_rgba8(uint8_t *dst_row,
-                  unsigned dst_stride,
-                  const uint8_t *src_row,
-                  unsigned src_stride,
-                  unsigned width,
-                  unsigned height)
+GLboolean
+_mesa_texstore_etc2_srgb8_alpha8_eac(UNUSED_TEXSTORE_PARAMS)
 {
-   /* If internalformat is COMPRESSED_RGBA8_ETC2_EAC, each 4 × 4 block of
-    * RGBA8888 information is compressed to 128 bits. To decode a block, the
-    * two 64-bit integers int64bitAlpha and int64bitColor are calculated.
-   */
-   const unsigned bw = 4, bh = 4, bs = 16, comps = 4;
-   struct etc2_block block;
-   unsigned x, y, i, j;
-
-   for (y = 0; y < height; y += bh) {
-      const uint8_t *src = src_row;
-      const unsigned h = MIN2(bh, height - y);
+   assert(0);
 
-      for (x = 0; x < width; x+= bw) {
-         const unsigned w = MIN2(bw, width - x);
-         etc2_rgba8_parse_block(&block, src);
+   return GL_FALSE;
+}
 
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < w; i++) {
-               etc2_rgba8_fetch_texel(&block, i, j, dst);
-               dst += comps;
-            }
-         }
-         src += bs;
-      }
+GLboolean
+_mesa_texstore_etc2_r11_eac(UNUSED_TEXSTORE_PARAMS)
+{
+   assert(0);
 
-      src_row += src_stride;
-   }
+   return GL_FALSE;
 }
 
-static void
-etc2_unpack_srgb8_alpha8(uint8_t *dst_row,
-                         unsigned dst_stride,
-                         const uint8_t *src_row,
-                         unsigned src_stride,
-                         unsigned width,
-			 unsigned height,
-			 bool bgra)
+GLboolean
+_mesa_texstore_etc2_signed_r11_eac(UNUSED_TEXSTORE_PARAMS)
 {
-   /* If internalformat is COMPRESSED_SRGB8_ALPHA8_ETC2_EAC, each 4 × 4 block
-    * of RGBA8888 information is compressed to 128 bits. To decode a block, the
-    * two 64-bit integers int64bitAlpha and int64bitColor are calculated.
-    */
-   const unsigned bw = 4, bh = 4, bs = 16, comps = 4;
-   struct etc2_block block;
-   unsigned x, y, i, j;
-   uint8_t tmp;
-
-   for (y = 0; y < height; y += bh) {
-      const unsigned h = MIN2(bh, height - y);
-      const uint8_t *src = src_row;
-
-      for (x = 0; x < width; x+= bw) {
-         const unsigned w = MIN2(bw, width - x);
-         etc2_rgba8_parse_block(&block, src);
-
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < w; i++) {
-               etc2_rgba8_fetch_texel(&block, i, j, dst);
-
-	       if (bgra) {
-		  /* Convert to MESA_FORMAT_B8G8R8A8_SRGB */
-		  tmp = dst[0];
-		  dst[0] = dst[2];
-		  dst[2] = tmp;
-		  dst[3] = dst[3];
-	       }
-
-               dst += comps;
-            }
-         }
-         src += bs;
-      }
+   assert(0);
 
-      src_row += src_stride;
-   }
+   return GL_FALSE;
 }
 
-static void
-etc2_unpack_r11(uint8_t *dst_row,
-                unsigned dst_stride,
-                const uint8_t *src_row,
-                unsigned src_stride,
-                unsigned width,
-                unsigned height)
+GLboolean
+_mesa_texstore_etc2_rg11_eac(UNUSED_TEXSTORE_PARAMS)
 {
-   /* If internalformat is COMPRESSED_R11_EAC, each 4 × 4 block of
-      color information is compressed to 64 bits.
-   */
-   const unsigned bw = 4, bh = 4, bs = 8, comps = 1, comp_size = 2;
-   struct etc2_block block;
-   unsigned x, y, i, j;
-
-   for (y = 0; y < height; y += bh) {
-      const unsigned h = MIN2(bh, height - y);
-      const uint8_t *src = src_row;
+   assert(0);
 
-      for (x = 0; x < width; x+= bw) {
-         const unsigned w = MIN2(bw, width - x);
-         etc2_r11_parse_block(&block, src);
+   return GL_FALSE;
+}
 
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps * comp_size;
-            for (i = 0; i < w; i++) {
-               etc2_r11_fetch_texel(&block, i, j, dst);
-               dst += comps * comp_size;
-            }
-         }
-         src += bs;
-      }
+GLboolean
+_mesa_texstore_etc2_signed_rg11_eac(UNUSED_TEXSTORE_PARAMS)
+{
+   assert(0);
 
-      src_row += src_stride;
-   }
+   return GL_FALSE;
 }
 
-static void
-etc2_unpack_rg11(uint8_t *dst_row,
-                 unsigned dst_stride,
-                 const uint8_t *src_row,
-                 unsigned src_stride,
-                 unsigned width,
-                 unsigned height)
+GLboolean
+_mesa_texstore_etc2_rgb8_punchthrough_alpha1(UNUSED_TEXSTORE_PARAMS)
 {
-   /* If internalformat is COMPRESSED_RG11_EAC, each 4 × 4 block of
-      RG color information is compressed to 128 bits.
-   */
-   const unsigned bw = 4, bh = 4, bs = 16, comps = 2, comp_size = 2;
-   struct etc2_block block;
-   unsigned x, y, i, j;
-
-   for (y = 0; y < height; y += bh) {
-      const unsigned h = MIN2(bh, height - y);
-      const uint8_t *src = src_row;
-
-      for (x = 0; x < width; x+= bw) {
-         const unsigned w = MIN2(bw, width - x);
-         /* red component */
-         etc2_r11_parse_block(&block, src);
-
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride +
-                           x * comps * comp_size;
-            for (i = 0; i < w; i++) {
-               etc2_r11_fetch_texel(&block, i, j, dst);
-               dst += comps * comp_size;
-            }
-         }
-         /* green component */
-         etc2_r11_parse_block(&block, src + 8);
-
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride +
-                           x * comps * comp_size;
-            for (i = 0; i < w; i++) {
-               etc2_r11_fetch_texel(&block, i, j, dst + comp_size);
-               dst += comps * comp_size;
-            }
-         }
-         src += bs;
-      }
+   assert(0);
 
-      src_row += src_stride;
-   }
+   return GL_FALSE;
 }
 
-static void
-etc2_unpack_signed_r11(uint8_t *dst_row,
-                       unsigned dst_stride,
-                       const uint8_t *src_row,
-                       unsigned src_stride,
-                       unsigned width,
-                       unsigned height)
+GLboolean
+_mesa_texstore_etc2_srgb8_punchthrough_alpha1(UNUSED_TEXSTORE_PARAMS)
 {
-   /* If internalformat is COMPRESSED_SIGNED_R11_EAC, each 4 × 4 block of
-      red color information is compressed to 64 bits.
-   */
-   const unsigned bw = 4, bh = 4, bs = 8, comps = 1, comp_size = 2;
-   struct etc2_block block;
-   unsigned x, y, i, j;
-
-   for (y = 0; y < height; y += bh) {
-      const unsigned h = MIN2(bh, height - y);
-      const uint8_t *src = src_row;
-
-      for (x = 0; x < width; x+= bw) {
-         const unsigned w = MIN2(bw, width - x);
-         etc2_r11_parse_block(&block, src);
-
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride +
-                           x * comps * comp_size;
-            for (i = 0; i < w; i++) {
-               etc2_signed_r11_fetch_texel(&block, i, j, dst);
-               dst += comps * comp_size;
-            }
-         }
-         src += bs;
-      }
+   assert(0);
 
-      src_row += src_stride;
-   }
+   return GL_FALSE;
 }
 
+
+/**
+ * Get the colours of an ETC2 RGB block that isn't in planar mode, and the
+ * colour of each texel as an index into them, in column-major order.  The
+ * colours of the second subblock of an individual or differential mode block
+ * are 4 to 7.  Transparent texels of punchthrough alpha blocks are black.
+ */
 static void
-etc2_unpack_signed_rg11(uint8_t *dst_row,
-                        unsigned dst_stride,
-                        const uint8_t *src_row,
-                        unsigned src_stride,
-                        unsigned width,
-                        unsigned height)
+etc2_rgb8_block_palette(const struct etc2_block *block,
+                        bool punchthrough_alpha, bool bgra,
+                        uint8_t colors[8][4], uint8_t indices[16])
 {
-   /* If internalformat is COMPRESSED_SIGNED_RG11_EAC, each 4 × 4 block of
-      RG color information is compressed to 128 bits.
-   */
-   const unsigned bw = 4, bh = 4, bs = 16, comps = 2, comp_size = 2;
-   struct etc2_block block;
-   unsigned x, y, i, j;
-
-   for (y = 0; y < height; y += bh) {
-      const unsigned h = MIN2(bh, height - y);
-      const uint8_t *src = src_row;
-
-      for (x = 0; x < width; x+= bw) {
-         const unsigned w = MIN2(bw, width - x);
-         /* red component */
-         etc2_r11_parse_block(&block, src);
-
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride +
-                          x * comps * comp_size;
-            for (i = 0; i < w; i++) {
-               etc2_signed_r11_fetch_texel(&block, i, j, dst);
-               dst += comps * comp_size;
-            }
-         }
-         /* green component */
-         etc2_r11_parse_block(&block, src + 8);
-
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride +
-                           x * comps * comp_size;
-            for (i = 0; i < w; i++) {
-               etc2_signed_r11_fetch_texel(&block, i, j, dst + comp_size);
-               dst += comps * comp_size;
-            }
-         }
-         src += bs;
+   const unsigned r = bgra ? 2 : 0, b = bgra ? 0 : 2;
+   unsigned i;
+
+   if (block->is_ind_mode || block->is_diff_mode) {
+      for (i = 0; i < 8; i++) {
+         const uint8_t *base_color = block->base_colors[i / 4];
+         const int modifier = block->modifier_tables[i / 4][i % 4];
+
+         colors[i][r] = etc2_clamp(base_color[0] + modifier);
+         colors[i][1] = etc2_clamp(base_color[1] + modifier);
+         colors[i][b] = etc2_clamp(base_color[2] + modifier);
+         colors[i][3] = 255;
       }
+   }
+   else {
+      for (i = 0; i < 8; i++) {
+         colors[i][r] = block->paint_colors[i % 4][0];
+         colors[i][1] = block->paint_colors[i % 4][1];
+         colors[i][b] = block->paint_colors[i % 4][2];
+         colors[i][3] = 255;
+      }
+   }
 
-      src_row += src_stride;
+   if (punchthrough_alpha && !block->opaque) {
+      memset(colors[2], 0, 4);
+      memset(colors[6], 0, 4);
    }
-}
 
-static void
-etc2_unpack_rgb8_punchthrough_alpha1(uint8_t *dst_row,
-                                     unsigned dst_stride,
-                                     const uint8_t *src_row,
-                                     unsigned src_stride,
-                                     unsigned width,
-                                     unsigned height)
-{
-   const unsigned bw = 4, bh = 4, bs = 8, comps = 4;
-   struct etc2_block block;
-   unsigned x, y, i, j;
-
-   for (y = 0; y < height; y += bh) {
-      const unsigned h = MIN2(bh, height - y);
-      const uint8_t *src = src_row;
-
-      for (x = 0; x < width; x+= bw) {
-         const unsigned w = MIN2(bw, width - x);
-         etc2_rgb8_parse_block(&block, src,
-                               true /* punchthrough_alpha */);
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < w; i++) {
-               etc2_rgb8_fetch_texel(&block, i, j, dst,
-                                     true /* punchthrough_alpha */);
-               dst += comps;
-            }
-         }
+   /* The bits of the indices are in column-major order, like the indices.
+    * The second subblock is either the bottom or the right half.
+    */
+   const uint32_t bits = block->pixel_indices[0];
+   uint32_t second_subblock = 0;
 
-         src += bs;
-      }
+   if (block->is_ind_mode || block->is_diff_mode)
+      second_subblock = block->flipped ? 0xcccc : 0xff00;
 
-      src_row += src_stride;
+   for (i = 0; i < 16; i++) {
+      indices[i] = ((bits >> (15 + i)) & 0x2) |
+                   ((bits >> i) & 0x1) |
+                   (((second_subblock >> i) & 0x1) << 2);
    }
 }
 
+/**
+ * Write the texels of an ETC2 RGB block in planar mode, with an alpha of 255.
+ */
 static void
-etc2_unpack_srgb8_punchthrough_alpha1(uint8_t *dst_row,
-                                     unsigned dst_stride,
-                                     const uint8_t *src_row,
-                                     unsigned src_stride,
-                                     unsigned width,
-				     unsigned height,
-				     bool bgra)
+etc2_rgb8_write_planar(const struct etc2_block *block, bool bgra,
+                       uint8_t *dst, unsigned dst_stride)
 {
-   const unsigned bw = 4, bh = 4, bs = 8, comps = 4;
-   struct etc2_block block;
-   unsigned x, y, i, j;
-   uint8_t tmp;
-
-   for (y = 0; y < height; y += bh) {
-      const unsigned h = MIN2(bh, height - y);
-      const uint8_t *src = src_row;
-
-      for (x = 0; x < width; x+= bw) {
-         const unsigned w = MIN2(bw, width - x);
-         etc2_rgb8_parse_block(&block, src,
-                               true /* punchthrough_alpha */);
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < w; i++) {
-               etc2_rgb8_fetch_texel(&block, i, j, dst,
-                                     true /* punchthrough_alpha */);
-
-	       if (bgra) {
-		  /* Convert to MESA_FORMAT_B8G8R8A8_SRGB */
-		  tmp = dst[0];
-		  dst[0] = dst[2];
-		  dst[2] = tmp;
-		  dst[3] = dst[3];
-	       }
-
-               dst += comps;
-            }
-         }
+   const unsigned r = bgra ? 2 : 0, b = bgra ? 0 : 2;
+   int dx[3], dy[3], o[3];
+   int c, x, y;
+
+   for (c = 0; c < 3; c++) {
+      o[c] = 4 * block->base_colors[0][c] + 2;
+      dx[c] = block->base_colors[1][c] - block->base_colors[0][c];
+      dy[c] = block->base_colors[2][c] - block->base_colors[0][c];
+   }
 
-         src += bs;
-      }
+   for (y = 0; y < 4; y++) {
+      uint8_t *texel = dst + y * dst_stride;
 
-      src_row += src_stride;
+      for (x = 0; x < 4; x++) {
+         texel[r] = etc2_clamp((x * dx[0] + y * dy[0] + o[0]) >> 2);
+         texel[1] = etc2_clamp((x * dx[1] + y * dy[1] + o[1]) >> 2);
+         texel[b] = etc2_clamp((x * dx[2] + y * dy[2] + o[2]) >> 2);
+         texel[3] = 255;
+         texel += 4;
+      }
    }
 }
 
-/* ETC2 texture formats are valid in glCompressedTexImage2D and
- * glCompressedTexSubImage2D functions */
-GLboolean
-_mesa_texstore_etc2_rgb8(UNUSED_TEXSTORE_PARAMS)
+/**
+ * Get the index into the eight values of an EAC block of each texel, in
+ * column-major order.  The indices are stored the other way around, from the
+ * most significant bits.
+ */
+static void
+etc2_eac_block_indices(const struct etc2_block *block, uint8_t indices[16])
 {
-   assert(0);
+   unsigned i;
 
-   return GL_FALSE;
+   for (i = 0; i < 16; i++)
+      indices[i] = (block->pixel_indices[1] >> (45 - i * 3)) & 0x7;
 }
 
-GLboolean
-_mesa_texstore_etc2_srgb8(UNUSED_TEXSTORE_PARAMS)
+static void
+etc2_alpha8_block_palette(const struct etc2_block *block, uint8_t alphas[8])
 {
-   assert(0);
+   unsigned i;
 
-   return GL_FALSE;
+   for (i = 0; i < 8; i++) {
+      const int modifier = etc2_modifier_tables[block->table_index][i];
+
+      alphas[i] = etc2_clamp(block->base_codeword +
+                             modifier * block->multiplier);
+   }
 }
 
-GLboolean
-_mesa_texstore_etc2_rgba8_eac(UNUSED_TEXSTORE_PARAMS)
+/**
+ * Get the eight values of an R11 EAC block, extended to 16 bits the same way
+ * as etc2_r11_fetch_texel() and etc2_signed_r11_fetch_texel().
+ */
+static void
+etc2_r11_block_palette(const struct etc2_block *block, bool is_signed,
+                       uint16_t values[8])
 {
-   assert(0);
+   unsigned i;
 
-   return GL_FALSE;
-}
+   for (i = 0; i < 8; i++) {
+      const int modifier = etc2_modifier_tables[block->table_index][i];
+      GLshort color;
 
-GLboolean
-_mesa_texstore_etc2_srgb8_alpha8_eac(UNUSED_TEXSTORE_PARAMS)
-{
-   assert(0);
+      if (is_signed) {
+         GLbyte base_codeword = (GLbyte) block->base_codeword;
 
-   return GL_FALSE;
-}
+         if (base_codeword == -128)
+            base_codeword = -127;
 
-GLboolean
-_mesa_texstore_etc2_r11_eac(UNUSED_TEXSTORE_PARAMS)
-{
-   assert(0);
+         if (block->multiplier != 0)
+            color = etc2_clamp3(base_codeword * 8 +
+                                modifier * block->multiplier * 8);
+         else
+            color = etc2_clamp3(base_codeword * 8 + modifier);
 
-   return GL_FALSE;
-}
+         if (color >= 0)
+            color = (color << 5) | (color >> 5);
+         else
+            color = -((-color << 5) | (-color >> 5));
+      }
+      else {
+         if (block->multiplier != 0)
+            color = etc2_clamp2(((block->base_codeword << 3) | 0x4) +
+                                modifier * block->multiplier * 8);
+         else
+            color = etc2_clamp2(((block->base_codeword << 3) | 0x4) +
+                                modifier);
 
-GLboolean
-_mesa_texstore_etc2_signed_r11_eac(UNUSED_TEXSTORE_PARAMS)
-{
-   assert(0);
+         color = (color << 5) | (color >> 6);
+      }
 
-   return GL_FALSE;
+      values[i] = (uint16_t) color;
+   }
 }
 
-GLboolean
-_mesa_texstore_etc2_rg11_eac(UNUSED_TEXSTORE_PARAMS)
+static void
+etc2_write_rgba8_block(uint8_t *dst, unsigned dst_stride,
+                       const uint8_t colors[8][4],
+                       const uint8_t color_indices[16],
+                       const uint8_t *alphas,
+                       const uint8_t *alpha_indices)
 {
-   assert(0);
+#if defined(USE_SSE41)
+   if (util_cpu_caps.has_sse4_1) {
+      _mesa_etc2_write_rgba8_block_sse41(dst, dst_stride,
+                                         colors, color_indices,
+                                         alphas, alpha_indices);
+      return;
+   }
+#endif
 
-   return GL_FALSE;
+   for (unsigned y = 0; y < 4; y++) {
+      uint8_t *texel = dst + y * dst_stride;
+
+      for (unsigned x = 0; x < 4; x++) {
+         memcpy(texel, colors[color_indices[x * 4 + y]], 4);
+         if (alphas)
+            texel[3] = alphas[alpha_indices[x * 4 + y]];
+         texel += 4;
+      }
+   }
 }
 
-GLboolean
-_mesa_texstore_etc2_signed_rg11_eac(UNUSED_TEXSTORE_PARAMS)
+static void
+etc2_write_r11_block(uint8_t *dst, unsigned dst_stride,
+                     const uint16_t red[8],
+                     const uint8_t red_indices[16],
+                     const uint16_t *green,
+                     const uint8_t *green_indices)
 {
-   assert(0);
+#if defined(USE_SSE41)
+   if (util_cpu_caps.has_sse4_1) {
+      _mesa_etc2_write_r11_block_sse41(dst, dst_stride,
+                                       red, red_indices,
+                                       green, green_indices);
+      return;
+   }
+#endif
 
-   return GL_FALSE;
+   for (unsigned y = 0; y < 4; y++) {
+      uint16_t *texel = (uint16_t *) (dst + y * dst_stride);
+
+      for (unsigned x = 0; x < 4; x++) {
+         *texel++ = red[red_indices[x * 4 + y]];
+         if (green)
+            *texel++ = green[green_indices[x * 4 + y]];
+      }
+   }
 }
 
-GLboolean
-_mesa_texstore_etc2_rgb8_punchthrough_alpha1(UNUSED_TEXSTORE_PARAMS)
+struct etc2_decode_job {
+   uint8_t *dst_row;
+   unsigned dst_stride;
+   const uint8_t *src_row;
+   unsigned src_stride;
+   unsigned width;
+   unsigned height;
+   mesa_format format;
+   bool bgra;
+};
+
+/**
+ * Decode whole blocks: each block is parsed once, and its texels are written
+ * from the few colours the block can have.  Blocks that would go past the
+ * edges of the image are decoded to a temporary block first.
+ */
+static void
+etc2_decode_rows(void *data, unsigned first_row, unsigned num_rows)
 {
-   assert(0);
+   const struct etc2_decode_job *job = data;
+   const mesa_format format = job->format;
+   const bool is_r11 = format == MESA_FORMAT_ETC2_R11_EAC ||
+                       format == MESA_FORMAT_ETC2_SIGNED_R11_EAC;
+   const bool is_rg11 = format == MESA_FORMAT_ETC2_RG11_EAC ||
+                        format == MESA_FORMAT_ETC2_SIGNED_RG11_EAC;
+   const bool is_signed = format == MESA_FORMAT_ETC2_SIGNED_R11_EAC ||
+                          format == MESA_FORMAT_ETC2_SIGNED_RG11_EAC;
+   const bool has_eac_alpha = format == MESA_FORMAT_ETC2_RGBA8_EAC ||
+                              format == MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC;
+   const bool punchthrough_alpha =
+      format == MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1 ||
+      format == MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1;
+   /* Only the sRGB formats can be decoded to BGRA. */
+   const bool bgra = job->bgra && _mesa_is_format_srgb(format);
+   const unsigned bs = (is_rg11 || has_eac_alpha) ? 16 : 8;
+   const unsigned texel_size = is_r11 ? 2 : 4;
+   struct etc2_block block;
+   unsigned x, y, j;
+
+   for (y = first_row; y < first_row + num_rows; y++) {
+      const uint8_t *src = job->src_row + y * job->src_stride;
+      const unsigned h = MIN2(4, job->height - y * 4);
+
+      for (x = 0; x < job->width; x += 4) {
+         const unsigned w = MIN2(4, job->width - x);
+         uint8_t *dst = job->dst_row + y * 4 * job->dst_stride +
+                        x * texel_size;
+         uint8_t tmp[4 * 4 * 4];
+         uint8_t *out = dst;
+         unsigned out_stride = job->dst_stride;
+
+         if (w < 4 || h < 4) {
+            out = tmp;
+            out_stride = 4 * texel_size;
+         }
 
-   return GL_FALSE;
-}
+         if (is_r11 || is_rg11) {
+            uint16_t values[2][8];
+            uint8_t indices[2][16];
 
-GLboolean
-_mesa_texstore_etc2_srgb8_punchthrough_alpha1(UNUSED_TEXSTORE_PARAMS)
-{
-   assert(0);
+            etc2_r11_parse_block(&block, src);
+            etc2_r11_block_palette(&block, is_signed, values[0]);
+            etc2_eac_block_indices(&block, indices[0]);
 
-   return GL_FALSE;
-}
+            if (is_rg11) {
+               etc2_r11_parse_block(&block, src + 8);
+               etc2_r11_block_palette(&block, is_signed, values[1]);
+               etc2_eac_block_indices(&block, indices[1]);
+            }
+
+            etc2_write_r11_block(out, out_stride, values[0], indices[0],
+                                 is_rg11 ? values[1] : NULL, indices[1]);
+         }
+         else {
+            uint8_t colors[8][4], color_indices[16];
+            uint8_t alphas[8], alpha_indices[16];
 
+            etc2_rgb8_parse_block(&block, has_eac_alpha ? src + 8 : src,
+                                  punchthrough_alpha);
+
+            if (has_eac_alpha) {
+               etc2_alpha8_parse_block(&block, src);
+               etc2_alpha8_block_palette(&block, alphas);
+               etc2_eac_block_indices(&block, alpha_indices);
+            }
+
+            if (block.is_planar_mode) {
+               etc2_rgb8_write_planar(&block, bgra, out, out_stride);
+
+               if (has_eac_alpha) {
+                  for (j = 0; j < 16; j++) {
+                     out[(j % 4) * out_stride + (j / 4) * 4 + 3] =
+                        alphas[alpha_indices[j]];
+                  }
+               }
+            }
+            else {
+               etc2_rgb8_block_palette(&block, punchthrough_alpha, bgra,
+                                       colors, color_indices);
+               etc2_write_rgba8_block(out, out_stride,
+                                      (const uint8_t (*)[4]) colors,
+                                      color_indices,
+                                      has_eac_alpha ? alphas : NULL,
+                                      alpha_indices);
+            }
+         }
+
+         if (out == tmp) {
+            for (j = 0; j < h; j++) {
+               memcpy(dst + j * job->dst_stride, tmp + j * out_stride,
+                      w * texel_size);
+            }
+         }
+
+         src += bs;
+      }
+   }
+}
 
 /**
  * Decode texture data in any one of following formats:
@@ -1207,6 +1105,9 @@ _mesa_texstore_etc2_srgb8_punchthrough_alpha1(UNUSED_TEXSTORE_PARAMS)
  * The size of the source data must be a multiple of the ETC2 block size
  * even if the texture image's dimensions are not aligned to 4.
  *
+ * The image is decoded a whole block at a time, and large images are split
+ * into bands of block rows that are decoded in parallel.
+ *
  * \param src_width in pixels
  * \param src_height in pixels
  * \param dst_stride in bytes
@@ -1222,46 +1123,22 @@ _mesa_unpack_etc2_format(uint8_t *dst_row,
 			 mesa_format format,
 			 bool bgra)
 {
-   if (format == MESA_FORMAT_ETC2_RGB8)
-      etc2_unpack_rgb8(dst_row, dst_stride,
-                       src_row, src_stride,
-                       src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_SRGB8)
-      etc2_unpack_srgb8(dst_row, dst_stride,
-                        src_row, src_stride,
-			src_width, src_height, bgra);
-   else if (format == MESA_FORMAT_ETC2_RGBA8_EAC)
-      etc2_unpack_rgba8(dst_row, dst_stride,
-                        src_row, src_stride,
-                        src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC)
-      etc2_unpack_srgb8_alpha8(dst_row, dst_stride,
-                               src_row, src_stride,
-			       src_width, src_height, bgra);
-   else if (format == MESA_FORMAT_ETC2_R11_EAC)
-      etc2_unpack_r11(dst_row, dst_stride,
-                      src_row, src_stride,
-                      src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_RG11_EAC)
-      etc2_unpack_rg11(dst_row, dst_stride,
-                       src_row, src_stride,
-                       src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_SIGNED_R11_EAC)
-      etc2_unpack_signed_r11(dst_row, dst_stride,
-                             src_row, src_stride,
-                             src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_SIGNED_RG11_EAC)
-      etc2_unpack_signed_rg11(dst_row, dst_stride,
-                              src_row, src_stride,
-                              src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1)
-      etc2_unpack_rgb8_punchthrough_alpha1(dst_row, dst_stride,
-                                           src_row, src_stride,
-                                           src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1)
-      etc2_unpack_srgb8_punchthrough_alpha1(dst_row, dst_stride,
-                                            src_row, src_stride,
-					    src_width, src_height, bgra);
+   struct etc2_decode_job job;
+
+   util_cpu_detect();
+
+   job.dst_row = dst_row;
+   job.dst_stride = dst_stride;
+   job.src_row = src_row;
+   job.src_stride = src_stride;
+   job.width = src_width;
+   job.height = src_height;
+   job.format = format;
+   job.bgra = bgra;
+
+   util_format_block_rows_parallel(DIV_ROUND_UP(src_width, 4),
+                                   DIV_ROUND_UP(src_height, 4),
+                                   etc2_decode_rows, &job);
 }
 
 
@@ -0,0 +1,119 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "main/texcompress_etc_sse41.h"
+#include <smmintrin.h>
+
+/**
+ * Writes an RGBA8 block.  The colours of \p colors are in the order the
+ * texels are stored in.  If \p alphas isn't NULL, the alpha of each texel
+ * is looked up in it instead, with \p alpha_indices.
+ *
+ * Each row of texels is one vector: the palette index of each texel is
+ * turned into the offsets of its four bytes in the palette, and the bytes
+ * are picked with a shuffle from each half of the palette.
+ */
+void
+_mesa_etc2_write_rgba8_block_sse41(uint8_t *dst, unsigned dst_stride,
+                                   const uint8_t colors[8][4],
+                                   const uint8_t color_indices[16],
+                                   const uint8_t *alphas,
+                                   const uint8_t *alpha_indices)
+{
+   const __m128i lo = _mm_loadu_si128((const __m128i *) colors[0]);
+   const __m128i hi = _mm_loadu_si128((const __m128i *) colors[4]);
+   const __m128i indices = _mm_loadu_si128((const __m128i *) color_indices);
+   const __m128i byte_offsets = _mm_set1_epi32(0x03020100);
+   const __m128i columns = _mm_setr_epi8(0, 0, 0, 0, 4, 4, 4, 4,
+                                         8, 8, 8, 8, 12, 12, 12, 12);
+   __m128i a = _mm_setzero_si128();
+
+   if (alphas) {
+      a = _mm_shuffle_epi8(_mm_loadl_epi64((const __m128i *) alphas),
+                           _mm_loadu_si128((const __m128i *) alpha_indices));
+   }
+
+   for (char y = 0; y < 4; y++) {
+      /* The index of each texel of the row, in each byte of the texel. */
+      const __m128i row = _mm_add_epi8(_mm_set1_epi8(y), columns);
+      __m128i idx = _mm_shuffle_epi8(indices, row);
+      __m128i sel = _mm_add_epi8(_mm_slli_epi16(_mm_and_si128(idx,
+                                                    _mm_set1_epi8(3)), 2),
+                                 byte_offsets);
+
+      /* Bit 2 of the index picks the half of the palette. */
+      __m128i texels = _mm_blendv_epi8(_mm_shuffle_epi8(lo, sel),
+                                       _mm_shuffle_epi8(hi, sel),
+                                       _mm_slli_epi16(idx, 5));
+
+      if (alphas) {
+         /* Only the last byte of each texel is taken from the alphas. */
+         const __m128i not_alpha = _mm_set1_epi32(0x00808080);
+         __m128i row_a = _mm_shuffle_epi8(a, _mm_or_si128(row, not_alpha));
+         texels = _mm_blendv_epi8(texels, row_a, _mm_set1_epi32(0xff000000));
+      }
+
+      _mm_storeu_si128((__m128i *) (dst + y * dst_stride), texels);
+   }
+}
+
+/**
+ * Writes an R16 block from \p red, or an RG16 block if \p green isn't NULL.
+ * The values are picked the same way as the colours of an RGBA8 block, two
+ * bytes at a time.
+ */
+void
+_mesa_etc2_write_r11_block_sse41(uint8_t *dst, unsigned dst_stride,
+                                 const uint16_t red[8],
+                                 const uint8_t red_indices[16],
+                                 const uint16_t *green,
+                                 const uint8_t *green_indices)
+{
+   const __m128i r = _mm_loadu_si128((const __m128i *) red);
+   const __m128i r_idx = _mm_loadu_si128((const __m128i *) red_indices);
+   const __m128i byte_offsets = _mm_set1_epi16(0x0100);
+   const __m128i columns = _mm_setr_epi8(0, 0, 4, 4, 8, 8, 12, 12,
+                                         0, 0, 0, 0, 0, 0, 0, 0);
+   __m128i g = _mm_setzero_si128(), g_idx = _mm_setzero_si128();
+
+   if (green) {
+      g = _mm_loadu_si128((const __m128i *) green);
+      g_idx = _mm_loadu_si128((const __m128i *) green_indices);
+   }
+
+   for (char y = 0; y < 4; y++) {
+      const __m128i spread = _mm_add_epi8(_mm_set1_epi8(y), columns);
+      __m128i sel = _mm_shuffle_epi8(r_idx, spread);
+      sel = _mm_add_epi8(_mm_add_epi8(sel, sel), byte_offsets);
+      __m128i texels = _mm_shuffle_epi8(r, sel);
+
+      if (green) {
+         sel = _mm_shuffle_epi8(g_idx, spread);
+         sel = _mm_add_epi8(_mm_add_epi8(sel, sel), byte_offsets);
+         texels = _mm_unpacklo_epi16(texels, _mm_shuffle_epi8(g, sel));
+         _mm_storeu_si128((__m128i *) (dst + y * dst_stride), texels);
+      } else {
+         _mm_storel_epi64((__m128i *) (dst + y * dst_stride), texels);
+      }
+   }
+}
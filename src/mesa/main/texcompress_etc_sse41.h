@@ -0,0 +1,50 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef TEXCOMPRESS_ETC_SSE41_H
+#define TEXCOMPRESS_ETC_SSE41_H
+
+#include <stdint.h>
+
+/*
+ * Once an ETC2 or EAC block is parsed, every texel of it is one of at most
+ * eight colours or values.  These write a whole 4x4 block, given the
+ * palette of the block and the palette index of each texel.  The indices
+ * are in column-major order, like the bits they come from.
+ */
+
+void
+_mesa_etc2_write_rgba8_block_sse41(uint8_t *dst, unsigned dst_stride,
+                                   const uint8_t colors[8][4],
+                                   const uint8_t color_indices[16],
+                                   const uint8_t *alphas,
+                                   const uint8_t *alpha_indices);
+
+void
+_mesa_etc2_write_r11_block_sse41(uint8_t *dst, unsigned dst_stride,
+                                 const uint16_t red[8],
+                                 const uint8_t red_indices[16],
+                                 const uint16_t *green,
+                                 const uint8_t *green_indices);
+
+#endif /* TEXCOMPRESS_ETC_SSE41_H */
@@ -31,6 +31,16 @@
 #include <GL/gl.h>
 #endif
 
+#include <string.h>
+
+#include "util/format/u_format_compress.h"
+#include "util/macros.h"
+
+#if defined(__SSE2__) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || defined(_M_X64)
+#include <emmintrin.h>
+#define TX_COMPRESS_USE_SSE2 1
+#endif
+
 typedef GLubyte GLchan;
 #define UBYTE_TO_CHAN(b)  (b)
 #define CHAN_MAX 255
@@ -890,6 +900,185 @@ static void encodedxt5alpha(GLubyte *blkaddr, GLubyte srccolors[4][4][4],
    }
 }
 
+/* the dxt color index of each of the four colors going from color1 to color0 */
+static const GLubyte dxtcolorindexfromstep[4] = { 1, 3, 2, 0 };
+
+/* Real-time encoder for the fast quality preset: instead of searching for
+   the base colors, take the corners of the bounding box of the texels, and
+   give each texel the color nearest to its projection on the line between
+   them. */
+static void encodedxtcolorblockfast( GLubyte *blkaddr, GLubyte srccolors[4][4][4],
+                         GLint numxpixels, GLint numypixels, GLuint type )
+{
+   GLubyte block[4][4][4];
+   GLubyte mincolor[4], maxcolor[4];
+   GLushort color0, color1;
+   GLint basecolor[3], axis[3], axislen2;
+   GLint steps[4][4];
+   GLuint bits = 0;
+   GLint i, j, c;
+   GLfloat scale;
+
+   /* transparent texels of rgba dxt1 blocks need the 3-color encoding, leave
+      those blocks to the full search */
+   if (type == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT) {
+      for (j = 0; j < numypixels; j++) {
+         for (i = 0; i < numxpixels; i++) {
+            if (srccolors[j][i][3] <= ALPHACUT) {
+               encodedxtcolorblockfaster(blkaddr, srccolors, numxpixels, numypixels, type);
+               return;
+            }
+         }
+      }
+   }
+
+   /* pad partial blocks by repeating their texels, so all 16 texels count */
+   for (j = 0; j < 4; j++) {
+      for (i = 0; i < 4; i++) {
+         memcpy(block[j][i], srccolors[j % numypixels][i % numxpixels], 4);
+      }
+   }
+
+#ifdef TX_COMPRESS_USE_SSE2
+   {
+      __m128i row0 = _mm_loadu_si128((const __m128i *)block[0]);
+      __m128i row1 = _mm_loadu_si128((const __m128i *)block[1]);
+      __m128i row2 = _mm_loadu_si128((const __m128i *)block[2]);
+      __m128i row3 = _mm_loadu_si128((const __m128i *)block[3]);
+      __m128i vmin = _mm_min_epu8(_mm_min_epu8(row0, row1), _mm_min_epu8(row2, row3));
+      __m128i vmax = _mm_max_epu8(_mm_max_epu8(row0, row1), _mm_max_epu8(row2, row3));
+      GLuint packed;
+
+      vmin = _mm_min_epu8(vmin, _mm_srli_si128(vmin, 8));
+      vmin = _mm_min_epu8(vmin, _mm_srli_si128(vmin, 4));
+      vmax = _mm_max_epu8(vmax, _mm_srli_si128(vmax, 8));
+      vmax = _mm_max_epu8(vmax, _mm_srli_si128(vmax, 4));
+      packed = _mm_cvtsi128_si32(vmin);
+      memcpy(mincolor, &packed, 4);
+      packed = _mm_cvtsi128_si32(vmax);
+      memcpy(maxcolor, &packed, 4);
+   }
+#else
+   memcpy(mincolor, block[0][0], 4);
+   memcpy(maxcolor, block[0][0], 4);
+   for (j = 0; j < 4; j++) {
+      for (i = 0; i < 4; i++) {
+         for (c = 0; c < 3; c++) {
+            mincolor[c] = MIN2(mincolor[c], block[j][i][c]);
+            maxcolor[c] = MAX2(maxcolor[c], block[j][i][c]);
+         }
+      }
+   }
+#endif
+
+   /* the corners of the bounding box are rarely hit by the texels, move
+      them inwards a little */
+   for (c = 0; c < 3; c++) {
+      GLubyte inset = (maxcolor[c] - mincolor[c]) >> 4;
+      mincolor[c] += inset;
+      maxcolor[c] -= inset;
+   }
+
+   color0 = (maxcolor[0] & 0xf8) << 8 | (maxcolor[1] & 0xfc) << 3 | maxcolor[2] >> 3;
+   color1 = (mincolor[0] & 0xf8) << 8 | (mincolor[1] & 0xfc) << 3 | mincolor[2] >> 3;
+
+   /* color0 > color1 selects the 4-color encoding, which is always the case
+      unless the block is a single color */
+   if (color0 != color1) {
+      basecolor[0] = EXP5TO8R(color1);
+      basecolor[1] = EXP6TO8G(color1);
+      basecolor[2] = EXP5TO8B(color1);
+      axis[0] = EXP5TO8R(color0) - basecolor[0];
+      axis[1] = EXP6TO8G(color0) - basecolor[1];
+      axis[2] = EXP5TO8B(color0) - basecolor[2];
+      axislen2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+      scale = 3.0f / axislen2;
+
+#ifdef TX_COMPRESS_USE_SSE2
+      {
+         const __m128i zero = _mm_setzero_si128();
+         const __m128i base = _mm_setr_epi16(basecolor[0], basecolor[1], basecolor[2], 0,
+                                             basecolor[0], basecolor[1], basecolor[2], 0);
+         const __m128i dir = _mm_setr_epi16(axis[0], axis[1], axis[2], 0,
+                                            axis[0], axis[1], axis[2], 0);
+         const __m128 vscale = _mm_set1_ps(scale);
+         const __m128 half = _mm_set1_ps(0.5f);
+
+         for (j = 0; j < 4; j++) {
+            __m128i row = _mm_loadu_si128((const __m128i *)block[j]);
+            __m128i lo = _mm_madd_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(row, zero), base), dir);
+            __m128i hi = _mm_madd_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(row, zero), base), dir);
+            /* add up the r+g and b+a halves of the dot products */
+            __m128 even = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi),
+                                         _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi),
+                                        _MM_SHUFFLE(3, 1, 3, 1));
+            __m128i dot = _mm_add_epi32(_mm_castps_si128(even), _mm_castps_si128(odd));
+            __m128 step = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(dot), vscale), half);
+
+            _mm_storeu_si128((__m128i *)steps[j], _mm_cvttps_epi32(step));
+         }
+      }
+#else
+      for (j = 0; j < 4; j++) {
+         for (i = 0; i < 4; i++) {
+            GLint dot = 0;
+            for (c = 0; c < 3; c++)
+               dot += (block[j][i][c] - basecolor[c]) * axis[c];
+            steps[j][i] = (GLint)((GLfloat)dot * scale + 0.5f);
+         }
+      }
+#endif
+
+      for (j = 0; j < 4; j++) {
+         for (i = 0; i < 4; i++) {
+            bits |= (GLuint)dxtcolorindexfromstep[CLAMP(steps[j][i], 0, 3)] << (2 * (j * 4 + i));
+         }
+      }
+   }
+
+   *blkaddr++ = color0 & 0xff;
+   *blkaddr++ = color0 >> 8;
+   *blkaddr++ = color1 & 0xff;
+   *blkaddr++ = color1 >> 8;
+   *blkaddr++ = bits & 0xff;
+   *blkaddr++ = ( bits >> 8) & 0xff;
+   *blkaddr++ = ( bits >> 16) & 0xff;
+   *blkaddr = bits >> 24;
+}
+
+/* alpha counterpart of encodedxtcolorblockfast: use the lowest and highest
+   alpha in the block with the 8-alpha encoding, and round each alpha to the
+   nearest of the interpolated values */
+static void encodedxt5alphafast(GLubyte *blkaddr, GLubyte srccolors[4][4][4],
+                            GLint numxpixels, GLint numypixels)
+{
+   GLubyte alphaenc[16] = { 0 };
+   GLubyte alphamin = 0xff, alphamax = 0;
+   GLint i, j, range, step;
+
+   for (j = 0; j < numypixels; j++) {
+      for (i = 0; i < numxpixels; i++) {
+         alphamin = MIN2(alphamin, srccolors[j][i][3]);
+         alphamax = MAX2(alphamax, srccolors[j][i][3]);
+      }
+   }
+
+   range = alphamax - alphamin;
+   if (range > 0) {
+      for (j = 0; j < numypixels; j++) {
+         for (i = 0; i < numxpixels; i++) {
+            step = ((srccolors[j][i][3] - alphamin) * 14 + range) / (2 * range);
+            /* alpha0 (the highest) is index 0, alpha1 index 1, and the
+               interpolated values are 2-7 going down from alpha0 */
+            alphaenc[j * 4 + i] = step == 7 ? 0 : step == 0 ? 1 : 8 - step;
+         }
+      }
+   }
+
+   writedxt5encodedalphablock(blkaddr, alphamax, alphamin, alphaenc);
+}
+
 static void extractsrccolors( GLubyte srcpixels[4][4][4], const GLchan *srcaddr,
                          GLint srcRowStride, GLint numxpixels, GLint numypixels, GLint comps)
 {
@@ -906,50 +1095,49 @@ static void extractsrccolors( GLubyte srcpixels[4][4][4], const GLchan *srcaddr,
 }
 
 
-static void tx_compress_dxtn(GLint srccomps, GLint width, GLint height, const GLubyte *srcPixData,
-                     GLenum destFormat, GLubyte *dest, GLint dstRowStride)
-{
-      GLubyte *blkaddr = dest;
-      GLubyte srcpixels[4][4][4];
-      const GLchan *srcaddr = srcPixData;
-      GLint numxpixels, numypixels;
-      GLint i, j;
-      GLint dstRowDiff;
+struct tx_compress_dxtn_job {
+   GLint srccomps;
+   GLint width, height;
+   const GLubyte *srcPixData;
+   GLenum destFormat;
+   GLubyte *dest;
+   GLint dstRowPitch;
+   GLboolean fast;
+};
 
-   switch (destFormat) {
-   case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
-   case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
-      /* hmm we used to get called without dstRowStride... */
-      dstRowDiff = dstRowStride >= (width * 2) ? dstRowStride - (((width + 3) & ~3) * 2) : 0;
-/*      fprintf(stderr, "dxt1 tex width %d tex height %d dstRowStride %d\n",
-              width, height, dstRowStride); */
-      for (j = 0; j < height; j += 4) {
-         if (height > j + 3) numypixels = 4;
-         else numypixels = height - j;
-         srcaddr = srcPixData + j * width * srccomps;
-         for (i = 0; i < width; i += 4) {
-            if (width > i + 3) numxpixels = 4;
-            else numxpixels = width - i;
-            extractsrccolors(srcpixels, srcaddr, width, numxpixels, numypixels, srccomps);
-            encodedxtcolorblockfaster(blkaddr, srcpixels, numxpixels, numypixels, destFormat);
-            srcaddr += srccomps * numxpixels;
+static void tx_compress_dxtn_rows(void *data, unsigned first_row, unsigned num_rows)
+{
+   const struct tx_compress_dxtn_job *job = data;
+   const GLint srccomps = job->srccomps;
+   const GLint width = job->width;
+   const GLenum destFormat = job->destFormat;
+   GLubyte srcpixels[4][4][4];
+   GLint numxpixels, numypixels;
+   GLint i, j;
+   unsigned row;
+
+   for (row = first_row; row < first_row + num_rows; row++) {
+      GLubyte *blkaddr = job->dest + row * job->dstRowPitch;
+      const GLchan *srcaddr;
+
+      j = row * 4;
+      if (job->height > j + 3) numypixels = 4;
+      else numypixels = job->height - j;
+      srcaddr = job->srcPixData + j * width * srccomps;
+      for (i = 0; i < width; i += 4) {
+         if (width > i + 3) numxpixels = 4;
+         else numxpixels = width - i;
+         extractsrccolors(srcpixels, srcaddr, width, numxpixels, numypixels, srccomps);
+         switch (destFormat) {
+         case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+         case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+            if (job->fast)
+               encodedxtcolorblockfast(blkaddr, srcpixels, numxpixels, numypixels, destFormat);
+            else
+               encodedxtcolorblockfaster(blkaddr, srcpixels, numxpixels, numypixels, destFormat);
             blkaddr += 8;
-         }
-         blkaddr += dstRowDiff;
-      }
-      break;
-   case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
-      dstRowDiff = dstRowStride >= (width * 4) ? dstRowStride - (((width + 3) & ~3) * 4) : 0;
-/*      fprintf(stderr, "dxt3 tex width %d tex height %d dstRowStride %d\n",
-              width, height, dstRowStride); */
-      for (j = 0; j < height; j += 4) {
-         if (height > j + 3) numypixels = 4;
-         else numypixels = height - j;
-         srcaddr = srcPixData + j * width * srccomps;
-         for (i = 0; i < width; i += 4) {
-            if (width > i + 3) numxpixels = 4;
-            else numxpixels = width - i;
-            extractsrccolors(srcpixels, srcaddr, width, numxpixels, numypixels, srccomps);
+            break;
+         case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
             *blkaddr++ = (srcpixels[0][0][3] >> 4) | (srcpixels[0][1][3] & 0xf0);
             *blkaddr++ = (srcpixels[0][2][3] >> 4) | (srcpixels[0][3][3] & 0xf0);
             *blkaddr++ = (srcpixels[1][0][3] >> 4) | (srcpixels[1][1][3] & 0xf0);
@@ -958,37 +1146,66 @@ static void tx_compress_dxtn(GLint srccomps, GLint width, GLint height, const GL
             *blkaddr++ = (srcpixels[2][2][3] >> 4) | (srcpixels[2][3][3] & 0xf0);
             *blkaddr++ = (srcpixels[3][0][3] >> 4) | (srcpixels[3][1][3] & 0xf0);
             *blkaddr++ = (srcpixels[3][2][3] >> 4) | (srcpixels[3][3][3] & 0xf0);
-            encodedxtcolorblockfaster(blkaddr, srcpixels, numxpixels, numypixels, destFormat);
-            srcaddr += srccomps * numxpixels;
+            if (job->fast)
+               encodedxtcolorblockfast(blkaddr, srcpixels, numxpixels, numypixels, destFormat);
+            else
+               encodedxtcolorblockfaster(blkaddr, srcpixels, numxpixels, numypixels, destFormat);
             blkaddr += 8;
+            break;
+         case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+            if (job->fast) {
+               encodedxt5alphafast(blkaddr, srcpixels, numxpixels, numypixels);
+               encodedxtcolorblockfast(blkaddr + 8, srcpixels, numxpixels, numypixels, destFormat);
+            }
+            else {
+               encodedxt5alpha(blkaddr, srcpixels, numxpixels, numypixels);
+               encodedxtcolorblockfaster(blkaddr + 8, srcpixels, numxpixels, numypixels, destFormat);
+            }
+            blkaddr += 16;
+            break;
+         default:
+            assert(false);
+            return;
          }
-         blkaddr += dstRowDiff;
+         srcaddr += srccomps * numxpixels;
       }
+   }
+}
+
+static void tx_compress_dxtn(GLint srccomps, GLint width, GLint height, const GLubyte *srcPixData,
+                     GLenum destFormat, GLubyte *dest, GLint dstRowStride)
+{
+   struct tx_compress_dxtn_job job;
+   GLint blockbytes;
+
+   switch (destFormat) {
+   case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+   case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+      blockbytes = 8;
       break;
+   case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
-      dstRowDiff = dstRowStride >= (width * 4) ? dstRowStride - (((width + 3) & ~3) * 4) : 0;
-/*      fprintf(stderr, "dxt5 tex width %d tex height %d dstRowStride %d\n",
-              width, height, dstRowStride); */
-      for (j = 0; j < height; j += 4) {
-         if (height > j + 3) numypixels = 4;
-         else numypixels = height - j;
-         srcaddr = srcPixData + j * width * srccomps;
-         for (i = 0; i < width; i += 4) {
-            if (width > i + 3) numxpixels = 4;
-            else numxpixels = width - i;
-            extractsrccolors(srcpixels, srcaddr, width, numxpixels, numypixels, srccomps);
-            encodedxt5alpha(blkaddr, srcpixels, numxpixels, numypixels);
-            encodedxtcolorblockfaster(blkaddr + 8, srcpixels, numxpixels, numypixels, destFormat);
-            srcaddr += srccomps * numxpixels;
-            blkaddr += 16;
-         }
-         blkaddr += dstRowDiff;
-      }
+      blockbytes = 16;
       break;
    default:
       assert(false);
       return;
    }
+
+   job.srccomps = srccomps;
+   job.width = width;
+   job.height = height;
+   job.srcPixData = srcPixData;
+   job.destFormat = destFormat;
+   job.dest = dest;
+   /* hmm we used to get called without dstRowStride... */
+   job.dstRowPitch = dstRowStride >= (width * blockbytes / 4) ?
+                     dstRowStride : ((width + 3) / 4) * blockbytes;
+   job.fast = util_format_get_compress_quality() == UTIL_FORMAT_COMPRESS_QUALITY_FAST;
+
+   /* every band of block rows is encoded independently */
+   util_format_block_rows_parallel((width + 3) / 4, (height + 3) / 4,
+                                   tx_compress_dxtn_rows, &job);
 }
 
 #endif
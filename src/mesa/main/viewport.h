@@ -56,6 +56,10 @@ _mesa_ViewportIndexedfv_no_error(GLuint index, const GLfloat * v);
 extern void GLAPIENTRY
 _mesa_ViewportIndexedfv(GLuint index, const GLfloat * v);
 
+extern void
+_mesa_clamp_viewport(struct gl_context *ctx, GLfloat *x, GLfloat *y,
+                     GLfloat *width, GLfloat *height);
+
 extern void 
 _mesa_set_viewport(struct gl_context *ctx, unsigned idx, GLfloat x, GLfloat y,
                    GLfloat width, GLfloat height);
@@ -50,6 +50,7 @@
 #include "compiler/glsl/gl_nir_linker.h"
 #include "compiler/glsl/ir.h"
 #include "compiler/glsl/ir_optimization.h"
+#include "compiler/glsl/linker_util.h"
 #include "compiler/glsl/string_to_uint_map.h"
 
 static int
@@ -379,10 +380,6 @@ st_nir_preprocess(struct st_context *st, struct gl_program *prog,
    }
 
    nir_shader_gather_info(nir, nir_shader_get_entrypoint(nir));
-   if (!st->ctx->SoftFP64 && nir->info.uses_64bit &&
-       (options->lower_doubles_options & nir_lower_fp64_full_software) != 0) {
-      st->ctx->SoftFP64 = glsl_float64_funcs_to_nir(st->ctx, options);
-   }
 
    /* ES has strict SSO validation rules for shader IO matching so we can't
     * remove dead IO until the resource list has been built. Here we skip
@@ -432,6 +429,19 @@ st_nir_preprocess(struct st_context *st, struct gl_program *prog,
    NIR_PASS_V(nir, nir_opt_constant_folding);
 }
 
+/* Builds the fp64 software library the first time a shader needs it.  This
+ * has to run after st_nir_preprocess(), outside of link_util_parallel_for().
+ */
+static void
+st_nir_init_soft_fp64(struct st_context *st, nir_shader *nir)
+{
+   if (!st->ctx->SoftFP64 && nir->info.uses_64bit &&
+       (nir->options->lower_doubles_options &
+        nir_lower_fp64_full_software) != 0) {
+      st->ctx->SoftFP64 = glsl_float64_funcs_to_nir(st->ctx, nir->options);
+   }
+}
+
 /* Second third of converting glsl_to_nir. This creates uniforms, gathers
  * info on varyings, etc after NIR link time opts have been applied.
  */
@@ -485,7 +495,15 @@ st_glsl_to_nir_post_opts(struct st_context *st, struct gl_program *prog,
    _mesa_associate_uniform_storage(st->ctx, shader_program, prog);
 
    st_set_prog_affected_state_flags(prog);
+}
 
+/* The NIR lowering and optimization part of st_glsl_to_nir_post_opts().  It
+ * only touches \p nir, so it runs for all stages in parallel.
+ */
+static void
+st_glsl_to_nir_lower(struct st_context *st, nir_shader *nir,
+                     struct gl_shader_program *shader_program)
+{
    /* None of the builtins being lowered here can be produced by SPIR-V.  See
     * _mesa_builtin_uniform_desc. Also drivers that support packed uniform
     * storage don't need to lower builtins.
@@ -522,6 +540,16 @@ st_glsl_to_nir_post_opts(struct st_context *st, struct gl_program *prog,
       NIR_PASS_V(nir, nir_lower_atomics_to_ssbo);
 
    st_finalize_nir_before_variants(nir);
+}
+
+/* The part of st_glsl_to_nir_post_opts() that runs after
+ * st_glsl_to_nir_lower().  It goes through the pipe_screen.
+ */
+static void
+st_glsl_to_nir_finish(struct st_context *st, struct gl_program *prog,
+                      struct gl_shader_program *shader_program)
+{
+   nir_shader *nir = prog->nir;
 
    if (st->allow_st_finalize_nir_twice)
       st_finalize_nir(st, prog, shader_program, nir, true);
@@ -652,6 +680,40 @@ st_nir_lower_wpos_ytransform(struct nir_shader *nir,
    }
 }
 
+struct st_glsl_to_nir_state {
+   struct st_context *st;
+   struct gl_shader_program *shader_program;
+   struct gl_linked_shader **linked_shader;
+};
+
+static void
+st_glsl_to_nir_stage(void *data, unsigned index)
+{
+   struct st_glsl_to_nir_state *state = (struct st_glsl_to_nir_state *)data;
+   struct st_context *st = state->st;
+   struct gl_linked_shader *shader = state->linked_shader[index];
+   struct gl_program *prog = shader->Program;
+   const nir_shader_compiler_options *options =
+      st->ctx->Const.ShaderCompilerOptions[shader->Stage].NirOptions;
+
+   prog->nir = glsl_to_nir(st->ctx, state->shader_program, shader->Stage,
+                           options);
+   st_nir_preprocess(st, prog, state->shader_program, shader->Stage);
+
+   if (options->lower_to_scalar) {
+      NIR_PASS_V(prog->nir, nir_lower_load_const_to_scalar);
+   }
+}
+
+static void
+st_glsl_to_nir_lower_stage(void *data, unsigned index)
+{
+   struct st_glsl_to_nir_state *state = (struct st_glsl_to_nir_state *)data;
+
+   st_glsl_to_nir_lower(state->st, state->linked_shader[index]->Program->nir,
+                        state->shader_program);
+}
+
 bool
 st_link_nir(struct gl_context *ctx,
             struct gl_shader_program *shader_program)
@@ -683,6 +745,10 @@ st_link_nir(struct gl_context *ctx,
 
       if (shader_program->data->spirv) {
          prog->nir = _mesa_spirv_to_nir(ctx, shader_program, shader->Stage, options);
+
+         if (options->lower_to_scalar) {
+            NIR_PASS_V(shader->Program->nir, nir_lower_load_const_to_scalar);
+         }
       } else {
          validate_ir_tree(shader->ir);
 
@@ -694,14 +760,20 @@ st_link_nir(struct gl_context *ctx,
             _mesa_print_ir(_mesa_get_log_file(), shader->ir, NULL);
             _mesa_log("\n\n");
          }
-
-         prog->nir = glsl_to_nir(st->ctx, shader_program, shader->Stage, options);
-         st_nir_preprocess(st, prog, shader_program, shader->Stage);
       }
+   }
 
-      if (options->lower_to_scalar) {
-         NIR_PASS_V(shader->Program->nir, nir_lower_load_const_to_scalar);
-      }
+   /* Translating GLSL IR to NIR only touches the stage being translated, so
+    * the stages are translated in parallel.
+    */
+   if (!shader_program->data->spirv) {
+      struct st_glsl_to_nir_state state = {
+         st, shader_program, linked_shader
+      };
+      link_util_parallel_for(num_shaders, st_glsl_to_nir_stage, &state);
+
+      for (unsigned i = 0; i < num_shaders; i++)
+         st_nir_init_soft_fp64(st, linked_shader[i]->Program->nir);
    }
 
    st_lower_patch_vertices_in(shader_program);
@@ -725,6 +797,7 @@ st_link_nir(struct gl_context *ctx,
          prog->ExternalSamplersUsed = gl_external_samplers(prog);
          _mesa_update_shader_textures_used(shader_program, prog);
          st_nir_preprocess(st, prog, shader_program, shader->Stage);
+         st_nir_init_soft_fp64(st, prog->nir);
       }
    }
 
@@ -827,11 +900,23 @@ st_link_nir(struct gl_context *ctx,
       prev_info = info;
    }
 
+   /* Uniform storage is shared between the stages, so it is set up
+    * serially.  The NIR lowering and optimization that follows only touches
+    * the stage's own shader.
+    */
+   for (unsigned i = 0; i < num_shaders; i++)
+      st_glsl_to_nir_post_opts(st, linked_shader[i]->Program, shader_program);
+
+   struct st_glsl_to_nir_state state = {
+      st, shader_program, linked_shader
+   };
+   link_util_parallel_for(num_shaders, st_glsl_to_nir_lower_stage, &state);
+
    for (unsigned i = 0; i < num_shaders; i++) {
       struct gl_linked_shader *shader = linked_shader[i];
       struct gl_program *prog = shader->Program;
       struct st_program *stp = st_program(prog);
-      st_glsl_to_nir_post_opts(st, prog, shader_program);
+      st_glsl_to_nir_finish(st, prog, shader_program);
 
       /* Initialize st_vertex_program members. */
       if (shader->Stage == MESA_SHADER_VERTEX)
@@ -481,8 +481,7 @@ midgard_nir_reorder_writeout(nir_shader *nir)
                                         continue;
 
                                 /* This is a real store, so move it to after dual-source stores */
-                                exec_node_remove(&instr->node);
-                                exec_node_insert_after(&last_writeout->node, &instr->node);
+                                nir_instr_move(nir_after_instr(last_writeout), instr);
 
                                 progress = true;
                         }
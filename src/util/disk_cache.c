@@ -42,14 +42,18 @@
 
 #ifdef HAVE_ZSTD
 #include "zstd.h"
+#include "zdict.h"
 #endif
 
 #include "util/crc32.h"
 #include "util/debug.h"
+#include "util/hash_table.h"
+#include "util/list.h"
 #include "util/rand_xor.h"
 #include "util/u_atomic.h"
 #include "util/u_queue.h"
 #include "util/mesa-sha1.h"
+#include "util/os_file.h"
 #include "util/ralloc.h"
 #include "util/compiler.h"
 
@@ -81,6 +85,12 @@
 /* 3 is the recomended level, with 22 as the absolute maximum */
 #define ZSTD_COMPRESSION_LEVEL 3
 
+/* The number of zstd dictionaries of a driver which are loaded, so that
+ * entries compressed before the latest dictionary was trained can still
+ * be read.
+ */
+#define CACHE_MAX_DICTS 4
+
 struct disk_cache {
    /* The path to the cache directory. */
    char *path;
@@ -111,6 +121,36 @@ struct disk_cache {
 
    disk_cache_put_cb blob_put_cb;
    disk_cache_get_cb blob_get_cb;
+
+   /* Single file backend, NULL when using a file per entry. */
+   struct disk_cache_pack *pack;
+
+#ifdef HAVE_ZSTD
+   /* Dictionaries trained for this driver by mesa_cache_dict.  New entries
+    * are compressed with the newest one, and entries compressed with any
+    * of the loaded ones can be inflated.
+    */
+   ZSTD_CDict *zstd_cdict;
+   ZSTD_DDict *zstd_ddicts[CACHE_MAX_DICTS];
+   unsigned zstd_dict_ids[CACHE_MAX_DICTS];
+   unsigned num_zstd_dicts;
+#endif
+
+   /* In-memory LRU of uncompressed entries, in front of the disk. */
+   struct {
+      mtx_t mutex;
+      struct hash_table *entries;
+      struct list_head lru;  /* most recently used first */
+      uint64_t size;
+      uint64_t max_size;
+   } mem;
+};
+
+struct disk_cache_mem_entry {
+   struct list_head link;
+   cache_key key;
+   void *data;
+   size_t size;
 };
 
 struct disk_cache_put_job {
@@ -129,6 +169,19 @@ struct disk_cache_put_job {
    struct cache_item_metadata cache_item_metadata;
 };
 
+/* Single file backend, see the implementation below */
+static struct disk_cache_pack *
+pack_create(struct disk_cache *cache);
+static void
+pack_destroy(struct disk_cache_pack *pack);
+static void
+pack_put(struct disk_cache_pack *pack, const cache_key key,
+         const void *data, size_t size);
+static void *
+pack_get(struct disk_cache_pack *pack, const cache_key key, size_t *size);
+static void
+pack_remove(struct disk_cache_pack *pack, const cache_key key);
+
 /* Create a directory named 'path' if it does not already exist.
  *
  * Returns: 0 if path already exists as a directory or if created.
@@ -189,6 +242,307 @@ concatenate_and_mkdir(void *ctx, const char *path, const char *name)
       return NULL;
 }
 
+#ifdef HAVE_ZSTD
+struct dict_file {
+   char *name;
+   time_t mtime;
+};
+
+static int
+compare_dict_files(const void *a, const void *b)
+{
+   const struct dict_file *fa = a, *fb = b;
+
+   /* Newest first */
+   return fa->mtime < fb->mtime ? 1 : fa->mtime > fb->mtime ? -1 : 0;
+}
+
+/* Load the zstd dictionaries trained for this driver, which are stored as
+ * <cache dir>/dict/<driver keys sha1>.<dictionary id>.
+ */
+static void
+load_zstd_dicts(struct disk_cache *cache)
+{
+   void *local = ralloc_context(NULL);
+   struct dict_file *files = NULL;
+   unsigned num_files = 0;
+   uint8_t sha1[20];
+   char prefix[42];
+   char *dir_path;
+   DIR *dir;
+
+   _mesa_sha1_compute(cache->driver_keys_blob, cache->driver_keys_blob_size,
+                      sha1);
+   _mesa_sha1_format(prefix, sha1);
+   strcat(prefix, ".");
+
+   dir_path = ralloc_asprintf(local, "%s/%s", cache->path,
+                              CACHE_DICT_DIR_NAME);
+   dir = opendir(dir_path);
+   if (!dir)
+      goto out;
+
+   struct dirent *entry;
+   while ((entry = readdir(dir)) != NULL) {
+      struct stat sb;
+
+      if (strncmp(entry->d_name, prefix, strlen(prefix)) != 0)
+         continue;
+
+      char *name = ralloc_asprintf(local, "%s/%s", dir_path, entry->d_name);
+      if (stat(name, &sb) == -1 || !S_ISREG(sb.st_mode))
+         continue;
+
+      files = reralloc(local, files, struct dict_file, num_files + 1);
+      files[num_files].name = name;
+      files[num_files].mtime = sb.st_mtime;
+      num_files++;
+   }
+   closedir(dir);
+
+   if (!num_files)
+      goto out;
+
+   qsort(files, num_files, sizeof(*files), compare_dict_files);
+
+   for (unsigned i = 0; i < num_files &&
+        cache->num_zstd_dicts < CACHE_MAX_DICTS; i++) {
+      size_t size;
+      char *dict = os_read_file(files[i].name, &size);
+      if (!dict)
+         continue;
+
+      unsigned dict_id = ZDICT_getDictID(dict, size);
+      ZSTD_DDict *ddict = dict_id ? ZSTD_createDDict(dict, size) : NULL;
+      if (!ddict) {
+         free(dict);
+         continue;
+      }
+
+      /* Compress with the newest valid dictionary. */
+      if (!cache->zstd_cdict) {
+         cache->zstd_cdict = ZSTD_createCDict(dict, size,
+                                              ZSTD_COMPRESSION_LEVEL);
+      }
+
+      cache->zstd_ddicts[cache->num_zstd_dicts] = ddict;
+      cache->zstd_dict_ids[cache->num_zstd_dicts] = dict_id;
+      cache->num_zstd_dicts++;
+      free(dict);
+   }
+
+ out:
+   ralloc_free(local);
+}
+
+static void
+free_zstd_dicts(struct disk_cache *cache)
+{
+   ZSTD_freeCDict(cache->zstd_cdict);
+   for (unsigned i = 0; i < cache->num_zstd_dicts; i++)
+      ZSTD_freeDDict(cache->zstd_ddicts[i]);
+}
+
+/* Returns the compressed size, or 0 on failure. */
+static size_t
+zstd_compress(struct disk_cache *cache, void *out, size_t out_size,
+              const void *in_data, size_t in_data_size)
+{
+   size_t ret;
+
+   if (cache->zstd_cdict) {
+      ZSTD_CCtx *cctx = ZSTD_createCCtx();
+      if (!cctx)
+         return 0;
+
+      ret = ZSTD_compress_usingCDict(cctx, out, out_size,
+                                     in_data, in_data_size,
+                                     cache->zstd_cdict);
+      ZSTD_freeCCtx(cctx);
+   } else {
+      ret = ZSTD_compress(out, out_size, in_data, in_data_size,
+                          ZSTD_COMPRESSION_LEVEL);
+   }
+
+   return ZSTD_isError(ret) ? 0 : ret;
+}
+#endif
+
+/* Parse a size optionally followed by K, M, or G, defaulting to gigabytes.
+ * Returns 0 if \p str doesn't start with a number.
+ */
+static uint64_t
+parse_cache_size(const char *str)
+{
+   char *end;
+   uint64_t size = strtoul(str, &end, 10);
+
+   if (end == str)
+      return 0;
+
+   switch (*end) {
+   case 'K':
+   case 'k':
+      return size * 1024;
+   case 'M':
+   case 'm':
+      return size * 1024*1024;
+   case '\0':
+   case 'G':
+   case 'g':
+   default:
+      return size * 1024*1024*1024;
+   }
+}
+
+static uint32_t
+mem_cache_key_hash(const void *key)
+{
+   /* Keys are SHA-1 hashes already. */
+   uint32_t hash;
+   memcpy(&hash, key, sizeof(hash));
+   return hash;
+}
+
+static bool
+mem_cache_key_equal(const void *a, const void *b)
+{
+   return memcmp(a, b, sizeof(cache_key)) == 0;
+}
+
+static void
+mem_cache_init(struct disk_cache *cache)
+{
+   const char *size_str = getenv("MESA_GLSL_CACHE_MEMORY_SIZE");
+
+   (void) mtx_init(&cache->mem.mutex, mtx_plain);
+   list_inithead(&cache->mem.lru);
+
+   /* Default to 16MB, 0 disables the in-memory cache. */
+   cache->mem.max_size = size_str ? parse_cache_size(size_str) : 16*1024*1024;
+   if (cache->mem.max_size) {
+      cache->mem.entries = _mesa_hash_table_create(cache, mem_cache_key_hash,
+                                                   mem_cache_key_equal);
+      if (!cache->mem.entries)
+         cache->mem.max_size = 0;
+   }
+}
+
+static void
+mem_cache_remove_entry(struct disk_cache *cache,
+                       struct disk_cache_mem_entry *entry)
+{
+   _mesa_hash_table_remove_key(cache->mem.entries, entry->key);
+   list_del(&entry->link);
+   cache->mem.size -= entry->size;
+   free(entry->data);
+   free(entry);
+}
+
+static void
+mem_cache_finish(struct disk_cache *cache)
+{
+   if (cache->mem.entries) {
+      list_for_each_entry_safe(struct disk_cache_mem_entry, entry,
+                               &cache->mem.lru, link)
+         mem_cache_remove_entry(cache, entry);
+      _mesa_hash_table_destroy(cache->mem.entries, NULL);
+   }
+   mtx_destroy(&cache->mem.mutex);
+}
+
+/* Take ownership of \p data, a malloc'ed copy of the entry of \p key, and
+ * keep it in memory, evicting the least recently used entries as needed.
+ */
+static void
+mem_cache_insert(struct disk_cache *cache, const cache_key key,
+                 void *data, size_t size)
+{
+   struct disk_cache_mem_entry *entry;
+
+   if (size > cache->mem.max_size / 4 ||
+       !(entry = malloc(sizeof(*entry)))) {
+      free(data);
+      return;
+   }
+
+   memcpy(entry->key, key, sizeof(cache_key));
+   entry->data = data;
+   entry->size = size;
+
+   mtx_lock(&cache->mem.mutex);
+
+   struct hash_entry *he = _mesa_hash_table_search(cache->mem.entries, key);
+   if (he)
+      mem_cache_remove_entry(cache, he->data);
+
+   while (cache->mem.size + size > cache->mem.max_size)
+      mem_cache_remove_entry(cache,
+                             list_last_entry(&cache->mem.lru,
+                                             struct disk_cache_mem_entry,
+                                             link));
+
+   _mesa_hash_table_insert(cache->mem.entries, entry->key, entry);
+   list_add(&entry->link, &cache->mem.lru);
+   cache->mem.size += size;
+
+   mtx_unlock(&cache->mem.mutex);
+}
+
+static void
+mem_cache_insert_copy(struct disk_cache *cache, const cache_key key,
+                      const void *data, size_t size)
+{
+   if (size > cache->mem.max_size / 4)
+      return;
+
+   void *copy = malloc(size);
+   if (copy) {
+      memcpy(copy, data, size);
+      mem_cache_insert(cache, key, copy, size);
+   }
+}
+
+/* Return a malloc'ed copy of the entry of \p key if it is in memory. */
+static void *
+mem_cache_get(struct disk_cache *cache, const cache_key key, size_t *size)
+{
+   void *data = NULL;
+
+   mtx_lock(&cache->mem.mutex);
+
+   struct hash_entry *he = _mesa_hash_table_search(cache->mem.entries, key);
+   if (he) {
+      struct disk_cache_mem_entry *entry = he->data;
+
+      data = malloc(entry->size);
+      if (data) {
+         memcpy(data, entry->data, entry->size);
+         if (size)
+            *size = entry->size;
+
+         list_del(&entry->link);
+         list_add(&entry->link, &cache->mem.lru);
+      }
+   }
+
+   mtx_unlock(&cache->mem.mutex);
+
+   return data;
+}
+
+static void
+mem_cache_remove(struct disk_cache *cache, const cache_key key)
+{
+   mtx_lock(&cache->mem.mutex);
+
+   struct hash_entry *he = _mesa_hash_table_search(cache->mem.entries, key);
+   if (he)
+      mem_cache_remove_entry(cache, he->data);
+
+   mtx_unlock(&cache->mem.mutex);
+}
+
 #define DRV_KEY_CPY(_dst, _src, _src_size) \
 do {                                       \
    memcpy(_dst, _src, _src_size);          \
@@ -230,6 +584,8 @@ disk_cache_create(const char *gpu_name, const char *driver_id,
    /* Assume failure. */
    cache->path_init_failed = true;
 
+   mem_cache_init(cache);
+
    /* Determine path for cache based on the first defined name as follows:
     *
     *   $MESA_GLSL_CACHE_DIR
@@ -343,30 +699,8 @@ disk_cache_create(const char *gpu_name, const char *driver_id,
    max_size = 0;
 
    max_size_str = getenv("MESA_GLSL_CACHE_MAX_SIZE");
-   if (max_size_str) {
-      char *end;
-      max_size = strtoul(max_size_str, &end, 10);
-      if (end == max_size_str) {
-         max_size = 0;
-      } else {
-         switch (*end) {
-         case 'K':
-         case 'k':
-            max_size *= 1024;
-            break;
-         case 'M':
-         case 'm':
-            max_size *= 1024*1024;
-            break;
-         case '\0':
-         case 'G':
-         case 'g':
-         default:
-            max_size *= 1024*1024*1024;
-            break;
-         }
-      }
-   }
+   if (max_size_str)
+      max_size = parse_cache_size(max_size_str);
 
    /* Default to 1GB for maximum cache size. */
    if (max_size == 0) {
@@ -390,6 +724,10 @@ disk_cache_create(const char *gpu_name, const char *driver_id,
                    UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY |
                    UTIL_QUEUE_INIT_SET_FULL_THREAD_AFFINITY);
 
+   /* At user request, keep all entries in a single file. */
+   if (env_var_as_boolean("MESA_GLSL_CACHE_SINGLE_FILE", false))
+      cache->pack = pack_create(cache);
+
    cache->path_init_failed = false;
 
  path_fail:
@@ -427,6 +765,11 @@ disk_cache_create(const char *gpu_name, const char *driver_id,
    DRV_KEY_CPY(drv_key_blob, &ptr_size, ptr_size_size)
    DRV_KEY_CPY(drv_key_blob, &driver_flags, driver_flags_size)
 
+#ifdef HAVE_ZSTD
+   if (!cache->path_init_failed)
+      load_zstd_dicts(cache);
+#endif
+
    /* Seed our rand function */
    s_rand_xorshift128plus(cache->seed_xorshift128plus, true);
 
@@ -449,6 +792,15 @@ disk_cache_destroy(struct disk_cache *cache)
       util_queue_finish(&cache->cache_queue);
       util_queue_destroy(&cache->cache_queue);
       munmap(cache->index_mmap, cache->index_mmap_size);
+      if (cache->pack)
+         pack_destroy(cache->pack);
+   }
+
+   if (cache) {
+      mem_cache_finish(cache);
+#ifdef HAVE_ZSTD
+      free_zstd_dicts(cache);
+#endif
    }
 
    ralloc_free(cache);
@@ -689,6 +1041,14 @@ disk_cache_remove(struct disk_cache *cache, const cache_key key)
 {
    struct stat sb;
 
+   if (cache->mem.max_size)
+      mem_cache_remove(cache, key);
+
+   if (cache->pack) {
+      pack_remove(cache->pack, key);
+      return;
+   }
+
    char *filename = get_cache_file(cache, key);
    if (filename == NULL) {
       return;
@@ -747,7 +1107,8 @@ write_all(int fd, const void *buf, size_t count)
  * of the data written to disk.
  */
 static size_t
-deflate_and_write_to_disk(const void *in_data, size_t in_data_size, int dest,
+deflate_and_write_to_disk(struct disk_cache *cache,
+                          const void *in_data, size_t in_data_size, int dest,
                           const char *filename)
 {
 #ifdef HAVE_ZSTD
@@ -757,9 +1118,8 @@ deflate_and_write_to_disk(const void *in_data, size_t in_data_size, int dest,
    size_t out_size = ZSTD_compressBound(in_data_size);
    void * out = malloc(out_size);
 
-   size_t ret = ZSTD_compress(out, out_size, in_data, in_data_size,
-                              ZSTD_COMPRESSION_LEVEL);
-   if (ZSTD_isError(ret)) {
+   size_t ret = zstd_compress(cache, out, out_size, in_data, in_data_size);
+   if (ret == 0) {
       free(out);
       return 0;
    }
@@ -905,6 +1265,11 @@ cache_put(void *job, int thread_index)
    char *filename = NULL, *filename_tmp = NULL;
    struct disk_cache_put_job *dc_job = (struct disk_cache_put_job *) job;
 
+   if (dc_job->cache->pack) {
+      pack_put(dc_job->cache->pack, dc_job->key, dc_job->data, dc_job->size);
+      return;
+   }
+
    filename = get_cache_file(dc_job->cache, dc_job->key);
    if (filename == NULL)
       goto done;
@@ -1030,7 +1395,8 @@ cache_put(void *job, int thread_index)
     * rename them atomically to the destination filename, and also
     * perform an atomic increment of the total cache size.
     */
-   size_t file_size = deflate_and_write_to_disk(dc_job->data, dc_job->size,
+   size_t file_size = deflate_and_write_to_disk(dc_job->cache,
+                                                dc_job->data, dc_job->size,
                                                 fd, filename_tmp);
    if (file_size == 0) {
       unlink(filename_tmp);
@@ -1069,6 +1435,8 @@ disk_cache_put(struct disk_cache *cache, const cache_key key,
                struct cache_item_metadata *cache_item_metadata)
 {
    if (cache->blob_put_cb) {
+      if (cache->mem.max_size)
+         mem_cache_insert_copy(cache, key, data, size);
       cache->blob_put_cb(key, CACHE_KEY_SIZE, data, size);
       return;
    }
@@ -1076,6 +1444,10 @@ disk_cache_put(struct disk_cache *cache, const cache_key key,
    if (cache->path_init_failed)
       return;
 
+   /* Keep a copy around for the other users of the cache in this process. */
+   if (cache->mem.max_size)
+      mem_cache_insert_copy(cache, key, data, size);
+
    struct disk_cache_put_job *dc_job =
       create_put_job(cache, key, data, size, cache_item_metadata);
 
@@ -1090,11 +1462,35 @@ disk_cache_put(struct disk_cache *cache, const cache_key key,
  * Decompresses cache entry, returns true if successful.
  */
 static bool
-inflate_cache_data(uint8_t *in_data, size_t in_data_size,
+inflate_cache_data(struct disk_cache *cache,
+                   uint8_t *in_data, size_t in_data_size,
                    uint8_t *out_data, size_t out_data_size)
 {
 #ifdef HAVE_ZSTD
-   size_t ret = ZSTD_decompress(out_data, out_data_size, in_data, in_data_size);
+   size_t ret;
+   unsigned dict_id = ZSTD_getDictID_fromFrame(in_data, in_data_size);
+
+   if (dict_id) {
+      ZSTD_DDict *ddict = NULL;
+      for (unsigned i = 0; i < cache->num_zstd_dicts; i++) {
+         if (cache->zstd_dict_ids[i] == dict_id)
+            ddict = cache->zstd_ddicts[i];
+      }
+
+      /* The dictionary was replaced since the entry was written. */
+      if (!ddict)
+         return false;
+
+      ZSTD_DCtx *dctx = ZSTD_createDCtx();
+      if (!dctx)
+         return false;
+
+      ret = ZSTD_decompress_usingDDict(dctx, out_data, out_data_size,
+                                       in_data, in_data_size, ddict);
+      ZSTD_freeDCtx(dctx);
+   } else {
+      ret = ZSTD_decompress(out_data, out_data_size, in_data, in_data_size);
+   }
    return !ZSTD_isError(ret);
 #else
    z_stream strm;
@@ -1130,8 +1526,587 @@ inflate_cache_data(uint8_t *in_data, size_t in_data_size,
 #endif
 }
 
-void *
-disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size)
+/* Single file backend
+ *
+ * With MESA_GLSL_CACHE_SINGLE_FILE set, entries are appended to one pack
+ * file in the cache directory instead of each being written to a file of
+ * its own.  The pack is mapped and an in-memory index maps keys to the
+ * offsets of their entries, so that a lookup needs no syscalls and reads
+ * the entry straight from the mapping.
+ *
+ * Appending is serialized between processes with a lock on the pack file.
+ * An entry that is only partially written, e.g. because of a crash, fails
+ * the checksums and is cut off by the next writer.  When the pack grows
+ * past the maximum cache size, its newest entries are copied to a new
+ * file which then atomically replaces it, and the other processes switch
+ * over to the new file when they notice that the path changed inode.
+ */
+
+#define PACK_FILE_NAME "pack"
+#define PACK_MAGIC "MESAPACK"
+#define PACK_VERSION 1
+
+#define PACK_ENTRY_MAGIC 0x52544e45 /* "ENTR" */
+#define PACK_ENTRY_ALIGN 8
+
+/* The entry data is compressed */
+#define PACK_ENTRY_COMPRESSED   (1 << 0)
+/* The entry has no data, and removes the previous entries of its key */
+#define PACK_ENTRY_REMOVED      (1 << 1)
+
+struct pack_header {
+   char magic[8];
+   uint32_t version;
+   uint32_t pad;
+};
+
+struct pack_entry_header {
+   uint32_t magic;
+   uint32_t flags;
+   cache_key key;
+   uint32_t stored_size;
+   uint32_t uncompressed_size;
+   uint32_t crc32;         /* of the uncompressed data */
+   uint32_t header_crc32;  /* of the fields above */
+   uint32_t pad;
+};
+
+struct disk_cache_pack {
+   struct disk_cache *cache;
+
+   /* Protects everything below, and serializes the use of the pack file
+    * between the threads of this process.
+    */
+   mtx_t mutex;
+
+   char *filename;
+   int fd;
+   ino_t ino;
+
+   uint8_t *map;
+   size_t map_size;
+
+   /* End of the last valid entry, the index covers the entries up to here */
+   uint64_t end;
+
+   /* Maps the first 64 bits of a key to the offset of its latest entry */
+   struct hash_table_u64 *index;
+
+   uint64_t max_size;
+};
+
+static uint64_t
+pack_index_key(const cache_key key)
+{
+   uint64_t index_key;
+
+   memcpy(&index_key, key, sizeof(index_key));
+   return index_key;
+}
+
+static uint64_t
+pack_entry_size(const struct pack_entry_header *hdr)
+{
+   return ALIGN_POT(sizeof(*hdr) + hdr->stored_size, PACK_ENTRY_ALIGN);
+}
+
+/* Lock the pack file, \p type is F_RDLCK, F_WRLCK or F_UNLCK.  Writers
+ * take the exclusive lock, and readers the shared one while they look
+ * past the end of the last entry they know of, since a writer may cut off
+ * what follows the last valid entry and touching the mapping beyond the
+ * end of the file raises SIGBUS.
+ */
+static int
+pack_lock_file(int fd, int type)
+{
+#ifdef HAVE_FLOCK
+   return flock(fd, type == F_WRLCK ? LOCK_EX :
+                    type == F_RDLCK ? LOCK_SH : LOCK_UN);
+#else
+   struct flock fl = {
+      .l_start = 0,
+      .l_len = 0, /* entire file */
+      .l_type = type,
+      .l_whence = SEEK_SET
+   };
+   return fcntl(fd, F_SETLKW, &fl);
+#endif
+}
+
+/* Map the pack file up to \p size bytes. */
+static bool
+pack_map(struct disk_cache_pack *pack, size_t size)
+{
+   if (pack->map)
+      munmap(pack->map, pack->map_size);
+   pack->map = NULL;
+   pack->map_size = 0;
+
+   if (!size)
+      return true;
+
+   void *map = mmap(NULL, size, PROT_READ, MAP_SHARED, pack->fd, 0);
+   if (map == MAP_FAILED)
+      return false;
+
+   pack->map = map;
+   pack->map_size = size;
+   return true;
+}
+
+/* Add the entries between pack->end and the end of the mapping to the
+ * index, stopping at the first invalid or incomplete one.  The caller holds
+ * the file lock.
+ */
+static void
+pack_scan(struct disk_cache_pack *pack)
+{
+   while (pack->end + sizeof(struct pack_entry_header) <= pack->map_size) {
+      const struct pack_entry_header *hdr =
+         (const struct pack_entry_header *)(pack->map + pack->end);
+
+      if (hdr->magic != PACK_ENTRY_MAGIC ||
+          hdr->header_crc32 !=
+          util_hash_crc32(hdr, offsetof(struct pack_entry_header,
+                                        header_crc32)) ||
+          pack->end + sizeof(*hdr) + hdr->stored_size > pack->map_size)
+         break;
+
+      uint64_t index_key = pack_index_key(hdr->key);
+      if (hdr->flags & PACK_ENTRY_REMOVED) {
+         _mesa_hash_table_u64_remove(pack->index, index_key);
+      } else {
+         _mesa_hash_table_u64_insert(pack->index, index_key,
+                                     (void *)(uintptr_t)pack->end);
+      }
+
+      pack->end += pack_entry_size(hdr);
+   }
+}
+
+static void
+pack_close_file(struct disk_cache_pack *pack)
+{
+   pack_map(pack, 0);
+   if (pack->fd != -1)
+      close(pack->fd);
+   pack->fd = -1;
+   pack->end = 0;
+   _mesa_hash_table_u64_clear(pack->index, NULL);
+}
+
+/* (Re)open the pack file, creating it if needed, and build the index. */
+static bool
+pack_open_file(struct disk_cache_pack *pack)
+{
+   struct pack_header header;
+   struct stat sb;
+
+   pack_close_file(pack);
+
+   pack->fd = open(pack->filename, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+   if (pack->fd == -1)
+      return false;
+
+   if (pack_lock_file(pack->fd, F_WRLCK) == -1)
+      goto fail;
+
+   if (fstat(pack->fd, &sb) == -1)
+      goto fail_unlock;
+
+   /* Write the header of a new pack. */
+   if (sb.st_size < sizeof(header)) {
+      memset(&header, 0, sizeof(header));
+      memcpy(header.magic, PACK_MAGIC, sizeof(header.magic));
+      header.version = PACK_VERSION;
+
+      if (ftruncate(pack->fd, 0) == -1 ||
+          pwrite(pack->fd, &header, sizeof(header), 0) != sizeof(header))
+         goto fail_unlock;
+      sb.st_size = sizeof(header);
+   }
+
+   pack->ino = sb.st_ino;
+   if (!pack_map(pack, sb.st_size))
+      goto fail_unlock;
+
+   /* A pack written by another version of Mesa is not used. */
+   const struct pack_header *map_header = (const struct pack_header *)pack->map;
+   if (memcmp(map_header->magic, PACK_MAGIC, sizeof(map_header->magic)) != 0 ||
+       map_header->version != PACK_VERSION)
+      goto fail_unlock;
+
+   pack->end = sizeof(header);
+   pack_scan(pack);
+
+   pack_lock_file(pack->fd, F_UNLCK);
+   return true;
+
+ fail_unlock:
+   pack_lock_file(pack->fd, F_UNLCK);
+ fail:
+   pack_close_file(pack);
+   return false;
+}
+
+/* Catch up with the changes other processes made to the pack: reopen it if
+ * it was replaced, and index the entries appended to it.
+ */
+static bool
+pack_update(struct disk_cache_pack *pack)
+{
+   struct stat sb;
+
+   if (pack->fd == -1 ||
+       stat(pack->filename, &sb) == -1 || sb.st_ino != pack->ino)
+      return pack_open_file(pack);
+
+   if (pack_lock_file(pack->fd, F_RDLCK) == -1)
+      return false;
+
+   bool ret = fstat(pack->fd, &sb) != -1;
+   if (ret && sb.st_size > pack->map_size) {
+      ret = pack_map(pack, sb.st_size);
+      if (ret)
+         pack_scan(pack);
+   }
+
+   pack_lock_file(pack->fd, F_UNLCK);
+   return ret;
+}
+
+/* Find the latest entry of \p key, or NULL. */
+static const struct pack_entry_header *
+pack_lookup(struct disk_cache_pack *pack, const cache_key key)
+{
+   uint64_t offset = (uintptr_t)
+      _mesa_hash_table_u64_search(pack->index, pack_index_key(key));
+   if (!offset)
+      return NULL;
+
+   /* Entries appended by this process may not be mapped yet. */
+   if (offset + sizeof(struct pack_entry_header) > pack->map_size &&
+       !pack_map(pack, pack->end))
+      return NULL;
+
+   const struct pack_entry_header *hdr =
+      (const struct pack_entry_header *)(pack->map + offset);
+   if (offset + sizeof(*hdr) + hdr->stored_size > pack->map_size &&
+       !pack_map(pack, pack->end))
+      return NULL;
+
+   hdr = (const struct pack_entry_header *)(pack->map + offset);
+   if (memcmp(hdr->key, key, sizeof(cache_key)) != 0)
+      return NULL;
+
+   return hdr;
+}
+
+/* Replace the pack with a new one holding only its newest live entries,
+ * which take up to half of the maximum cache size.  The caller holds the
+ * file lock.
+ */
+static void
+pack_compact(struct disk_cache_pack *pack)
+{
+   struct pack_header header;
+   uint64_t live_size = 0, offset;
+   char *filename_tmp;
+   int fd_tmp;
+
+   if (!pack_map(pack, pack->end))
+      return;
+
+   /* Find the first entry to keep. */
+   offset = sizeof(header);
+   while (offset < pack->end) {
+      const struct pack_entry_header *hdr =
+         (const struct pack_entry_header *)(pack->map + offset);
+      if (pack_lookup(pack, hdr->key) == hdr)
+         live_size += pack_entry_size(hdr);
+      offset += pack_entry_size(hdr);
+   }
+
+   uint64_t first = sizeof(header);
+   while (live_size > pack->max_size / 2 && first < pack->end) {
+      const struct pack_entry_header *hdr =
+         (const struct pack_entry_header *)(pack->map + first);
+      if (pack_lookup(pack, hdr->key) == hdr)
+         live_size -= pack_entry_size(hdr);
+      first += pack_entry_size(hdr);
+   }
+
+   if (asprintf(&filename_tmp, "%s.tmp", pack->filename) == -1)
+      return;
+
+   fd_tmp = open(filename_tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+   if (fd_tmp == -1) {
+      free(filename_tmp);
+      return;
+   }
+
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, PACK_MAGIC, sizeof(header.magic));
+   header.version = PACK_VERSION;
+   if (write_all(fd_tmp, &header, sizeof(header)) == -1)
+      goto fail;
+
+   for (offset = first; offset < pack->end;) {
+      const struct pack_entry_header *hdr =
+         (const struct pack_entry_header *)(pack->map + offset);
+      uint64_t entry_size = pack_entry_size(hdr);
+
+      if (pack_lookup(pack, hdr->key) == hdr &&
+          write_all(fd_tmp, hdr, entry_size) == -1)
+         goto fail;
+      offset += entry_size;
+   }
+
+   /* Make sure the new pack is complete before it replaces the old one. */
+   if (fdatasync(fd_tmp) == -1 ||
+       rename(filename_tmp, pack->filename) == -1)
+      goto fail;
+
+   close(fd_tmp);
+   free(filename_tmp);
+   return;
+
+ fail:
+   close(fd_tmp);
+   unlink(filename_tmp);
+   free(filename_tmp);
+}
+
+/* Append an entry to the pack. */
+static void
+pack_append(struct disk_cache_pack *pack, const cache_key key, uint32_t flags,
+            const void *data, uint32_t stored_size, uint32_t uncompressed_size,
+            uint32_t crc32)
+{
+   static const uint8_t zeros[PACK_ENTRY_ALIGN];
+   struct pack_entry_header hdr;
+   bool compacted = false;
+   struct stat sb;
+
+   memset(&hdr, 0, sizeof(hdr));
+   hdr.magic = PACK_ENTRY_MAGIC;
+   hdr.flags = flags;
+   memcpy(hdr.key, key, sizeof(cache_key));
+   hdr.stored_size = stored_size;
+   hdr.uncompressed_size = uncompressed_size;
+   hdr.crc32 = crc32;
+   hdr.header_crc32 =
+      util_hash_crc32(&hdr, offsetof(struct pack_entry_header, header_crc32));
+
+   uint64_t entry_size = pack_entry_size(&hdr);
+
+   mtx_lock(&pack->mutex);
+
+   for (unsigned tries = 0; tries < 4; tries++) {
+      if (!pack_update(pack))
+         break;
+
+      if (pack_lock_file(pack->fd, F_WRLCK) == -1)
+         break;
+
+      /* Another process may have replaced the pack in the meantime. */
+      if (stat(pack->filename, &sb) == -1 || sb.st_ino != pack->ino) {
+         pack_lock_file(pack->fd, F_UNLCK);
+         continue;
+      }
+
+      /* Index what was appended in the meantime, and cut off whatever
+       * follows the last valid entry, such as an entry that was only
+       * partially written.
+       */
+      if (fstat(pack->fd, &sb) == -1 ||
+          (sb.st_size > pack->map_size && !pack_map(pack, sb.st_size))) {
+         pack_lock_file(pack->fd, F_UNLCK);
+         break;
+      }
+      pack_scan(pack);
+      if (sb.st_size > pack->end && ftruncate(pack->fd, pack->end) == -1) {
+         pack_lock_file(pack->fd, F_UNLCK);
+         break;
+      }
+
+      if (!compacted && pack->end + entry_size > pack->max_size) {
+         pack_compact(pack);
+         compacted = true;
+         pack_lock_file(pack->fd, F_UNLCK);
+         continue;
+      }
+
+      if (pwrite(pack->fd, &hdr, sizeof(hdr), pack->end) == sizeof(hdr) &&
+          pwrite(pack->fd, data, stored_size, pack->end + sizeof(hdr)) ==
+          stored_size &&
+          pwrite(pack->fd, zeros, entry_size - sizeof(hdr) - stored_size,
+                 pack->end + sizeof(hdr) + stored_size) ==
+          entry_size - sizeof(hdr) - stored_size) {
+         uint64_t index_key = pack_index_key(key);
+         if (flags & PACK_ENTRY_REMOVED) {
+            _mesa_hash_table_u64_remove(pack->index, index_key);
+         } else {
+            _mesa_hash_table_u64_insert(pack->index, index_key,
+                                        (void *)(uintptr_t)pack->end);
+         }
+         pack->end += entry_size;
+      }
+
+      pack_lock_file(pack->fd, F_UNLCK);
+      break;
+   }
+
+   mtx_unlock(&pack->mutex);
+}
+
+/* Compresses \p in_data into a malloc'ed buffer, returning its size, or 0
+ * if compression failed.
+ */
+static size_t
+compress_cache_data(struct disk_cache *cache,
+                    const void *in_data, size_t in_data_size, void **out_data)
+{
+#ifdef HAVE_ZSTD
+   size_t out_size = ZSTD_compressBound(in_data_size);
+   void *out = malloc(out_size);
+   if (!out)
+      return 0;
+
+   size_t ret = zstd_compress(cache, out, out_size, in_data, in_data_size);
+   if (ret == 0) {
+      free(out);
+      return 0;
+   }
+#else
+   uLongf ret = compressBound(in_data_size);
+   void *out = malloc(ret);
+   if (!out)
+      return 0;
+
+   if (compress2(out, &ret, in_data, in_data_size,
+                 Z_BEST_COMPRESSION) != Z_OK) {
+      free(out);
+      return 0;
+   }
+#endif
+   *out_data = out;
+   return ret;
+}
+
+static void
+pack_put(struct disk_cache_pack *pack, const cache_key key,
+         const void *data, size_t size)
+{
+   void *compressed = NULL;
+   size_t compressed_size;
+   uint32_t crc32 = util_hash_crc32(data, size);
+
+   /* Entries which don't compress are stored as they are, and can be
+    * read with a single copy.
+    */
+   compressed_size = compress_cache_data(pack->cache, data, size, &compressed);
+   if (compressed_size && compressed_size < size) {
+      pack_append(pack, key, PACK_ENTRY_COMPRESSED, compressed,
+                  compressed_size, size, crc32);
+   } else {
+      pack_append(pack, key, 0, data, size, size, crc32);
+   }
+
+   free(compressed);
+}
+
+static void *
+pack_get(struct disk_cache_pack *pack, const cache_key key, size_t *size)
+{
+   const struct pack_entry_header *hdr;
+   uint8_t *data = NULL;
+
+   mtx_lock(&pack->mutex);
+
+   hdr = pack_lookup(pack, key);
+   if (!hdr && pack_update(pack))
+      hdr = pack_lookup(pack, key);
+   if (!hdr)
+      goto out;
+
+   data = malloc(hdr->uncompressed_size);
+   if (!data)
+      goto out;
+
+   if (hdr->flags & PACK_ENTRY_COMPRESSED) {
+      if (!inflate_cache_data(pack->cache, (uint8_t *)(hdr + 1),
+                              hdr->stored_size,
+                              data, hdr->uncompressed_size))
+         goto fail;
+   } else {
+      if (hdr->stored_size != hdr->uncompressed_size)
+         goto fail;
+      memcpy(data, hdr + 1, hdr->stored_size);
+   }
+
+   /* Check the data for corruption */
+   if (hdr->crc32 != util_hash_crc32(data, hdr->uncompressed_size))
+      goto fail;
+
+   if (size)
+      *size = hdr->uncompressed_size;
+
+ out:
+   mtx_unlock(&pack->mutex);
+   return data;
+
+ fail:
+   free(data);
+   data = NULL;
+   goto out;
+}
+
+static void
+pack_remove(struct disk_cache_pack *pack, const cache_key key)
+{
+   pack_append(pack, key, PACK_ENTRY_REMOVED, NULL, 0, 0, 0);
+}
+
+static struct disk_cache_pack *
+pack_create(struct disk_cache *cache)
+{
+   struct disk_cache_pack *pack = rzalloc(cache, struct disk_cache_pack);
+   if (!pack)
+      return NULL;
+
+   pack->cache = cache;
+   pack->fd = -1;
+   pack->max_size = cache->max_size;
+   pack->filename = ralloc_asprintf(pack, "%s/%s", cache->path,
+                                    PACK_FILE_NAME);
+   pack->index = _mesa_hash_table_u64_create(pack);
+   if (!pack->filename || !pack->index)
+      goto fail;
+
+   if (!pack_open_file(pack))
+      goto fail;
+
+   (void) mtx_init(&pack->mutex, mtx_plain);
+   return pack;
+
+ fail:
+   _mesa_hash_table_u64_destroy(pack->index, NULL);
+   ralloc_free(pack);
+   return NULL;
+}
+
+static void
+pack_destroy(struct disk_cache_pack *pack)
+{
+   pack_close_file(pack);
+   _mesa_hash_table_u64_destroy(pack->index, NULL);
+   mtx_destroy(&pack->mutex);
+   ralloc_free(pack);
+}
+
+static void *
+load_cache_entry(struct disk_cache *cache, const cache_key key, size_t *size)
 {
    int fd = -1, ret;
    struct stat sb;
@@ -1140,9 +2115,6 @@ disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size)
    uint8_t *uncompressed_data = NULL;
    uint8_t *file_header = NULL;
 
-   if (size)
-      *size = 0;
-
    if (cache->blob_get_cb) {
       /* This is what Android EGL defines as the maxValueSize in egl_cache_t
        * class implementation.
@@ -1165,6 +2137,9 @@ disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size)
       return blob;
    }
 
+   if (cache->pack)
+      return pack_get(cache->pack, key, size);
+
    filename = get_cache_file(cache, key);
    if (filename == NULL)
       goto fail;
@@ -1239,7 +2214,7 @@ disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size)
 
    /* Uncompress the cache data */
    uncompressed_data = malloc(cf_data.uncompressed_size);
-   if (!inflate_cache_data(data, cache_data_size, uncompressed_data,
+   if (!inflate_cache_data(cache, data, cache_data_size, uncompressed_data,
                            cf_data.uncompressed_size))
       goto fail;
 
@@ -1273,6 +2248,93 @@ disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size)
    return NULL;
 }
 
+bool
+disk_cache_parse_entry_file(const void *file, size_t size,
+                            struct disk_cache_entry_file *entry)
+{
+   const uint8_t *p = file, *end = p + size;
+   struct cache_entry_file_data cf_data;
+   uint32_t md_type, num_keys;
+   const uint8_t *nul;
+
+   /* The driver keys: cache version, driver id, gpu name, pointer size and
+    * driver flags, see disk_cache_create().
+    */
+   if (size < 1 || p[0] != CACHE_VERSION)
+      return false;
+   p++;
+
+   for (unsigned i = 0; i < 2; i++) {
+      nul = memchr(p, '\0', end - p);
+      if (!nul)
+         return false;
+      p = nul + 1;
+   }
+
+   p += sizeof(uint8_t) + sizeof(uint64_t);
+   if (p > end)
+      return false;
+
+   entry->driver_keys_blob = file;
+   entry->driver_keys_blob_size = p - (const uint8_t *)file;
+
+   /* The cache item metadata */
+   if (end - p < sizeof(md_type))
+      return false;
+   memcpy(&md_type, p, sizeof(md_type));
+   p += sizeof(md_type);
+
+   if (md_type == CACHE_ITEM_TYPE_GLSL) {
+      if (end - p < sizeof(num_keys))
+         return false;
+      memcpy(&num_keys, p, sizeof(num_keys));
+      p += sizeof(num_keys);
+
+      if ((end - p) / sizeof(cache_key) < num_keys)
+         return false;
+      p += num_keys * sizeof(cache_key);
+   }
+
+   if (end - p < sizeof(cf_data))
+      return false;
+   memcpy(&cf_data, p, sizeof(cf_data));
+   p += sizeof(cf_data);
+
+   entry->data = p;
+   entry->size = end - p;
+   entry->uncompressed_size = cf_data.uncompressed_size;
+   entry->crc32 = cf_data.crc32;
+
+   return true;
+}
+
+void *
+disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size)
+{
+   void *data;
+   size_t data_size;
+
+   if (size)
+      *size = 0;
+
+   if (!cache->mem.max_size)
+      return load_cache_entry(cache, key, size);
+
+   data = mem_cache_get(cache, key, size);
+   if (data)
+      return data;
+
+   data = load_cache_entry(cache, key, &data_size);
+   if (!data)
+      return NULL;
+
+   mem_cache_insert_copy(cache, key, data, data_size);
+
+   if (size)
+      *size = data_size;
+   return data;
+}
+
 void
 disk_cache_put_key(struct disk_cache *cache, const cache_key key)
 {
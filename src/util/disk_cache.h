@@ -44,6 +44,11 @@ extern "C" {
 
 #define CACHE_DIR_NAME "mesa_shader_cache"
 
+/* Directory within the cache holding the zstd dictionaries of the drivers,
+ * named <sha1 of the driver keys>.<dictionary id>.
+ */
+#define CACHE_DICT_DIR_NAME "dict"
+
 typedef uint8_t cache_key[CACHE_KEY_SIZE];
 
 /* WARNING: 3rd party applications might be reading the cache item metadata.
@@ -74,6 +79,20 @@ struct cache_item_metadata {
    uint32_t num_keys;
 };
 
+/* The parts of a cache entry file, pointing into the file contents. */
+struct disk_cache_entry_file {
+   /* Identifies the driver which wrote the entry. */
+   const uint8_t *driver_keys_blob;
+   size_t driver_keys_blob_size;
+
+   /* The compressed entry data. */
+   const uint8_t *data;
+   size_t size;
+
+   uint32_t uncompressed_size;
+   uint32_t crc32;
+};
+
 struct disk_cache;
 
 static inline char *
@@ -258,6 +277,16 @@ void
 disk_cache_set_callbacks(struct disk_cache *cache, disk_cache_put_cb put,
                          disk_cache_get_cb get);
 
+/**
+ * Split the \size bytes of \file, the contents of a cache entry file, into
+ * its parts, for tools that inspect a cache directory.
+ *
+ * \return false if \file is not a valid cache entry file.
+ */
+bool
+disk_cache_parse_entry_file(const void *file, size_t size,
+                            struct disk_cache_entry_file *entry);
+
 #else
 
 static inline struct disk_cache *
@@ -152,6 +152,11 @@ DRI_CONF_OPT_BEGIN_B(disable_glsl_line_continuations, def) \
         DRI_CONF_DESC("Disable backslash-based line continuations in GLSL source") \
 DRI_CONF_OPT_END
 
+#define DRI_CONF_DISABLE_GLSL_PREPROCESSOR_FAST_PATH(def) \
+DRI_CONF_OPT_BEGIN_B(disable_glsl_preprocessor_fast_path, def) \
+        DRI_CONF_DESC("Run the full GLSL preprocessor even for shaders without macros or conditionals") \
+DRI_CONF_OPT_END
+
 #define DRI_CONF_FORCE_GLSL_VERSION(def) \
 DRI_CONF_OPT_BEGIN_V(force_glsl_version, int, def, "0:999") \
         DRI_CONF_DESC("Force a default GLSL version for shaders that lack an explicit #version line") \
@@ -0,0 +1,145 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "c11/threads.h"
+#include "util/format/u_format_compress.h"
+#include "util/macros.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_debug.h"
+#include "util/u_queue.h"
+
+
+static enum util_format_compress_quality compress_quality;
+static once_flag compress_quality_once = ONCE_FLAG_INIT;
+
+static void
+init_compress_quality(void)
+{
+   const char *quality = debug_get_option("MESA_TEXCOMPRESS_QUALITY",
+                                          "default");
+
+   if (!strcmp(quality, "fast"))
+      compress_quality = UTIL_FORMAT_COMPRESS_QUALITY_FAST;
+   else
+      compress_quality = UTIL_FORMAT_COMPRESS_QUALITY_DEFAULT;
+}
+
+enum util_format_compress_quality
+util_format_get_compress_quality(void)
+{
+   call_once(&compress_quality_once, init_compress_quality);
+   return compress_quality;
+}
+
+/**
+ * Override MESA_TEXCOMPRESS_QUALITY, e.g. to compare the presets.
+ */
+void
+util_format_set_compress_quality(enum util_format_compress_quality quality)
+{
+   call_once(&compress_quality_once, init_compress_quality);
+   compress_quality = quality;
+}
+
+
+/* Images with fewer blocks than this are processed by the calling thread. */
+#define MIN_BLOCKS_FOR_THREADS 4096
+#define MIN_BLOCK_ROWS_PER_JOB 16
+#define MAX_BLOCK_ROWS_JOBS 8
+
+static struct util_queue block_rows_queue;
+static bool block_rows_queue_initialized;
+static once_flag block_rows_queue_once = ONCE_FLAG_INIT;
+
+static void
+init_block_rows_queue(void)
+{
+   util_cpu_detect();
+
+   /* The calling thread processes a part of the image itself. */
+   unsigned num_threads = MIN2(util_cpu_caps.nr_cpus, MAX_BLOCK_ROWS_JOBS) - 1;
+
+   if (num_threads > 0) {
+      block_rows_queue_initialized =
+         util_queue_init(&block_rows_queue, "texblocks", MAX_BLOCK_ROWS_JOBS,
+                         num_threads, UTIL_QUEUE_INIT_RESIZE_IF_FULL);
+   }
+}
+
+struct block_rows_state {
+   util_format_block_rows_func func;
+   void *data;
+   unsigned y_blocks;
+   unsigned rows_per_job;
+};
+
+static void
+run_block_rows_job(void *data, unsigned index)
+{
+   struct block_rows_state *state = data;
+   unsigned first_row = index * state->rows_per_job;
+
+   state->func(state->data, first_row,
+               MIN2(state->rows_per_job, state->y_blocks - first_row));
+}
+
+/**
+ * Encode or decode an image of \p x_blocks by \p y_blocks blocks by calling
+ * \p func on bands of block rows.
+ *
+ * Large images are split into one band per CPU, and the bands are processed
+ * in parallel.  \p func must only write to the rows of its own band.
+ */
+void
+util_format_block_rows_parallel(unsigned x_blocks, unsigned y_blocks,
+                                util_format_block_rows_func func,
+                                void *data)
+{
+   unsigned num_jobs = 1;
+
+   if (x_blocks * y_blocks >= MIN_BLOCKS_FOR_THREADS) {
+      call_once(&block_rows_queue_once, init_block_rows_queue);
+      if (block_rows_queue_initialized) {
+         num_jobs = MIN3(block_rows_queue.num_threads + 1, MAX_BLOCK_ROWS_JOBS,
+                         MAX2(y_blocks / MIN_BLOCK_ROWS_PER_JOB, 1));
+      }
+   }
+
+   if (num_jobs <= 1) {
+      if (y_blocks)
+         func(data, 0, y_blocks);
+      return;
+   }
+
+   struct block_rows_state state;
+   state.func = func;
+   state.data = data;
+   state.y_blocks = y_blocks;
+   state.rows_per_job = DIV_ROUND_UP(y_blocks, num_jobs);
+
+   util_queue_parallel_for(&block_rows_queue,
+                           DIV_ROUND_UP(y_blocks, state.rows_per_job),
+                           run_block_rows_job, &state);
+}
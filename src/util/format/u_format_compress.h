@@ -0,0 +1,73 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file u_format_compress.h
+ *
+ * Helpers shared by the encoders and decoders of the block-compressed
+ * formats.
+ */
+
+#ifndef U_FORMAT_COMPRESS_H_
+#define U_FORMAT_COMPRESS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * How hard the encoders of the block-compressed formats try.
+ *
+ * The default is taken from the MESA_TEXCOMPRESS_QUALITY environment
+ * variable, which can be "fast" or "default".
+ */
+enum util_format_compress_quality {
+   /** The encoders' usual endpoint search. */
+   UTIL_FORMAT_COMPRESS_QUALITY_DEFAULT,
+   /** A single pass endpoint search, for textures generated at runtime. */
+   UTIL_FORMAT_COMPRESS_QUALITY_FAST,
+};
+
+enum util_format_compress_quality
+util_format_get_compress_quality(void);
+
+void
+util_format_set_compress_quality(enum util_format_compress_quality quality);
+
+/**
+ * A function that encodes or decodes \p num_rows rows of blocks of an image,
+ * starting at block row \p first_row.
+ */
+typedef void (*util_format_block_rows_func)(void *data, unsigned first_row,
+                                            unsigned num_rows);
+
+void
+util_format_block_rows_parallel(unsigned x_blocks, unsigned y_blocks,
+                                util_format_block_rows_func func,
+                                void *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* U_FORMAT_COMPRESS_H_ */
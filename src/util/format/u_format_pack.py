@@ -619,6 +619,160 @@ def generate_pack_kernel(format, src_channel, src_native_type):
         print_channels(format, pack_into_struct)
 
 
+def is_simd_format(format, channel_type, channel_size):
+    '''Determines whether the SIMD kernels can handle this format: four
+    channels of the given type and size in xyzw order, or 8-bit unorm
+    channels and padding in any order.'''
+
+    if format.layout != PLAIN or format.colorspace != RGB:
+        return False
+    if format.block_width != 1 or format.block_height != 1:
+        return False
+    if format.block_size() != 4 * channel_size:
+        return False
+
+    for i in range(4):
+        channel = format.le_channels[i]
+        if channel.size != channel_size or channel.shift % 8:
+            return False
+        if channel_type == UNSIGNED and channel_size == 8:
+            # Swizzled with shifts and masks
+            if channel.type == VOID:
+                continue
+        elif channel.shift != i * channel_size or format.le_swizzles[i] != i:
+            return False
+        if channel.type != channel_type or channel.pure:
+            return False
+        if channel_type == UNSIGNED and not channel.norm:
+            return False
+
+    return True
+
+
+def generate_simd_byte_swizzle(dst, src, moves, constant):
+    '''Generate the SSE2 code that moves bytes within the 32-bit lanes of
+    src, as a list of (src_shift, dst_shift) pairs, and sets the bits of
+    constant.'''
+
+    # Move all the bytes that go the same distance at once.
+    masks = {}
+    for src_shift, dst_shift in moves:
+        delta = dst_shift - src_shift
+        masks[delta] = masks.get(delta, 0) | (0xff << dst_shift)
+
+    terms = []
+    for delta, mask in sorted(masks.items()):
+        if delta > 0:
+            value = '_mm_slli_epi32(%s, %u)' % (src, delta)
+            kept = (0xffffffff << delta) & 0xffffffff
+        elif delta < 0:
+            value = '_mm_srli_epi32(%s, %u)' % (src, -delta)
+            kept = 0xffffffff >> -delta
+        else:
+            value = src
+            kept = 0xffffffff
+        if mask != kept:
+            value = '_mm_and_si128(%s, _mm_set1_epi32(0x%08x))' % (value, mask)
+        terms.append(value)
+    if constant:
+        terms.append('_mm_set1_epi32(0x%08x)' % constant)
+
+    print('            __m128i %s = %s;' % (dst, terms[0]))
+    for term in terms[1:]:
+        print('            %s = _mm_or_si128(%s, %s);' % (dst, dst, term))
+
+
+def generate_simd_kernel(format, func):
+    '''Generate the SSE2 code that converts four pixels at once for the most
+    common formats, giving exactly the same results as the scalar kernels.
+    Returns False if there is none for this format.'''
+
+    if is_simd_format(format, UNSIGNED, 8):
+        channels = format.le_channels
+        swizzles = format.le_swizzles
+
+        if func in ('unpack_rgba_8unorm', 'unpack_rgba_float'):
+            moves = []
+            constant = 0
+            for i in range(4):
+                if swizzles[i] < 4:
+                    moves.append((channels[swizzles[i]].shift, i * 8))
+                elif swizzles[i] == SWIZZLE_1:
+                    constant |= 0xff << (i * 8)
+
+            print('            __m128i texels = _mm_loadu_si128((const __m128i *)src);')
+            generate_simd_byte_swizzle('rgba', 'texels', moves, constant)
+            if func == 'unpack_rgba_8unorm':
+                print('            _mm_storeu_si128((__m128i *)dst, rgba);')
+            else:
+                print('            util_format_8unorm_to_float_sse2(dst, rgba);')
+        else:
+            inv_swizzle = inv_swizzles(swizzles)
+            moves = []
+            for i in range(4):
+                if inv_swizzle[i] is not None and channels[i].type != VOID:
+                    moves.append((inv_swizzle[i] * 8, channels[i].shift))
+
+            if func == 'pack_rgba_8unorm':
+                print('            __m128i rgba = _mm_loadu_si128((const __m128i *)src);')
+            else:
+                print('            __m128i rgba = util_format_float_to_8unorm_sse2(src);')
+            generate_simd_byte_swizzle('texels', 'rgba', moves, 0)
+            print('            _mm_storeu_si128((__m128i *)dst, texels);')
+        return True
+
+    if is_simd_format(format, UNSIGNED, 16):
+        if func == 'unpack_rgba_float':
+            print('            util_format_16unorm_to_float_sse2(dst, _mm_loadu_si128((const __m128i *)src));')
+            print('            util_format_16unorm_to_float_sse2(dst + 8, _mm_loadu_si128((const __m128i *)(src + 16)));')
+        elif func == 'unpack_rgba_8unorm':
+            print('            __m128i lo = _mm_srli_epi16(_mm_loadu_si128((const __m128i *)src), 8);')
+            print('            __m128i hi = _mm_srli_epi16(_mm_loadu_si128((const __m128i *)(src + 16)), 8);')
+            print('            _mm_storeu_si128((__m128i *)dst, _mm_packus_epi16(lo, hi));')
+        elif func == 'pack_rgba_float':
+            print('            _mm_storeu_si128((__m128i *)dst, util_format_float_to_16unorm_sse2(src));')
+            print('            _mm_storeu_si128((__m128i *)(dst + 16), util_format_float_to_16unorm_sse2(src + 8));')
+        else:
+            # x * 0xffff / 0xff is x * 0x101
+            print('            __m128i rgba = _mm_loadu_si128((const __m128i *)src);')
+            print('            _mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi8(rgba, rgba));')
+            print('            _mm_storeu_si128((__m128i *)(dst + 16), _mm_unpackhi_epi8(rgba, rgba));')
+        return True
+
+    if is_simd_format(format, FLOAT, 32):
+        if func == 'unpack_rgba_8unorm':
+            print('            _mm_storeu_si128((__m128i *)dst, util_format_float_to_8unorm_sse2((const float *)src));')
+            return True
+        elif func == 'pack_rgba_8unorm':
+            print('            util_format_8unorm_to_float_sse2((float *)dst, _mm_loadu_si128((const __m128i *)src));')
+            return True
+
+    return False
+
+
+def generate_simd_loop(format, func, src_pixel_size, dst_pixel_size):
+    '''Generate the loop that converts as many pixels of the row as it can
+    with the SIMD kernels, if the CPU supports them, and leaves the rest to
+    the scalar loop.'''
+
+    print('#ifdef UTIL_FORMAT_SIMD_SSE2')
+    print('      if (util_cpu_caps.has_sse2) {')
+    print('         for(; x + 4 <= width; x += 4) {')
+    supported = generate_simd_kernel(format, func)
+    assert supported
+    print('            src += %u;' % (4 * src_pixel_size,))
+    print('            dst += %u;' % (4 * dst_pixel_size,))
+    print('         }')
+    print('      }')
+    print('#endif')
+
+
+def has_simd_kernel(format, func):
+    return (is_simd_format(format, UNSIGNED, 8) or
+            is_simd_format(format, UNSIGNED, 16) or
+            (is_simd_format(format, FLOAT, 32) and func.endswith('8unorm')))
+
+
 def generate_format_unpack(format, dst_channel, dst_native_type, dst_suffix):
     '''Generate the function to unpack pixels from a particular format'''
 
@@ -638,7 +792,14 @@ def generate_format_unpack(format, dst_channel, dst_native_type, dst_suffix):
         print('   for(y = 0; y < height; y += %u) {' % (format.block_height,))
         print('      %s *dst = dst_row;' % (dst_native_type))
         print('      const uint8_t *src = src_row;')
-        print('      for(x = 0; x < width; x += %u) {' % (format.block_width,))
+        if dst_suffix in ('rgba_float', 'rgba_8unorm') and \
+           has_simd_kernel(format, 'unpack_' + dst_suffix):
+            print('      x = 0;')
+            generate_simd_loop(format, 'unpack_' + dst_suffix,
+                               format.block_size() // 8, 4)
+            print('      for(; x < width; x += %u) {' % (format.block_width,))
+        else:
+            print('      for(x = 0; x < width; x += %u) {' % (format.block_width,))
         
         generate_unpack_kernel(format, dst_channel, dst_native_type)
     
@@ -667,7 +828,14 @@ def generate_format_pack(format, src_channel, src_native_type, src_suffix):
         print('   for(y = 0; y < height; y += %u) {' % (format.block_height,))
         print('      const %s *src = src_row;' % (src_native_type))
         print('      uint8_t *dst = dst_row;')
-        print('      for(x = 0; x < width; x += %u) {' % (format.block_width,))
+        if src_suffix in ('rgba_float', 'rgba_8unorm') and \
+           has_simd_kernel(format, 'pack_' + src_suffix):
+            print('      x = 0;')
+            generate_simd_loop(format, 'pack_' + src_suffix,
+                               4, format.block_size() // 8)
+            print('      for(; x < width; x += %u) {' % (format.block_width,))
+        else:
+            print('      for(x = 0; x < width; x += %u) {' % (format.block_width,))
     
         generate_pack_kernel(format, src_channel, src_native_type)
             
@@ -712,6 +880,7 @@ def generate(formats):
     print('#include "util/format_srgb.h"')
     print('#include "u_format_yuv.h"')
     print('#include "u_format_zs.h"')
+    print('#include "u_format_simd.h"')
     print()
 
     for format in formats:
@@ -24,6 +24,7 @@
  **************************************************************************/
 
 #include "util/format/u_format.h"
+#include "util/format/u_format_compress.h"
 #include "util/format/u_format_s3tc.h"
 #include "util/format_srgb.h"
 #include "util/u_math.h"
@@ -280,25 +281,36 @@ util_format_dxt5_rgba_unpack_rgba_float(void *dst_row, unsigned dst_stride,
  * Block compression.
  */
 
-static inline void
-util_format_dxtn_pack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride,
-                                  const uint8_t *src, unsigned src_stride,
-                                  unsigned width, unsigned height,
-                                  enum util_format_dxtn format,
-                                  unsigned block_size, boolean srgb)
-{
+struct util_format_dxtn_pack_job {
+   uint8_t *dst_row;
+   unsigned dst_stride;
+   const uint8_t *src;
+   unsigned src_stride;
+   unsigned width;
+   enum util_format_dxtn format;
+   unsigned block_size;
+   boolean srgb;
+};
+
+static void
+util_format_dxtn_pack_rows_8unorm(void *data, unsigned first_row,
+                                  unsigned num_rows)
+{
+   const struct util_format_dxtn_pack_job *job = data;
+   const uint8_t *src = job->src;
+   const unsigned src_stride = job->src_stride;
    const unsigned bw = 4, bh = 4, comps = 4;
    unsigned x, y, i, j, k;
-   for(y = 0; y < height; y += bh) {
-      uint8_t *dst = dst_row;
-      for(x = 0; x < width; x += bw) {
+   for(y = first_row * bh; y < (first_row + num_rows) * bh; y += bh) {
+      uint8_t *dst = job->dst_row + (y / bh) * job->dst_stride;
+      for(x = 0; x < job->width; x += bw) {
          uint8_t tmp[4][4][4];  /* [bh][bw][comps] */
          for(j = 0; j < bh; ++j) {
             for(i = 0; i < bw; ++i) {
                uint8_t src_tmp;
                for(k = 0; k < 3; ++k) {
                   src_tmp = src[(y + j)*src_stride/sizeof(*src) + (x+i)*comps + k];
-                  if (srgb) {
+                  if (job->srgb) {
                      tmp[j][i][k] = util_format_linear_to_srgb_8unorm(src_tmp);
                   }
                   else {
@@ -310,12 +322,35 @@ util_format_dxtn_pack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride,
             }
          }
          /* even for dxt1_rgb have 4 src comps */
-         util_format_dxtn_pack(4, 4, 4, &tmp[0][0][0], format, dst, 0);
-         dst += block_size;
+         util_format_dxtn_pack(4, 4, 4, &tmp[0][0][0], job->format, dst, 0);
+         dst += job->block_size;
       }
-      dst_row += dst_stride / sizeof(*dst_row);
    }
+}
 
+static inline void
+util_format_dxtn_pack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride,
+                                  const uint8_t *src, unsigned src_stride,
+                                  unsigned width, unsigned height,
+                                  enum util_format_dxtn format,
+                                  unsigned block_size, boolean srgb)
+{
+   struct util_format_dxtn_pack_job job = {
+      .dst_row = dst_row,
+      .dst_stride = dst_stride,
+      .src = src,
+      .src_stride = src_stride,
+      .width = width,
+      .format = format,
+      .block_size = block_size,
+      .srgb = srgb,
+   };
+
+   /* the block rows don't depend on each other, large images are packed
+    * by several threads */
+   util_format_block_rows_parallel(DIV_ROUND_UP(width, 4),
+                                   DIV_ROUND_UP(height, 4),
+                                   util_format_dxtn_pack_rows_8unorm, &job);
 }
 
 void
@@ -0,0 +1,151 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file u_format_simd.h
+ *
+ * Channel conversions used by the SIMD row kernels that u_format_pack.py
+ * generates for the most common formats.
+ *
+ * Each helper gives exactly the same bits as the scalar conversion it is
+ * named after, so a row is converted the same way whether or not its texels
+ * go through the SIMD kernels.  The kernels are only built for x86-64, where
+ * the scalar code also does its float arithmetic in SSE registers.
+ */
+
+#ifndef U_FORMAT_SIMD_H_
+#define U_FORMAT_SIMD_H_
+
+#include "pipe/p_config.h"
+
+#if defined(PIPE_ARCH_X86_64)
+
+#include <emmintrin.h>
+
+#include "util/u_cpu_detect.h"
+
+#define UTIL_FORMAT_SIMD_SSE2 1
+
+/**
+ * Convert four RGBA8 texels to sixteen floats, like ubyte_to_float().
+ */
+static inline void
+util_format_8unorm_to_float_sse2(float *dst, __m128i texels)
+{
+   const __m128i zero = _mm_setzero_si128();
+   const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+   const __m128i lo = _mm_unpacklo_epi8(texels, zero);
+   const __m128i hi = _mm_unpackhi_epi8(texels, zero);
+
+   _mm_storeu_ps(dst + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+   _mm_storeu_ps(dst + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+   _mm_storeu_ps(dst + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+   _mm_storeu_ps(dst + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+}
+
+/**
+ * Convert four floats to four bytes in the low bits of 32-bit lanes, like
+ * float_to_ubyte().
+ */
+static inline __m128i
+util_format_float_to_ubyte_sse2(__m128 f)
+{
+   const __m128 zero = _mm_setzero_ps();
+   const __m128 one = _mm_set1_ps(1.0f);
+   const __m128i byte_mask = _mm_set1_epi32(0xff);
+   __m128 tmp;
+   __m128i result;
+
+   /* The low byte of f * (255/256) + 32768 is the rounded byte. */
+   tmp = _mm_add_ps(_mm_mul_ps(f, _mm_set1_ps(255.0f / 256.0f)),
+                    _mm_set1_ps(32768.0f));
+   result = _mm_and_si128(_mm_castps_si128(tmp), byte_mask);
+
+   /* 0 for NaN and f <= 0, 255 for f >= 1. */
+   result = _mm_and_si128(result, _mm_castps_si128(_mm_cmpgt_ps(f, zero)));
+   result = _mm_or_si128(result, _mm_and_si128(_mm_castps_si128(_mm_cmpge_ps(f, one)),
+                                               byte_mask));
+   return result;
+}
+
+/**
+ * Convert sixteen floats to four RGBA8 texels, like float_to_ubyte().
+ */
+static inline __m128i
+util_format_float_to_8unorm_sse2(const float *src)
+{
+   const __m128i r0 = util_format_float_to_ubyte_sse2(_mm_loadu_ps(src + 0));
+   const __m128i r1 = util_format_float_to_ubyte_sse2(_mm_loadu_ps(src + 4));
+   const __m128i r2 = util_format_float_to_ubyte_sse2(_mm_loadu_ps(src + 8));
+   const __m128i r3 = util_format_float_to_ubyte_sse2(_mm_loadu_ps(src + 12));
+
+   return _mm_packus_epi16(_mm_packs_epi32(r0, r1), _mm_packs_epi32(r2, r3));
+}
+
+/**
+ * Convert two RGBA16 unorm texels to eight floats, like
+ * (float)(x * (1.0f/0xffff)).
+ */
+static inline void
+util_format_16unorm_to_float_sse2(float *dst, __m128i texels)
+{
+   const __m128i zero = _mm_setzero_si128();
+   const __m128 scale = _mm_set1_ps(1.0f / 0xffff);
+
+   _mm_storeu_ps(dst + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(texels, zero)), scale));
+   _mm_storeu_ps(dst + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(texels, zero)), scale));
+}
+
+/**
+ * Convert four floats to four 16-bit values in the low bits of 32-bit lanes,
+ * sign extended, like (uint16_t)util_iround(CLAMP(f, 0.0f, 1.0f) * 0xffff).
+ */
+static inline __m128i
+util_format_float_to_16unorm_lanes_sse2(__m128 f)
+{
+   /* CLAMP() gives 0 for NaN. */
+   __m128 clamped = _mm_and_ps(_mm_min_ps(f, _mm_set1_ps(1.0f)),
+                               _mm_cmpgt_ps(f, _mm_setzero_ps()));
+   __m128i result;
+
+   /* util_iround() of a positive number on x86-64. */
+   result = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, _mm_set1_ps(0xffff)),
+                                        _mm_set1_ps(0.5f)));
+
+   /* Sign extend, so that _mm_packs_epi32() keeps the low 16 bits. */
+   return _mm_srai_epi32(_mm_slli_epi32(result, 16), 16);
+}
+
+/**
+ * Convert eight floats to two RGBA16 unorm texels.
+ */
+static inline __m128i
+util_format_float_to_16unorm_sse2(const float *src)
+{
+   return _mm_packs_epi32(util_format_float_to_16unorm_lanes_sse2(_mm_loadu_ps(src + 0)),
+                          util_format_float_to_16unorm_lanes_sse2(_mm_loadu_ps(src + 4)));
+}
+
+#endif /* PIPE_ARCH_X86_64 */
+
+#endif /* U_FORMAT_SIMD_H_ */
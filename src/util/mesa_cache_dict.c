@@ -0,0 +1,439 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Trains zstd dictionaries for the drivers which wrote the entries of a
+ * shader cache directory, and reports how they compare to compressing each
+ * entry on its own.  With --write, the dictionaries are installed in the
+ * cache, and used for the entries written from then on.
+ */
+
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <ftw.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "zstd.h"
+#include "zdict.h"
+
+#include "util/crc32.h"
+#include "util/disk_cache.h"
+#include "util/hash_table.h"
+#include "util/macros.h"
+#include "util/mesa-sha1.h"
+#include "util/os_file.h"
+#include "util/os_time.h"
+#include "util/ralloc.h"
+#include "util/u_dynarray.h"
+
+#define ZSTD_COMPRESSION_LEVEL 3
+
+/* The entries written by one driver */
+struct driver_entries {
+   char name[41];    /* sha1 of the driver keys */
+   const char *driver_id;
+
+   struct util_dynarray data;    /* concatenated uncompressed entries */
+   struct util_dynarray sizes;   /* size_t per entry */
+   size_t stored_size;
+   unsigned num_unreadable;
+};
+
+static const char *cache_path;
+static struct hash_table *drivers;
+static void *mem_ctx;
+
+static void
+usage(const char *name)
+{
+   fprintf(stderr,
+           "Usage: %s [OPTION]... CACHE_DIR\n"
+           "Train zstd dictionaries from the entries of the shader cache in\n"
+           "CACHE_DIR (e.g. ~/.cache/" CACHE_DIR_NAME ") and report the\n"
+           "compression ratio and decompression throughput with and without\n"
+           "them.\n"
+           "\n"
+           "  -s, --dict-size=SIZE   maximum dictionary size in bytes\n"
+           "                         (default: 112640)\n"
+           "  -w, --write            install the dictionaries in the cache\n"
+           "  -h, --help             display this help and exit\n",
+           name);
+}
+
+/* Load the dictionaries that were installed for a driver before, which the
+ * entries it wrote since may have been compressed with.
+ */
+static unsigned
+load_ddicts(const char *name, ZSTD_DDict **ddicts, unsigned *ids,
+            unsigned max_ddicts)
+{
+   char *dir_path = ralloc_asprintf(mem_ctx, "%s/" CACHE_DICT_DIR_NAME,
+                                    cache_path);
+   unsigned num_ddicts = 0;
+   DIR *dir = opendir(dir_path);
+   if (!dir)
+      return 0;
+
+   struct dirent *entry;
+   while ((entry = readdir(dir)) != NULL && num_ddicts < max_ddicts) {
+      if (strncmp(entry->d_name, name, 40) != 0 || entry->d_name[40] != '.')
+         continue;
+
+      char *filename = ralloc_asprintf(mem_ctx, "%s/%s", dir_path,
+                                       entry->d_name);
+      size_t size;
+      char *dict = os_read_file(filename, &size);
+      if (!dict)
+         continue;
+
+      ddicts[num_ddicts] = ZSTD_createDDict(dict, size);
+      ids[num_ddicts] = ZDICT_getDictID(dict, size);
+      if (ddicts[num_ddicts])
+         num_ddicts++;
+      free(dict);
+   }
+   closedir(dir);
+
+   return num_ddicts;
+}
+
+static void *
+inflate_entry(const char *name, const struct disk_cache_entry_file *entry)
+{
+   static ZSTD_DDict *ddicts[16];
+   static unsigned ids[16], num_ddicts;
+   static const char *ddicts_name;
+
+   void *data = malloc(entry->uncompressed_size);
+   if (!data)
+      return NULL;
+
+   size_t ret;
+   unsigned dict_id = ZSTD_getDictID_fromFrame(entry->data, entry->size);
+   if (dict_id) {
+      if (ddicts_name != name) {
+         for (unsigned i = 0; i < num_ddicts; i++)
+            ZSTD_freeDDict(ddicts[i]);
+         num_ddicts = load_ddicts(name, ddicts, ids, ARRAY_SIZE(ddicts));
+         ddicts_name = name;
+      }
+
+      ret = (size_t)-1;
+      for (unsigned i = 0; i < num_ddicts; i++) {
+         if (ids[i] != dict_id)
+            continue;
+
+         ZSTD_DCtx *dctx = ZSTD_createDCtx();
+         ret = ZSTD_decompress_usingDDict(dctx, data, entry->uncompressed_size,
+                                          entry->data, entry->size, ddicts[i]);
+         ZSTD_freeDCtx(dctx);
+         break;
+      }
+   } else {
+      ret = ZSTD_decompress(data, entry->uncompressed_size,
+                            entry->data, entry->size);
+   }
+
+   if (ZSTD_isError(ret) || ret != entry->uncompressed_size ||
+       util_hash_crc32(data, ret) != entry->crc32) {
+      free(data);
+      return NULL;
+   }
+
+   return data;
+}
+
+static int
+add_entry(const char *path, const struct stat *sb, int typeflag,
+          struct FTW *ftwbuf)
+{
+   /* Entries live in the subdirectories named after the first two hex
+    * digits of their keys, next to the index, the dictionaries, and the
+    * single file backend.
+    */
+   if (typeflag != FTW_F || ftwbuf->level != 2 || ftwbuf->base < 4)
+      return 0;
+
+   const char *parent = path + ftwbuf->base - 4;
+   if (parent[0] != '/' || !isxdigit(parent[1]) || !isxdigit(parent[2]))
+      return 0;
+
+   size_t size;
+   char *file = os_read_file(path, &size);
+   if (!file)
+      return 0;
+
+   struct disk_cache_entry_file entry;
+   if (!disk_cache_parse_entry_file(file, size, &entry)) {
+      free(file);
+      return 0;
+   }
+
+   uint8_t sha1[20];
+   char name[41];
+   _mesa_sha1_compute(entry.driver_keys_blob, entry.driver_keys_blob_size,
+                      sha1);
+   _mesa_sha1_format(name, sha1);
+
+   struct driver_entries *driver;
+   struct hash_entry *he = _mesa_hash_table_search(drivers, name);
+   if (he) {
+      driver = he->data;
+   } else {
+      driver = rzalloc(mem_ctx, struct driver_entries);
+      memcpy(driver->name, name, sizeof(name));
+      /* The driver id follows the cache version. */
+      driver->driver_id = ralloc_strdup(driver,
+                                        (const char *)entry.driver_keys_blob + 1);
+      util_dynarray_init(&driver->data, driver);
+      util_dynarray_init(&driver->sizes, driver);
+      _mesa_hash_table_insert(drivers, driver->name, driver);
+   }
+
+   void *data = inflate_entry(driver->name, &entry);
+   if (data) {
+      memcpy(util_dynarray_grow_bytes(&driver->data, 1,
+                                      entry.uncompressed_size),
+             data, entry.uncompressed_size);
+      util_dynarray_append(&driver->sizes, size_t, entry.uncompressed_size);
+      driver->stored_size += entry.size;
+      free(data);
+   } else {
+      driver->num_unreadable++;
+   }
+
+   free(file);
+   return 0;
+}
+
+/* Compresses all entries of a driver, with \p cdict if not NULL, returning
+ * the total compressed size, and the time it takes to decompress them in
+ * \p decompress_ns.
+ */
+static size_t
+measure(struct driver_entries *driver, const ZSTD_CDict *cdict,
+        const ZSTD_DDict *ddict, int64_t *decompress_ns)
+{
+   unsigned num_entries = util_dynarray_num_elements(&driver->sizes, size_t);
+   const uint8_t *data = driver->data.data;
+   size_t total = 0, offset = 0, max_size = 0;
+
+   util_dynarray_foreach(&driver->sizes, size_t, size)
+      max_size = MAX2(max_size, *size);
+
+   size_t bound = ZSTD_compressBound(max_size);
+   uint8_t *compressed = malloc(bound * num_entries);
+   size_t *compressed_sizes = malloc(num_entries * sizeof(size_t));
+   uint8_t *out = malloc(max_size);
+   ZSTD_CCtx *cctx = ZSTD_createCCtx();
+   ZSTD_DCtx *dctx = ZSTD_createDCtx();
+
+   for (unsigned i = 0; i < num_entries; i++) {
+      size_t size = *util_dynarray_element(&driver->sizes, size_t, i);
+      uint8_t *dst = compressed + i * bound;
+
+      if (cdict) {
+         compressed_sizes[i] =
+            ZSTD_compress_usingCDict(cctx, dst, bound, data + offset, size,
+                                     cdict);
+      } else {
+         compressed_sizes[i] =
+            ZSTD_compressCCtx(cctx, dst, bound, data + offset, size,
+                              ZSTD_COMPRESSION_LEVEL);
+      }
+      if (ZSTD_isError(compressed_sizes[i]))
+         compressed_sizes[i] = 0;
+
+      total += compressed_sizes[i];
+      offset += size;
+   }
+
+   int64_t start = os_time_get_nano();
+   for (unsigned i = 0; i < num_entries; i++) {
+      size_t size = *util_dynarray_element(&driver->sizes, size_t, i);
+      if (!compressed_sizes[i])
+         continue;
+
+      if (ddict) {
+         ZSTD_decompress_usingDDict(dctx, out, size, compressed + i * bound,
+                                    compressed_sizes[i], ddict);
+      } else {
+         ZSTD_decompressDCtx(dctx, out, size, compressed + i * bound,
+                             compressed_sizes[i]);
+      }
+   }
+   *decompress_ns = os_time_get_nano() - start;
+
+   ZSTD_freeDCtx(dctx);
+   ZSTD_freeCCtx(cctx);
+   free(out);
+   free(compressed_sizes);
+   free(compressed);
+
+   return total;
+}
+
+static bool
+write_dict(struct driver_entries *driver, const void *dict, size_t size)
+{
+   char *dir_path = ralloc_asprintf(mem_ctx, "%s/" CACHE_DICT_DIR_NAME,
+                                    cache_path);
+   if (mkdir(dir_path, 0755) == -1 && errno != EEXIST)
+      return false;
+
+   char *filename = ralloc_asprintf(mem_ctx, "%s/%s.%08x", dir_path,
+                                    driver->name, ZDICT_getDictID(dict, size));
+   char *filename_tmp = ralloc_asprintf(mem_ctx, "%s.tmp", filename);
+
+   /* Mesa loads the dictionaries when a cache is created, so make sure it
+    * never sees a partial one.
+    */
+   FILE *f = fopen(filename_tmp, "wb");
+   if (!f)
+      return false;
+
+   bool ok = fwrite(dict, 1, size, f) == size;
+   ok = fclose(f) == 0 && ok;
+   if (!ok || rename(filename_tmp, filename) == -1) {
+      unlink(filename_tmp);
+      return false;
+   }
+
+   printf("  installed %s\n", filename);
+   return true;
+}
+
+static double
+mb_per_s(size_t size, int64_t ns)
+{
+   return ns ? size / 1e6 / (ns / 1e9) : 0.0;
+}
+
+static void
+train_driver(struct driver_entries *driver, size_t dict_size, bool write)
+{
+   unsigned num_entries = util_dynarray_num_elements(&driver->sizes, size_t);
+   size_t total_size = driver->data.size;
+
+   printf("driver %s (%s): %u entries, %zu bytes uncompressed\n",
+          driver->name, driver->driver_id, num_entries, total_size);
+   if (driver->num_unreadable)
+      printf("  %u unreadable entries skipped\n", driver->num_unreadable);
+   if (!num_entries)
+      return;
+
+   printf("  stored:          %10zu bytes, ratio %.2f\n",
+          driver->stored_size, (double)total_size / driver->stored_size);
+
+   int64_t plain_ns, dict_ns;
+   size_t plain_size = measure(driver, NULL, NULL, &plain_ns);
+   printf("  zstd:            %10zu bytes, ratio %.2f, "
+          "decompression %.1f MB/s\n",
+          plain_size, (double)total_size / plain_size,
+          mb_per_s(total_size, plain_ns));
+
+   /* zdict wants the sample sizes as size_t, which is what we kept. */
+   void *dict = malloc(dict_size);
+   size_t ret = ZDICT_trainFromBuffer(dict, dict_size, driver->data.data,
+                                      driver->sizes.data, num_entries);
+   if (ZDICT_isError(ret)) {
+      printf("  training failed: %s\n", ZDICT_getErrorName(ret));
+      free(dict);
+      return;
+   }
+
+   ZSTD_CDict *cdict = ZSTD_createCDict(dict, ret, ZSTD_COMPRESSION_LEVEL);
+   ZSTD_DDict *ddict = ZSTD_createDDict(dict, ret);
+   size_t dict_total = measure(driver, cdict, ddict, &dict_ns);
+   printf("  zstd+dictionary: %10zu bytes, ratio %.2f, "
+          "decompression %.1f MB/s (%zu byte dictionary)\n",
+          dict_total, (double)total_size / dict_total,
+          mb_per_s(total_size, dict_ns), ret);
+
+   if (write && !write_dict(driver, dict, ret))
+      fprintf(stderr, "  failed to install the dictionary: %s\n",
+              strerror(errno));
+
+   ZSTD_freeDDict(ddict);
+   ZSTD_freeCDict(cdict);
+   free(dict);
+}
+
+int
+main(int argc, char **argv)
+{
+   static const struct option opts[] = {
+      { "dict-size", required_argument, NULL, 's' },
+      { "write",     no_argument,       NULL, 'w' },
+      { "help",      no_argument,       NULL, 'h' },
+      { NULL,        0,                 NULL, 0 }
+   };
+   size_t dict_size = 112640;
+   bool write = false;
+   int c;
+
+   while ((c = getopt_long(argc, argv, "s:wh", opts, NULL)) != -1) {
+      switch (c) {
+      case 's':
+         dict_size = strtoul(optarg, NULL, 0);
+         break;
+      case 'w':
+         write = true;
+         break;
+      case 'h':
+         usage(argv[0]);
+         return EXIT_SUCCESS;
+      default:
+         usage(argv[0]);
+         return EXIT_FAILURE;
+      }
+   }
+
+   if (optind != argc - 1 || !dict_size) {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   cache_path = argv[optind];
+   mem_ctx = ralloc_context(NULL);
+   drivers = _mesa_hash_table_create(mem_ctx, _mesa_hash_string,
+                                     _mesa_key_string_equal);
+
+   if (nftw(cache_path, add_entry, 64, FTW_PHYS) == -1) {
+      fprintf(stderr, "Failed to read %s: %s\n", cache_path, strerror(errno));
+      ralloc_free(mem_ctx);
+      return EXIT_FAILURE;
+   }
+
+   hash_table_foreach(drivers, entry)
+      train_driver(entry->data, dict_size, write);
+
+   ralloc_free(mem_ctx);
+   return EXIT_SUCCESS;
+}
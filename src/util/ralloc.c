@@ -35,6 +35,8 @@ _CRTIMP int _vscprintf(const char *format, va_list argptr);
 #endif
 
 #include "ralloc.h"
+#include "os_memory.h"
+#include "u_atomic.h"
 
 #ifndef va_copy
 #ifdef __va_copy
@@ -70,6 +72,11 @@ __declspec(align(16))
    unsigned canary;
 #endif
 
+   /* The size of the block, header included, if it was carved out of an
+    * arena, otherwise 0.  This fits in what would otherwise be padding.
+    */
+   unsigned arena_size;
+
    struct ralloc_header *parent;
 
    /* The first child (head of a linked list) */
@@ -86,6 +93,7 @@ typedef struct ralloc_header ralloc_header;
 
 static void unlink_block(ralloc_header *info);
 static void unsafe_free(ralloc_header *info);
+static void arena_free_block(ralloc_header *info);
 
 static ralloc_header *
 get_header(const void *ptr)
@@ -132,6 +140,7 @@ ralloc_size(const void *ctx, size_t size)
     * the multiplication overflow checking?), so clear things
     * manually
     */
+   info->arena_size = 0;
    info->parent = NULL;
    info->child = NULL;
    info->prev = NULL;
@@ -165,9 +174,24 @@ static void *
 resize(void *ptr, size_t size)
 {
    ralloc_header *child, *old, *info;
+   unsigned old_arena_size;
 
    old = get_header(ptr);
-   info = realloc(old, size + sizeof(ralloc_header));
+   old_arena_size = old->arena_size;
+
+   if (old_arena_size) {
+      /* Move blocks carved out of an arena to the heap. */
+      size_t old_size = old_arena_size - sizeof(ralloc_header);
+
+      info = malloc(size + sizeof(ralloc_header));
+      if (info == NULL)
+         return NULL;
+
+      memcpy(info, old, sizeof(ralloc_header) + MIN2(old_size, size));
+      info->arena_size = 0;
+   } else {
+      info = realloc(old, size + sizeof(ralloc_header));
+   }
 
    if (info == NULL)
       return NULL;
@@ -188,6 +212,9 @@ resize(void *ptr, size_t size)
    for (child = info->child; child != NULL; child = child->next)
       child->parent = info;
 
+   if (old_arena_size)
+      arena_free_block(old);
+
    return PTR_FROM_HEADER(info);
 }
 
@@ -300,7 +327,10 @@ unsafe_free(ralloc_header *info)
    if (info->destructor != NULL)
       info->destructor(PTR_FROM_HEADER(info));
 
-   free(info);
+   if (info->arena_size)
+      arena_free_block(info);
+   else
+      free(info);
 }
 
 void
@@ -367,6 +397,183 @@ ralloc_set_destructor(const void *ptr, void(*destructor)(void *))
    info->destructor = destructor;
 }
 
+/*
+ * Arenas
+ *
+ * Blocks carved out of an arena are ordinary ralloc blocks, except that their
+ * memory comes from large chunks shared with other blocks.  Each chunk counts
+ * the blocks which still live in it, and is returned to the system when the
+ * last of them is freed.  The arena itself is only referenced by the chunks
+ * and its handle, and goes away once both are gone, so blocks may outlive
+ * the handle.
+ *
+ * Blocks are only carved out of an arena by one thread at a time, like any
+ * other allocation from a ralloc context, but blocks whose contexts live on
+ * different threads may be freed concurrently, so the reference counts of
+ * chunks and arenas are atomic.
+ */
+
+#define ARENA_CHUNK_SIZE (64 * 1024)
+
+/* Larger blocks are allocated from the heap. */
+#define ARENA_MAX_BLOCK_SIZE (ARENA_CHUNK_SIZE / 8)
+
+/* Blocks start at a multiple of this, which must be a power of two and a
+ * multiple of the alignment of ralloc_header.
+ */
+#define ARENA_BLOCK_ALIGNMENT 16
+
+struct ralloc_arena {
+   /* The chunk blocks are carved out of, and the offset of its free space */
+   struct arena_chunk *chunk;
+   unsigned offset;
+
+   /* The number of chunks which still hold live blocks, plus one until the
+    * handle is freed.
+    */
+   unsigned refcount;
+};
+
+struct arena_chunk {
+   struct ralloc_arena *arena;
+
+   /* The number of live blocks, plus one while blocks are carved out of the
+    * chunk.
+    */
+   unsigned num_blocks;
+};
+
+#define ARENA_CHUNK_HEADER_SIZE \
+   ALIGN_POT(sizeof(struct arena_chunk), ARENA_BLOCK_ALIGNMENT)
+
+static void
+arena_unref(struct ralloc_arena *arena)
+{
+   if (p_atomic_dec_zero(&arena->refcount))
+      free(arena);
+}
+
+static void
+arena_unref_chunk(struct arena_chunk *chunk)
+{
+   struct ralloc_arena *arena = chunk->arena;
+
+   if (!p_atomic_dec_zero(&chunk->num_blocks))
+      return;
+
+   os_free_aligned(chunk);
+   arena_unref(arena);
+}
+
+static void
+arena_free_block(ralloc_header *info)
+{
+   arena_unref_chunk((struct arena_chunk *)
+                     ((uintptr_t)info & ~(uintptr_t)(ARENA_CHUNK_SIZE - 1)));
+}
+
+static void
+arena_handle_destructor(void *ptr)
+{
+   struct ralloc_arena *arena = *(struct ralloc_arena **)ptr;
+
+   if (arena->chunk)
+      arena_unref_chunk(arena->chunk);
+   arena_unref(arena);
+}
+
+void *
+ralloc_arena_create(const void *ctx)
+{
+   struct ralloc_arena **handle = ralloc(ctx, struct ralloc_arena *);
+   if (unlikely(handle == NULL))
+      return NULL;
+
+   *handle = calloc(1, sizeof(struct ralloc_arena));
+   if (unlikely(*handle == NULL)) {
+      ralloc_free(handle);
+      return NULL;
+   }
+   (*handle)->refcount = 1;
+
+   ralloc_set_destructor(handle, arena_handle_destructor);
+   return handle;
+}
+
+void *
+ralloc_arena_size(void *arena_handle, const void *ctx, size_t size)
+{
+   struct ralloc_arena *arena;
+   ralloc_header *info;
+   size_t block_size;
+
+   STATIC_ASSERT(ARENA_BLOCK_ALIGNMENT % offsetof(struct { char c; ralloc_header h; }, h) == 0);
+   STATIC_ASSERT((ARENA_BLOCK_ALIGNMENT & (ARENA_BLOCK_ALIGNMENT - 1)) == 0);
+
+   block_size = ALIGN_POT(size + sizeof(ralloc_header), ARENA_BLOCK_ALIGNMENT);
+   if (arena_handle == NULL || block_size > ARENA_MAX_BLOCK_SIZE)
+      return ralloc_size(ctx, size);
+
+   arena = *(struct ralloc_arena **)arena_handle;
+
+   if (unlikely(arena->chunk == NULL ||
+                arena->offset + block_size > ARENA_CHUNK_SIZE)) {
+      struct arena_chunk *chunk =
+         os_malloc_aligned(ARENA_CHUNK_SIZE, ARENA_CHUNK_SIZE);
+      if (unlikely(chunk == NULL))
+         return NULL;
+
+      chunk->arena = arena;
+      chunk->num_blocks = 1;
+      p_atomic_inc(&arena->refcount);
+
+      if (arena->chunk)
+         arena_unref_chunk(arena->chunk);
+      arena->chunk = chunk;
+      arena->offset = ARENA_CHUNK_HEADER_SIZE;
+   }
+
+   info = (ralloc_header *)((char *)arena->chunk + arena->offset);
+   arena->offset += block_size;
+   p_atomic_inc(&arena->chunk->num_blocks);
+
+   info->arena_size = block_size;
+   info->parent = NULL;
+   info->child = NULL;
+   info->prev = NULL;
+   info->next = NULL;
+   info->destructor = NULL;
+
+   add_child(ctx != NULL ? get_header(ctx) : NULL, info);
+
+#ifndef NDEBUG
+   info->canary = CANARY;
+#endif
+
+   return PTR_FROM_HEADER(info);
+}
+
+void *
+rzalloc_arena_size(void *arena_handle, const void *ctx, size_t size)
+{
+   void *ptr = ralloc_arena_size(arena_handle, ctx, size);
+
+   if (likely(ptr))
+      memset(ptr, 0, size);
+
+   return ptr;
+}
+
+void *
+rzalloc_arena_array_size(void *arena_handle, const void *ctx, size_t size,
+                         unsigned count)
+{
+   if (count > SIZE_MAX/size)
+      return NULL;
+
+   return rzalloc_arena_size(arena_handle, ctx, size * count);
+}
+
 char *
 ralloc_strdup(const void *ctx, const char *str)
 {
@@ -478,6 +478,56 @@ bool ralloc_asprintf_append (char **str, const char *fmt, ...)
 bool ralloc_vasprintf_append(char **str, const char *fmt, va_list args);
 /// @}
 
+/**
+ * \name Arenas
+ *
+ * An arena hands out ralloc blocks carved out of large chunks, which saves
+ * a malloc() and free() per block for objects that are allocated in great
+ * numbers, like IR nodes.
+ *
+ * The blocks behave like any other ralloc block: they are chained off of a
+ * context, can be contexts themselves, and can be stolen, resized or freed.
+ * A chunk is returned to the system once all of the blocks carved out of it
+ * have been freed.
+ */
+/// @{
+
+/**
+ * Create an arena, whose handle is chained off of \p ctx.
+ *
+ * No more blocks can be carved out of the arena once the handle is freed,
+ * but the blocks that were carved out of it stay valid until they are freed.
+ */
+void *ralloc_arena_create(const void *ctx);
+
+/**
+ * Allocate \p size bytes out of the arena \p arena, chained off of \p ctx.
+ *
+ * If \p arena is NULL, or the allocation is large, this is the same as
+ * ralloc_size().
+ */
+void *ralloc_arena_size(void *arena, const void *ctx, size_t size) MALLOCLIKE;
+
+/**
+ * Same as ralloc_arena_size(), but also clears memory.
+ */
+void *rzalloc_arena_size(void *arena, const void *ctx, size_t size) MALLOCLIKE;
+
+/**
+ * Allocate a zero-initialized array out of an arena.
+ */
+void *rzalloc_arena_array_size(void *arena, const void *ctx, size_t size,
+                               unsigned count) MALLOCLIKE;
+
+#define ralloc_arena(arena, ctx, type) \
+   ((type *) ralloc_arena_size(arena, ctx, sizeof(type)))
+#define rzalloc_arena(arena, ctx, type) \
+   ((type *) rzalloc_arena_size(arena, ctx, sizeof(type)))
+#define rzalloc_arena_array(arena, ctx, type, count) \
+   ((type *) rzalloc_arena_array_size(arena, ctx, sizeof(type), count))
+
+/// @}
+
 /**
  * Declare C++ new and delete operators which use ralloc.
  *
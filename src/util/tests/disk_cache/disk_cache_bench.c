@@ -0,0 +1,160 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file disk_cache_bench.c
+ *
+ * Fills an on-disk cache with shader-sized entries, then opens it again the
+ * way a new process would and reads every entry back in a shuffled order.
+ * The in-memory layer is turned off, so the reads go to the disk backend.
+ * Run it with MESA_GLSL_CACHE_SINGLE_FILE=true to use the pack file
+ * instead of one file per entry.
+ *
+ * Usage: disk_cache_bench [entries]
+ */
+
+#define _XOPEN_SOURCE 500 /* for nftw */
+
+#include <ftw.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/disk_cache.h"
+#include "util/os_time.h"
+
+#define CACHE_BENCH_TMP "./disk-cache-bench-tmp"
+
+static int
+remove_entry(const char *path, const struct stat *sb, int typeflag,
+             struct FTW *ftwbuf)
+{
+   return remove(path);
+}
+
+static uint32_t seed = 1;
+
+static uint32_t
+random_u32(void)
+{
+   seed = seed * 1103515245 + 12345;
+   return seed >> 8;
+}
+
+/* Between 2 and 16 KiB, which is what most shader binaries come to. */
+static size_t
+entry_size(unsigned i)
+{
+   return 2048 + (i * 2654435761u) % (14 * 1024);
+}
+
+static void
+compute_entry_key(struct disk_cache *cache, unsigned i, cache_key key)
+{
+   disk_cache_compute_key(cache, &i, sizeof(i), key);
+}
+
+int
+main(int argc, char **argv)
+{
+   unsigned num_entries = argc > 1 ? atoi(argv[1]) : 4000;
+
+   if (!num_entries) {
+      fprintf(stderr, "usage: %s [entries]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   nftw(CACHE_BENCH_TMP, remove_entry, 64, FTW_DEPTH | FTW_PHYS);
+   setenv("MESA_GLSL_CACHE_DIR", CACHE_BENCH_TMP, 1);
+   setenv("MESA_GLSL_CACHE_MAX_SIZE", "1G", 1);
+   setenv("MESA_GLSL_CACHE_MEMORY_SIZE", "0", 1);
+
+   /* Mostly small values, so the entries compress about as well as
+    * shader binaries do.
+    */
+   uint8_t *data = malloc(16 * 1024);
+   if (!data)
+      return EXIT_FAILURE;
+   for (unsigned i = 0; i < 16 * 1024; i++)
+      data[i] = random_u32() % 16;
+
+   int64_t start = os_time_get_nano();
+   struct disk_cache *cache = disk_cache_create("bench", "disk_cache_bench", 0);
+   if (!cache) {
+      fprintf(stderr, "could not create the cache\n");
+      return EXIT_FAILURE;
+   }
+   for (unsigned i = 0; i < num_entries; i++) {
+      cache_key key;
+      compute_entry_key(cache, i, key);
+      data[0] = i;
+      disk_cache_put(cache, key, data, entry_size(i), NULL);
+   }
+   disk_cache_wait_for_idle(cache);
+   disk_cache_destroy(cache);
+   int64_t put_ns = os_time_get_nano() - start;
+
+   unsigned *order = malloc(num_entries * sizeof(*order));
+   if (!order)
+      return EXIT_FAILURE;
+   for (unsigned i = 0; i < num_entries; i++)
+      order[i] = i;
+   for (unsigned i = num_entries - 1; i > 0; i--) {
+      unsigned j = random_u32() % (i + 1);
+      unsigned tmp = order[i];
+      order[i] = order[j];
+      order[j] = tmp;
+   }
+
+   start = os_time_get_nano();
+   cache = disk_cache_create("bench", "disk_cache_bench", 0);
+   int64_t open_ns = os_time_get_nano() - start;
+
+   unsigned misses = 0;
+   start = os_time_get_nano();
+   for (unsigned i = 0; i < num_entries; i++) {
+      cache_key key;
+      size_t size;
+      compute_entry_key(cache, order[i], key);
+      void *entry = disk_cache_get(cache, key, &size);
+      if (!entry || size != entry_size(order[i]))
+         misses++;
+      free(entry);
+   }
+   int64_t get_ns = os_time_get_nano() - start;
+   disk_cache_destroy(cache);
+
+   nftw(CACHE_BENCH_TMP, remove_entry, 64, FTW_DEPTH | FTW_PHYS);
+
+   printf("%u entries: put %.1f ms, reopen %.3f ms, get %.2f us per entry",
+          num_entries, put_ns / 1e6, open_ns / 1e6,
+          get_ns / 1e3 / num_entries);
+   if (misses)
+      printf(" (%u misses)", misses);
+   printf("\n");
+
+   free(order);
+   free(data);
+   return misses ? EXIT_FAILURE : EXIT_SUCCESS;
+}
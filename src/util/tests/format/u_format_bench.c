@@ -0,0 +1,168 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file u_format_bench.c
+ *
+ * Measures how many texels per second the pack and unpack functions of a
+ * few common formats convert, with and without the SIMD kernels.
+ *
+ * Usage: u_format_bench [width height [iterations]]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "util/format/u_format.h"
+#include "util/macros.h"
+#include "util/os_time.h"
+#include "util/u_cpu_detect.h"
+
+enum bench_func {
+   UNPACK_RGBA_FLOAT,
+   PACK_RGBA_FLOAT,
+   UNPACK_RGBA_8UNORM,
+   PACK_RGBA_8UNORM,
+};
+
+static const char *func_names[] = {
+   "unpack_rgba_float",
+   "pack_rgba_float",
+   "unpack_rgba_8unorm",
+   "pack_rgba_8unorm",
+};
+
+static const enum pipe_format formats[] = {
+   PIPE_FORMAT_R8G8B8A8_UNORM,
+   PIPE_FORMAT_B8G8R8A8_UNORM,
+   PIPE_FORMAT_B8G8R8X8_UNORM,
+   PIPE_FORMAT_A8R8G8B8_UNORM,
+   PIPE_FORMAT_R16G16B16A16_UNORM,
+   PIPE_FORMAT_R32G32B32A32_FLOAT,
+};
+
+static void
+run(const struct util_format_description *desc, enum bench_func func,
+    uint8_t *packed, float *unpacked, uint8_t *unpacked_8unorm,
+    unsigned width, unsigned height)
+{
+   const unsigned packed_stride = width * desc->block.bits / 8;
+
+   switch (func) {
+   case UNPACK_RGBA_FLOAT:
+      desc->unpack_rgba(unpacked, width * 16, packed, packed_stride,
+                        width, height);
+      break;
+   case PACK_RGBA_FLOAT:
+      desc->pack_rgba_float(packed, packed_stride, unpacked, width * 16,
+                            width, height);
+      break;
+   case UNPACK_RGBA_8UNORM:
+      desc->unpack_rgba_8unorm(unpacked_8unorm, width * 4, packed,
+                               packed_stride, width, height);
+      break;
+   case PACK_RGBA_8UNORM:
+      desc->pack_rgba_8unorm(packed, packed_stride, unpacked_8unorm,
+                             width * 4, width, height);
+      break;
+   }
+}
+
+static double
+mtexels_per_second(const struct util_format_description *desc,
+                   enum bench_func func, uint8_t *packed, float *unpacked,
+                   uint8_t *unpacked_8unorm, unsigned width, unsigned height,
+                   unsigned iterations)
+{
+   /* Fault in the destination first. */
+   run(desc, func, packed, unpacked, unpacked_8unorm, width, height);
+
+   int64_t start = os_time_get_nano();
+
+   for (unsigned i = 0; i < iterations; i++)
+      run(desc, func, packed, unpacked, unpacked_8unorm, width, height);
+
+   int64_t ns = os_time_get_nano() - start;
+   return (double)width * height * iterations * 1000.0 / ns;
+}
+
+int
+main(int argc, char **argv)
+{
+   unsigned width = argc > 2 ? atoi(argv[1]) : 2048;
+   unsigned height = argc > 2 ? atoi(argv[2]) : 2048;
+   unsigned iterations = argc > 3 ? atoi(argv[3]) : 8;
+
+   if (!width || !height || !iterations) {
+      fprintf(stderr, "usage: %s [width height [iterations]]\n", argv[0]);
+      return 1;
+   }
+
+   util_cpu_detect();
+   const bool has_sse2 = util_cpu_caps.has_sse2;
+
+   uint8_t *packed = malloc((size_t)width * height * 16);
+   float *unpacked = malloc((size_t)width * height * 16);
+   uint8_t *unpacked_8unorm = malloc((size_t)width * height * 4);
+
+   if (!packed || !unpacked || !unpacked_8unorm)
+      return 1;
+
+   srand(1);
+   for (size_t i = 0; i < (size_t)width * height * 4; i++) {
+      unpacked[i] = (float)rand() / RAND_MAX;
+      unpacked_8unorm[i] = rand();
+   }
+
+   for (unsigned f = 0; f < ARRAY_SIZE(formats); f++) {
+      const struct util_format_description *desc =
+         util_format_description(formats[f]);
+
+      /* Start from valid pixels, which the float formats need. */
+      desc->pack_rgba_float(packed, width * desc->block.bits / 8,
+                            unpacked, width * 16, width, height);
+
+      for (unsigned func = 0; func < ARRAY_SIZE(func_names); func++) {
+         util_cpu_caps.has_sse2 = has_sse2;
+         double simd = mtexels_per_second(desc, func, packed, unpacked,
+                                          unpacked_8unorm, width, height,
+                                          iterations);
+         util_cpu_caps.has_sse2 = 0;
+         double scalar = mtexels_per_second(desc, func, packed, unpacked,
+                                            unpacked_8unorm, width, height,
+                                            iterations);
+
+         printf("%-20s %-18s %8.1f MTexel/s (scalar %7.1f MTexel/s, %.1fx)\n",
+                desc->short_name, func_names[func], simd, scalar,
+                simd / scalar);
+      }
+   }
+
+   util_cpu_caps.has_sse2 = has_sse2;
+
+   free(packed);
+   free(unpacked);
+   free(unpacked_8unorm);
+   return 0;
+}
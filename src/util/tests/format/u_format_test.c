@@ -28,8 +28,11 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <float.h>
+#include <math.h>
 
+#include "util/u_cpu_detect.h"
 #include "util/u_half.h"
 #include "util/format/u_format.h"
 #include "util/format/u_format_tests.h"
@@ -671,6 +674,178 @@ test_format_pack_s_8uint(const struct util_format_description *format_desc,
 }
 
 
+/* Enough pixels for a few iterations of the SIMD kernels and a scalar tail. */
+#define ROW_WIDTH 19
+#define ROW_HEIGHT 2
+
+
+static float
+random_float_component(void)
+{
+   static const float special[] = {
+      0.0f, -0.0f, 1.0f, -1.0f, 0.5f, 1.0f / 255.0f, 254.5f / 255.0f,
+      1.0f / 65535.0f, 2.0f, 1e30f, -1e30f, INFINITY, -INFINITY, NAN,
+   };
+
+   if (rand() % 4 == 0)
+      return special[rand() % ARRAY_SIZE(special)];
+
+   return (float)rand() / RAND_MAX * 1.5f - 0.25f;
+}
+
+
+/* Bits of a pixel that aren't padding. */
+static void
+get_channel_mask(const struct util_format_description *format_desc,
+                 uint8_t mask[UTIL_FORMAT_MAX_PACKED_BYTES])
+{
+   unsigned i, bit;
+
+   memset(mask, 0, UTIL_FORMAT_MAX_PACKED_BYTES);
+   for (i = 0; i < format_desc->nr_channels; ++i) {
+      const struct util_format_channel_description *channel =
+         &format_desc->channel[i];
+
+      if (channel->type == UTIL_FORMAT_TYPE_VOID)
+         continue;
+
+      for (bit = channel->shift; bit < channel->shift + channel->size; ++bit) {
+#if UTIL_ARCH_BIG_ENDIAN
+         mask[format_desc->block.bits / 8 - 1 - bit / 8] |= 1 << (bit % 8);
+#else
+         mask[bit / 8] |= 1 << (bit % 8);
+#endif
+      }
+   }
+}
+
+
+/*
+ * Check that converting whole rows, which may go through the SIMD kernels,
+ * gives exactly the same bits as converting one pixel at a time.  Rows are
+ * filled with the packed pixels of the test cases and with random data.
+ */
+static boolean
+test_format_rows(const struct util_format_description *format_desc)
+{
+   const unsigned bytes = format_desc->block.bits / 8;
+   const unsigned packed_stride = ROW_WIDTH * UTIL_FORMAT_MAX_PACKED_BYTES;
+   uint8_t packed[ROW_HEIGHT][ROW_WIDTH * UTIL_FORMAT_MAX_PACKED_BYTES];
+   uint8_t packed_row[ROW_HEIGHT][ROW_WIDTH * UTIL_FORMAT_MAX_PACKED_BYTES];
+   uint8_t packed_pixel[UTIL_FORMAT_MAX_PACKED_BYTES];
+   float unpacked[ROW_HEIGHT][ROW_WIDTH][4];
+   float unpacked_row[ROW_HEIGHT][ROW_WIDTH][4];
+   float unpacked_pixel[4];
+   uint8_t unpacked_8unorm[ROW_HEIGHT][ROW_WIDTH][4];
+   uint8_t unpacked_8unorm_row[ROW_HEIGHT][ROW_WIDTH][4];
+   uint8_t unpacked_8unorm_pixel[4];
+   uint8_t mask[UTIL_FORMAT_MAX_PACKED_BYTES];
+   unsigned i, j, k, t;
+   boolean success = TRUE;
+
+   if (format_desc->layout != UTIL_FORMAT_LAYOUT_PLAIN ||
+       format_desc->block.width != 1 || format_desc->block.height != 1 ||
+       util_format_is_pure_integer(format_desc->format) ||
+       !format_desc->unpack_rgba || !format_desc->pack_rgba_float ||
+       !format_desc->unpack_rgba_8unorm || !format_desc->pack_rgba_8unorm)
+      return TRUE;
+
+   get_channel_mask(format_desc, mask);
+
+   srand(format_desc->format);
+
+   for (i = 0; i < ROW_HEIGHT; ++i) {
+      for (j = 0; j < sizeof packed[i]; ++j)
+         packed[i][j] = rand();
+      for (j = 0; j < ROW_WIDTH; ++j) {
+         for (k = 0; k < 4; ++k) {
+            unpacked[i][j][k] = random_float_component();
+            unpacked_8unorm[i][j][k] = rand();
+         }
+      }
+   }
+
+   for (t = 0, i = 0; t < util_format_nr_test_cases; ++t) {
+      const struct util_format_test_case *test = &util_format_test_cases[t];
+
+      if (test->format == format_desc->format) {
+         memcpy(&packed[i % ROW_HEIGHT][(i / ROW_HEIGHT % ROW_WIDTH) * bytes],
+                test->packed, bytes);
+         ++i;
+      }
+   }
+
+   format_desc->unpack_rgba(&unpacked_row[0][0][0], sizeof unpacked_row[0],
+                            &packed[0][0], packed_stride,
+                            ROW_WIDTH, ROW_HEIGHT);
+   format_desc->unpack_rgba_8unorm(&unpacked_8unorm_row[0][0][0],
+                                   sizeof unpacked_8unorm_row[0],
+                                   &packed[0][0], packed_stride,
+                                   ROW_WIDTH, ROW_HEIGHT);
+
+   for (i = 0; i < ROW_HEIGHT; ++i) {
+      for (j = 0; j < ROW_WIDTH; ++j) {
+         format_desc->unpack_rgba(unpacked_pixel, 0, &packed[i][j * bytes], 0,
+                                  1, 1);
+         format_desc->unpack_rgba_8unorm(unpacked_8unorm_pixel, 0,
+                                         &packed[i][j * bytes], 0, 1, 1);
+
+         if (memcmp(unpacked_pixel, unpacked_row[i][j], sizeof unpacked_pixel)) {
+            printf("FAILED: unpack_rgba of pixel %u, %u\n", j, i);
+            success = FALSE;
+         }
+         if (memcmp(unpacked_8unorm_pixel, unpacked_8unorm_row[i][j],
+                    sizeof unpacked_8unorm_pixel)) {
+            printf("FAILED: unpack_rgba_8unorm of pixel %u, %u\n", j, i);
+            success = FALSE;
+         }
+      }
+   }
+
+   format_desc->pack_rgba_float(&packed_row[0][0], packed_stride,
+                                &unpacked[0][0][0], sizeof unpacked[0],
+                                ROW_WIDTH, ROW_HEIGHT);
+
+   for (i = 0; i < ROW_HEIGHT; ++i) {
+      for (j = 0; j < ROW_WIDTH; ++j) {
+         format_desc->pack_rgba_float(packed_pixel, 0, unpacked[i][j], 0, 1, 1);
+
+         for (k = 0; k < bytes; ++k) {
+            if ((packed_pixel[k] & mask[k]) !=
+                (packed_row[i][j * bytes + k] & mask[k])) {
+               printf("FAILED: pack_rgba_float of pixel %u, %u\n", j, i);
+               success = FALSE;
+               break;
+            }
+         }
+      }
+   }
+
+   format_desc->pack_rgba_8unorm(&packed_row[0][0], packed_stride,
+                                 &unpacked_8unorm[0][0][0],
+                                 sizeof unpacked_8unorm[0],
+                                 ROW_WIDTH, ROW_HEIGHT);
+
+   for (i = 0; i < ROW_HEIGHT; ++i) {
+      for (j = 0; j < ROW_WIDTH; ++j) {
+         format_desc->pack_rgba_8unorm(packed_pixel, 0, unpacked_8unorm[i][j], 0,
+                                       1, 1);
+
+         for (k = 0; k < bytes; ++k) {
+            if ((packed_pixel[k] & mask[k]) !=
+                (packed_row[i][j * bytes + k] & mask[k])) {
+               printf("FAILED: pack_rgba_8unorm of pixel %u, %u\n", j, i);
+               success = FALSE;
+               break;
+            }
+         }
+      }
+   }
+
+   return success;
+}
+
+
 /* Touch-test that the unorm/snorm flags are set up right by codegen. */
 static boolean
 test_format_norm_flags(const struct util_format_description *format_desc)
@@ -803,6 +978,7 @@ test_all(void)
       TEST_ONE_FUNC(pack_s_8uint);
 
       TEST_FORMAT_METADATA(norm_flags);
+      TEST_FORMAT_METADATA(rows);
 
 #     undef TEST_ONE_FUNC
 #     undef TEST_ONE_FORMAT
@@ -816,6 +992,8 @@ int main(int argc, char **argv)
 {
    boolean success;
 
+   util_cpu_detect();
+
    success = test_all();
 
    return success ? 0 : 1;
@@ -0,0 +1,109 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file ralloc_arena_bench.c
+ *
+ * Builds and sweeps a tree of small ralloc blocks the way the NIR of a big
+ * shader is built and cleaned up by its passes, either with plain ralloc or
+ * out of an arena, and reports the time taken and the peak RSS.  Each pass
+ * tops the tree up with nodes with a couple of children each, and then
+ * moves all but every eighth node to a new context and frees the old one,
+ * like nir_sweep() does.
+ *
+ * Usage: ralloc_arena_bench heap|arena [nodes]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include "util/os_time.h"
+#include "util/ralloc.h"
+
+#define PASSES 20
+
+/* About the size of a NIR ALU instruction and of its sources. */
+#define NODE_SIZE 136
+#define CHILD_SIZE 48
+
+/* Each pass leaves one in this many nodes dead. */
+#ifndef KILL_EVERY
+#define KILL_EVERY 8
+#endif
+
+int
+main(int argc, char **argv)
+{
+   const char *mode = argc > 1 ? argv[1] : "";
+   unsigned num_nodes = argc > 2 ? atoi(argv[2]) : 200000;
+   bool use_arena = !strcmp(mode, "arena");
+
+   if ((!use_arena && strcmp(mode, "heap")) || !num_nodes) {
+      fprintf(stderr, "usage: %s heap|arena [nodes]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   void *shader = ralloc_context(NULL);
+   void *arena = use_arena ? ralloc_arena_create(shader) : NULL;
+   void **nodes = malloc(num_nodes * sizeof(*nodes));
+   unsigned live = 0;
+
+   int64_t start = os_time_get_nano();
+
+   void *ctx = ralloc_context(shader);
+   for (unsigned pass = 0; pass < PASSES; pass++) {
+      for (unsigned i = live; i < num_nodes; i++) {
+         nodes[i] = ralloc_arena_size(arena, ctx, NODE_SIZE);
+         memset(nodes[i], 0, NODE_SIZE);
+         for (unsigned c = 0; c < 2; c++)
+            memset(ralloc_arena_size(arena, nodes[i], CHILD_SIZE), 0,
+                   CHILD_SIZE);
+      }
+
+      void *new_ctx = ralloc_context(shader);
+      live = 0;
+      for (unsigned i = 0; i < num_nodes; i++) {
+         if (i % KILL_EVERY == 0)
+            continue;
+         ralloc_steal(new_ctx, nodes[i]);
+         nodes[live++] = nodes[i];
+      }
+      ralloc_free(ctx);
+      ctx = new_ctx;
+   }
+
+   ralloc_free(shader);
+
+   double ms = (os_time_get_nano() - start) / 1e6;
+
+   struct rusage usage;
+   getrusage(RUSAGE_SELF, &usage);
+
+   printf("%s: %u passes over %u nodes: %.1f ms, peak RSS %ld KiB\n",
+          mode, PASSES, num_nodes, ms, usage.ru_maxrss);
+
+   free(nodes);
+   return EXIT_SUCCESS;
+}
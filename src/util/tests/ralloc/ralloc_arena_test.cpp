@@ -0,0 +1,187 @@
+/*
+ * Copyright © 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "util/ralloc.h"
+#include "gtest/gtest.h"
+
+static unsigned destroyed;
+
+static void
+count_destructor(void *ptr)
+{
+   destroyed++;
+}
+
+class ralloc_arena_test : public ::testing::Test {
+protected:
+   ralloc_arena_test()
+   {
+      destroyed = 0;
+      ctx = ralloc_context(NULL);
+      arena = ralloc_arena_create(ctx);
+   }
+
+   ~ralloc_arena_test()
+   {
+      ralloc_free(ctx);
+   }
+
+   void *ctx;
+   void *arena;
+};
+
+TEST_F(ralloc_arena_test, allocation)
+{
+   const unsigned count = 4096;
+   char **blocks = ralloc_array(ctx, char *, count);
+
+   /* Enough blocks to fill a few chunks. */
+   for (unsigned i = 0; i < count; i++) {
+      size_t size = 1 + i % 200;
+
+      blocks[i] = (char *)ralloc_arena_size(arena, ctx, size);
+      ASSERT_NE(nullptr, blocks[i]);
+      EXPECT_EQ(0u, (uintptr_t)blocks[i] % sizeof(void *));
+      EXPECT_EQ(ctx, ralloc_parent(blocks[i]));
+      memset(blocks[i], i & 0xff, size);
+   }
+
+   /* No block overlaps another one. */
+   for (unsigned i = 0; i < count; i++) {
+      size_t size = 1 + i % 200;
+      for (size_t j = 0; j < size; j++)
+         ASSERT_EQ((char)(i & 0xff), blocks[i][j]);
+   }
+
+   int *zeroed = rzalloc_arena_array(arena, ctx, int, 100);
+   for (unsigned i = 0; i < 100; i++)
+      EXPECT_EQ(0, zeroed[i]);
+}
+
+TEST_F(ralloc_arena_test, fallback)
+{
+   /* Without an arena, and for blocks larger than a chunk can hold, this
+    * is a plain ralloc.
+    */
+   void *a = ralloc_arena_size(NULL, ctx, 16);
+   void *b = ralloc_arena_size(arena, ctx, 1024 * 1024);
+
+   ASSERT_NE(nullptr, a);
+   ASSERT_NE(nullptr, b);
+   EXPECT_EQ(ctx, ralloc_parent(a));
+   EXPECT_EQ(ctx, ralloc_parent(b));
+   memset(b, 0, 1024 * 1024);
+}
+
+TEST_F(ralloc_arena_test, free)
+{
+   void *parent = ralloc_arena_size(arena, ctx, 32);
+   void *child = ralloc_arena_size(arena, parent, 32);
+   void *other = ralloc_arena_size(arena, ctx, 32);
+
+   ralloc_set_destructor(parent, count_destructor);
+   ralloc_set_destructor(child, count_destructor);
+   ralloc_set_destructor(other, count_destructor);
+
+   /* Freeing a block frees its children, and nothing else. */
+   ralloc_free(parent);
+   EXPECT_EQ(2u, destroyed);
+
+   ralloc_free(other);
+   EXPECT_EQ(3u, destroyed);
+
+   /* The arena still hands out blocks. */
+   EXPECT_NE(nullptr, ralloc_arena_size(arena, ctx, 32));
+}
+
+TEST_F(ralloc_arena_test, blocks_outlive_handle)
+{
+   void *mem_ctx = ralloc_context(NULL);
+   char *str = (char *)ralloc_arena_size(arena, mem_ctx, 6);
+   strcpy(str, "arena");
+   ralloc_set_destructor(str, count_destructor);
+
+   /* The chunk stays around until its last block is freed. */
+   ralloc_free(arena);
+   EXPECT_STREQ("arena", str);
+   EXPECT_EQ(0u, destroyed);
+
+   ralloc_free(mem_ctx);
+   EXPECT_EQ(1u, destroyed);
+}
+
+TEST_F(ralloc_arena_test, steal)
+{
+   void *old_ctx = ralloc_context(ctx);
+   void *new_ctx = ralloc_context(NULL);
+   char *str = (char *)ralloc_arena_size(arena, old_ctx, 6);
+   strcpy(str, "stole");
+   ralloc_set_destructor(str, count_destructor);
+
+   ralloc_steal(new_ctx, str);
+   EXPECT_EQ(new_ctx, ralloc_parent(str));
+
+   ralloc_free(old_ctx);
+   EXPECT_EQ(0u, destroyed);
+   EXPECT_STREQ("stole", str);
+
+   ralloc_free(new_ctx);
+   EXPECT_EQ(1u, destroyed);
+}
+
+TEST_F(ralloc_arena_test, adopt)
+{
+   void *old_ctx = ralloc_context(ctx);
+   void *new_ctx = ralloc_context(ctx);
+
+   for (unsigned i = 0; i < 10; i++) {
+      void *block = ralloc_arena_size(arena, old_ctx, 32);
+      ralloc_set_destructor(block, count_destructor);
+   }
+
+   ralloc_adopt(new_ctx, old_ctx);
+   ralloc_free(old_ctx);
+   EXPECT_EQ(0u, destroyed);
+
+   ralloc_free(new_ctx);
+   EXPECT_EQ(10u, destroyed);
+}
+
+TEST_F(ralloc_arena_test, resize)
+{
+   /* Resizing moves the block to the heap, with its children. */
+   char *str = (char *)ralloc_arena_size(arena, ctx, 6);
+   void *child = ralloc_arena_size(arena, str, 32);
+   strcpy(str, "arena");
+
+   str = (char *)reralloc_size(ctx, str, 64 * 1024);
+   ASSERT_NE(nullptr, str);
+   EXPECT_STREQ("arena", str);
+   EXPECT_EQ(str, ralloc_parent(child));
+
+   str = (char *)reralloc_size(ctx, str, 6);
+   EXPECT_STREQ("arena", str);
+}
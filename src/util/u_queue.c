@@ -689,6 +689,62 @@ util_queue_finish(struct util_queue *queue)
    free(fences);
 }
 
+struct util_queue_parallel_job {
+   util_queue_parallel_func func;
+   void *data;
+   unsigned index;
+   struct util_queue_fence fence;
+};
+
+static void
+util_queue_parallel_execute(void *data, int thread_index)
+{
+   struct util_queue_parallel_job *job = data;
+
+   job->func(job->data, job->index);
+}
+
+/**
+ * Call \p func for every index below \p count, and return once all calls
+ * have returned.
+ *
+ * The calling thread handles index 0 itself, the others are added to
+ * \p queue.  Everything runs on the calling thread if \p queue is NULL.
+ */
+void
+util_queue_parallel_for(struct util_queue *queue, unsigned count,
+                        util_queue_parallel_func func, void *data)
+{
+   struct util_queue_parallel_job *jobs = NULL;
+
+   if (queue && count > 1)
+      jobs = calloc(count, sizeof(*jobs));
+
+   if (!jobs) {
+      for (unsigned i = 0; i < count; i++)
+         func(data, i);
+      return;
+   }
+
+   for (unsigned i = 1; i < count; i++) {
+      jobs[i].func = func;
+      jobs[i].data = data;
+      jobs[i].index = i;
+      util_queue_fence_init(&jobs[i].fence);
+      util_queue_add_job(queue, &jobs[i], &jobs[i].fence,
+                         util_queue_parallel_execute, NULL, 0);
+   }
+
+   func(data, 0);
+
+   for (unsigned i = 1; i < count; i++) {
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
+   }
+
+   free(jobs);
+}
+
 int64_t
 util_queue_get_thread_time_nano(struct util_queue *queue, unsigned thread_index)
 {
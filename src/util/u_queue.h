@@ -239,6 +239,11 @@ void util_queue_drop_job(struct util_queue *queue,
 
 void util_queue_finish(struct util_queue *queue);
 
+typedef void (*util_queue_parallel_func)(void *data, unsigned index);
+
+void util_queue_parallel_for(struct util_queue *queue, unsigned count,
+                             util_queue_parallel_func func, void *data);
+
 /* Adjust the number of active threads. The new number of threads can't be
  * greater than the initial number of threads at the creation of the queue,
  * and it can't be less than 1.